@@ -9,6 +9,7 @@
 #include <vector>
 #include "../Utilities.h"
 #include "../MHC-PRG.h"
+#include "../hash/sequence/kMerCountsFile.h"
 #include <boost/math/distributions/poisson.hpp>
 
 using namespace boost::math::policies;
@@ -16,6 +17,48 @@ using namespace boost::math;
 
 typedef boost::math::poisson_distribution< double, policy < discrete_quantile < integer_round_inwards> > > poisson_up;
 
+// emission of a utilized k-mer by a haploid state (edge), see fillForwardBackwardTable_8(..)
+struct AlphaHMM_kMerEmission
+{
+	int code;
+	int number;
+	long long observed;
+	double logL_count0;
+};
+
+AlphaHMM_logPoissonTable::AlphaHMM_logPoissonTable() : ratePerCopy(0), maxCopies(0), maxObserved(-1), clipZero(false)
+{
+}
+
+AlphaHMM_logPoissonTable::AlphaHMM_logPoissonTable(double pRatePerCopy, int pMaxCopies, long long pMaxObserved, bool pClipZero) : ratePerCopy(pRatePerCopy), maxCopies(pMaxCopies), maxObserved(pMaxObserved), clipZero(pClipZero)
+{
+	assert(ratePerCopy > 0);
+	assert(maxCopies >= 1);
+	assert(maxObserved >= 0);
+	table.resize((size_t)maxCopies * (size_t)(maxObserved + 1));
+
+	#pragma omp parallel for schedule(static)
+	for(int copies = 1; copies <= maxCopies; copies++)
+	{
+		double* row = &(table[(size_t)(copies - 1) * (size_t)(maxObserved + 1)]);
+		for(long long observed = 0; observed <= maxObserved; observed++)
+		{
+			row[observed] = compute(copies, observed);
+		}
+	}
+}
+
+double AlphaHMM_logPoissonTable::compute(int copies, long long observed) const
+{
+	double rate = (double)copies * ratePerCopy;
+	poisson_up poisson(rate);
+	double P = pdf(poisson, observed);
+	if(clipZero && (P == 0))
+	{
+		P = 1e-200;
+	}
+	return log(P);
+}
 
 void AlphaHMM::init(MultiGraph* g, int pGenotypingMode, bool verbose)
 {
@@ -23,6 +66,13 @@ void AlphaHMM::init(MultiGraph* g, int pGenotypingMode, bool verbose)
 	myGraph = g;
 	genotypingMode = pGenotypingMode;
 
+	useForwardCheckpoints = false;
+	forwardCheckpointInterval = 0;
+	forwardSegmentStart = -1;
+	forwardSegmentStop = -1;
+
+	myGraph->buildkMerIDs();
+
 	Edge2Int.clear();
 	Edge2Level.clear();
 
@@ -326,12 +376,13 @@ void AlphaHMM::init(MultiGraph* g, int pGenotypingMode, bool verbose)
 						assert(diploidStates > 0);
 						assert(lastPair >= 0);
 
-						string kMer = myGraph->CODE.deCode(locusID, kMerSymbol);
+						int kMerID = myGraph->CODE.kMerID(locusID, kMerSymbol);
+						assert(kMerID != -1);
 
 						assert(diploidStates > 0);
 						assert(lastPair >= 0);
 
-						interestingKMerStrings.insert(kMer);
+						interestingKMerIDs.insert(kMerID);
 
 						assert(diploidStates > 0);
 						assert(lastPair >= 0);
@@ -425,6 +476,7 @@ void AlphaHMM::fillStateTransitions(int level)
 	{
 		diploidStateTransitions_Reverse.at(level).clear();
 		diploidStateTransitions_Reverse.at(level).resize(diploidStates);
+		diploid_initialProbabilities.clear();
 	}
 	if(level < (levels-2))
 	{
@@ -491,81 +543,158 @@ void AlphaHMM::fillStateTransitions(int level)
 	}
 }
 
-map<string, long long> AlphaHMM::estimateEmissions(string kMerCountsSamplePath, string kMerCountsGenomePath, int kMerSize)
+// counts and metadata from a kMerCountsFile; with graphkMers, only these kMers are decoded
+static map<string, long long> readkMerCountsFile(string path, int kMerSize, vector<string>* graphkMers)
 {
-	// this function reads in kMer counts from kMerCountsSamplePath
-
-	map<string, long long> kMerCountsInSample;
-	ifstream kMerCountsSampleFile;
-	kMerCountsSampleFile.open (kMerCountsSamplePath.c_str(), ios::in);
-	int lineCounter = 0;
-	if(kMerCountsSampleFile.is_open())
+	map<string, long long> forReturn;
+	kMerCountsFile countsFile;
+	try
 	{
-		string line;
-		while(kMerCountsSampleFile.good())
+		countsFile.load(path);
+		if((countsFile.size() > 0) && (countsFile.getK() != kMerSize))
 		{
-			lineCounter++;
-			getline (kMerCountsSampleFile, line);
-			Utilities::eraseNL(line);
-
-			if(line.length() == 0)
-				continue;
-
-			vector<string> fields = Utilities::split(line, ' ');
-			if(fields.size() != 2)
-				errEx("Strange format in kMerCountsInSample file. Expect two fields (kMer and count). Problem occured in line: "+Utilities::ItoStr(lineCounter));
+			errEx("kMer counts file "+path+" has k = "+Utilities::ItoStr(countsFile.getK())+", but the graph uses k = "+Utilities::ItoStr(kMerSize));
+		}
 
-			if((fields.at(0) != "MeanReadLen") && (fields.at(0) != "TotalKMerCoverage") && (fields.at(0) != "TotalSeq"))
+		forReturn = countsFile.getMetadata();
+		if(graphkMers != 0)
+		{
+			vector<long long> counts;
+			countsFile.lookup(*graphkMers, counts, MultiGraph::kMerCountMissing);
+			for(unsigned int kMerI = 0; kMerI < graphkMers->size(); kMerI++)
 			{
-				assert((int)fields.at(0).length() == kMerSize);
+				if(counts.at(kMerI) != MultiGraph::kMerCountMissing)
+				{
+					forReturn[graphkMers->at(kMerI)] = counts.at(kMerI);
+				}
 			}
-
-			kMerCountsInSample[fields.at(0)] = Utilities::StrtoLongLong(fields.at(1));
 		}
-		kMerCountsSampleFile.close();
+		else
+		{
+			countsFile.readAll(forReturn);
+		}
 	}
-	else
+	catch(std::runtime_error& e)
 	{
-		errEx("Cannot open kMer counts file: "+kMerCountsSamplePath);
+		errEx(e.what());
 	}
+	return forReturn;
+}
+
+map<string, long long> AlphaHMM::estimateEmissions(string kMerCountsSamplePath, string kMerCountsGenomePath, int kMerSize, MultiGraph* graph)
+{
+	// this function reads in kMer counts from kMerCountsSamplePath
 
-	ifstream kMerCountsGenomeFile;
-	kMerCountsGenomeFile.open (kMerCountsGenomePath.c_str(), ios::in);
-	lineCounter = 0;
-	if(kMerCountsGenomeFile.is_open())
+	vector<string> graphkMers;
+	if(graph != 0)
 	{
-		string line;
-		while(kMerCountsGenomeFile.good())
+		int kMerIDs = graph->buildkMerIDs();
+		graphkMers.reserve(kMerIDs);
+		for(int kMerID = 0; kMerID < kMerIDs; kMerID++)
 		{
-			lineCounter++;
-			getline (kMerCountsGenomeFile, line);
-			Utilities::eraseNL(line);
+			graphkMers.push_back(graph->CODE.kMerForID(kMerID));
+		}
+		sort(graphkMers.begin(), graphkMers.end());
+	}
+	vector<string>* kMerFilter = (graph != 0) ? &graphkMers : 0;
 
-			if(line.length() == 0)
-				continue;
+	map<string, long long> kMerCountsInSample;
+	if(kMerCountsFile::isKMerCountsFile(kMerCountsSamplePath))
+	{
+		kMerCountsInSample = readkMerCountsFile(kMerCountsSamplePath, kMerSize, kMerFilter);
+	}
+	else
+	{
+		ifstream kMerCountsSampleFile;
+		kMerCountsSampleFile.open (kMerCountsSamplePath.c_str(), ios::in);
+		int lineCounter = 0;
+		if(kMerCountsSampleFile.is_open())
+		{
+			string line;
+			while(kMerCountsSampleFile.good())
+			{
+				lineCounter++;
+				getline (kMerCountsSampleFile, line);
+				Utilities::eraseNL(line);
 
-			vector<string> fields = Utilities::split(line, ' ');
-			if(fields.size() != 2)
-				errEx("Strange format in kMerGenomeCountsFile file. Expect two fields (kMer and count). Problem occured in line: "+Utilities::ItoStr(lineCounter));
+				if(line.length() == 0)
+					continue;
 
-			if((fields.at(0) != "MeanReadLen") && (fields.at(0) != "TotalKMerCoverage") && (fields.at(0) != "TotalSeq"))
-			{
-				assert((int)fields.at(0).length() == kMerSize);
+				vector<string> fields = Utilities::split(line, ' ');
+				if(fields.size() != 2)
+					errEx("Strange format in kMerCountsInSample file. Expect two fields (kMer and count). Problem occured in line: "+Utilities::ItoStr(lineCounter));
 
-				if(Utilities::StrtoLongLong(fields.at(1)) != 0)
+				if((fields.at(0) != "MeanReadLen") && (fields.at(0) != "TotalKMerCoverage") && (fields.at(0) != "TotalSeq"))
 				{
-					kMerCountsInSample[fields.at(0)] = -1;
+					assert((int)fields.at(0).length() == kMerSize);
+
+					if((kMerFilter != 0) && (! binary_search(kMerFilter->begin(), kMerFilter->end(), fields.at(0))))
+						continue;
 				}
+
+				kMerCountsInSample[fields.at(0)] = Utilities::StrtoLongLong(fields.at(1));
 			}
+			kMerCountsSampleFile.close();
+		}
+		else
+		{
+			errEx("Cannot open kMer counts file: "+kMerCountsSamplePath);
+		}
+	}
 
+	if(kMerCountsFile::isKMerCountsFile(kMerCountsGenomePath))
+	{
+		map<string, long long> kMerCountsInGenome = readkMerCountsFile(kMerCountsGenomePath, kMerSize, kMerFilter);
+		for(map<string, long long>::iterator kMerIt = kMerCountsInGenome.begin(); kMerIt != kMerCountsInGenome.end(); kMerIt++)
+		{
+			if((kMerIt->first != "MeanReadLen") && (kMerIt->first != "TotalKMerCoverage") && (kMerIt->first != "TotalSeq") && (kMerIt->second != 0))
+			{
+				kMerCountsInSample[kMerIt->first] = -1;
+			}
 		}
-		kMerCountsGenomeFile.close();
 	}
 	else
 	{
-		// cerr << "Cannot open genome counts file: "+kMerCountsGenomePath+" -- this is not a problem if you are not using a Cortex-like likelihood!\n\n" << flush;
-	}
+		ifstream kMerCountsGenomeFile;
+		kMerCountsGenomeFile.open (kMerCountsGenomePath.c_str(), ios::in);
+		int lineCounter = 0;
+		if(kMerCountsGenomeFile.is_open())
+		{
+			string line;
+			while(kMerCountsGenomeFile.good())
+			{
+				lineCounter++;
+				getline (kMerCountsGenomeFile, line);
+				Utilities::eraseNL(line);
 
+				if(line.length() == 0)
+					continue;
+
+				vector<string> fields = Utilities::split(line, ' ');
+				if(fields.size() != 2)
+					errEx("Strange format in kMerGenomeCountsFile file. Expect two fields (kMer and count). Problem occured in line: "+Utilities::ItoStr(lineCounter));
+
+				if((fields.at(0) != "MeanReadLen") && (fields.at(0) != "TotalKMerCoverage") && (fields.at(0) != "TotalSeq"))
+				{
+					assert((int)fields.at(0).length() == kMerSize);
+
+					if((kMerFilter != 0) && (! binary_search(kMerFilter->begin(), kMerFilter->end(), fields.at(0))))
+						continue;
+
+					if(Utilities::StrtoLongLong(fields.at(1)) != 0)
+					{
+						kMerCountsInSample[fields.at(0)] = -1;
+					}
+				}
+
+			}
+			kMerCountsGenomeFile.close();
+		}
+		else
+		{
+			// cerr << "Cannot open genome counts file: "+kMerCountsGenomePath+" -- this is not a problem if you are not using a Cortex-like likelihood!\n\n" << flush;
+		}
+	}
 
 	return kMerCountsInSample;
 }
@@ -714,6 +843,8 @@ vector< vector<int> > AlphaHMM::retrieveAllBestPaths_rec(int level, int runningS
 
 	if(genotypingMode >= 5)
 	{
+		requireForwardLevel(level);
+
 		assert((int)fw_Viterbi_backtrack_int.size() > level);
 		assert((int)fw_Viterbi_backtrack_int.at(level).size() > runningState);
 
@@ -836,7 +967,7 @@ multiHaplotypePair_and_P AlphaHMM::retrieveViterbiSample(bool labelOnly)
 	return forReturn;
 }
 
-double AlphaHMM::fillForwardBackwardTable(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable(map<string, long long>& globalEmission)
 {
 	if(genotypingMode == 0)
 	{
@@ -884,14 +1015,14 @@ double AlphaHMM::fillForwardBackwardTable(map<string, long long> globalEmission)
 vector< vector<double> > AlphaHMM::populatekMerMatrix(double coverage, map<string, long long>& globalEmission)
 {
 	cout << "Expected haploid kMer coverage: " << coverage << "\n";
-	cout << "Number of interesting kMers: " << interestingKMerStrings.size() << "\n";
+	cout << "Number of interesting kMers: " << interestingKMerIDs.size() << "\n";
 
-	assert(interestingKMerStrings.size() > 0);
+	assert(interestingKMerIDs.size() > 0);
 
 	int maxObservedKMer = 0;
-	for(set<string>::iterator kMerIt = interestingKMerStrings.begin(); kMerIt != interestingKMerStrings.end(); kMerIt++)
+	for(set<int>::iterator kMerIt = interestingKMerIDs.begin(); kMerIt != interestingKMerIDs.end(); kMerIt++)
 	{
-		string kMer = *kMerIt;
+		string kMer = myGraph->CODE.kMerForID(*kMerIt);
 		if(globalEmission.count(kMer) == 0)
 		{
 			cerr << "kMer " << kMer << " is not defined in coverage file!\n";
@@ -903,7 +1034,7 @@ vector< vector<double> > AlphaHMM::populatekMerMatrix(double coverage, map<strin
 			maxObservedKMer = kMerCount;
 		}
 	}
-	interestingKMerStrings.clear();
+	interestingKMerIDs.clear();
 
 	cout << "Maximum observed kMer count from sample: " << maxObservedKMer << "\n";
 	cout << "Maximum count of single kMer in single state: " << maxStateKMerCount << "\n";
@@ -983,7 +1114,7 @@ vector< vector<double> > AlphaHMM::populatekMerMatrix(double coverage, map<strin
 
 }
 
-void AlphaHMM::debug(map<string, long long> globalEmission)
+void AlphaHMM::debug(map<string, long long>& globalEmission)
 {
 	vector<string> interestingSNPs;
 	interestingSNPs.push_back("rs114471122");
@@ -1029,6 +1160,8 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 	interestingSNPs.push_back("rs115033670");
 
 
+	vector<long long> kMerCounts = myGraph->kMerCountsByID(globalEmission);
+
 	map<string, long long> noEmissions;
 	vector<diploidEdgePointerPath> bestPaths_Edges = retrieveAllBestPaths(noEmissions);
 	diploidEdgePointerPath firstEstimatedEdgePath = bestPaths_Edges.at(0);
@@ -1059,25 +1192,20 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 		{
 			cout << "Level " << level << "is interesting (for SNP " << foundLocus << " and possibly other!\n";
 
-			set<string> utilizeKMersatLevel;
-			set<int> utilizeCodedKMersatLevel;
-
 			double likelihood_all_kMers_0 = 0;
-			map<string, double> logL_count0;
+			map<int, double> logL_count0;
 			string locusID = haploidStatesByLevel.at(level).at(0).e->locus_id;
 
-			assert(kMersInGraphInfo.Level2Kmers.count(level) > 0);
-			for(set<string>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
+			assert(level < (int)kMersInGraphInfo.Level2Kmers.size());
+			for(vector<int>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
 			{
-				string kMer = *kMerIt;
-				if(utilizekMers.count(kMer) > 0)
+				int kMerID = *kMerIt;
+				if(utilizekMers.at(kMerID))
 				{
-					utilizeKMersatLevel.insert(kMer);
-					utilizeCodedKMersatLevel.insert(myGraph->CODE.doCode(locusID, kMer));
-					assert(globalEmission.count(kMer) > 0);
+					assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
 					poisson_up poisson(error_rate);
 
-					double likelihood_thisMer_if_underlying_0 = pdf(poisson, globalEmission[kMer]);
+					double likelihood_thisMer_if_underlying_0 = pdf(poisson, kMerCounts.at(kMerID));
 					if(likelihood_thisMer_if_underlying_0 == 0)
 					{
 						likelihood_thisMer_if_underlying_0 = 1e-200;
@@ -1085,11 +1213,11 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 					double log_likelihood_thisMer_if_underlying_0 = log(likelihood_thisMer_if_underlying_0);
 					assert(log_likelihood_thisMer_if_underlying_0 <= 0);
 					likelihood_all_kMers_0 += log_likelihood_thisMer_if_underlying_0;
-					logL_count0[kMer] = log_likelihood_thisMer_if_underlying_0;
+					logL_count0[kMerID] = log_likelihood_thisMer_if_underlying_0;
 				}
 				else
 				{
-					assert(ignorekMers.count(kMer) > 0);
+					assert(ignorekMers.at(kMerID));
 				}
 			}
 
@@ -1158,8 +1286,9 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 					for(map<int, int>::iterator kMerIt = combinedCodedEdgeEmission.begin(); kMerIt != combinedCodedEdgeEmission.end(); kMerIt++)
 					{
 						string kMer = myGraph->CODE.deCode(e1->locus_id, kMerIt->first);
+						int kMerID = myGraph->CODE.kMerID(e1->locus_id, kMerIt->first);
 
-						if(utilizeCodedKMersatLevel.count(kMerIt->first) == 0)
+						if(! utilizekMers.at(kMerID))
 						{
 							subst_cout << "\t\t" << kMer << ": ignore.\n";
 							continue;
@@ -1171,25 +1300,26 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 						subst_cout << "\t\t" << kMer << ": " << underlyingCopyCount << " on underlying copies " << underlyingCopyCount << ".\n";
 
 
-						assert(logL_count0.count(kMer) > 0);
-						assert(logL_count0[kMer] <= 0);
+						assert(logL_count0.count(kMerID) > 0);
+						assert(logL_count0[kMerID] <= 0);
 
-						log_emission_p -= logL_count0[kMer];
+						log_emission_p -= logL_count0[kMerID];
 						assert(log_emission_p <= 0);
 
 						double rate = (double)underlyingCopyCount * coverage;
-						assert(globalEmission.count(kMer) > 0);
+						long long observed = kMerCounts.at(kMerID);
+						assert(observed != MultiGraph::kMerCountMissing);
 
 						double thiskMer_P;
-						if((_cache_poisson_PDF.count(underlyingCopyCount) > 0) && (_cache_poisson_PDF.at(underlyingCopyCount).count(globalEmission[kMer]) > 0))
+						if((_cache_poisson_PDF.count(underlyingCopyCount) > 0) && (_cache_poisson_PDF.at(underlyingCopyCount).count(observed) > 0))
 						{
-							thiskMer_P = _cache_poisson_PDF[underlyingCopyCount][globalEmission[kMer]];
+							thiskMer_P = _cache_poisson_PDF[underlyingCopyCount][observed];
 						}
 						else
 						{
 							poisson_up poisson(rate);
-							thiskMer_P = pdf(poisson, globalEmission[kMer]);
-							_cache_poisson_PDF[underlyingCopyCount][globalEmission[kMer]] = thiskMer_P;
+							thiskMer_P = pdf(poisson, observed);
+							_cache_poisson_PDF[underlyingCopyCount][observed] = thiskMer_P;
 						}
 
 						if(thiskMer_P == 0)
@@ -1217,7 +1347,7 @@ void AlphaHMM::debug(map<string, long long> globalEmission)
 	}
 }
 
-double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_8(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 8);
 
@@ -1239,6 +1369,13 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 	kMersInGraph = kMersInGraphInfo.kMers;
 	uniqueMers = myGraph->kMerUniqueness();
 
+	// observed counts by k-mer ID - k-mers aren't looked up by their strings past this point
+	vector<long long> kMerCounts = myGraph->kMerCountsByID(globalEmission);
+	int kMerIDs = kMerCounts.size();
+	utilizekMers.assign(kMerIDs, false);
+	ignorekMers.assign(kMerIDs, false);
+	int utilizekMers_count = 0;
+
 	// find out which kMers we want to keep
 
 	int kickedOutBecauseGraphDuplicate = 0;
@@ -1246,21 +1383,21 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 	int kickedOutBecauseAssumeOtherDuplication = 0;
 	int kickedOutBecauseWayTooManyReads = 0;
 
-	for(set<string>::iterator kMerIt = kMersInGraph.begin(); kMerIt != kMersInGraph.end(); kMerIt++)
+	for(vector<int>::iterator kMerIt = kMersInGraph.begin(); kMerIt != kMersInGraph.end(); kMerIt++)
 	{
-		string kMer = *kMerIt;
+		int kMerID = *kMerIt;
 		bool usekMer = true;
 
 		// non-unique within graph
-		if(uniqueMers.levelUniqueKMers.count(kMer) == 0)
+		if(! uniqueMers.levelUniqueKMers.at(kMerID))
 		{
 			usekMer = false;
 			kickedOutBecauseGraphDuplicate++;
 		}
 
 		// non-unique within genome
-		assert(globalEmission.count(kMer) > 0);
-		if(globalEmission[kMer] == -1)
+		assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+		if(kMerCounts.at(kMerID) == -1)
 		{
 			kickedOutBecauseWholeGenomeDuplicate++;
 			usekMer = false;
@@ -1269,13 +1406,12 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 		// estimate number of underlying copies - consistent with
 		// our expectation from graph?
 
-		assert(kMersInGraphInfo.kMerMaxPerLevel.count(kMer) > 0);
-		int maxLevelCount = kMersInGraphInfo.kMerMaxPerLevel[kMer];
+		int maxLevelCount = kMersInGraphInfo.kMerMaxPerLevel.at(kMerID);
 		assert(maxLevelCount > 0);
 		assert(maxLevelCount < maxStateKMerCount);
 
-		long long observedReadsOnKMer = globalEmission[kMer];
-		if(globalEmission[kMer] != -1)
+		long long observedReadsOnKMer = kMerCounts.at(kMerID);
+		if(observedReadsOnKMer != -1)
 		{
 			if(observedReadsOnKMer < (int)observedXunderlying.size())
 			{
@@ -1301,18 +1437,19 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 		if(usekMer)
 		{
-			utilizekMers.insert(kMer);
+			utilizekMers.at(kMerID) = true;
+			utilizekMers_count++;
 		}
 		else
 		{
-			ignorekMers.insert(kMer);
+			ignorekMers.at(kMerID) = true;
 		}
 	}
 
 	// summary stats of kMer usage
 	cout << "AlphaHMM in mode 8!\n";
 	cout << levels << " Levels\n";
-	cout << "Utilize " << utilizekMers.size() << " of " << kMersInGraph.size() << "kMers\n";
+	cout << "Utilize " << utilizekMers_count << " of " << kMersInGraph.size() << "kMers\n";
 	cout << "\t Kicked out because (multiple reasons possible):\n";
 	cout << "\t\tDuplication in graph: " << kickedOutBecauseGraphDuplicate << "\n";
 	cout << "\t\tDuplication in genome outside xMHC: " << kickedOutBecauseWholeGenomeDuplicate << "\n";
@@ -1321,7 +1458,7 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 	// assert(kickedOutBecauseWholeGenomeDuplicate > 0);
 
-	cout << uniqueMers.levelUniqueKMers.size() << " graph-unique kMers\n";
+	cout << uniqueMers.levelUniqueKMers_count << " graph-unique kMers\n";
 
 	// use graph to estimate coverage
 
@@ -1346,17 +1483,18 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 			for(map<int, int>::iterator emissionIt = edgeEmissions.begin(); emissionIt != edgeEmissions.end(); emissionIt++)
 			{
-				string kMer = myGraph->CODE.deCode(locusID, emissionIt->first);
-				if(ignorekMers.count(kMer) > 0)
+				int kMerID = myGraph->CODE.kMerID(locusID, emissionIt->first);
+				assert(kMerID != -1);
+				if(ignorekMers.at(kMerID))
 				{
 					continue;
 				}
 				else
 				{
 					kMers_used_for_coverage_estimation += emissionIt->second;
-					assert(globalEmission.count(kMer) > 0);
-					assert(utilizekMers.count(kMer) > 0);
-					sum_kMer_coverage += globalEmission[kMer];
+					assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+					assert(utilizekMers.at(kMerID));
+					sum_kMer_coverage += kMerCounts.at(kMerID);
 				}
 			}
 		}
@@ -1379,6 +1517,12 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 	// use graph to estimate error rates
 
+	// log-likelihoods of observed counts given the underlying copy number (copies * coverage) or no
+	// copies (error_rate). Utilized k-mers have counts below observedXunderlying.size(), and a state
+	// has at most 2 * maxStateKMerCount copies of a k-mer.
+	long long maxObservedUtilized = (long long)observedXunderlying.size() - 1;
+	AlphaHMM_logPoissonTable logP_coverage(coverage, 2 * maxStateKMerCount, maxObservedUtilized, false);
+
 	error_rate = 0.1;
 	bool update_error_rate = true;
 
@@ -1393,6 +1537,8 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 		int levels_used_for_error_estimation = 0;
 		double sum_error_kMer_rates = 0.00;
 
+		AlphaHMM_logPoissonTable logP_error(error_rate, 1, maxObservedUtilized, false);
+
 		for(int level = 0; level < levels; level++)
 		{
 			if((previous_likelihood != 1) && (considerLevelsForErrorEstimation.count(level) == 0))
@@ -1424,8 +1570,9 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 					for(map<int, int>::iterator emissionIt = edgeEmissions.begin(); emissionIt != edgeEmissions.end(); emissionIt++)
 					{
-						string kMer = myGraph->CODE.deCode(locusID, emissionIt->first);
-						if(utilizekMers.count(kMer) > 0)
+						int kMerID = myGraph->CODE.kMerID(locusID, emissionIt->first);
+						assert(kMerID != -1);
+						if(utilizekMers.at(kMerID))
 						{
 							use_kMers.at(eI) += emissionIt->second;
 						}
@@ -1483,6 +1630,8 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 							edgeEmissions.erase(gap_symbol);
 							edgeEmissions.erase(star_symbol);
 
+							set<int> edgeEmissions_kMerIDs;
+
 							// get likelihood for this pair of edges
 
 							// ... kMers implied...
@@ -1491,21 +1640,19 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 							int _used_kMers = 0;
 							for(map<int, int>::iterator kMerIt = edgeEmissions.begin(); kMerIt != edgeEmissions.end(); kMerIt++)
 							{
-								string kMer = myGraph->CODE.deCode(locusID, kMerIt->first);
+								int kMerID = myGraph->CODE.kMerID(locusID, kMerIt->first);
+								assert(kMerID != -1);
+								edgeEmissions_kMerIDs.insert(kMerID);
 
-								if(utilizekMers.count(kMer) > 0)
+								if(utilizekMers.at(kMerID))
 								{
 									int underlyingCopyCount = kMerIt->second;
-									double rate = (double)underlyingCopyCount * coverage;
-
-									poisson_up poisson(rate);
-									assert(globalEmission.count(kMer) > 0);
-									double thiskMer_P = pdf(poisson, globalEmission[kMer]);
 
-									assert(thiskMer_P >= 0);
-									assert(thiskMer_P <= 1);
+									assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+									double thiskMer_logP = logP_coverage.logP(underlyingCopyCount, kMerCounts.at(kMerID));
+									assert(thiskMer_logP <= 0);
 
-									log_emission_p += log(thiskMer_P);
+									log_emission_p += thiskMer_logP;
 
 									_used_kMers++;
 								}
@@ -1516,26 +1663,21 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 							double other_coverage = 0;
 							int other_kMers = 0;
 
-							for(set<string>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
+							for(vector<int>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
 							{
-								string kMer = *kMerIt;
+								int kMerID = *kMerIt;
 
-								if(utilizekMers.count(kMer) > 0)
+								if(utilizekMers.at(kMerID))
 								{
-									int symbol = myGraph->CODE.doCode(locusID, kMer);
-
-									if(edgeEmissions.count(symbol) == 0)
+									if(edgeEmissions_kMerIDs.count(kMerID) == 0)
 									{
-										poisson_up poisson(error_rate);
-										assert(globalEmission.count(kMer) > 0);
-										double thiskMer_P = pdf(poisson, globalEmission[kMer]);
+										assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+										double thiskMer_logP = logP_error.logP(1, kMerCounts.at(kMerID));
+										assert(thiskMer_logP <= 0);
 
-										assert(thiskMer_P >= 0);
-										assert(thiskMer_P <= 1);
+										log_emission_p += thiskMer_logP;
 
-										log_emission_p += log(thiskMer_P);
-
-										other_coverage += globalEmission[kMer];
+										other_coverage += kMerCounts.at(kMerID);
 										other_kMers++;
 
 									}
@@ -1622,388 +1764,459 @@ double AlphaHMM::fillForwardBackwardTable_8(map<string, long long> globalEmissio
 
 	cout << "Error rate estimated from graph: " << error_rate << "\n\n";
 
-	for(int level = 0; level < levels; level++)
-	{
-		set<string> utilizeKMersatLevel;
-		set<int> utilizeCodedKMersatLevel;
+	forward_kMerCounts = kMerCounts;
+	forward_logP_coverage = AlphaHMM_logPoissonTable(coverage, 2 * maxStateKMerCount, maxObservedUtilized, true);
+	forward_logP_error = AlphaHMM_logPoissonTable(error_rate, 1, maxObservedUtilized, true);
 
-		double likelihood_all_kMers_0 = 0;
-		map<string, double> logL_count0;
+	// logL_count0: log-likelihood of a k-mer's count if it has no underlying copies (set per level)
+	forward_logL_count0.assign(kMerIDs, 0);
 
-		string locusID = haploidStatesByLevel.at(level).at(0).e->locus_id;
+	forwardCheckpointInterval = 0;
+	if(useForwardCheckpoints)
+	{
+		forwardCheckpointInterval = (int)ceil(sqrt((double)levels));
+		cout << "Keep forward columns every " << forwardCheckpointInterval << " levels\n";
+	}
+	forwardSegmentStart = -1;
+	forwardSegmentStop = -1;
 
-		assert(kMersInGraphInfo.Level2Kmers.count(level) > 0);
-		for(set<string>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
+	ofstream emissionsStream;
+	if(forwardEmissionsFile.length())
+	{
+		emissionsStream.open(forwardEmissionsFile.c_str());
+		if(! emissionsStream.is_open())
 		{
-			string kMer = *kMerIt;
-			if(utilizekMers.count(kMer) > 0)
-			{
-				utilizeKMersatLevel.insert(kMer);
-				utilizeCodedKMersatLevel.insert(myGraph->CODE.doCode(locusID, kMer));
-				assert(globalEmission.count(kMer) > 0);
-				poisson_up poisson(error_rate);
+			errEx("Cannot open file for writing: "+forwardEmissionsFile);
+		}
+	}
 
+	for(int level = 0; level < levels; level++)
+	{
+		if((level % 1000) == 0)
+			cout << "fillForwardBackwardTable level " << level << "/" << (levels-1) << " (first thread) \n" << flush;
 
+		double max_forward = fillForwardLevel_8(level);
+		fw_underflow_factor += max_forward;
 
-				double likelihood_thisMer_if_underlying_0 = pdf(poisson, globalEmission[kMer]);
-				if(likelihood_thisMer_if_underlying_0 == 0)
-				{
-					likelihood_thisMer_if_underlying_0 = 1e-200;
-				}
-				double log_likelihood_thisMer_if_underlying_0 = log(likelihood_thisMer_if_underlying_0);
-				assert(log_likelihood_thisMer_if_underlying_0 <= 0);
-				likelihood_all_kMers_0 += log_likelihood_thisMer_if_underlying_0;
-				logL_count0[kMer] = log_likelihood_thisMer_if_underlying_0;
+		if(emissionsStream.is_open())
+		{
+			emissionsStream << level;
+			for(int state = 0; state < (int)fw_Emission.at(level).size(); state++)
+			{
+				emissionsStream << "\t" << fw_Emission.at(level).at(state);
 			}
-			else
+			emissionsStream << "\n";
+		}
+
+		if(forwardCheckpointInterval)
+		{
+			vector<double>().swap(fw_Emission.at(level));
+			if((level > 0) && (! isForwardCheckpoint(level-1)))
 			{
-				assert(ignorekMers.count(kMer) > 0);
+				releaseForwardLevel(level-1);
 			}
 		}
+	}
 
-		assert(likelihood_all_kMers_0 <= 0);
+	double max_viterbi = -1;
+	int last_states = diploidStatesByLevel.at(levels-1);
+	for(int state = 0; state < last_states; state++)
+	{
+		if((max_viterbi == -1) || (fw_Viterbi.at(levels-1).at(state) > max_viterbi))
+		{
+			max_viterbi = fw_Viterbi.at(levels-1).at(state);
+		}
+	}
 
+	cout << "Best path optimality measure (log): " << max_viterbi << "\n";
 
-		if((level % 1000) == 0)
-		{
-			int startLevelFill = level;
-			int stopLevelFill = level + 1000 - 1;
+	return max_viterbi;
+}
 
-			cout << "Fill state transitions table from " << startLevelFill << " to " << stopLevelFill << "\n" << flush;
+void AlphaHMM::haploidPredecessors(int level, vector<int>& ret_start, vector<int>& ret_predecessors)
+{
+	assert(level > 0);
+	int haploidStates = haploidStatesByLevel.at(level).size();
+	int haploidStates_previous = haploidStatesByLevel.at(level-1).size();
 
-			int previousStepFillStop = startLevelFill - 1;
-			int previousStepFillStart = previousStepFillStop - 1000 + 1;
+	ret_start.assign(haploidStates + 1, 0);
+	for(int t = 0; t < haploidStates_previous; t++)
+	{
+		const vector<stateAlternative>& next = haploidStatesByLevel.at(level-1).at(t).next;
+		for(unsigned int jI = 0; jI < next.size(); jI++)
+		{
+			assert((next.at(jI).id >= 0) && (next.at(jI).id < haploidStates));
+			ret_start.at(next.at(jI).id + 1)++;
+		}
+	}
+	for(int s = 0; s < haploidStates; s++)
+	{
+		ret_start.at(s + 1) += ret_start.at(s);
+	}
 
-			fillStateTransitions(startLevelFill, stopLevelFill, previousStepFillStart, previousStepFillStop);
+	ret_predecessors.resize(ret_start.at(haploidStates));
+	vector<int> fill(ret_start.begin(), ret_start.end() - 1);
+	for(int t = 0; t < haploidStates_previous; t++)
+	{
+		const vector<stateAlternative>& next = haploidStatesByLevel.at(level-1).at(t).next;
+		for(unsigned int jI = 0; jI < next.size(); jI++)
+		{
+			ret_predecessors.at(fill.at(next.at(jI).id)++) = t;
 		}
+	}
+}
 
-		int states = diploidStatesByLevel.at(level);
+double AlphaHMM::fillForwardLevel_8(int level)
+{
+	double likelihood_all_kMers_0 = 0;
 
-		fw.at(level).resize(states);
-		fw_Viterbi.at(level).resize(states);
-		fw_Emission.at(level).resize(states);
-		fw_Viterbi_backtrack_int.at(level).resize(states);
+	string locusID = haploidStatesByLevel.at(level).at(0).e->locus_id;
 
-		//string locusID = haploidStatesByLevel.at(level).at(0).e->locus_id;
-		int gap_symbol = myGraph->CODE.doCode(locusID, "_");
-		int star_symbol = myGraph->CODE.doCode(locusID, "*");
+	assert(level < (int)kMersInGraphInfo.Level2Kmers.size());
+	for(vector<int>::iterator kMerIt = kMersInGraphInfo.Level2Kmers.at(level).begin(); kMerIt != kMersInGraphInfo.Level2Kmers.at(level).end(); kMerIt++)
+	{
+		int kMerID = *kMerIt;
+		if(utilizekMers.at(kMerID))
+		{
+			assert(forward_kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+			double log_likelihood_thisMer_if_underlying_0 = forward_logP_error.logP(1, forward_kMerCounts.at(kMerID));
+			assert(log_likelihood_thisMer_if_underlying_0 <= 0);
+			likelihood_all_kMers_0 += log_likelihood_thisMer_if_underlying_0;
+			forward_logL_count0.at(kMerID) = log_likelihood_thisMer_if_underlying_0;
+		}
+		else
+		{
+			assert(ignorekMers.at(kMerID));
+		}
+	}
 
-		if((level % 1000) == 0)
-			cout << "fillForwardBackwardTable level " << level << "/" << (levels-1) << " (first thread) \n" << flush;
+	assert(likelihood_all_kMers_0 <= 0);
 
-		int chunk_size = states / CONFIG.threads;
+	int states = diploidStatesByLevel.at(level);
 
-		double max_forward = 0;
-		bool set_max_forward_first_value = false;
+	fw.at(level).resize(states);
+	fw_Viterbi.at(level).resize(states);
+	fw_Emission.at(level).resize(states);
+	fw_Viterbi_backtrack_int.at(level).resize(states);
 
-		#pragma omp parallel
+	// utilized k-mers emitted by each haploid state, in order of emission code
+	int haploidStates = haploidStatesByLevel.at(level).size();
+	const vector<int>& locus_kMerIDs = myGraph->CODE.kMerIDsForLocus(locusID);
+	vector< vector<AlphaHMM_kMerEmission> > haploidStateEmissions(haploidStates);
+	for(int s = 0; s < haploidStates; s++)
+	{
+		Edge* e = haploidStatesByLevel.at(level).at(s).e;
+		assert(e->locus_id == locusID);
+		for(map<int, int>::iterator emissionIt = e->multiEmission.begin(); emissionIt != e->multiEmission.end(); emissionIt++)
 		{
-			assert(omp_get_num_threads() == CONFIG.threads);
-			int thisThread = omp_get_thread_num();
-			int firstPair = thisThread * chunk_size;
-			int lastPair = (thisThread+1) * chunk_size - 1;
-			if((thisThread == (CONFIG.threads-1)) && (lastPair < (states-1)))
+			assert(emissionIt->second >= 0);
+			int kMerID = locus_kMerIDs.at(emissionIt->first);
+			if((kMerID != -1) && utilizekMers.at(kMerID))
 			{
-				lastPair = states - 1;
+				AlphaHMM_kMerEmission emission;
+				emission.code = emissionIt->first;
+				emission.number = emissionIt->second;
+				emission.observed = forward_kMerCounts.at(kMerID);
+				emission.logL_count0 = forward_logL_count0.at(kMerID);
+				haploidStateEmissions.at(s).push_back(emission);
 			}
-			assert(lastPair <= (states - 1));
-
-			map<int, map<int, double> > _cache_poisson_PDF;
-			double local_max_forward = 0;
-			bool have_local_max_forward_value = false;
-
-			for(int state = firstPair; state <= lastPair; state++)
-			{
-
-				std::stringstream subst_cout;
-
-				int haploidStates = haploidStatesByLevel.at(level).size();
-				int s1 = state % haploidStates;
-				int s2 = state / haploidStates;
-
-				Edge* e1 = haploidStatesByLevel.at(level).at(s1).e;
-				Edge* e2 = haploidStatesByLevel.at(level).at(s2).e;
-
-				assert(e1->locus_id == e2->locus_id);
+		}
+	}
 
-				map<int, int> combinedCodedEdgeEmission = e1->multiEmission;
-				for(map<int, int>::iterator emissionIt = e2->multiEmission.begin(); emissionIt != e2->multiEmission.end(); emissionIt++)
-				{
-					int emissionSymbol = emissionIt->first;
-					int number = emissionIt->second;
+	// the predecessors of diploid state s1 + s2 * haploidStates are t1 + t2 * haploidStates_previous
+	// for all haploid predecessors t1 of s1 and t2 of s2 - diploid transitions are not needed here.
+	int haploidStates_previous = (level > 0) ? haploidStatesByLevel.at(level-1).size() : 0;
+	vector<int> predecessors_start;
+	vector<int> predecessors;
+	if(level > 0)
+	{
+		haploidPredecessors(level, predecessors_start, predecessors);
+	}
+	int haploidTransitions = predecessors.size();
+
+	// Diploid transitions are the Kronecker product of the haploid ones (all transition probabilities
+	// are taken to be 1, see sampleFromPosterior(..)). If worthwhile, sums and maxima over the first
+	// haplotype's predecessors are computed once per (s1, t2) and shared by all states with the same s1:
+	// haploidTransitions * (haploidStates + haploidStates_previous) instead of haploidTransitions^2
+	// operations. Forward sums are then added in a different order than in state order, so they may
+	// differ in the last bits; Viterbi values and backtracking are the same (ties go to the lowest state).
+	bool useKronecker = (level > 0) && ((haploidStates + haploidStates_previous) < haploidTransitions);
+	vector<double> firstHaplotype_fw;
+	vector<double> firstHaplotype_fwViterbi;
+	vector<int> firstHaplotype_fwViterbi_from;
+	if(useKronecker)
+	{
+		firstHaplotype_fw.resize(haploidStates * haploidStates_previous);
+		firstHaplotype_fwViterbi.resize(haploidStates * haploidStates_previous);
+		firstHaplotype_fwViterbi_from.resize(haploidStates * haploidStates_previous);
+	}
 
-					assert(number >= 0);
-					if(combinedCodedEdgeEmission.count(emissionSymbol) == 0)
-						combinedCodedEdgeEmission[emissionSymbol] = 0;
+	double max_forward = 0;
+	bool set_max_forward_first_value = false;
 
-					combinedCodedEdgeEmission[emissionSymbol] += number;
-				}
+	#pragma omp parallel
+	{
+		if(useKronecker)
+		{
+			const vector<double>& fw_previous = fw.at(level-1);
+			const vector<double>& fw_Viterbi_previous = fw_Viterbi.at(level-1);
 
-				combinedCodedEdgeEmission.erase(gap_symbol);
-				combinedCodedEdgeEmission.erase(star_symbol);
+			#pragma omp for schedule(dynamic, 16)
+			for(int i = 0; i < (haploidStates * haploidStates_previous); i++)
+			{
+				int s1 = i / haploidStates_previous;
+				int t2 = i % haploidStates_previous;
 
-				/*
-				map<string, int> combinedEdgeEmission;
-				for(set<string>::iterator kMerIt = utilizeKMersatLevel.begin(); kMerIt != utilizeKMersatLevel.end(); kMerIt++)
+				double sum_P = 0;
+				double max_P = -1;
+				int max_from = -1;
+				for(int pI = predecessors_start[s1]; pI < predecessors_start[s1 + 1]; pI++)
 				{
-					string kMerToUse = *kMerIt;
-					combinedEdgeEmission[kMerToUse] = 0;
-					int kMerSymbol = myGraph->CODE.doCode(e1->locus_id, kMerToUse);
-					if(combinedCodedEdgeEmission.count(kMerSymbol) > 0)
+					int from = predecessors[pI] + t2 * haploidStates_previous;
+					assert(fw_previous[from] >= 0);
+					sum_P += fw_previous[from];
+					if((max_from == -1) || (fw_Viterbi_previous[from] > max_P))
 					{
-						combinedEdgeEmission[kMerToUse] = combinedCodedEdgeEmission[kMerSymbol];
+						max_from = from;
+						max_P = fw_Viterbi_previous[from];
 					}
 				}
-				*/
-
-				double log_emission_p = likelihood_all_kMers_0;
-				assert(log_emission_p <= 0);
-
-				for(map<int, int>::iterator kMerIt = combinedCodedEdgeEmission.begin(); kMerIt != combinedCodedEdgeEmission.end(); kMerIt++)
-				{
-					if(utilizeCodedKMersatLevel.count(kMerIt->first) == 0)
-					{
-						continue;
-					}
-
-					string kMer = myGraph->CODE.deCode(e1->locus_id, kMerIt->first);
-
-					int underlyingCopyCount = kMerIt->second;
-					assert(underlyingCopyCount != 0);
-
-					assert(logL_count0.count(kMer) > 0);
-					assert(logL_count0[kMer] <= 0);
-
-					log_emission_p -= logL_count0[kMer];
-					assert(log_emission_p <= 0);
+				firstHaplotype_fw[i] = sum_P;
+				firstHaplotype_fwViterbi[i] = max_P;
+				firstHaplotype_fwViterbi_from[i] = max_from;
+			}
+		}
 
-					double rate = (double)underlyingCopyCount * coverage;
-					assert(globalEmission.count(kMer) > 0);
+		double local_max_forward = 0;
+		bool have_local_max_forward_value = false;
 
-					double thiskMer_P;
-					if((_cache_poisson_PDF.count(underlyingCopyCount) > 0) && (_cache_poisson_PDF.at(underlyingCopyCount).count(globalEmission[kMer]) > 0))
-					{
-						thiskMer_P = _cache_poisson_PDF[underlyingCopyCount][globalEmission[kMer]];
-					}
-					else
-					{
-						poisson_up poisson(rate);
-						thiskMer_P = pdf(poisson, globalEmission[kMer]);
-						_cache_poisson_PDF[underlyingCopyCount][globalEmission[kMer]] = thiskMer_P;
-					}
+		#pragma omp for schedule(dynamic, 64)
+		for(int state = 0; state < states; state++)
+		{
+			int s1 = state % haploidStates;
+			int s2 = state / haploidStates;
 
-					if(thiskMer_P == 0)
-					{
-						thiskMer_P = 1e-200;
-					}
+			const vector<AlphaHMM_kMerEmission>& emissions_1 = haploidStateEmissions.at(s1);
+			const vector<AlphaHMM_kMerEmission>& emissions_2 = haploidStateEmissions.at(s2);
 
-					assert(thiskMer_P > 0);
-					assert(thiskMer_P <= 1);
+			double log_emission_p = likelihood_all_kMers_0;
+			assert(log_emission_p <= 0);
 
-					log_emission_p += log(thiskMer_P);
-					assert(log_emission_p <= 0);
+			// merge the two states' emissions by code, summing the copies of shared k-mers
+			size_t i1 = 0;
+			size_t i2 = 0;
+			while((i1 < emissions_1.size()) || (i2 < emissions_2.size()))
+			{
+				const AlphaHMM_kMerEmission* emission;
+				int underlyingCopyCount;
+				if((i2 == emissions_2.size()) || ((i1 < emissions_1.size()) && (emissions_1[i1].code < emissions_2[i2].code)))
+				{
+					emission = &(emissions_1[i1]);
+					underlyingCopyCount = emission->number;
+					i1++;
 				}
-
-				// std::stringstream s_stdout;
-
-
-				if(level == 0)
+				else if((i1 == emissions_1.size()) || (emissions_2[i2].code < emissions_1[i1].code))
 				{
-					fw.at(level).at(state) = log(diploid_initialProbabilities.at(state));
-					assert(fw.at(level).at(state) <= 0);
-
-					fw_Viterbi.at(level).at(state) = log(diploid_initialProbabilities.at(state));
-					fw_Viterbi_backtrack_int.at(level).at(state) = -1;
+					emission = &(emissions_2[i2]);
+					underlyingCopyCount = emission->number;
+					i2++;
 				}
 				else
 				{
-					double max_jump_P = -1;
-					int max_jump_state = -1;
-					double combined_jump_P = 0;
-
-					assert(diploidStateTransitions_Reverse.at(level).at(state).size() > 0);
-
-					// s_stdout << "Compute combined_jump_P for state " << state << " at level " << level << "\n";
-
-					for(unsigned int sI2 = 0; sI2 < diploidStateTransitions_Reverse.at(level).at(state).size(); sI2++)
-					{
-						stateAlternative jumpState = diploidStateTransitions_Reverse.at(level).at(state).at(sI2);
-						int from = jumpState.id;
-						double jumpState_P = jumpState.p;
-						jumpState_P  = 1.0; // if we change this, we need to change it in the backwards sampling procedure as well!
-
-						double viterbiJumpP = fw_Viterbi.at(level-1).at(from) + log(jumpState_P);
-
-						if((max_jump_state == -1) || (viterbiJumpP > max_jump_P))
-						{
-							max_jump_state = from;
-							max_jump_P = viterbiJumpP;
-						}
+					emission = &(emissions_1[i1]);
+					underlyingCopyCount = emissions_1[i1].number + emissions_2[i2].number;
+					i1++;
+					i2++;
+				}
 
-						if(!(fw.at(level-1).at(from) >= 0))
-						{
-							// cout << "Error: !(fw.at(level-1).at(from) >= 0). Level: " << level << " from: " << from << " value: " << fw_Viterbi.at(level-1).at(from) << "\n" << flush;
-						}
+				assert(underlyingCopyCount != 0);
+				assert(emission->logL_count0 <= 0);
 
-						assert(fw.at(level-1).at(from) >= 0);
-						assert( jumpState_P >= 0);
+				log_emission_p -= emission->logL_count0;
+				assert(log_emission_p <= 0);
 
-						// s_stdout << "\t\t from " << from << ": " << fw.at(level-1).at(from) << ", jumpState_P " << jumpState_P << "\n";
+				double thiskMer_logP = forward_logP_coverage.logP(underlyingCopyCount, emission->observed);
+				assert(thiskMer_logP <= 0);
 
-						combined_jump_P += (fw.at(level-1).at(from) * jumpState_P);
-						assert(combined_jump_P >= 0);
-					}
+				log_emission_p += thiskMer_logP;
+				assert(log_emission_p <= 0);
+			}
 
-					assert(max_jump_state != -1);
+			if(level == 0)
+			{
+				double initialP = haploid_initialProbabilities.at(s1) * haploid_initialProbabilities.at(s2);
+				fw.at(level).at(state) = log(initialP);
+				assert(fw.at(level).at(state) <= 0);
 
-					assert(combined_jump_P >= 0);
+				fw_Viterbi.at(level).at(state) = log(initialP);
+				fw_Viterbi_backtrack_int.at(level).at(state) = -1;
+			}
+			else
+			{
+				double max_jump_P = -1;
+				int max_jump_state = -1;
+				double combined_jump_P = 0;
 
-					// s_stdout << "\tcombined_jump_P: " << combined_jump_P << "\n";
+				assert(predecessors_start[s1 + 1] > predecessors_start[s1]);
+				assert(predecessors_start[s2 + 1] > predecessors_start[s2]);
 
-					if(combined_jump_P == 0)
-					{
-						fw.at(level).at(state) = -1 * 1e100;
-					}
-					else
+				if(useKronecker)
+				{
+					for(int pI2 = predecessors_start[s2]; pI2 < predecessors_start[s2 + 1]; pI2++)
 					{
-						fw.at(level).at(state) = log(combined_jump_P);
+						int i = s1 * haploidStates_previous + predecessors[pI2];
+						if((max_jump_state == -1) || (firstHaplotype_fwViterbi[i] > max_jump_P))
+						{
+							max_jump_state = firstHaplotype_fwViterbi_from[i];
+							max_jump_P = firstHaplotype_fwViterbi[i];
+						}
+						combined_jump_P += firstHaplotype_fw[i];
 					}
-
-					// s_stdout << "\tfw.at(level).at(state) : " << fw.at(level).at(state)  << "\n\n";
-
-
-					//assert(fw.at(level).at(state) >= 0);
-
-					fw_Viterbi.at(level).at(state) = max_jump_P;
-					fw_Viterbi_backtrack_int.at(level).at(state) = max_jump_state;
-
 				}
-
-				assert(fw_Viterbi.at(level).at(state) <= 0);
-				assert(log_emission_p <= 0);
-
-				fw_Viterbi.at(level).at(state) += log_emission_p;
-				fw.at(level).at(state) += log_emission_p;
-
-				// assert(fw.at(level).at(state) <= 0);
-
-				/*
-					#pragma omp critical
+				else
+				{
+					const vector<double>& fw_previous = fw.at(level-1);
+					const vector<double>& fw_Viterbi_previous = fw_Viterbi.at(level-1);
+					for(int pI2 = predecessors_start[s2]; pI2 < predecessors_start[s2 + 1]; pI2++)
 					{
-						subst_cout << "log_emission_p: " << log_emission_p << "\n";
-						subst_cout << "fw.at(level).at(state): " << log_emission_p << "\n";
-						cout << s_stdout.str() << flush;
+						for(int pI1 = predecessors_start[s1]; pI1 < predecessors_start[s1 + 1]; pI1++)
+						{
+							int from = predecessors[pI1] + predecessors[pI2] * haploidStates_previous;
+							if((max_jump_state == -1) || (fw_Viterbi_previous[from] > max_jump_P))
+							{
+								max_jump_state = from;
+								max_jump_P = fw_Viterbi_previous[from];
+							}
+
+							assert(fw_previous[from] >= 0);
+							combined_jump_P += fw_previous[from];
+						}
 					}
-				*/
+				}
 
+				assert(max_jump_state != -1);
+				assert(combined_jump_P >= 0);
 
-				if((state == firstPair) || (fw.at(level).at(state) > local_max_forward))
+				if(combined_jump_P == 0)
 				{
-					local_max_forward = fw.at(level).at(state);
-					have_local_max_forward_value = true;
+					fw.at(level).at(state) = -1 * 1e100;
 				}
+				else
+				{
+					fw.at(level).at(state) = log(combined_jump_P);
+				}
+
+				fw_Viterbi.at(level).at(state) = max_jump_P;
+				fw_Viterbi_backtrack_int.at(level).at(state) = max_jump_state;
 			}
 
-			//assert(local_max_forward <= 0);
+			assert(fw_Viterbi.at(level).at(state) <= 0);
+			assert(log_emission_p <= 0);
 
+			fw_Emission.at(level).at(state) = log_emission_p;
+			fw_Viterbi.at(level).at(state) += log_emission_p;
+			fw.at(level).at(state) += log_emission_p;
 
-			#pragma omp critical
+			if((! have_local_max_forward_value) || (fw.at(level).at(state) > local_max_forward))
 			{
-				if(have_local_max_forward_value)
-				{
-					if((set_max_forward_first_value == false) || (local_max_forward > max_forward))
-					{
-						max_forward = local_max_forward;
-						set_max_forward_first_value = true;
-					}
-				}
+				local_max_forward = fw.at(level).at(state);
+				have_local_max_forward_value = true;
 			}
 		}
 
-		// cout << "\n\nmax_forward: " << max_forward << "\n";
-
-
-		/*
-		if(!(max_forward <= 0))
+		#pragma omp critical
 		{
-			cout << "Level: " << level << "\n";
-			cout << "max_forward: " << max_forward << "\n";
-			cout << "states: " << states << "\n" << flush;
+			if(have_local_max_forward_value)
+			{
+				if((set_max_forward_first_value == false) || (local_max_forward > max_forward))
+				{
+					max_forward = local_max_forward;
+					set_max_forward_first_value = true;
+				}
+			}
 		}
-		*/
 
-		// assert(max_forward <= 0);
+		#pragma omp barrier
 
-		#pragma omp parallel
+		#pragma omp for schedule(static)
+		for(int state = 0; state < states; state++)
 		{
-			assert(omp_get_num_threads() == CONFIG.threads);
-			int thisThread = omp_get_thread_num();
-			int firstPair = thisThread * chunk_size;
-			int lastPair = (thisThread+1) * chunk_size - 1;
-			if((thisThread == (CONFIG.threads-1)) && (lastPair < (states-1)))
-			{
-				lastPair = states - 1;
-			}
-			assert(lastPair <= (states - 1));
-
-			// std::stringstream subst_cout;
+			fw.at(level).at(state) = exp(fw.at(level).at(state) - max_forward);
+			assert(fw.at(level).at(state) >= 0);
+		}
+	}
 
-			for(int state = firstPair; state <= lastPair; state++)
-			{
-				// subst_cout << "Re-compute forward for state " << state << " at level " << level << "\n";
+	return max_forward;
+}
 
-				double fw_before = fw.at(level).at(state);
+bool AlphaHMM::isForwardCheckpoint(int level)
+{
+	int levels = diploidStatesByLevel.size();
+	return ((forwardCheckpointInterval == 0) || ((level % forwardCheckpointInterval) == 0) || (level == (levels-1)));
+}
 
-				/*
-				subst_cout << "\tfw_before " << fw_before <<  "\n";
-				subst_cout << "\tmax_forward " << max_forward <<  "\n";
-				subst_cout << "\texp(fw.at(level).at(state) - max_forward): " <<  exp(fw.at(level).at(state) - max_forward) << "\n";
-				*/
+void AlphaHMM::releaseForwardLevel(int level)
+{
+	vector<double>().swap(fw.at(level));
+	vector<double>().swap(fw_Viterbi.at(level));
+	vector<double>().swap(fw_Emission.at(level));
+	vector<int>().swap(fw_Viterbi_backtrack_int.at(level));
+}
 
-				fw.at(level).at(state) = exp(fw.at(level).at(state) - max_forward);
+void AlphaHMM::requireForwardLevel(int level)
+{
+	if((forwardCheckpointInterval == 0) || (fw.at(level).size() > 0))
+	{
+		return;
+	}
 
-				// subst_cout << "\fw.at(level).at(state) " << fw.at(level).at(state) <<  "\n";
+	assert(genotypingMode == 8);
+	assert(! isForwardCheckpoint(level));
 
-				if(!(fw.at(level).at(state) >= 0))
-				{
-					/*
-					#pragma omp critical
-					{
-					cout << "!(fw.at(level).at(state) >= 0)\n";
-					cout << "level: " << level << "\n";
-					cout << "state: " << state << "\n";
-					cout << "fw_before: " << fw_before << "\n";
-					cout << "max_forward: " << max_forward << "\n";
-					cout << "fw.at(level).at(state): " << fw.at(level).at(state) << "\n";
-					cout << "\n" << flush;
-					}
-					*/
-				}
-				assert(fw.at(level).at(state) >= 0);
-			}
+	int levels = diploidStatesByLevel.size();
 
-			#pragma omp critical
-			{
-				//cout << subst_cout.str() << "\n" << flush;
-			}
+	// only one recomputed segment is kept
+	if(forwardSegmentStart != -1)
+	{
+		for(int l = forwardSegmentStart + 1; l <= forwardSegmentStop; l++)
+		{
+			releaseForwardLevel(l);
 		}
+	}
 
-		fw_underflow_factor += max_forward;
+	int checkpointLevel = (level / forwardCheckpointInterval) * forwardCheckpointInterval;
+	int segmentStop = checkpointLevel + forwardCheckpointInterval - 1;
+	if(segmentStop > (levels - 2))
+	{
+		segmentStop = levels - 2;
 	}
+	assert(level > checkpointLevel);
+	assert(level <= segmentStop);
+	assert(fw.at(checkpointLevel).size() > 0);
 
-	double max_viterbi = -1;
-	int last_states = diploidStatesByLevel.at(levels-1);
-	for(int state = 0; state < last_states; state++)
+	for(int l = checkpointLevel + 1; l <= segmentStop; l++)
 	{
-		if((max_viterbi == -1) || (fw_Viterbi.at(levels-1).at(state) > max_viterbi))
-		{
-			max_viterbi = fw_Viterbi.at(levels-1).at(state);
-		}
+		fillForwardLevel_8(l);
+		vector<double>().swap(fw_Emission.at(l));
 	}
 
-	cout << "Best path optimality measure (log): " << max_viterbi << "\n";
+	forwardSegmentStart = checkpointLevel;
+	forwardSegmentStop = segmentStop;
+}
 
-	return max_viterbi;
+void AlphaHMM::setForwardCheckpoints(bool use)
+{
+	if(use && (genotypingMode != 8))
+	{
+		cerr << "Forward checkpoints are only available in genotyping mode 8 - ignored.\n";
+		use = false;
+	}
+	useForwardCheckpoints = use;
+}
+
+void AlphaHMM::setForwardEmissionsFile(string file)
+{
+	forwardEmissionsFile = file;
 }
 
 void AlphaHMM::fillStateTransitions(int startLevelFill, int stopLevelFill, int previousStepFillStop, int previousStepFillStart)
@@ -2071,33 +2284,12 @@ diploidEdgePointerPath AlphaHMM::sampleFromPosterior(map<string, long long>& obs
 	int currentState = -1;
 	int currentLevel = levels - 1;
 
-	int currentFillStart = -1;
-	int currentFillStop = -1;
+	vector<int> predecessors_start;
+	vector<int> predecessors;
 
 	while(currentLevel >= 0)
 	{
-		int states = diploidStatesByLevel.at(currentLevel);
-
-		if((currentFillStart == -1) || (currentLevel == (currentFillStart + 1)))
-		{
-			int newFillStart = currentLevel - 1000;
-			int newFillStop = currentLevel;
-			if(newFillStart < 0)
-			{
-				newFillStart = 0;
-			}
-			if(newFillStop < 0)
-			{
-				newFillStop = 0;
-			}
-			if(newFillStop >= levels)
-			{
-				newFillStop = levels - 1;
-			}
-			fillStateTransitions(newFillStart, newFillStop, currentFillStart, currentFillStop);
-			currentFillStart = newFillStart;
-			currentFillStop = newFillStop;
-		}
+		requireForwardLevel(currentLevel);
 
 		if(currentLevel == (levels - 1))
 		{
@@ -2108,15 +2300,22 @@ diploidEdgePointerPath AlphaHMM::sampleFromPosterior(map<string, long long>& obs
 			int previousState = currentState;
 			vector<double> alternatives_P;
 			vector<int> alternatives_stateI;
-			for(unsigned int sI2 = 0; sI2 < diploidStateTransitions_Reverse.at(currentLevel+1).at(previousState).size(); sI2++)
-			{
-				stateAlternative jumpState = diploidStateTransitions_Reverse.at(currentLevel+1).at(previousState).at(sI2);
-				int from = jumpState.id;
-				double jumpState_P = jumpState.p;
-				jumpState_P  = 1.0; // if we change this, we need to change it in the backwards sampling procedure as well!
 
-				alternatives_P.push_back(jumpState_P * fw.at(currentLevel).at(from));
-				alternatives_stateI.push_back(from);
+			// diploid predecessors of previousState in ascending order, from the haploid ones (as in
+			// the forward pass, transition probabilities are taken to be 1)
+			haploidPredecessors(currentLevel+1, predecessors_start, predecessors);
+			int haploidStates_next = haploidStatesByLevel.at(currentLevel+1).size();
+			int haploidStates = haploidStatesByLevel.at(currentLevel).size();
+			int previous_s1 = previousState % haploidStates_next;
+			int previous_s2 = previousState / haploidStates_next;
+			for(int pI2 = predecessors_start.at(previous_s2); pI2 < predecessors_start.at(previous_s2 + 1); pI2++)
+			{
+				for(int pI1 = predecessors_start.at(previous_s1); pI1 < predecessors_start.at(previous_s1 + 1); pI1++)
+				{
+					int from = predecessors.at(pI1) + predecessors.at(pI2) * haploidStates;
+					alternatives_P.push_back(fw.at(currentLevel).at(from));
+					alternatives_stateI.push_back(from);
+				}
 			}
 
 			int currentState_vectorI = Utilities::chooseFromVector(alternatives_P);
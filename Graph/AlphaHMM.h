@@ -7,11 +7,46 @@
 #include "MultiHMM.h"
 #include <vector>
 #include <map>
+#include <string>
+#include <assert.h>
 #include "../LocusCodeAllocation.h"
 #include "../MHC-PRG.h"
 
 
 
+// log pdf(Poisson(copies * ratePerCopy), observed) for copies 1..maxCopies and observed 0..maxObserved,
+// see AlphaHMM::fillForwardBackwardTable_8(..). Pairs outside the table are computed directly. With
+// clipZero, a density of 0 is taken to be 1e-200 (as in the forward pass).
+class AlphaHMM_logPoissonTable
+{
+protected:
+	double ratePerCopy;
+	int maxCopies;
+	long long maxObserved;
+	bool clipZero;
+	vector<double> table;
+
+	double compute(int copies, long long observed) const;
+
+public:
+	AlphaHMM_logPoissonTable();
+	AlphaHMM_logPoissonTable(double pRatePerCopy, int pMaxCopies, long long pMaxObserved, bool pClipZero);
+
+	double logP(int copies, long long observed) const
+	{
+		assert(copies >= 1);
+		assert(observed >= 0);
+		if((copies <= maxCopies) && (observed <= maxObserved))
+		{
+			return table[(size_t)(copies - 1) * (size_t)(maxObserved + 1) + observed];
+		}
+		else
+		{
+			return compute(copies, observed);
+		}
+	}
+};
+
 struct multiHaplotypePair_and_P
 {
 	multiHaploLabelPair haploPair;
@@ -36,7 +71,7 @@ protected:
 	vector<int> diploidStatesByLevel;
 
 	int maxStateKMerCount;
-	set<string> interestingKMerStrings;
+	set<int> interestingKMerIDs;
 	vector< vector< map<int, int> > > diploidStateEmissions;
 	vector< vector< vector<stateAlternative> > > diploidStateTransitions;
 
@@ -62,25 +97,50 @@ protected:
 	int haploidEdgeLength(int level);
 	int haploidEdgeValidLength(int level, int diploidIndex, int e12);
 
-	double fillForwardBackwardTable_0(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_1(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_2(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_3(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_4(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_5(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_6(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_7(map<string, long long> globalEmission);
-	double fillForwardBackwardTable_8(map<string, long long> globalEmission);
+	double fillForwardBackwardTable_0(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_1(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_2(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_3(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_4(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_5(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_6(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_7(map<string, long long>& globalEmission);
+	double fillForwardBackwardTable_8(map<string, long long>& globalEmission);
 
-	set<string> utilizekMers;
-	set<string> ignorekMers;
+	// by k-mer ID
+	vector<bool> utilizekMers;
+	vector<bool> ignorekMers;
 
 	kMerPositionInfo kMersInGraphInfo;
-	set<string> kMersInGraph;
+	vector<int> kMersInGraph;
 	kMerUniquenessInfo uniqueMers;
 	double error_rate;
 	double coverage;
 
+	// mode 8 emission model, kept so that forward levels can be recomputed
+	vector<long long> forward_kMerCounts;
+	vector<double> forward_logL_count0;
+	AlphaHMM_logPoissonTable forward_logP_coverage;
+	AlphaHMM_logPoissonTable forward_logP_error;
+	double fillForwardLevel_8(int level);
+
+	// haploid states at level-1 preceding those at level (CSR, in ascending order): the predecessors of
+	// haploid state s are ret_predecessors[ret_start[s] .. ret_start[s+1])
+	void haploidPredecessors(int level, vector<int>& ret_start, vector<int>& ret_predecessors);
+
+	// Forward checkpoints (mode 8): fw, fw_Viterbi and fw_Viterbi_backtrack_int are only kept for every
+	// forwardCheckpointInterval-th level and the last level (0: all levels). The levels in between are
+	// recomputed from the preceding checkpoint one segment at a time when needed, so that the Viterbi
+	// traceback and each posterior sample cost one additional forward pass.
+	bool useForwardCheckpoints;
+	int forwardCheckpointInterval;
+	int forwardSegmentStart;
+	int forwardSegmentStop;
+	string forwardEmissionsFile;
+	bool isForwardCheckpoint(int level);
+	void releaseForwardLevel(int level);
+	void requireForwardLevel(int level);
+
 public:
 
 	map<Edge*, int> Edge2Int;
@@ -120,8 +180,16 @@ public:
 	AlphaHMM(MultiGraph* g, bool verbose=true);
 	AlphaHMM(MultiGraph* g, int pGenotypingMode, bool verbose=true);
 
-	static map<string, long long> estimateEmissions(string kMerCountsSamplePath, string kMerCountsGenomePath, int kMerSize);
-	double fillForwardBackwardTable(map<string, long long> globalEmission);
+	// kMer count files are text ("kMer count" per line) or kMerCountsFile (see convertkMerCounts mode);
+	// if graph is given, only its kMers (and the metadata) are kept
+	static map<string, long long> estimateEmissions(string kMerCountsSamplePath, string kMerCountsGenomePath, int kMerSize, MultiGraph* graph = 0);
+	double fillForwardBackwardTable(map<string, long long>& globalEmission);
+
+	// mode 8 only; call before fillForwardBackwardTable(..). Checkpoints use ~sqrt(levels) stored levels
+	// (fw_Emission is then not kept); the emissions file receives one line per level with the log
+	// emission probabilities of all diploid states.
+	void setForwardCheckpoints(bool use);
+	void setForwardEmissionsFile(string file);
 
 	multiHaplotypePair_and_P retrieveViterbiSample(bool labelOnly);
 	diploidEdgePointerPath sampleFromPosterior(map<string, long long>& observedEmissions);
@@ -137,7 +205,7 @@ public:
 
 	int getGenotypingMode();
 
-	void debug(map<string, long long> globalEmission);
+	void debug(map<string, long long>& globalEmission);
 
 };
 
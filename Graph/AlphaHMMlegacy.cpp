@@ -29,7 +29,7 @@ typedef boost::math::poisson_distribution< double, policy < discrete_quantile <
 
 
 
-double AlphaHMM::fillForwardBackwardTable_5(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_5(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 5);
 
@@ -633,7 +633,7 @@ double AlphaHMM::fillForwardBackwardTable_5(map<string, long long> globalEmissio
 	return max_viterbi;
 }
 
-double AlphaHMM::fillForwardBackwardTable_6(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_6(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 6);
 
@@ -671,7 +671,7 @@ double AlphaHMM::fillForwardBackwardTable_6(map<string, long long> globalEmissio
 	kMerUniquenessInfo uniqueMers = myGraph->kMerUniqueness();
 
 	cout << levels << " Levels\n";
-	cout << uniqueMers.levelUniqueKMers.size() << " graph-unique kMers\n";
+	cout << uniqueMers.levelUniqueKMers_count << " graph-unique kMers\n";
 
 	int grand_total_edge_length = 0;
 
@@ -874,8 +874,8 @@ double AlphaHMM::fillForwardBackwardTable_6(map<string, long long> globalEmissio
 
 					if(cache_kMerSymbolUnique.count(kMerSymbol) == 0)
 					{
-						string kMer = myGraph->CODE.deCode(e1->locus_id, kMerSymbol);
-						cache_kMerSymbolUnique[kMerSymbol] = (uniqueMers.levelUniqueKMers.count(kMer) > 0) ? true : false;
+						int kMerID = myGraph->CODE.kMerID(e1->locus_id, kMerSymbol);
+						cache_kMerSymbolUnique[kMerSymbol] = ((kMerID != -1) && uniqueMers.levelUniqueKMers.at(kMerID)) ? true : false;
 					}
 
 					bool kMerUnique = cache_kMerSymbolUnique[kMerSymbol];
@@ -1277,7 +1277,7 @@ double AlphaHMM::fillForwardBackwardTable_6(map<string, long long> globalEmissio
 }
 
 
-double AlphaHMM::fillForwardBackwardTable_7(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_7(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 7);
 
@@ -2270,7 +2270,7 @@ double AlphaHMM::fillForwardBackwardTable_7(map<string, long long> globalEmissio
 	return max_viterbi;
 }
 
-double AlphaHMM::fillForwardBackwardTable_2(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_2(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 2);
 
@@ -2690,7 +2690,7 @@ double AlphaHMM::fillForwardBackwardTable_2(map<string, long long> globalEmissio
 	return max_viterbi;
 }
 
-double AlphaHMM::fillForwardBackwardTable_3(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_3(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 3);
 
@@ -3116,7 +3116,7 @@ double AlphaHMM::fillForwardBackwardTable_3(map<string, long long> globalEmissio
 }
 
 
-double AlphaHMM::fillForwardBackwardTable_4(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_4(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 4);
 
@@ -3666,7 +3666,7 @@ double AlphaHMM::fillForwardBackwardTable_4(map<string, long long> globalEmissio
 }
 
 
-double AlphaHMM::fillForwardBackwardTable_1(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_1(map<string, long long>& globalEmission)
 {
 
 	assert(genotypingMode == 1);
@@ -4132,7 +4132,7 @@ double AlphaHMM::fillForwardBackwardTable_1(map<string, long long> globalEmissio
 }
 
 
-double AlphaHMM::fillForwardBackwardTable_0(map<string, long long> globalEmission)
+double AlphaHMM::fillForwardBackwardTable_0(map<string, long long>& globalEmission)
 {
 	assert(genotypingMode == 0);
 
@@ -0,0 +1,67 @@
+/*
+ * FrozenGraph.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "FrozenGraph.h"
+
+const unsigned int FrozenGraph::noEdge;
+
+FrozenGraph::FrozenGraph(Graph* graph) : g(graph) {
+	level_first_node.push_back(0);
+	node_first_outgoing.push_back(0);
+	node_first_incoming.push_back(0);
+
+	if(g == 0)
+		return;
+
+	unsigned int levels = g->NodesPerLevel.size();
+	nodes.reserve(g->Nodes.size());
+	edges.reserve(g->Edges.size());
+	node_ids.reserve(g->Nodes.size());
+	edge_ids.reserve(g->Edges.size());
+
+	for(unsigned int levelI = 0; levelI < levels; levelI++)
+	{
+		for(set<Node*>::iterator nodeIt = g->NodesPerLevel.at(levelI).begin(); nodeIt != g->NodesPerLevel.at(levelI).end(); nodeIt++)
+		{
+			Node* n = *nodeIt;
+			node_ids[n] = nodes.size();
+			nodes.push_back(n);
+			node_level.push_back(levelI);
+		}
+		level_first_node.push_back(nodes.size());
+	}
+
+	for(unsigned int nodeI = 0; nodeI < nodes.size(); nodeI++)
+	{
+		Node* n = nodes.at(nodeI);
+		for(set<Edge*>::iterator edgeIt = n->Outgoing_Edges.begin(); edgeIt != n->Outgoing_Edges.end(); edgeIt++)
+		{
+			Edge* e = *edgeIt;
+			assert(e->From == n);
+
+			std::string emission = g->CODE.deCode(e->locus_id, e->emission);
+			assert(emission.length() == 1);
+
+			edge_ids[e] = edges.size();
+			edges.push_back(e);
+			edge_from.push_back(nodeI);
+			edge_to.push_back(node_ids.at(e->To));
+			edge_emission.push_back(emission.at(0));
+		}
+		node_first_outgoing.push_back(edges.size());
+	}
+
+	incoming_edges.reserve(edges.size());
+	for(unsigned int nodeI = 0; nodeI < nodes.size(); nodeI++)
+	{
+		Node* n = nodes.at(nodeI);
+		for(set<Edge*>::iterator edgeIt = n->Incoming_Edges.begin(); edgeIt != n->Incoming_Edges.end(); edgeIt++)
+		{
+			incoming_edges.push_back(edge_ids.at(*edgeIt));
+		}
+		node_first_incoming.push_back(incoming_edges.size());
+	}
+}
@@ -0,0 +1,182 @@
+/*
+ * FrozenGraph.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef FROZENGRAPH_H_
+#define FROZENGRAPH_H_
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <limits>
+#include <assert.h>
+
+#include "Graph.h"
+#include "Node.h"
+#include "Edge.h"
+
+using namespace std;
+
+// Immutable, compact view of a loaded Graph, for code that traverses the graph millions of times
+// (the aligners). Nodes and edges get integer IDs:
+// - nodes are numbered level by level, and within a level in the order of Graph::NodesPerLevel,
+//   so that the node ID of (level, z) is levelFirstNode(level) + z.
+// - edges are numbered node by node, and within a node in the order of Node::Outgoing_Edges, so
+//   that the outgoing edges of a node form one contiguous ID range.
+//   Incoming edges are kept in a separate CSR index, in the order of Node::Incoming_Edges.
+// Edge emissions are decoded once, into single characters.
+// Code that traverses the graph should work on these IDs throughout; nodeID(Node*) and edgeID(Edge*)
+// are hash lookups, meant for translating Node*/Edge* at interface boundaries only.
+// The Graph must not be modified while a FrozenGraph for it is in use.
+class FrozenGraph {
+protected:
+	Graph* g;
+
+	vector<unsigned int> level_first_node;
+	vector<Node*> nodes;
+	vector<unsigned int> node_level;
+	vector<unsigned int> node_first_outgoing;
+	vector<unsigned int> node_first_incoming;
+	vector<unsigned int> incoming_edges;
+
+	vector<Edge*> edges;
+	vector<unsigned int> edge_from;
+	vector<unsigned int> edge_to;
+	vector<char> edge_emission;
+
+	unordered_map<Node*, unsigned int> node_ids;
+	unordered_map<Edge*, unsigned int> edge_ids;
+
+public:
+	// "no edge", for places that store an optional edge ID (e.g. steps that are gaps in the graph)
+	static const unsigned int noEdge = std::numeric_limits<unsigned int>::max();
+
+	FrozenGraph(Graph* graph);
+
+	Graph* getGraph() const
+	{
+		return g;
+	}
+
+	unsigned int levels() const
+	{
+		return level_first_node.size() - 1;
+	}
+	unsigned int statesAtLevel(unsigned int level) const
+	{
+		return level_first_node[level+1] - level_first_node[level];
+	}
+	unsigned int levelFirstNode(unsigned int level) const
+	{
+		return level_first_node[level];
+	}
+
+	// nodes
+
+	unsigned int nodeCount() const
+	{
+		return nodes.size();
+	}
+	Node* node(unsigned int nodeID) const
+	{
+		return nodes[nodeID];
+	}
+	unsigned int nodeID(Node* n) const
+	{
+		assert(node_ids.count(n));
+		return node_ids.at(n);
+	}
+	unsigned int nodeLevel(unsigned int nodeID) const
+	{
+		return node_level[nodeID];
+	}
+	unsigned int nodeZ(unsigned int nodeID) const
+	{
+		return nodeID - level_first_node[node_level[nodeID]];
+	}
+
+	// outgoing edges of a node: IDs firstOutgoing(nodeID) .. (endOutgoing(nodeID) - 1)
+	unsigned int firstOutgoing(unsigned int nodeID) const
+	{
+		return node_first_outgoing[nodeID];
+	}
+	unsigned int endOutgoing(unsigned int nodeID) const
+	{
+		return node_first_outgoing[nodeID+1];
+	}
+
+	// incoming edges of a node: incomingEdge(i) for i = firstIncoming(nodeID) .. (endIncoming(nodeID) - 1)
+	unsigned int firstIncoming(unsigned int nodeID) const
+	{
+		return node_first_incoming[nodeID];
+	}
+	unsigned int endIncoming(unsigned int nodeID) const
+	{
+		return node_first_incoming[nodeID+1];
+	}
+	unsigned int incomingEdge(unsigned int i) const
+	{
+		return incoming_edges[i];
+	}
+
+	// edges in extension direction - outgoing edges if forward, incoming edges otherwise:
+	// directedEdge(i, forward) for i = firstDirected(nodeID, forward) .. (endDirected(nodeID, forward) - 1)
+	unsigned int firstDirected(unsigned int nodeID, bool forward) const
+	{
+		return (forward ? node_first_outgoing[nodeID] : node_first_incoming[nodeID]);
+	}
+	unsigned int endDirected(unsigned int nodeID, bool forward) const
+	{
+		return (forward ? node_first_outgoing[nodeID+1] : node_first_incoming[nodeID+1]);
+	}
+	unsigned int directedEdge(unsigned int i, bool forward) const
+	{
+		return (forward ? i : incoming_edges[i]);
+	}
+	// the node an edge leads to in extension direction
+	unsigned int directedTarget(unsigned int edgeID, bool forward) const
+	{
+		return (forward ? edge_to[edgeID] : edge_from[edgeID]);
+	}
+
+	// edges
+
+	unsigned int edgeCount() const
+	{
+		return edges.size();
+	}
+	Edge* edge(unsigned int edgeID) const
+	{
+		return edges[edgeID];
+	}
+	unsigned int edgeID(Edge* e) const
+	{
+		assert(edge_ids.count(e));
+		return edge_ids.at(e);
+	}
+	unsigned int edgeFrom(unsigned int edgeID) const
+	{
+		return edge_from[edgeID];
+	}
+	unsigned int edgeTo(unsigned int edgeID) const
+	{
+		return edge_to[edgeID];
+	}
+	char edgeEmission(unsigned int edgeID) const
+	{
+		return edge_emission[edgeID];
+	}
+	bool edgeIsGap(unsigned int edgeID) const
+	{
+		return (edge_emission[edgeID] == '_');
+	}
+	// level of the node the edge starts from
+	unsigned int edgeLevel(unsigned int edgeID) const
+	{
+		return node_level[edge_from[edgeID]];
+	}
+};
+
+#endif /* FROZENGRAPH_H_ */
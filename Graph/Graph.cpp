@@ -17,6 +17,11 @@
 #include <boost/lexical_cast.hpp>
 #include <stdlib.h>
 #include <time.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 typedef std::basic_string <unsigned char> ustring;
 
@@ -486,6 +491,7 @@ void Graph::unRegisterEdge(Edge* e)
 	assert(Edges.count(e) > 0);
 	Edges.erase(e);
 	delete(e);
+	EdgesInFileOrder.clear();
 }
 
 void Graph::registerNode(Node* n, unsigned int level)
@@ -808,6 +814,7 @@ void Graph::registerEdge(Edge* e)
 {
 	assert(Edges.count(e) == 0);
 	Edges.insert(e);
+	EdgesInFileOrder.clear();
 }
 
 
@@ -1190,7 +1197,358 @@ void Graph::writeToFile(string filename)
 	}
 }
 
+/*
+ * Binary graph format (graph.bin), version 1. All integers are native-endian; the byte order
+ * mark lets readers reject files written on a machine with different endianness.
+ *
+ *	char[8]		"MHCPRGGB"
+ *	uint32		version
+ *	uint32		byte order mark 0x01020304
+ *	uint32		number of CODE lines, then each line as string
+ *	uint32		number of locus IDs, then each locus ID as string
+ *	uint32		number of nodes, then per node: uint32 level, uint8 terminal
+ *	uint32		number of edges, then per edge: uint32 from node, uint32 to node, uint32 locus ID index,
+ *				uint8 emission, uint8 pgf_protect, double count, string label
+ *
+ * Strings are stored as uint32 length followed by the characters. Edges are stored in
+ * EdgesInFileOrder order and nodes are numbered by first touch in that order (see writeToBinaryFile).
+ *
+ * The file is mmap'ed for reading, but readFromBinaryFile still builds the usual Node/Edge
+ * objects and edge sets from it - it replaces the text parser, it is not a zero-copy view.
+ */
+
+static const char binaryGraph_magic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'G', 'B'};
+static const unsigned int binaryGraph_version = 1;
+static const unsigned int binaryGraph_byteOrderMark = 0x01020304;
+
+class binaryGraphWriter {
+public:
+	std::string buffer;
+
+	template<typename T>
+	void put(T value)
+	{
+		buffer.append((const char*)&value, sizeof(T));
+	}
+
+	void putString(const string& S)
+	{
+		put<unsigned int>(S.length());
+		buffer.append(S);
+	}
+};
+
+class binaryGraphReader {
+public:
+	const char* position;
+	const char* end;
+
+	binaryGraphReader(const char* begin, size_t size) : position(begin), end(begin + size)
+	{
+
+	}
+
+	template<typename T>
+	T get()
+	{
+		if((size_t)(end - position) < sizeof(T))
+			errEx("Binary graph file is truncated.");
+		T value;
+		memcpy(&value, position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	string getString()
+	{
+		unsigned int length = get<unsigned int>();
+		if((size_t)(end - position) < length)
+			errEx("Binary graph file is truncated.");
+		string S(position, length);
+		position += length;
+		return S;
+	}
+};
+
+string Graph::binaryFilename(string filename)
+{
+	string txt = ".txt";
+	if((filename.length() >= txt.length()) && (filename.substr(filename.length() - txt.length()) == txt))
+	{
+		return filename.substr(0, filename.length() - txt.length()) + ".bin";
+	}
+	return filename + ".bin";
+}
+
+void Graph::writeToBinaryFile(string filename)
+{
+	checkConsistency(false);
+
+	binaryGraphWriter output;
+	output.buffer.append(binaryGraph_magic, sizeof(binaryGraph_magic));
+	output.put<unsigned int>(binaryGraph_version);
+	output.put<unsigned int>(binaryGraph_byteOrderMark);
+
+	vector<string> linesFromCode = CODE.serializeIntoVector();
+	output.put<unsigned int>(linesFromCode.size());
+	for(unsigned int lineI = 0; lineI < linesFromCode.size(); lineI++)
+	{
+		output.putString(linesFromCode.at(lineI));
+	}
+
+	// Edges are written in the order of the file the graph was read from, and nodes are numbered
+	// in the order in which these edges first touch them. Reading the binary file thus gives the
+	// same EdgesInFileOrder as reading the text file, and converting the same file twice gives
+	// identical binary files. Graphs not read from a file fall back to the order of the edge set.
+	vector<Edge*> edgesInOrder;
+	if(EdgesInFileOrder.size() == Edges.size())
+	{
+		edgesInOrder = EdgesInFileOrder;
+	}
+	else
+	{
+		edgesInOrder.assign(Edges.begin(), Edges.end());
+	}
+
+	map<string, unsigned int> locusIndex;
+	vector<string> loci;
+	map<Node*, unsigned int> nodeIndex;
+	vector<Node*> nodesInOrder;
+	nodesInOrder.reserve(Nodes.size());
+	for(unsigned int edgeI = 0; edgeI < edgesInOrder.size(); edgeI++)
+	{
+		Edge* e = edgesInOrder.at(edgeI);
+		assert(Edges.count(e) > 0);
+		if(locusIndex.count(e->locus_id) == 0)
+		{
+			locusIndex[e->locus_id] = loci.size();
+			loci.push_back(e->locus_id);
+		}
+		Node* touched[2] = {e->From, e->To};
+		for(unsigned int nI = 0; nI < 2; nI++)
+		{
+			if(nodeIndex.count(touched[nI]) == 0)
+			{
+				unsigned int n_index = nodesInOrder.size();
+				nodeIndex[touched[nI]] = n_index;
+				nodesInOrder.push_back(touched[nI]);
+			}
+		}
+	}
+	for(set<Node*>::iterator nodeIt = Nodes.begin(); nodeIt != Nodes.end(); nodeIt++)
+	{
+		Node* n = *nodeIt;
+		if(nodeIndex.count(n) == 0)
+		{
+			unsigned int n_index = nodesInOrder.size();
+			nodeIndex[n] = n_index;
+			nodesInOrder.push_back(n);
+		}
+	}
+
+	output.put<unsigned int>(loci.size());
+	for(unsigned int locusI = 0; locusI < loci.size(); locusI++)
+	{
+		output.putString(loci.at(locusI));
+	}
+
+	output.put<unsigned int>(nodesInOrder.size());
+	for(unsigned int nodeI = 0; nodeI < nodesInOrder.size(); nodeI++)
+	{
+		Node* n = nodesInOrder.at(nodeI);
+		output.put<unsigned int>(n->level);
+		output.put<unsigned char>(n->terminal);
+	}
+
+	output.put<unsigned int>(edgesInOrder.size());
+	for(unsigned int edgeI = 0; edgeI < edgesInOrder.size(); edgeI++)
+	{
+		Edge* e = edgesInOrder.at(edgeI);
+
+		output.put<unsigned int>(nodeIndex.at(e->From));
+		output.put<unsigned int>(nodeIndex.at(e->To));
+		output.put<unsigned int>(locusIndex.at(e->locus_id));
+		output.put<unsigned char>(e->emission);
+		output.put<unsigned char>(e->pgf_protect);
+		output.put<double>(e->count);
+		output.putString(e->label);
+	}
+
+	ofstream outputStream;
+	outputStream.open (filename.c_str(), ios::out | ios::trunc | ios::binary);
+	if (outputStream.is_open())
+	{
+		outputStream.write(output.buffer.data(), output.buffer.size());
+		outputStream.close();
+	}
+	else
+	{
+		errEx("Cannot open output file for binary graph serialization: "+filename);
+	}
+}
+
+void Graph::readFromBinaryFile(string filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+	{
+		errEx("Cannot open binary graph file: "+filename);
+	}
+
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0)
+	{
+		errEx("Cannot stat binary graph file: "+filename);
+	}
+	size_t fileSize = fileInfo.st_size;
+
+	void* mapped = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	if(mapped == MAP_FAILED)
+	{
+		errEx("Cannot mmap binary graph file: "+filename);
+	}
+	close(fd);
+
+	binaryGraphReader input((const char*)mapped, fileSize);
+
+	char magic[sizeof(binaryGraph_magic)];
+	for(unsigned int i = 0; i < sizeof(binaryGraph_magic); i++)
+	{
+		magic[i] = input.get<char>();
+	}
+	if(memcmp(magic, binaryGraph_magic, sizeof(binaryGraph_magic)) != 0)
+	{
+		errEx("Not a binary graph file: "+filename);
+	}
+	if(input.get<unsigned int>() != binaryGraph_version)
+	{
+		errEx("Unsupported binary graph file version, please re-create: "+filename);
+	}
+	if(input.get<unsigned int>() != binaryGraph_byteOrderMark)
+	{
+		errEx("Binary graph file was written with a different byte order: "+filename);
+	}
+
+	unsigned int codeLines = input.get<unsigned int>();
+	vector<string> linesForCode;
+	linesForCode.reserve(codeLines);
+	for(unsigned int lineI = 0; lineI < codeLines; lineI++)
+	{
+		linesForCode.push_back(input.getString());
+	}
+	CODE.readFromVector(linesForCode);
+
+	unsigned int lociCount = input.get<unsigned int>();
+	vector<string> loci;
+	loci.reserve(lociCount);
+	for(unsigned int locusI = 0; locusI < lociCount; locusI++)
+	{
+		loci.push_back(input.getString());
+	}
+
+	unsigned int nodeCount = input.get<unsigned int>();
+	vector<Node*> idx2Node;
+	idx2Node.reserve(nodeCount);
+	for(unsigned int nodeI = 0; nodeI < nodeCount; nodeI++)
+	{
+		unsigned int level = input.get<unsigned int>();
+		bool terminal = input.get<unsigned char>();
+
+		Node* n = new Node();
+		n->level = level;
+		n->terminal = terminal;
+		registerNode(n, level);
+
+		idx2Node.push_back(n);
+	}
+
+	unsigned int edgeCount = input.get<unsigned int>();
+	vector<Edge*> edgesInFileOrder;
+	edgesInFileOrder.reserve(edgeCount);
+	for(unsigned int edgeI = 0; edgeI < edgeCount; edgeI++)
+	{
+		unsigned int from_idx = input.get<unsigned int>();
+		unsigned int to_idx = input.get<unsigned int>();
+		unsigned int locus_idx = input.get<unsigned int>();
+		assert(from_idx < idx2Node.size());
+		assert(to_idx < idx2Node.size());
+		assert(locus_idx < loci.size());
+
+		Edge* e = new Edge();
+		e->emission = input.get<unsigned char>();
+		e->pgf_protect = input.get<unsigned char>();
+		e->count = input.get<double>();
+		e->label = input.getString();
+		e->locus_id = loci.at(locus_idx);
+		registerEdge(e);
+		edgesInFileOrder.push_back(e);
+
+		Node* n1 = idx2Node.at(from_idx);
+		Node* n2 = idx2Node.at(to_idx);
+
+		e->From = n1;
+		e->To = n2;
+
+		n1->Outgoing_Edges.insert(e);
+		n2->Incoming_Edges.insert(e);
+	}
+
+	if(input.position != input.end)
+	{
+		errEx("Trailing data in binary graph file: "+filename);
+	}
+
+	munmap(mapped, fileSize);
+
+	EdgesInFileOrder = edgesInFileOrder;
+	filename_last_read = filename;
+}
+
+// the binary file is used if it exists, has the current version and is not older than the text file
+static bool binaryGraphFileUsable(string textFilename, string binaryFilename)
+{
+	struct stat binaryInfo;
+	if(stat(binaryFilename.c_str(), &binaryInfo) != 0)
+		return false;
+
+	struct stat textInfo;
+	if((stat(textFilename.c_str(), &textInfo) == 0) && (binaryInfo.st_mtime < textInfo.st_mtime))
+	{
+		cerr << "Binary graph file " << binaryFilename << " is older than " << textFilename << " - ignore.\n" << flush;
+		return false;
+	}
+
+	ifstream binaryStream;
+	binaryStream.open(binaryFilename.c_str(), ios::in | ios::binary);
+	char header[sizeof(binaryGraph_magic) + sizeof(unsigned int)];
+	if(! binaryStream.read(header, sizeof(header)))
+		return false;
+
+	unsigned int version;
+	memcpy(&version, header + sizeof(binaryGraph_magic), sizeof(unsigned int));
+	if((memcmp(header, binaryGraph_magic, sizeof(binaryGraph_magic)) != 0) || (version != binaryGraph_version))
+	{
+		cerr << "Binary graph file " << binaryFilename << " has an unsupported format - ignore.\n" << flush;
+		return false;
+	}
+
+	return true;
+}
+
 void Graph::readFromFile(string filename)
+{
+	string binaryFile = binaryFilename(filename);
+	if(binaryGraphFileUsable(filename, binaryFile))
+	{
+		readFromBinaryFile(binaryFile);
+		filename_last_read = filename;
+		return;
+	}
+
+	readFromTextFile(filename);
+}
+
+void Graph::readFromTextFile(string filename)
 {
     using boost::lexical_cast;
     using boost::bad_lexical_cast;
@@ -1297,6 +1655,8 @@ void Graph::readFromFile(string filename)
 	}
 	
 	bool encounteredErr = false;
+	vector<Edge*> edgesInFileOrder;
+	edgesInFileOrder.reserve(linesForEdges.size());
 	for(unsigned int i = 0; i < linesForEdges.size(); i++)
 	{
 		if((i % 100000) == 0)
@@ -1383,6 +1743,7 @@ void Graph::readFromFile(string filename)
 		e->pgf_protect = protected_pgf;
 		idx2Edge[e_idx] = e;
 		registerEdge(e);
+		edgesInFileOrder.push_back(e);
 
 		assert(idx2Node.count(from_idx) > 0);
 		if(!(idx2Node.count(to_idx) > 0))
@@ -1416,6 +1777,7 @@ void Graph::readFromFile(string filename)
 
 	cout << "\n\n" << flush;
 	
+	EdgesInFileOrder = edgesInFileOrder;
 	filename_last_read = filename;
 }
 
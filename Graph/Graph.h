@@ -40,6 +40,10 @@ public:
 	set<Edge*> Edges;
 	vector< set<Node*> > NodesPerLevel;
 
+	// edges in the order of the file the graph was read from - a process-independent edge numbering.
+	// Empty if the graph was not read from a file or has been modified since.
+	vector<Edge*> EdgesInFileOrder;
+
 	LocusCodeAllocation CODE;
 	void registerNode(Node* n, unsigned int level);
 	void registerEdge(Edge* e);
@@ -54,6 +58,14 @@ public:
 
 	void writeToFile(string filename);
 	void readFromFile(string filename);
+	void readFromTextFile(string filename);
+
+	// binary serialization (graph.bin), see Graph.cpp for the format. readFromFile(..) uses the
+	// binary file instead of the text file if it is present and at least as new as the text file;
+	// readFromTextFile(..) always parses the text file.
+	void writeToBinaryFile(string filename);
+	void readFromBinaryFile(string filename);
+	static string binaryFilename(string filename);
 	void printComplexity (string filename);
 
 
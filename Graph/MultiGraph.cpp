@@ -92,13 +92,46 @@ int MultiGraph::minEdgeNumber()
 	return minEdgeNum;
 }
 
+int MultiGraph::buildkMerIDs()
+{
+	if(! CODE.havekMerIDs(kMerSize))
+	{
+		CODE.buildkMerIDs(kMerSize);
+	}
+	return CODE.kMerIDs();
+}
+
+vector<long long> MultiGraph::kMerCountsByID(map<string, long long>& kMerCounts)
+{
+	int kMerIDs = buildkMerIDs();
+	vector<long long> forReturn(kMerIDs, kMerCountMissing);
+	for(int kMerID = 0; kMerID < kMerIDs; kMerID++)
+	{
+		map<string, long long>::iterator countIt = kMerCounts.find(CODE.kMerForID(kMerID));
+		if(countIt != kMerCounts.end())
+		{
+			forReturn.at(kMerID) = countIt->second;
+		}
+	}
+	return forReturn;
+}
+
 kMerPositionInfo MultiGraph::getkMerPositions()
 {
 	kMerPositionInfo forReturn;
 
+	int kMerIDs = buildkMerIDs();
+	forReturn.kMers2Level.resize(kMerIDs);
+	forReturn.kMerMultiplicity.resize(kMerIDs, 0);
+	forReturn.kMerMaxPerLevel.resize(kMerIDs, 0);
+	forReturn.kMerEdgeNum.resize(kMerIDs, 0);
+	forReturn.Level2Kmers.resize(max((int)NodesPerLevel.size()-1, 0));
+
 	for(int l = 0; l < ((int)NodesPerLevel.size()-1); l++)
 	{
 		string locusID = (*(*(NodesPerLevel.at(l).begin()))->Outgoing_Edges.begin())->locus_id;
+		const vector<int>& locus_kMerIDs = CODE.kMerIDsForLocus(locusID);
+		vector<int>& levelkMers = forReturn.Level2Kmers.at(l);
 
 		for(set<Node*>::iterator nodeIt = NodesPerLevel.at(l).begin(); nodeIt !=  NodesPerLevel.at(l).end(); nodeIt++)
 		{
@@ -118,43 +151,37 @@ kMerPositionInfo MultiGraph::getkMerPositions()
 					{
 						int emissionSymbol = emissionIt->first;
 						int number = emissionIt->second;
-						string kMer = CODE.deCode(e->locus_id, emissionSymbol);
-						if((kMer != "*") && (kMer != "_"))
+						int kMerID = locus_kMerIDs.at(emissionSymbol);
+						if(kMerID != -1)
 						{
-							forReturn.kMers.insert(kMer);
-							forReturn.kMers2Level[kMer].insert(l);
-							if(forReturn.kMerMultiplicity.count(kMer) == 0)
-							{
-								forReturn.kMerMultiplicity[kMer] = 0;
-							}
-							forReturn.kMerMultiplicity[kMer] += number;
-
-							if(forReturn.kMerEdgeNum.count(kMer) == 0)
-							{
-								forReturn.kMerEdgeNum[kMer] = 0;
-							}
-							forReturn.kMerEdgeNum[kMer]++;
-
-							if(forReturn.kMerMaxPerLevel.count(kMer) == 0)
+							vector<int>& kMerLevels = forReturn.kMers2Level.at(kMerID);
+							if((kMerLevels.size() == 0) || (kMerLevels.back() != l))
 							{
-								forReturn.kMerMaxPerLevel[kMer] = 0;
+								kMerLevels.push_back(l);
 							}
-							if(number > forReturn.kMerMaxPerLevel[kMer])
+							forReturn.kMerMultiplicity.at(kMerID) += number;
+							forReturn.kMerEdgeNum.at(kMerID)++;
+							if(number > forReturn.kMerMaxPerLevel.at(kMerID))
 							{
-								forReturn.kMerMaxPerLevel[kMer] = number;
+								forReturn.kMerMaxPerLevel.at(kMerID) = number;
 							}
 
-							forReturn.Level2Kmers[l].insert(kMer);
+							levelkMers.push_back(kMerID);
 						}
 					}
 				}
 			}
 		}
 
-		if(forReturn.Level2Kmers.count(l) == 0)
+		sort(levelkMers.begin(), levelkMers.end());
+		levelkMers.erase(unique(levelkMers.begin(), levelkMers.end()), levelkMers.end());
+	}
+
+	for(int kMerID = 0; kMerID < kMerIDs; kMerID++)
+	{
+		if(forReturn.kMerEdgeNum.at(kMerID) > 0)
 		{
-			set<string> empty;
-			forReturn.Level2Kmers[l] = empty;
+			forReturn.kMers.push_back(kMerID);
 		}
 	}
 
@@ -167,26 +194,26 @@ kMerUniquenessInfo MultiGraph::kMerUniqueness()
 
 	kMerPositionInfo kMerPos = getkMerPositions();
 
-	set<string> levelUniqueKMers;
-	for(set<string>::iterator kMerIt = kMerPos.kMers.begin(); kMerIt != kMerPos.kMers.end(); kMerIt++)
+	int kMerIDs = kMerPos.kMers2Level.size();
+	forReturn.kMer2Level.resize(kMerIDs, -1);
+	forReturn.levelUniqueKMers.resize(kMerIDs, false);
+	forReturn.levelUniqueKMers_count = 0;
+
+	for(unsigned int kMerI = 0; kMerI < kMerPos.kMers.size(); kMerI++)
 	{
-		string kMer = *kMerIt;
-		assert(kMerPos.kMers2Level.count(kMer) > 0);
-		int levels = kMerPos.kMers2Level[kMer].size();
+		int kMerID = kMerPos.kMers.at(kMerI);
+		int levels = kMerPos.kMers2Level.at(kMerID).size();
 
 		assert(levels >= 1);
 
 		if(levels == 1)
 		{
-			forReturn.levelUniqueKMers.insert(kMer);
+			forReturn.levelUniqueKMers.at(kMerID) = true;
+			forReturn.levelUniqueKMers_count++;
+			forReturn.kMer2Level.at(kMerID) = kMerPos.kMers2Level.at(kMerID).at(0);
 		}
 	}
 
-	for(set<string>::iterator kMerIt = forReturn.levelUniqueKMers.begin(); kMerIt != forReturn.levelUniqueKMers.end(); kMerIt++)
-	{
-		forReturn.kMers2Level[*kMerIt] = kMerPos.kMers2Level[*kMerIt];
-	}
-
 	return forReturn;
 }
 
@@ -196,33 +223,27 @@ kMerNonUniquenessInfo MultiGraph::kMerNonUniqueness()
 
 	kMerPositionInfo kMerPos = getkMerPositions();
 
-	set<string> levelNonUniqueKMers;
-	for(set<string>::iterator kMerIt = kMerPos.kMers.begin(); kMerIt != kMerPos.kMers.end(); kMerIt++)
+	for(unsigned int kMerI = 0; kMerI < kMerPos.kMers.size(); kMerI++)
 	{
-		string kMer = *kMerIt;
-		assert(kMerPos.kMers2Level.count(kMer) > 0);
-		int levels = kMerPos.kMers2Level[kMer].size();
+		int kMerID = kMerPos.kMers.at(kMerI);
+		string kMer = CODE.kMerForID(kMerID);
+		const vector<int>& kMerLevels = kMerPos.kMers2Level.at(kMerID);
 
-		assert(levels >= 1);
+		assert(kMerLevels.size() >= 1);
 
-		if(levels != 1)
-		{
-			forReturn.levelNonUniqueKMers.insert(kMer);
-		}
-	}
+		forReturn.kMerMultiplicity[kMer] = kMerPos.kMerMultiplicity.at(kMerID);
 
-	for(set<string>::iterator kMerIt = forReturn.levelNonUniqueKMers.begin(); kMerIt != forReturn.levelNonUniqueKMers.end(); kMerIt++)
-	{
-		forReturn.kMers2Level[*kMerIt] = kMerPos.kMers2Level[*kMerIt];
-		for(set<int>::iterator levelIt = forReturn.kMers2Level[*kMerIt] .begin(); levelIt != forReturn.kMers2Level[*kMerIt].end(); levelIt++)
+		if(kMerLevels.size() != 1)
 		{
-			int level = *levelIt;
-			forReturn.level2kMers[level].insert(*kMerIt);
+			forReturn.levelNonUniqueKMers.insert(kMer);
+			forReturn.kMers2Level[kMer].insert(kMerLevels.begin(), kMerLevels.end());
+			for(unsigned int levelI = 0; levelI < kMerLevels.size(); levelI++)
+			{
+				forReturn.level2kMers[kMerLevels.at(levelI)].insert(kMer);
+			}
 		}
 	}
 
-	forReturn.kMerMultiplicity = kMerPos.kMerMultiplicity;
-
 	return forReturn;
 }
 
@@ -230,15 +251,12 @@ kMerNonUniquenessInfo MultiGraph::kMerNonUniqueness()
 void MultiGraph::kMerDiagnostics()
 {
 	kMerPositionInfo kMerPos = getkMerPositions();
-
-	set<string> kMers = kMerPos.kMers;
-	map<string, set<int> > kMers2Level = kMerPos.kMers2Level;
-	set<string> levelUniqueKMers = kMerUniqueness().levelUniqueKMers;
+	kMerUniquenessInfo uniqueness = kMerUniqueness();
 
 	cout << "GRAPH DESCRIPTION\n";
-	cout << "Total # kMers: " << kMers.size() << "\n";
-	cout << "\tof which " << levelUniqueKMers.size() << " (";
-	printf("%.2f", (double)levelUniqueKMers.size()/(double)kMers.size() );
+	cout << "Total # kMers: " << kMerPos.kMers.size() << "\n";
+	cout << "\tof which " << uniqueness.levelUniqueKMers_count << " (";
+	printf("%.2f", (double)uniqueness.levelUniqueKMers_count/(double)kMerPos.kMers.size() );
 	cout << ") are unique\n\n";
 
 	map<int, avg_struct> uniquenessByLength;
@@ -264,11 +282,11 @@ void MultiGraph::kMerDiagnostics()
 					{
 						int emissionSymbol = emissionIt->first;
 						int number = emissionIt->second;
-						string kMer = CODE.deCode(e->locus_id, emissionSymbol);
-						if((kMer != "_") && (kMer != "*"))
+						int kMerID = CODE.kMerID(e->locus_id, emissionSymbol);
+						if(kMerID != -1)
 						{
 							edge_length += number;
-							if(levelUniqueKMers.count(kMer) > 0)
+							if(uniqueness.levelUniqueKMers.at(kMerID))
 							{
 								edge_levelUnique += number;
 							}
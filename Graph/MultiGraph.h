@@ -36,22 +36,25 @@ struct avg_struct
 	int sum;
 };
 
+// k-mers are identified by their ID in the k-mer dictionary of the graph's CODE (see MultiGraph::buildkMerIDs())
+
 struct kMerPositionInfo
 {
-	set<string> kMers;
-	map<string, set<int> > kMers2Level;
-	map<int, set<string> > Level2Kmers;
-	map<string, int > kMerMultiplicity;
-	map<string, int> kMerMaxPerLevel;
-	map<string, int> kMerEdgeNum;
+	vector<int> kMers; // k-mers emitted by the graph, ascending
+	vector< vector<int> > kMers2Level; // by k-mer, ascending
+	vector< vector<int> > Level2Kmers; // by level, ascending
+	vector<int> kMerMultiplicity; // by k-mer
+	vector<int> kMerMaxPerLevel; // by k-mer
+	vector<int> kMerEdgeNum; // by k-mer, 0 for k-mers that the graph doesn't emit
 
 };
 
 
 struct kMerUniquenessInfo
 {
-	map<string, set<int> > kMers2Level;
-	set<string> levelUniqueKMers;
+	vector<int> kMer2Level; // by k-mer: the level of k-mers that occur at one level only, -1 otherwise
+	vector<bool> levelUniqueKMers; // by k-mer
+	int levelUniqueKMers_count;
 };
 
 struct kMerNonUniquenessInfo
@@ -93,6 +96,13 @@ public:
 
 	multiHaploLabelPair edgePointerPathToLabels(diploidEdgePointerPath& multiEdgesPath);
 
+	// Builds the k-mer dictionary of CODE (all k-mers of the graph, see LargeLocusCodeAllocation::buildkMerIDs(..))
+	// unless it is up to date. Returns the number of k-mer IDs.
+	int buildkMerIDs();
+	// by k-mer ID, kMerCountMissing for k-mers without a count
+	static const long long kMerCountMissing = -2;
+	vector<long long> kMerCountsByID(map<string, long long>& kMerCounts);
+
 	void kMerDiagnostics();
 	kMerUniquenessInfo kMerUniqueness();
 	kMerPositionInfo getkMerPositions();
@@ -8,6 +8,7 @@
 #include <vector>
 #include "../Utilities.h"
 #include "../MHC-PRG.h"
+#include "../hash/sequence/kMerCountsFile.h"
 #include <boost/math/distributions/poisson.hpp>
 
 int multiUnderflowProtection = 1;
@@ -24,6 +25,26 @@ map<string, long long> MultiHMM::estimateEmissions(string kMerCountsSamplePath,
 	// read in kMer count in sample
 
 	map<string, long long> kMerCountsInSample;
+	if(kMerCountsFile::isKMerCountsFile(kMerCountsSamplePath))
+	{
+		kMerCountsFile countsFile;
+		try
+		{
+			countsFile.load(kMerCountsSamplePath);
+			if((countsFile.size() > 0) && (countsFile.getK() != myGraph->kMerSize))
+			{
+				errEx("kMer counts file "+kMerCountsSamplePath+" has k = "+Utilities::ItoStr(countsFile.getK())+", but the graph uses k = "+Utilities::ItoStr(myGraph->kMerSize));
+			}
+			kMerCountsInSample = countsFile.getMetadata();
+			countsFile.readAll(kMerCountsInSample);
+		}
+		catch(std::runtime_error& e)
+		{
+			errEx(e.what());
+		}
+		return kMerCountsInSample;
+	}
+
 	ifstream kMerCountsSampleFile;
 	kMerCountsSampleFile.open (kMerCountsSamplePath.c_str(), ios::in);
 	int lineCounter = 0;
@@ -357,7 +378,7 @@ multiHaploLabelPair MultiHMM::retrieveProbabilisticSample(bool labelOnly)
 	return forReturn;	
 }
 
-double MultiHMM::fillForwardBackwardTable(map<string, long long> globalEmission)
+double MultiHMM::fillForwardBackwardTable(map<string, long long>& globalEmission)
 {
 	//assert((globalEmission.size()) == diploidStatesByLevel.size());
 
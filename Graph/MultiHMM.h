@@ -48,7 +48,7 @@ protected:
 public:
 	MultiHMM(MultiGraph* g, bool verbose=true);
 	map<string, long long> estimateEmissions(string kMerCountsSamplePath, string kMerCountsGenomePath);
-	double fillForwardBackwardTable(map<string, long long> globalEmission);
+	double fillForwardBackwardTable(map<string, long long>& globalEmission);
 	multiHaploLabelPair retrieveProbabilisticSample(bool labelOnly);
 };
 
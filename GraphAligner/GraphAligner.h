@@ -9,6 +9,7 @@
 #define GRAPHALIGNER_H_
 
 #include "GraphAndIndex.h"
+#include "../Graph/FrozenGraph.h"
 #include "VirtualNW.h"
 
 #include <vector>
@@ -149,6 +150,13 @@ public:
 		assert(usedEdge->From == nodeFrom);
 	}
 
+	void takeNodeAndEdge(unsigned int usedEdgeID, const FrozenGraph& frozenGraph)
+	{
+		usedEdges.push_back(frozenGraph.edge(usedEdgeID));
+		graphSequence.push_back(frozenGraph.edgeEmission(usedEdgeID));
+		graphSequence_levels.push_back(frozenGraph.edgeLevel(usedEdgeID));
+	}
+
 	backtrackBookkeeper()
 	{
 		backtrack = 0;
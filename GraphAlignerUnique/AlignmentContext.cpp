@@ -0,0 +1,94 @@
+/*
+ * AlignmentContext.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "AlignmentContext.h"
+
+#include <iostream>
+#include <fstream>
+#include <assert.h>
+#include <omp.h>
+
+#include "../Utilities.h"
+
+namespace GraphAlignerUnique {
+
+AlignmentContext::AlignmentContext(Graph* graph, int k) : g(graph), fG(graph), kMerSize(k), gI(g, &fG, k) {
+	if(graph != 0)
+	{
+		// enumerate states at levels
+		unsigned int levels = g->NodesPerLevel.size();
+		nodesPerLevel_ordered.resize(levels);
+		nodesPerLevel_ordered_rev.resize(levels);
+		for(unsigned int levelI = 0; levelI < levels; levelI++)
+		{
+			nodesPerLevel_ordered.at(levelI) = std::vector<Node*>(g->NodesPerLevel.at(levelI).begin(), g->NodesPerLevel.at(levelI).end());
+			for(unsigned int nodeI = 0; nodeI < nodesPerLevel_ordered.at(levelI).size(); nodeI++)
+			{
+				nodesPerLevel_ordered_rev.at(levelI)[nodesPerLevel_ordered.at(levelI).at(nodeI)] = nodeI;
+			}
+		}
+
+		slabTransitions_forward.resize(levels);
+		slabTransitions_backward.resize(levels);
+		for(unsigned int levelI = 0; levelI < levels; levelI++)
+		{
+			if((levelI + 1) < levels)
+				slabTransitions_forward.at(levelI).build(fG, levelI, true);
+			if(levelI > 0)
+				slabTransitions_backward.at(levelI).build(fG, levelI, false);
+		}
+
+		if(g->filename_last_read.length())
+		{
+			std::string graphFile = g->filename_last_read;
+			std::string gTxt = "graph.txt";
+			assert(graphFile.substr(graphFile.length() - gTxt.length()) == gTxt);
+			std::string graphDir = graphFile.substr(0, graphFile.length() - gTxt.length());
+
+			std::string genomicCoverage_file = graphDir + "genomicMapping.txt";
+			if(! Utilities::fileExists(genomicCoverage_file))
+			{
+				std::cerr << "Error: file " << genomicCoverage_file << " not there!\n" << std::flush;
+			}
+			assert(Utilities::fileExists(genomicCoverage_file));
+
+			std::ifstream genomicCoverageStream;
+			genomicCoverageStream.open(genomicCoverage_file.c_str());
+			assert(genomicCoverageStream.is_open());
+
+			std::string line;
+			while(genomicCoverageStream.good())
+			{
+				std::getline(genomicCoverageStream, line);
+				Utilities::eraseNL(line);
+				if(line.length() > 0)
+				{
+					std::vector<std::string> fields = Utilities::split(line, ",");
+					for(unsigned int fI = 0; fI < fields.size(); fI++)
+					{
+						std::string fP = fields.at(fI);
+						std::vector<std::string> fP_parts = Utilities::split(fP, ":");
+						assert(fP_parts.size() == 2);
+
+						std::string regionID = fP_parts.at(0);
+						int part_pos = Utilities::StrtoI(fP_parts.at(1));
+
+						myGraph_coveredIntervals.addPoint(regionID, part_pos);
+					}
+				}
+			}
+			genomicCoverageStream.close();
+
+			if(omp_get_thread_num() == 0)
+			{
+				myGraph_coveredIntervals.printIntervals();
+			}
+		}
+		//std::cout << "myGraph_coveredIntervals: Have " << myGraph_coveredIntervals.getNumIntervals() << " intervals.\n" << std::flush;
+	}
+}
+
+} /* namespace GraphAlignerUnique */
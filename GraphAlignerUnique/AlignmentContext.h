@@ -0,0 +1,58 @@
+/*
+ * AlignmentContext.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef ALIGNMENTCONTEXT_H_
+#define ALIGNMENTCONTEXT_H_
+
+#include <vector>
+#include <map>
+
+#include "../Graph/Graph.h"
+#include "../Graph/FrozenGraph.h"
+#include "GraphAndEdgeIndex.h"
+#include "coveredIntervals.h"
+#include "NWSlabKernel.h"
+
+namespace GraphAlignerUnique {
+
+// Everything a GraphAlignerUnique needs to know about its graph: the graph itself, its k-mer
+// index, the per-level state tables and the genomic intervals covered by the graph.
+// An AlignmentContext is immutable after construction; any number of GraphAlignerUniques (one
+// per thread, each holding only its scoring parameters, scratch tables and random seeds) can
+// share one context, and the graph it was built for, without synchronisation.
+class AlignmentContext {
+protected:
+	Graph* g;
+	FrozenGraph fG;
+	int kMerSize;
+	GraphAndEdgeIndex gI;
+
+	coveredIntervals myGraph_coveredIntervals;
+
+	std::vector<std::vector<Node*> > nodesPerLevel_ordered;
+	std::vector<std::map<Node*, unsigned int> > nodesPerLevel_ordered_rev;
+
+	// transitions level x -> x+1 and x -> x-1, for the slab kernels in fullNeedleman_diagonal_extension(..)
+	std::vector<NWSlabTransitions> slabTransitions_forward;
+	std::vector<NWSlabTransitions> slabTransitions_backward;
+
+public:
+	AlignmentContext(Graph* graph, int k);
+
+	Graph* getGraph() const
+	{
+		return g;
+	}
+	int getkMerSize() const
+	{
+		return kMerSize;
+	}
+
+	friend class GraphAlignerUnique;
+};
+
+} /* namespace GraphAlignerUnique */
+#endif /* ALIGNMENTCONTEXT_H_ */
@@ -0,0 +1,149 @@
+/*
+ * BandedNWTable.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "BandedNWTable.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+namespace GraphAlignerUnique {
+
+BandedNWTable::BandedNWTable() : start_x(0), start_y(0), directionPositive(true), open_x_lo(0), open_x_hi(-1), open_stamp(0)
+{
+
+}
+
+void BandedNWTable::reset(int start_x_, int start_y_, bool directionPositive_)
+{
+	start_x = start_x_;
+	start_y = start_y_;
+	directionPositive = directionPositive_;
+
+	cells.clear();
+	diagonal_first_cell.clear();
+	diagonal_first_cell.push_back(0);
+
+	open_cells.clear();
+	open_x_lo = 0;
+	open_x_hi = -1;
+}
+
+void BandedNWTable::closeDiagonal()
+{
+	diagonal_first_cell.push_back(cells.size());
+}
+
+void BandedNWTable::beginDiagonal(int x_lo, int x_hi, const std::vector<std::vector<Node*> >& statesPerLevel)
+{
+	open_cells.clear();
+	open_x_lo = x_lo;
+	open_x_hi = x_hi;
+
+	open_level_offsets.clear();
+	unsigned int offset = 0;
+	for(int x = x_lo; x <= x_hi; x++)
+	{
+		open_level_offsets.push_back(offset);
+		offset += statesPerLevel.at(x).size();
+	}
+
+	if(open_slot_index.size() < offset)
+	{
+		open_slot_index.resize(offset);
+		open_slot_stamp.resize(offset, 0);
+	}
+
+	open_stamp++;
+	if(open_stamp == 0)
+	{
+		std::fill(open_slot_stamp.begin(), open_slot_stamp.end(), 0);
+		open_stamp = 1;
+	}
+}
+
+bandedNWCandidates& BandedNWTable::openCell(int x, int y, int z)
+{
+	assert((x >= open_x_lo) && (x <= open_x_hi));
+	unsigned int slot = open_level_offsets[x - open_x_lo] + z;
+	assert(slot < open_slot_index.size());
+	if(open_slot_stamp[slot] != open_stamp)
+	{
+		open_slot_stamp[slot] = open_stamp;
+		open_slot_index[slot] = open_cells.size();
+
+		open_cells.push_back(bandedNWCandidates());
+		bandedNWCandidates& c = open_cells.back();
+		c.x = x;
+		c.y = y;
+		c.z = z;
+		c.have_D = false;
+		c.have_GraphGap = false;
+		c.have_SequenceGap = false;
+	}
+	return open_cells[open_slot_index[slot]];
+}
+
+const std::vector<std::pair<unsigned int, int> >& BandedNWTable::openCellsSorted()
+{
+	// slots are laid out by ascending level and ascending z, and within one diagonal the level determines
+	// the sequence position - so slot order is (x, y, z) order.
+	open_cells_sorted.clear();
+	for(unsigned int i = 0; i < open_cells.size(); i++)
+	{
+		const bandedNWCandidates& c = open_cells[i];
+		open_cells_sorted.push_back(std::make_pair(open_level_offsets[c.x - open_x_lo] + c.z, (int)i));
+	}
+	std::sort(open_cells_sorted.begin(), open_cells_sorted.end());
+	return open_cells_sorted;
+}
+
+int BandedNWTable::find(int x, int y, int z) const
+{
+	int diagonal = abs(x - start_x) + abs(y - start_y);
+	if(diagonal >= closedDiagonals())
+		return -1;
+
+	std::vector<bandedNWCell>::const_iterator first = cells.begin() + diagonal_first_cell.at(diagonal);
+	std::vector<bandedNWCell>::const_iterator last = cells.begin() + diagonal_first_cell.at(diagonal + 1);
+	std::vector<bandedNWCell>::const_iterator it = std::lower_bound(first, last, 0, [&](const bandedNWCell& c, int) -> bool {
+		if(c.x != x)
+			return (c.x < x);
+		if(c.y != y)
+			return (c.y < y);
+		return (c.z < z);
+	});
+
+	if((it != last) && (it->x == x) && (it->y == y) && (it->z == z))
+	{
+		return it - cells.begin();
+	}
+	return -1;
+}
+
+std::pair<int, int> BandedNWTable::cellsAt(int x, int y) const
+{
+	int diagonal = abs(x - start_x) + abs(y - start_y);
+	if(diagonal >= closedDiagonals())
+		return std::make_pair(0, 0);
+
+	int first = -1;
+	int last = -1;
+	for(unsigned int i = diagonal_first_cell.at(diagonal); i < diagonal_first_cell.at(diagonal + 1); i++)
+	{
+		if((cells[i].x == x) && (cells[i].y == y))
+		{
+			if(first == -1)
+				first = i;
+			last = i + 1;
+		}
+	}
+	if(first == -1)
+		return std::make_pair(0, 0);
+
+	return std::make_pair(first, last);
+}
+
+} /* namespace GraphAlignerUnique */
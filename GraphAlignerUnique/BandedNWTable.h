@@ -0,0 +1,173 @@
+/*
+ * BandedNWTable.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef BANDEDNWTABLE_H_
+#define BANDEDNWTABLE_H_
+
+#include <vector>
+#include <assert.h>
+
+#include "../Graph/Node.h"
+#include "../Graph/Edge.h"
+#include "NWSlabKernel.h"
+
+namespace GraphAlignerUnique {
+
+// Backtrace step within a BandedNWTable: the source cell is referenced by its index in the table
+// (-1 if there is none), so that following a backtrace never needs a coordinate lookup. The graph
+// edge is a FrozenGraph edge ID (FrozenGraph::noEdge for gaps in the graph).
+class bandedNWStep {
+public:
+	int cell;
+	int sourceMatrix;
+	unsigned int usedEdgeID;
+
+	bandedNWStep() : cell(-1), sourceMatrix(-1), usedEdgeID(FrozenGraph::noEdge)
+	{
+
+	}
+
+	bandedNWStep(int cell_, int sourceMatrix_, unsigned int usedEdgeID_) : cell(cell_), sourceMatrix(sourceMatrix_), usedEdgeID(usedEdgeID_)
+	{
+
+	}
+};
+
+class bandedNWCell {
+public:
+	int x;
+	int y;
+	int z;
+
+	double D;
+	double GraphGap;
+	double SequenceGap;
+
+	bandedNWStep D_backtrace;
+	bandedNWStep GraphGap_backtrace;
+	bandedNWStep SequenceGap_backtrace;
+};
+
+// Running maxima for one cell of the diagonal under construction. Candidates have to be offered in the
+// order in which the original alternatives vectors were filled - the first maximum wins, which is what
+// Utilities::findVectorMaxP_nonCritical(..) selects.
+class bandedNWCandidates {
+public:
+	int x;
+	int y;
+	int z;
+
+	bool have_D;
+	bool have_GraphGap;
+	bool have_SequenceGap;
+
+	double D;
+	double GraphGap;
+	double SequenceGap;
+
+	bandedNWStep D_backtrace;
+	bandedNWStep GraphGap_backtrace;
+	bandedNWStep SequenceGap_backtrace;
+
+	void offer_D(double S, const bandedNWStep& step)
+	{
+		if((! have_D) || (S > D))
+		{
+			D = S;
+			D_backtrace = step;
+			have_D = true;
+		}
+	}
+
+	void offer_GraphGap(double S, const bandedNWStep& step)
+	{
+		if((! have_GraphGap) || (S > GraphGap))
+		{
+			GraphGap = S;
+			GraphGap_backtrace = step;
+			have_GraphGap = true;
+		}
+	}
+
+	void offer_SequenceGap(double S, const bandedNWStep& step)
+	{
+		if((! have_SequenceGap) || (S > SequenceGap))
+		{
+			SequenceGap = S;
+			SequenceGap_backtrace = step;
+			have_SequenceGap = true;
+		}
+	}
+};
+
+// Affine NW table for GraphAlignerUnique::fullNeedleman_diagonal_extension(..).
+// Only the cells that survive the diagonal filtering are stored, contiguously per anti-diagonal
+// and sorted by (x, y, z) within each diagonal. Diagonal k comprises all cells k steps away from the
+// start cell. All buffers are kept between calls, so one table per thread is enough.
+class BandedNWTable {
+protected:
+	int start_x;
+	int start_y;
+	bool directionPositive;
+
+	std::vector<bandedNWCell> cells;
+	std::vector<unsigned int> diagonal_first_cell;
+
+	// diagonal under construction
+	int open_x_lo;
+	int open_x_hi;
+	std::vector<unsigned int> open_level_offsets;
+	std::vector<int> open_slot_index;
+	std::vector<unsigned int> open_slot_stamp;
+	unsigned int open_stamp;
+	std::vector<bandedNWCandidates> open_cells;
+	std::vector<std::pair<unsigned int, int> > open_cells_sorted;
+
+public:
+	// scratch space for the slab kernels
+	NWSlabBuffers slab;
+
+	BandedNWTable();
+
+	void reset(int start_x, int start_y, bool directionPositive);
+
+	int addCell(const bandedNWCell& c)
+	{
+		cells.push_back(c);
+		return (int)cells.size() - 1;
+	}
+
+	bandedNWCell& cell(int i)
+	{
+		assert((i >= 0) && (i < (int)cells.size()));
+		return cells[i];
+	}
+
+	int nextCellIndex() const
+	{
+		return (int)cells.size();
+	}
+
+	void closeDiagonal();
+	int closedDiagonals() const
+	{
+		return (int)diagonal_first_cell.size() - 1;
+	}
+
+	void beginDiagonal(int x_lo, int x_hi, const std::vector<std::vector<Node*> >& statesPerLevel);
+	bandedNWCandidates& openCell(int x, int y, int z);
+	const std::vector<std::pair<unsigned int, int> >& openCellsSorted();
+	bandedNWCandidates& openCandidates(int i)
+	{
+		return open_cells[i];
+	}
+
+	int find(int x, int y, int z) const;
+	std::pair<int, int> cellsAt(int x, int y) const;
+};
+
+} /* namespace GraphAlignerUnique */
+#endif /* BANDEDNWTABLE_H_ */
@@ -31,7 +31,12 @@
 namespace GraphAlignerUnique {
 int _dbg_local_chainI = 0;
 
-GraphAlignerUnique::GraphAlignerUnique(Graph* graph, int k) : g(graph), kMerSize(k), gI(g, k){
+GraphAlignerUnique::GraphAlignerUnique(Graph* graph, int k) : GraphAlignerUnique(std::make_shared<AlignmentContext>(graph, k))
+{
+
+}
+
+GraphAlignerUnique::GraphAlignerUnique(std::shared_ptr<AlignmentContext> alignmentContext) : context(alignmentContext), g(context->g), fG(context->fG), kMerSize(context->kMerSize), gI(context->gI), myGraph_coveredIntervals(context->myGraph_coveredIntervals), nodesPerLevel_ordered(context->nodesPerLevel_ordered), nodesPerLevel_ordered_rev(context->nodesPerLevel_ordered_rev), slabTransitions_forward(context->slabTransitions_forward), slabTransitions_backward(context->slabTransitions_backward) {
 
 	std::cout << "T: " << omp_get_thread_num() << "\n" << std::flush;
 	
@@ -50,70 +55,6 @@ GraphAlignerUnique::GraphAlignerUnique(Graph* graph, int k) : g(graph), kMerSize
 	verbose = false;
 
 	threads = 4;
-
-	if(graph != 0)
-	{
-		// enumerate states at levels
-		unsigned int levels = g->NodesPerLevel.size();
-		nodesPerLevel_ordered.resize(levels);
-		nodesPerLevel_ordered_rev.resize(levels);
-		for(unsigned int levelI = 0; levelI < levels; levelI++)
-		{
-			nodesPerLevel_ordered.at(levelI) = std::vector<Node*>(g->NodesPerLevel.at(levelI).begin(), g->NodesPerLevel.at(levelI).end());
-			for(unsigned int nodeI = 0; nodeI < nodesPerLevel_ordered.at(levelI).size(); nodeI++)
-			{
-				nodesPerLevel_ordered_rev.at(levelI)[nodesPerLevel_ordered.at(levelI).at(nodeI)] = nodeI;
-			}
-		}
-
-		if(g->filename_last_read.length())
-		{
-			std::string graphFile = g->filename_last_read;
-			std::string gTxt = "graph.txt";
-			assert(graphFile.substr(graphFile.length() - gTxt.length()) == gTxt);
-			std::string graphDir = graphFile.substr(0, graphFile.length() - gTxt.length());
-
-			std::string genomicCoverage_file = graphDir + "genomicMapping.txt";
-			if(! Utilities::fileExists(genomicCoverage_file))
-			{
-				std::cerr << "Error: file " << genomicCoverage_file << " not there!\n" << std::flush;
-			}
-			assert(Utilities::fileExists(genomicCoverage_file));
-
-			std::ifstream genomicCoverageStream;
-			genomicCoverageStream.open(genomicCoverage_file.c_str());
-			assert(genomicCoverageStream.is_open());
-
-			std::string line;
-			while(genomicCoverageStream.good())
-			{
-				std::getline(genomicCoverageStream, line);
-				Utilities::eraseNL(line);
-				if(line.length() > 0)
-				{
-					std::vector<std::string> fields = Utilities::split(line, ",");
-					for(unsigned int fI = 0; fI < fields.size(); fI++)
-					{
-						std::string fP = fields.at(fI);
-						std::vector<std::string> fP_parts = Utilities::split(fP, ":");
-						assert(fP_parts.size() == 2);
-
-						std::string regionID = fP_parts.at(0);
-						int part_pos = Utilities::StrtoI(fP_parts.at(1));
-
-						myGraph_coveredIntervals.addPoint(regionID, part_pos);
-					}
-				}
-			}
-			genomicCoverageStream.close();
-
-			if(omp_get_thread_num() == 0)
-			{
-				myGraph_coveredIntervals.printIntervals();
-			}
-		}
-		//std::cout << "myGraph_coveredIntervals: Have " << myGraph_coveredIntervals.getNumIntervals() << " intervals.\n" << std::flush;
-	}  
 }
 
 
@@ -412,7 +353,7 @@ void GraphAlignerUnique::trimChain(kMerEdgeChain* inputChain, std::string& seque
 	assert(existingLength > (removeLeft + removeRight));
 
 	auto getEdgeEmission = [&](Edge* e) -> std::string {
-			return g->CODE.deCode(e->locus_id, e->emission);
+			return std::string(1, fG.edgeEmission(fG.edgeID(e)));
 		};
 
 	int sequenceRemove_begin_characters = removeLeft;
@@ -476,12 +417,10 @@ void GraphAlignerUnique::trimChain(kMerEdgeChain* inputChain, std::string& seque
 	std::string impliedSequence;
 	for(unsigned int eI = 0; eI < inputChain->traversedEdges.size(); eI++)
 	{
-		Edge* e = inputChain->traversedEdges.at(eI);
-		std::string edgeEmission = g->CODE.deCode(e->locus_id, e->emission);
-		assert(edgeEmission.length() == 1);
-		if(edgeEmission != "_")
+		unsigned int edgeID = fG.edgeID(inputChain->traversedEdges.at(eI));
+		if(! fG.edgeIsGap(edgeID))
 		{
-			impliedSequence.append(edgeEmission);
+			impliedSequence.push_back(fG.edgeEmission(edgeID));
 		}
 	}
 	std::string extractedSequence(sequence.begin() + inputChain->sequence_begin, sequence.begin() + inputChain->sequence_end + 1);
@@ -1091,6 +1030,7 @@ seedAndExtend_return GraphAlignerUnique::seedAndExtend(std::string sequence_nonR
 	certainty_alignment_graph.resize(g->NodesPerLevel.size() - 1);
 
 	rng_seeds.resize(threads);
+	bandedNWTables.resize(rng_seeds.size());
 	srand(time(NULL));
 	for(unsigned int tI = 0; (int)tI < threads; tI++)
 	{
@@ -3101,7 +3041,7 @@ seedAndExtend_return_local GraphAlignerUnique::seedAndExtend_local(std::string s
 {
 	assert(g != 0);
 	seedAndExtend_return_local forReturn;
-	
+	
 	verbose = false;
 	
 	// std::cout << Utilities::timestamp() << " Enter GraphAlignerUnique::seedAndExtend(..)!\n" << std::flush;
@@ -3206,6 +3146,7 @@ seedAndExtend_return_local GraphAlignerUnique::seedAndExtend_local(std::string s
 	}
 	
 	rng_seeds.resize(required_rng_seeds);
+	bandedNWTables.resize(rng_seeds.size());
 	srand(time(NULL));
 	for(unsigned int tI = 0; (int)tI < required_rng_seeds; tI++)
 	{
@@ -3770,6 +3711,7 @@ seedAndExtend_return_local GraphAlignerUnique::seedAndExtend_short(std::string s
 		}
 
 		rng_seeds.resize(required_rng_seeds);
+		bandedNWTables.resize(rng_seeds.size());
 		for(unsigned int tI = 0; (int)tI < required_rng_seeds; tI++)
 		{
 			rng_seeds.at(tI) = 0;
@@ -4608,7 +4550,7 @@ void GraphAlignerUnique::vNW_completeRemainingGaps_and_score(std::string& sequen
 				entryExitStatus = 1;
 			}
 
-			NWEdge* createdEdge = p->createAndAddEdge(fixX, y, 0, fixX, y+1, 0, 0, 0, entryExitStatus);
+			NWEdge* createdEdge = p->createAndAddEdge(fixX, y, 0, fixX, y+1, 0, FrozenGraph::noEdge, 0, entryExitStatus);
 			if(entryExitStatus == -1)
 			{
 				entryEdge = createdEdge;
@@ -5456,7 +5398,7 @@ void GraphAlignerUnique::vNW_completeRemainingGaps_and_score_local(std::string&
 				entryExitStatus = 1;
 			}
 
-			NWEdge* createdEdge = p->createAndAddEdge(fixX, y, 0, fixX, y+1, 0, 0, 0, entryExitStatus);
+			NWEdge* createdEdge = p->createAndAddEdge(fixX, y, 0, fixX, y+1, 0, FrozenGraph::noEdge, 0, entryExitStatus);
 			if(entryExitStatus == -1)
 			{
 				entryEdge = createdEdge;
@@ -5718,8 +5660,8 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 			}
 			else
 			{
-				std::set<Edge*> incomingEdges = n->Incoming_Edges;
-				assert(incomingEdges.size() > 0);
+				unsigned int nodeID = fG.levelFirstNode(lI) + z;
+				assert(fG.endIncoming(nodeID) > fG.firstIncoming(nodeID));
 
 				if(debug) std::cout << "b1" << "\n" << std::flush;
 
@@ -5732,15 +5674,14 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 				if(debug) std::cout << "b2" << "\n" << std::flush;
 
 
-				for(std::set<Edge*>::iterator eIt = incomingEdges.begin(); eIt != incomingEdges.end(); eIt++)
+				for(unsigned int incomingI = fG.firstIncoming(nodeID); incomingI < fG.endIncoming(nodeID); incomingI++)
 				{
 					if(debug) std::cout << "c1" << "\n" << std::flush;
 
-					Edge* e = *eIt;
-					std::string edgeEmission = g->CODE.deCode(e->locus_id, e->emission);
-					assert(edgeEmission.length() == 1);
+					unsigned int edgeID = fG.incomingEdge(incomingI);
+					char edgeEmission = fG.edgeEmission(edgeID);
 
-					Node* nodeFrom = e->From;
+					Node* nodeFrom = fG.node(fG.edgeFrom(edgeID));
 
 					if(debug) std::cout << "c2" << "\n" << std::flush;
 
@@ -5764,7 +5705,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 							{
 								double newDistance_notStartInAffineGap_affine_extend;
 								double newDistance_notStartInAffineGap_affine_start;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_notStartInAffineGap_affine_start = minusInfinity;
 									if(previousDistance_notStartInAffineGap_endInAffineGap == minusInfinity)
@@ -5794,7 +5735,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 							{
 								double newDistance_startInAffineGap_affine_extend;
 								double newDistance_startInAffineGap_affine_start;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_startInAffineGap_affine_start = minusInfinity;
 									if(previousDistance_startInAffineGap_endInAffineGap == minusInfinity)
@@ -5829,7 +5770,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 							{
 								double alternativeScore_endInAffine = runningNodeDistances_notStartInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingEdge);
 								double followGraphGap = minusInfinity;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									followGraphGap = previousDistance_notStartInAffineGap_endInAnything;
 								}
@@ -5844,7 +5785,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW(int fromLev
 							{
 								double alternativeScore_endInAffine = runningNodeDistances_startInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingEdge);
 								double followGraphGap = minusInfinity;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									followGraphGap = previousDistance_startInAffineGap_endInAnything;
 								}
@@ -6071,8 +6012,8 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 			}
 			else
 			{
-				std::set<Edge*> incomingEdges = n->Incoming_Edges;
-				assert(incomingEdges.size() > 0);
+				unsigned int nodeID = fG.levelFirstNode(lI) + z;
+				assert(fG.endIncoming(nodeID) > fG.firstIncoming(nodeID));
 
 				if(debug) std::cout << "b1" << "\n" << std::flush;
 
@@ -6085,15 +6026,14 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 				if(debug) std::cout << "b2" << "\n" << std::flush;
 
 
-				for(std::set<Edge*>::iterator eIt = incomingEdges.begin(); eIt != incomingEdges.end(); eIt++)
+				for(unsigned int incomingI = fG.firstIncoming(nodeID); incomingI < fG.endIncoming(nodeID); incomingI++)
 				{
 					if(debug) std::cout << "c1" << "\n" << std::flush;
 
-					Edge* e = *eIt;
-					std::string edgeEmission = g->CODE.deCode(e->locus_id, e->emission);
-					assert(edgeEmission.length() == 1);
+					unsigned int edgeID = fG.incomingEdge(incomingI);
+					char edgeEmission = fG.edgeEmission(edgeID);
 
-					Node* nodeFrom = e->From;
+					Node* nodeFrom = fG.node(fG.edgeFrom(edgeID));
 
 					if(debug) std::cout << "c2" << "\n" << std::flush;
 
@@ -6117,7 +6057,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 							{
 								double newDistance_notStartInAffineGap_affine_extend;
 								double newDistance_notStartInAffineGap_affine_start;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_notStartInAffineGap_affine_start = minusInfinity;
 									if(previousDistance_notStartInAffineGap_endInAffineGap == minusInfinity)
@@ -6147,7 +6087,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 							{
 								double newDistance_startInAffineGap_affine_extend;
 								double newDistance_startInAffineGap_affine_start;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_startInAffineGap_affine_start = minusInfinity;
 									if(previousDistance_startInAffineGap_endInAffineGap == minusInfinity)
@@ -6182,7 +6122,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 							{
 								double alternativeScore_endInAffine = runningNodeDistances_notStartInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingEdge);
 								double followGraphGap = minusInfinity;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									followGraphGap = previousDistance_notStartInAffineGap_endInAnything;
 								}
@@ -6197,7 +6137,7 @@ void GraphAlignerUnique::affinelyCalculateGraphDistancesForVirtualNW_local(int f
 							{
 								double alternativeScore_endInAffine = runningNodeDistances_startInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingEdge);
 								double followGraphGap = minusInfinity;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									followGraphGap = previousDistance_startInAffineGap_endInAnything;
 								}
@@ -6430,21 +6370,19 @@ void GraphAlignerUnique::seedAndExtend_backtrack(VirtualNWTable_Unique& vNW2, st
 			{
 				sequence_character = sequence.substr(currentEdge->from_y, 1);
 
-				Edge* usedGraphEdge = currentEdge->usedGraphEdge;
-				assert(usedGraphEdge != 0);
-				graph_character = g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
-				assert(graph_character.length() == 1);
-				graph_level = usedGraphEdge->From->level;
+				unsigned int usedGraphEdgeID = currentEdge->usedGraphEdgeID;
+				assert(usedGraphEdgeID != FrozenGraph::noEdge);
+				graph_character = std::string(1, fG.edgeEmission(usedGraphEdgeID));
+				graph_level = fG.edgeLevel(usedGraphEdgeID);
 			}
 			else if((diff_current_x == 1) && (diff_current_y == 0))
 			{
 				// gap in sequence
 				sequence_character = "_";
-				Edge* usedGraphEdge = currentEdge->usedGraphEdge;
-				assert(usedGraphEdge != 0);
-				graph_character = g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
-				assert(graph_character.length() == 1);
-				graph_level = usedGraphEdge->From->level;
+				unsigned int usedGraphEdgeID = currentEdge->usedGraphEdgeID;
+				assert(usedGraphEdgeID != FrozenGraph::noEdge);
+				graph_character = std::string(1, fG.edgeEmission(usedGraphEdgeID));
+				graph_level = fG.edgeLevel(usedGraphEdgeID);
 			}
 			else if((diff_current_x == 0) && (diff_current_y == 1))
 			{
@@ -7067,21 +7005,19 @@ void GraphAlignerUnique::seedAndExtend_backtrack_local(VirtualNWTable_Unique& vN
 			{
 				sequence_character = sequence.substr(currentEdge->from_y, 1);
 
-				Edge* usedGraphEdge = currentEdge->usedGraphEdge;
-				assert(usedGraphEdge != 0);
-				graph_character = g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
-				assert(graph_character.length() == 1);
-				graph_level = usedGraphEdge->From->level;
+				unsigned int usedGraphEdgeID = currentEdge->usedGraphEdgeID;
+				assert(usedGraphEdgeID != FrozenGraph::noEdge);
+				graph_character = std::string(1, fG.edgeEmission(usedGraphEdgeID));
+				graph_level = fG.edgeLevel(usedGraphEdgeID);
 			}
 			else if((diff_current_x == 1) && (diff_current_y == 0))
 			{
 				// gap in sequence
 				sequence_character = "_";
-				Edge* usedGraphEdge = currentEdge->usedGraphEdge;
-				assert(usedGraphEdge != 0);
-				graph_character = g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
-				assert(graph_character.length() == 1);
-				graph_level = usedGraphEdge->From->level;
+				unsigned int usedGraphEdgeID = currentEdge->usedGraphEdgeID;
+				assert(usedGraphEdgeID != FrozenGraph::noEdge);
+				graph_character = std::string(1, fG.edgeEmission(usedGraphEdgeID));
+				graph_level = fG.edgeLevel(usedGraphEdgeID);
 			}
 			else if((diff_current_x == 0) && (diff_current_y == 1))
 			{
@@ -7702,21 +7638,20 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine(int start_x, int
 			}
 			else
 			{
-				std::set<Edge*> incomingEdges = n->Incoming_Edges;
-				assert(incomingEdges.size() > 0);
+				unsigned int nodeID = fG.levelFirstNode(lI) + z;
+				assert(fG.endIncoming(nodeID) > fG.firstIncoming(nodeID));
 
 				runningNodeDistances_notStartInAffineGap_endInAnything_thisLevel[n] = std::map<Node*, backtrackBookkeeper>();
 				runningNodeDistances_notStartInAffineGap_endInAffineGap_thisLevel[n] = std::map<Node*, backtrackBookkeeper>();
 				runningNodeDistances_startInAffineGap_endInAnything_thisLevel[n] = std::map<Node*, backtrackBookkeeper>();
 				runningNodeDistances_startInAffineGap_endInAffineGap_thisLevel[n] = std::map<Node*, backtrackBookkeeper>();
 
-				for(std::set<Edge*>::iterator eIt = incomingEdges.begin(); eIt != incomingEdges.end(); eIt++)
+				for(unsigned int incomingI = fG.firstIncoming(nodeID); incomingI < fG.endIncoming(nodeID); incomingI++)
 				{
-					Edge* e = *eIt;
-					std::string edgeEmission = g->CODE.deCode(e->locus_id, e->emission);
-					assert(edgeEmission.length() == 1);
+					unsigned int edgeID = fG.incomingEdge(incomingI);
+					char edgeEmission = fG.edgeEmission(edgeID);
 
-					Node* nodeFrom = e->From;
+					Node* nodeFrom = fG.node(fG.edgeFrom(edgeID));
 
 					assert(runningNodeDistances_notStartInAffineGap_endInAnything != 0);
 					if(! runningNodeDistances_notStartInAffineGap_endInAnything->count(nodeFrom))
@@ -7740,23 +7675,23 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine(int start_x, int
 								backtrackBookkeeper newDistance_notStartInAffineGap_affine_start; // = previousDistance_notStartInAffineGap_endInAnything;
 								backtrackBookkeeper newDistance_notStartInAffineGap_affine_extend; // = previousDistance_notStartInAffineGap_endInAffineGap;
 
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_notStartInAffineGap_affine_start.S =           minusInfinity;
 
 									newDistance_notStartInAffineGap_affine_extend.S =          previousDistance_notStartInAffineGap_endInAffineGap.S;
 									newDistance_notStartInAffineGap_affine_extend.backtrack = &previousDistance_notStartInAffineGap_endInAffineGap;
-									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
 									newDistance_notStartInAffineGap_affine_start.S =           previousDistance_notStartInAffineGap_endInAnything.S + (S_openGap + S_extendGap);
 									newDistance_notStartInAffineGap_affine_start.backtrack =  &previousDistance_notStartInAffineGap_endInAnything;
-									newDistance_notStartInAffineGap_affine_start.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_start.takeNodeAndEdge(edgeID, fG);
 
 									newDistance_notStartInAffineGap_affine_extend.S =          previousDistance_notStartInAffineGap_endInAffineGap.S + S_extendGap;
 									newDistance_notStartInAffineGap_affine_extend.backtrack = &previousDistance_notStartInAffineGap_endInAffineGap;
-									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 
 								backtrackBookkeeper newDistance_notStartInAffineGap_affine_maximum = (newDistance_notStartInAffineGap_affine_start.S > newDistance_notStartInAffineGap_affine_extend.S) ? newDistance_notStartInAffineGap_affine_start : newDistance_notStartInAffineGap_affine_extend;
@@ -7771,23 +7706,23 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine(int start_x, int
 							{
 								backtrackBookkeeper newDistance_startInAffineGap_affine_start; // = previousDistance_startInAffineGap_endInAnything;
 								backtrackBookkeeper newDistance_startInAffineGap_affine_extend; // = previousDistance_startInAffineGap_endInAffineGap;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_startInAffineGap_affine_start.S = minusInfinity;
 
 									newDistance_startInAffineGap_affine_extend.S = previousDistance_startInAffineGap_endInAffineGap.S;
 									newDistance_startInAffineGap_affine_extend.backtrack = &previousDistance_startInAffineGap_endInAffineGap;
-									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
 									newDistance_startInAffineGap_affine_start.S = previousDistance_startInAffineGap_endInAnything.S + (S_openGap + S_extendGap);
 									newDistance_startInAffineGap_affine_start.backtrack = &previousDistance_startInAffineGap_endInAnything;
-									newDistance_startInAffineGap_affine_start.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_start.takeNodeAndEdge(edgeID, fG);
 
 									newDistance_startInAffineGap_affine_extend.S = previousDistance_startInAffineGap_endInAffineGap.S + S_extendGap;
 									newDistance_startInAffineGap_affine_extend.backtrack = &previousDistance_startInAffineGap_endInAffineGap;
-									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 
 								backtrackBookkeeper newDistance_startInAffineGap_affine_maximum = (newDistance_startInAffineGap_affine_start.S > newDistance_startInAffineGap_affine_extend.S) ? newDistance_startInAffineGap_affine_start : newDistance_startInAffineGap_affine_extend;
@@ -7806,12 +7741,12 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine(int start_x, int
 								backtrackBookkeeper alternativeScore_endInAffine = runningNodeDistances_notStartInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingNode);
 
 								backtrackBookkeeper followGraphGap; // = previousDistance_notStartInAffineGap_endInAnything;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									// followGraphGap.S = previousDistance_notStartInAffineGap_endInAnything;
 									followGraphGap.S = previousDistance_notStartInAffineGap_endInAnything.S;
 									followGraphGap.backtrack = &previousDistance_notStartInAffineGap_endInAnything;
-									followGraphGap.takeNodeAndEdge(nodeFrom, e);
+									followGraphGap.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
@@ -7829,12 +7764,12 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine(int start_x, int
 							{
 								backtrackBookkeeper alternativeScore_endInAffine = runningNodeDistances_startInAffineGap_endInAffineGap_thisLevel.at(n).at(interestingNode);
 								backtrackBookkeeper followGraphGap;// = previousDistance_startInAffineGap_endInAnything;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									// followGraphGap = previousDistance_startInAffineGap_endInAnything;
 									followGraphGap.S = previousDistance_startInAffineGap_endInAnything.S;
 									followGraphGap.backtrack = &previousDistance_startInAffineGap_endInAnything;
-									followGraphGap.takeNodeAndEdge(nodeFrom, e);
+									followGraphGap.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
@@ -8226,16 +8161,15 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 			}
 			else
 			{
-				std::set<Edge*> incomingEdges = n->Incoming_Edges;
-				assert(incomingEdges.size() > 0);
+				unsigned int nodeID = fG.levelFirstNode(lI) + z;
+				assert(fG.endIncoming(nodeID) > fG.firstIncoming(nodeID));
 
-				for(std::set<Edge*>::iterator eIt = incomingEdges.begin(); eIt != incomingEdges.end(); eIt++)
+				for(unsigned int incomingI = fG.firstIncoming(nodeID); incomingI < fG.endIncoming(nodeID); incomingI++)
 				{
-					Edge* e = *eIt;
-					std::string edgeEmission = g->CODE.deCode(e->locus_id, e->emission);
-					assert(edgeEmission.length() == 1);
+					unsigned int edgeID = fG.incomingEdge(incomingI);
+					char edgeEmission = fG.edgeEmission(edgeID);
 
-					Node* nodeFrom = e->From;
+					Node* nodeFrom = fG.node(fG.edgeFrom(edgeID));
 					for(std::set<Node*>::iterator nodeIt = keepTrackOfNodes.begin(); nodeIt != keepTrackOfNodes.end(); nodeIt++)
 					{
 						Node* interestingNode = *nodeIt;
@@ -8257,23 +8191,23 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 								backtrackBookkeeper_UGA newDistance_notStartInAffineGap_affine_start; // = previousDistance_notStartInAffineGap_endInAnything;
 								backtrackBookkeeper_UGA newDistance_notStartInAffineGap_affine_extend; // = previousDistance_notStartInAffineGap_endInAffineGap;
 
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_notStartInAffineGap_affine_start.S =           minusInfinity;
 
 									newDistance_notStartInAffineGap_affine_extend.S =          previousDistance_notStartInAffineGap_endInAffineGap->S;
 									newDistance_notStartInAffineGap_affine_extend.backtrack = (backtrackBookkeeper_UGA*)previousDistance_notStartInAffineGap_endInAffineGap;
-									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
 									newDistance_notStartInAffineGap_affine_start.S =           previousDistance_notStartInAffineGap_endInAnything->S + (S_openGap + S_extendGap);
 									newDistance_notStartInAffineGap_affine_start.backtrack =   (backtrackBookkeeper_UGA*)previousDistance_notStartInAffineGap_endInAnything;
-									newDistance_notStartInAffineGap_affine_start.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_start.takeNodeAndEdge(edgeID, fG);
 
 									newDistance_notStartInAffineGap_affine_extend.S =          previousDistance_notStartInAffineGap_endInAffineGap->S + S_extendGap;
 									newDistance_notStartInAffineGap_affine_extend.backtrack =  (backtrackBookkeeper_UGA*)previousDistance_notStartInAffineGap_endInAffineGap;
-									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_notStartInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 
 								backtrackBookkeeper_UGA newDistance_notStartInAffineGap_affine_maximum = (newDistance_notStartInAffineGap_affine_start.S > newDistance_notStartInAffineGap_affine_extend.S) ? newDistance_notStartInAffineGap_affine_start : newDistance_notStartInAffineGap_affine_extend;
@@ -8291,23 +8225,23 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 							{
 								backtrackBookkeeper_UGA newDistance_startInAffineGap_affine_start; // = previousDistance_startInAffineGap_endInAnything;
 								backtrackBookkeeper_UGA newDistance_startInAffineGap_affine_extend; // = previousDistance_startInAffineGap_endInAffineGap;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									newDistance_startInAffineGap_affine_start.S = minusInfinity;
 
 									newDistance_startInAffineGap_affine_extend.S = previousDistance_startInAffineGap_endInAffineGap->S;
 									newDistance_startInAffineGap_affine_extend.backtrack = (backtrackBookkeeper_UGA*)previousDistance_startInAffineGap_endInAffineGap;
-									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
 									newDistance_startInAffineGap_affine_start.S = previousDistance_startInAffineGap_endInAnything->S + (S_openGap + S_extendGap);
 									newDistance_startInAffineGap_affine_start.backtrack = (backtrackBookkeeper_UGA*)previousDistance_startInAffineGap_endInAnything;
-									newDistance_startInAffineGap_affine_start.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_start.takeNodeAndEdge(edgeID, fG);
 
 									newDistance_startInAffineGap_affine_extend.S = previousDistance_startInAffineGap_endInAffineGap->S + S_extendGap;
 									newDistance_startInAffineGap_affine_extend.backtrack = (backtrackBookkeeper_UGA*)previousDistance_startInAffineGap_endInAffineGap;
-									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(nodeFrom, e);
+									newDistance_startInAffineGap_affine_extend.takeNodeAndEdge(edgeID, fG);
 								}
 
 								backtrackBookkeeper_UGA newDistance_startInAffineGap_affine_maximum = (newDistance_startInAffineGap_affine_start.S > newDistance_startInAffineGap_affine_extend.S) ? newDistance_startInAffineGap_affine_start : newDistance_startInAffineGap_affine_extend;
@@ -8330,12 +8264,12 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 
 
 								backtrackBookkeeper_UGA followGraphGap; // = previousDistance_notStartInAffineGap_endInAnything;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									// followGraphGap.S = previousDistance_notStartInAffineGap_endInAnything;
 									followGraphGap.S = previousDistance_notStartInAffineGap_endInAnything->S;
 									followGraphGap.backtrack = (backtrackBookkeeper_UGA*)previousDistance_notStartInAffineGap_endInAnything;
-									followGraphGap.takeNodeAndEdge(nodeFrom, e);
+									followGraphGap.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
@@ -8361,12 +8295,12 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 
 
 								backtrackBookkeeper_UGA followGraphGap;// = previousDistance_startInAffineGap_endInAnything;
-								if(edgeEmission == "_")
+								if(edgeEmission == '_')
 								{
 									// followGraphGap = previousDistance_startInAffineGap_endInAnything;
 									followGraphGap.S = previousDistance_startInAffineGap_endInAnything->S;
 									followGraphGap.backtrack = (backtrackBookkeeper_UGA*)previousDistance_startInAffineGap_endInAnything;
-									followGraphGap.takeNodeAndEdge(nodeFrom, e);
+									followGraphGap.takeNodeAndEdge(edgeID, fG);
 								}
 								else
 								{
@@ -8436,7 +8370,7 @@ void GraphAlignerUnique::findShortGappedGraphConnection_affine_MTM(int start_x,
 //								assert(current->graphSequence.size() == 1);
 //								assert(current->graphSequence_levels.size() == 1);
 
-								usedEdges.push_back(current->usedEdges);
+								usedEdges.push_back(fG.edge(current->usedEdgeID));
 								graphSequence.push_back(current->graphSequence);
 								graphSequence_levels.push_back(current->graphSequence_levels);
 							}
@@ -8569,21 +8503,18 @@ void GraphAlignerUnique::kMerEdgeChains2vNW(VirtualNWTable_Unique& vNW, std::vec
 		int traversedEdges_nonGap = 0;
 		for(unsigned int eI = 0; eI < chain->traversedEdges.size(); eI++)
 		{
-			Edge* e = chain->traversedEdges.at(eI);
-			std::string e_emission = g->CODE.deCode(e->locus_id, e->emission);
-
-			Node* from = e->From;
-			Node* to = e->To;
+			unsigned int edgeID = fG.edgeID(chain->traversedEdges.at(eI));
+			bool e_isGap = fG.edgeIsGap(edgeID);
 
 			int y_from = initialY + traversedEdges_nonGap;
-			int y_to = y_from + ((e_emission != "_") ? 1 : 0);
+			int y_to = y_from + ((! e_isGap) ? 1 : 0);
 
-			int x_from = from->level;
-			int x_to = to->level;
+			int x_from = fG.nodeLevel(fG.edgeFrom(edgeID));
+			int x_to = fG.nodeLevel(fG.edgeTo(edgeID));
 			assert(x_from < x_to);
 
-			int z_from = nodesPerLevel_ordered_rev.at(x_from).at(from);
-			int z_to = nodesPerLevel_ordered_rev.at(x_to).at(to);
+			int z_from = fG.nodeZ(fG.edgeFrom(edgeID));
+			int z_to = fG.nodeZ(fG.edgeTo(edgeID));
 
 			bool firstEdge = (eI == 0);
 			bool lastEdge = (eI == (chain->traversedEdges.size() - 1));
@@ -8598,9 +8529,9 @@ void GraphAlignerUnique::kMerEdgeChains2vNW(VirtualNWTable_Unique& vNW, std::vec
 			}
 			assert(!(firstEdge && lastEdge));
 
-			chainPath->createAndAddEdge(x_from, y_from, z_from, x_to, y_to, z_to, e, edgeCode, edgeCode);
+			chainPath->createAndAddEdge(x_from, y_from, z_from, x_to, y_to, z_to, edgeID, edgeCode, edgeCode);
 
-			if(e_emission != "_")
+			if(! e_isGap)
 			{
 				traversedEdges_nonGap++;
 			}
@@ -9247,73 +9178,6 @@ void GraphAlignerUnique::selectedChainsConsistencyCheck(std::set<kMerEdgeChain*>
 }
 
 
-std::vector<std::pair<int, Edge*> > GraphAlignerUnique::_graph_get_previous_z_values_and_edges(int x, int z)
-{
-	assert(g != 0);
-	std::vector<std::pair<int, Edge*> > forReturn;
-	unsigned int uZ = (unsigned int)z;
-	assert(x > 0);
-	assert(x < (int)nodesPerLevel_ordered.size());
-	assert(z >= 0);
-	assert(z < (int)nodesPerLevel_ordered.at(x).size());
-	Node* thisZ = nodesPerLevel_ordered.at(x).at(uZ);
-	set<Edge*> incomingEdges = thisZ->Incoming_Edges;
-	set<Node*> nodesPreviousLevel;
-	assert(incomingEdges.size() > 0);
-	for(std::set<Edge*>::iterator eIt = incomingEdges.begin(); eIt != incomingEdges.end(); eIt++)
-	{
-		Edge* e = *eIt;
-		Node* fromNode = e->From;
-		int z_for_fromNode = nodesPerLevel_ordered_rev.at(x-1).at(fromNode);
-		forReturn.push_back(std::pair<int, Edge*>(z_for_fromNode, e));
-	}
-
-	return forReturn;
-}
-
-std::vector<std::pair<int, Edge*> > GraphAlignerUnique::_graph_get_next_z_values_and_edges(int x, int z)
-{
-	assert(g != 0);
-	std::vector<std::pair<int, Edge*> > forReturn;
-	unsigned int uZ = (unsigned int)z;
-	assert(x >= 0);
-	assert(x < (int)nodesPerLevel_ordered.size());
-	assert(z >= 0);
-	assert(z < (int)nodesPerLevel_ordered.at(x).size());
-	Node* thisZ = nodesPerLevel_ordered.at(x).at(uZ);
-	set<Edge*> outgoingEdges = thisZ->Outgoing_Edges;
-	set<Node*> nodesNextLevel;
-	assert(outgoingEdges.size() > 0);
-	for(std::set<Edge*>::iterator eIt = outgoingEdges.begin(); eIt != outgoingEdges.end(); eIt++)
-	{
-		Edge* e = *eIt;
-		Node* toNode = e->To;
-		int z_for_toNode = nodesPerLevel_ordered_rev.at(x+1).at(toNode);
-		forReturn.push_back(std::pair<int, Edge*>(z_for_toNode, e));
-	}
-
-	return forReturn;
-}
-
-std::vector<int> GraphAlignerUnique::_graph_get_previous_z_values(int x, int z)
-{
-	assert(g != 0);
-	std::vector<std::pair<int, Edge*> > previousZs = _graph_get_previous_z_values_and_edges(x, z);
-
-	std::set<int> forReturn;
-	for(unsigned int i = 0; i < previousZs.size(); i++)
-	{
-		int previousZ = previousZs.at(i).first;
-		forReturn.insert(previousZ);
-	}
-
-	return std::vector<int>(forReturn.begin(), forReturn.end());
-}
-
-
-
-
-
 double GraphAlignerUnique::score(std::string reconstructed_graph, std::vector<int> reconstructed_graph_levels, std::string reconstructed_sequence)
 {
 	assert(reconstructed_graph.length() == reconstructed_sequence.length());
@@ -9485,40 +9349,14 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 		assert(maxLevel_graph == -1);
 	}
 
-	class mScore {
-	public:
-		double D;
-		double GraphGap;
-		double SequenceGap;
-	};
-
-	class mScore_backtrace {
-	public:
-		backtraceStep_affine D;
-		backtraceStep_affine GraphGap;
-		backtraceStep_affine SequenceGap;
-	};
-
-	class mScore_alternatives {
-	public:
-		std::vector<double> D;
-		std::vector<double> GraphGap;
-		std::vector<double> SequenceGap;
-	};
-
-	class mScore_backtrace_alternatives {
-	public:
-		std::vector<backtraceStep_affine> D;
-		std::vector<backtraceStep_affine> GraphGap;
-		std::vector<backtraceStep_affine> SequenceGap;
-	};
-
-	std::map<int, std::map<int, std::map<int, mScore>> > scores;
-	std::map<int, std::map<int, std::map<int, mScore_backtrace>> > scores_backtrace;
+	// the NW table only keeps the cells which survive filtering, stored per diagonal - see BandedNWTable.h.
+	// m1_diagonal / m2_diagonal hold table indices of the surviving cells of the last two diagonals.
+	assert(omp_get_thread_num() < (int)bandedNWTables.size());
+	BandedNWTable& table = bandedNWTables.at(omp_get_thread_num());
+	table.reset(startLevel_graph, start_sequence, directionPositive);
 
-	std::vector<std::vector<int> > coordinates_for_backtracking;
-	std::vector<std::vector<int> > m1_diagonal;
-	std::vector<std::vector<int> > m2_diagonal;
+	std::vector<int> m1_diagonal;
+	std::vector<int> m2_diagonal;
 
 	bool verbose = false;
 
@@ -9577,7 +9415,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 	assert(max_seqI > min_seqI);
 
 	double currentMaximum = 0;
-	std::vector<std::vector<int> > currentMaxima_coordinates;
+	std::vector<int> currentMaxima_cells;
 
 	// init first cell
 	unsigned int statesPerLevel0 = g->NodesPerLevel.at(startLevel_graph).size();
@@ -9594,39 +9432,82 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 
 	for(unsigned int stateI = 0; stateI < statesPerLevel0; stateI++)
 	{
+		bandedNWCell startCell;
+		startCell.x = startLevel_graph;
+		startCell.y = start_sequence;
+		startCell.z = stateI;
+		startCell.D = (((int)stateI == startZ_graph) ? 0 : minusInfinity);
+		startCell.GraphGap = minusInfinity;
+		startCell.SequenceGap = minusInfinity;
+
+		int startCellI = table.addCell(startCell);
+
 		if((int)stateI == startZ_graph)
 		{
-			scores[startLevel_graph][start_sequence][stateI].D = 0;
-			scores_backtrace[startLevel_graph][start_sequence][stateI] = mScore_backtrace();
+			m1_diagonal.push_back(startCellI);
+			currentMaxima_cells.push_back(startCellI);
 		}
-		else
+	}
+	table.closeDiagonal();
+
+	std::map<NWPath*, std::pair<double, int> > hit_NW_paths;
+
+	// Runs of at least NWSlab_minimumStates cells at one (x, y) are extended with the slab kernels (see
+	// NWSlabKernel.h), shorter ones cell by cell. Both give the same maxima and backtraces.
+	bool useSlabKernels = NWSlab_applicable(S_match, S_mismatch, S_openGap, S_extendGap, S_graphGap);
+	NWSlabBuffers& slab = table.slab;
+
+	auto slabRunEnd = [&](const std::vector<int>& diagonal, int firstI) -> int {
+		const bandedNWCell& first_cell = table.cell(diagonal.at(firstI));
+		int lastI = firstI + 1;
+		while((lastI < (int)diagonal.size()) && (table.cell(diagonal.at(lastI)).x == first_cell.x) && (table.cell(diagonal.at(lastI)).y == first_cell.y))
 		{
-			scores[startLevel_graph][start_sequence][stateI].D = minusInfinity;
+			lastI++;
 		}
+		return lastI;
+	};
 
-		scores[startLevel_graph][start_sequence][stateI].GraphGap = minusInfinity;
-		scores[startLevel_graph][start_sequence][stateI].SequenceGap = minusInfinity;
+	auto toSlab = [&](double S) -> int {
+		if(S == minusInfinity)
+			return NWSlab_minusInfinity;
+		assert((S == (int)S) && (std::abs(S) < -NWSlab_minusInfinity / 2));
+		return (int)S;
+	};
 
-		if((int)stateI == startZ_graph)
+	auto fromSlab = [&](int S) -> double {
+		return ((S == NWSlab_minusInfinity) ? minusInfinity : (double)S);
+	};
+
+	auto loadSlab = [&](const std::vector<int>& diagonal, int firstI, int lastI, int levelI) -> void {
+		slab.resetSource(nodesPerLevel_ordered.at(levelI).size());
+		for(int runI = firstI; runI < lastI; runI++)
 		{
-			std::vector<int> existingCoordinates;
-			existingCoordinates.push_back(startLevel_graph);
-			existingCoordinates.push_back(start_sequence);
-			existingCoordinates.push_back(stateI);
-			m1_diagonal.push_back(existingCoordinates);
-			currentMaxima_coordinates.push_back(existingCoordinates);
+			const bandedNWCell& c = table.cell(diagonal.at(runI));
+			assert(c.x == levelI);
+			slab.D[c.z] = toSlab(c.D);
+			slab.GraphGap[c.z] = toSlab(c.GraphGap);
+			slab.SequenceGap[c.z] = toSlab(c.SequenceGap);
+			slab.cell[c.z] = diagonal.at(runI);
 		}
-	}
-
-	std::map<NWPath*, std::pair<double, std::vector<int> > > hit_NW_paths;
+	};
 
-//	std::cerr << "fullNeedleman_diagonal_extension:\n";
-//	std::cerr << "\tmin_seqI: " << min_seqI << "\n";
-//	std::cerr << "\tmin_seqI: " << min_seqI << "\n";
-//	std::cerr << "\tdirectionPositive: " << directionPositive << "\n" << std::flush;
+	// first maximum over the candidates into one target state, -1 if no candidate is there
+	auto slabBestEdge = [&](const NWSlabTransitions& T, int targetZ, const std::vector<int>& candidates) -> int {
+		int bestEdgeI = -1;
+		for(int edgeI = T.target_first_edge[targetZ]; edgeI < T.target_first_edge[targetZ + 1]; edgeI++)
+		{
+			if((candidates[edgeI] != NWSlab_absent) && ((bestEdgeI == -1) || (candidates[edgeI] > candidates[bestEdgeI])))
+			{
+				bestEdgeI = edgeI;
+			}
+		}
+		return bestEdgeI;
+	};
 
 	int lastMaximumIncrease_at_diagonalI = 0;
 
+	std::vector<int> m_thisDiagonal;
+	std::vector<int> m_thisDiagonal_filtered;
 
 	for(int diagonalI = 1; diagonalI <= diagonals; diagonalI++)
 	{
@@ -9636,532 +9517,478 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			std::cout << "\t diagonalI " << diagonalI << "/" << diagonals << ".\n" << std::flush;
 		}
 
-
-//		int scores_size = 0;
-//		for(std::map<int, std::map<int, std::map<int, mScore>> >::iterator it1 = scores.begin(); it1 != scores.end(); it1++)
-//		{
-//			for(std::map<int, std::map<int, mScore>>::iterator it2 = it1->second.begin(); it2 != it1->second.end(); it2++)
-//			{
-//				for(std::map<int, mScore>::iterator it3 = it2->second.begin(); it3 != it2->second.end(); it3++)
-//				{
-//					scores_size++;
-//				}
-//			}
-//		}
-		//std::cerr << "\t\tdiagonalI = " << diagonalI << " => scores_size: " << scores_size << "\n" << std::flush;
-
 		if((diagonalI - lastMaximumIncrease_at_diagonalI) > maximum_steps_nonIncrease)
 		{
 			break;
 		}
 
-		std::map<int, std::map<int, std::map<int, mScore_alternatives > > >  thisDiagonal;
-		std::map<int, std::map<int, std::map<int, mScore_backtrace_alternatives > > > thisDiagonal_backtrace;
+		assert(table.closedDiagonals() == diagonalI);
+
+		// levels reachable from the last two diagonals
+		int thisDiagonal_x_lo = max_levelI;
+		int thisDiagonal_x_hi = min_levelI;
+		for(unsigned int mI = 0; mI < (m1_diagonal.size() + m2_diagonal.size()); mI++)
+		{
+			int previous_levelI = table.cell((mI < m1_diagonal.size()) ? m1_diagonal.at(mI) : m2_diagonal.at(mI - m1_diagonal.size())).x;
+			thisDiagonal_x_lo = std::min(thisDiagonal_x_lo, previous_levelI + (directionPositive ? 0 : -1));
+			thisDiagonal_x_hi = std::max(thisDiagonal_x_hi, previous_levelI + (directionPositive ? 1 : 0));
+		}
+		thisDiagonal_x_lo = std::max(thisDiagonal_x_lo, min_levelI);
+		thisDiagonal_x_hi = std::min(thisDiagonal_x_hi, max_levelI);
+		table.beginDiagonal(thisDiagonal_x_lo, thisDiagonal_x_hi, nodesPerLevel_ordered);
 
 		if(verbose)
 			std::cout << "\t\tfrom m-2 diagonal" << "\n" << std::flush;
 
 		// extend from m-2 diagonal
-		for(int m2I = 0; m2I < (int)m2_diagonal.size(); m2I++)
+		for(int m2I = 0; m2I < (int)m2_diagonal.size(); )
 		{
-			std::vector<int>& previous_coordinates = m2_diagonal.at(m2I);
+			// cells are sorted, so all states at one (x, y) form a contiguous run
+			int m2I_end = slabRunEnd(m2_diagonal, m2I);
 
-			int previous_levelI = previous_coordinates.at(0);
-			int previous_seqI = previous_coordinates.at(1);
-			int previous_stateI = previous_coordinates.at(2);
+			const bandedNWCell& first_cell = table.cell(m2_diagonal.at(m2I));
+			int previous_levelI = first_cell.x;
+			int previous_seqI = first_cell.y;
 
-			int next_levelI = previous_coordinates.at(0) + (directionPositive ? 1 : -1);
-			int next_seqI = previous_coordinates.at(1) + (directionPositive ? 1 : -1);
+			int next_levelI = previous_levelI + (directionPositive ? 1 : -1);
+			int next_seqI = previous_seqI + (directionPositive ? 1 : -1);
 
-			if((next_levelI > max_levelI) || (next_seqI > max_seqI))
+			if((next_levelI > max_levelI) || (next_seqI > max_seqI) || (next_levelI < min_levelI) || (next_seqI < min_seqI))
+			{
+				m2I = m2I_end;
 				continue;
+			}
 
-			if((next_levelI < min_levelI) || (next_seqI < min_seqI))
-				continue;
+			char sequenceEmission = (directionPositive ? sequence.at(previous_seqI) : sequence.at(previous_seqI-1));
+
+			if(useSlabKernels && ((m2I_end - m2I) >= NWSlab_minimumStates))
+			{
+				const NWSlabTransitions& T = (directionPositive ? slabTransitions_forward.at(previous_levelI) : slabTransitions_backward.at(previous_levelI));
+				loadSlab(m2_diagonal, m2I, m2I_end, previous_levelI);
+				slab.reserveCandidates(T.edges());
 
-			std::string sequenceEmission = (directionPositive ? sequence.substr(previous_seqI, 1) : sequence.substr(previous_seqI-1, 1));
+				NWSlab_matchMismatch(T, slab.D.data(), sequenceEmission, (int)S_match, (int)S_mismatch, slab.candidates.data());
 
-			std::vector<std::pair<int, Edge*> > nextZs = (directionPositive ? _graph_get_next_z_values_and_edges(previous_levelI, previous_stateI) : _graph_get_previous_z_values_and_edges(previous_levelI, previous_stateI));
-			assert(nextZs.size() > 0);
+				for(int next_stateI = 0; next_stateI < T.targetStates(); next_stateI++)
+				{
+					int edgeI = slabBestEdge(T, next_stateI, slab.candidates);
+					if(edgeI == -1)
+						continue;
 
-			for(unsigned int zI = 0; zI < nextZs.size(); zI++)
+					table.openCell(next_levelI, next_seqI, next_stateI).offer_D(fromSlab(slab.candidates[edgeI]), bandedNWStep(slab.cell[T.edge_source_z[edgeI]], 0, T.edge_id[edgeI]));
+				}
+			}
+			else
 			{
-				std::pair<int, Edge*>& thisZjump = nextZs.at(zI);
-				int next_stateI = thisZjump.first;
+				for(int runI = m2I; runI < m2I_end; runI++)
+				{
+					int previous_cellI = m2_diagonal.at(runI);
+					const bandedNWCell& previous_cell = table.cell(previous_cellI);
+					int previous_stateI = previous_cell.z;
 
-				std::string edgeEmission = g->CODE.deCode(thisZjump.second->locus_id, thisZjump.second->emission);
-				assert(edgeEmission.size() == 1);
+					unsigned int previous_nodeID = fG.levelFirstNode(previous_levelI) + previous_stateI;
+					assert(fG.endDirected(previous_nodeID, directionPositive) > fG.firstDirected(previous_nodeID, directionPositive));
 
-				double score_MatchMismatch = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + ((edgeEmission == sequenceEmission) ? S_match : S_mismatch);
+					for(unsigned int directedI = fG.firstDirected(previous_nodeID, directionPositive); directedI < fG.endDirected(previous_nodeID, directionPositive); directedI++)
+					{
+						unsigned int edgeID = fG.directedEdge(directedI, directionPositive);
+						int next_stateI = fG.nodeZ(fG.directedTarget(edgeID, directionPositive));
 
-				backtraceStep_affine backtrack_MatchMismatch;
-				backtrack_MatchMismatch.x = previous_levelI;
-				backtrack_MatchMismatch.y = previous_seqI;
-				backtrack_MatchMismatch.z = previous_stateI;
-				backtrack_MatchMismatch.usedEdge = thisZjump.second;
-				backtrack_MatchMismatch.sourceMatrix = 0;
+						double score_MatchMismatch = previous_cell.D + ((fG.edgeEmission(edgeID) == sequenceEmission) ? S_match : S_mismatch);
 
-				thisDiagonal[next_levelI][next_seqI][next_stateI].D.push_back(score_MatchMismatch);
-				thisDiagonal_backtrace[next_levelI][next_seqI][next_stateI].D.push_back(backtrack_MatchMismatch);
+						table.openCell(next_levelI, next_seqI, next_stateI).offer_D(score_MatchMismatch, bandedNWStep(previous_cellI, 0, edgeID));
+					}
+				}
 			}
+
+			m2I = m2I_end;
 		}
 
 		if(verbose)
 			std::cout << "\t\tfrom m-1 diagonal" << "\n" << std::flush;
 
 		// extend from m-1 diagonal
-		for(int m1I = 0; m1I < (int)m1_diagonal.size(); m1I++)
+		for(int m1I = 0; m1I < (int)m1_diagonal.size(); )
 		{
-			std::vector<int>& previous_coordinates = m1_diagonal.at(m1I);
+			int m1I_end = slabRunEnd(m1_diagonal, m1I);
 
-			int previous_levelI = previous_coordinates.at(0);
-			int previous_seqI = previous_coordinates.at(1);
-			int previous_stateI = previous_coordinates.at(2);
+			const bandedNWCell& first_cell = table.cell(m1_diagonal.at(m1I));
+			int previous_levelI = first_cell.x;
+			int previous_seqI = first_cell.y;
 
-			// gap in graph
-			int gapInGraph_next_levelI = previous_coordinates.at(0);
-			int gapInGraph_next_seqI = previous_coordinates.at(1) + (directionPositive ? 1 : -1);
-			if	(
+			int gapInGraph_next_levelI = previous_levelI;
+			int gapInGraph_next_seqI = previous_seqI + (directionPositive ? 1 : -1);
+			bool gapInGraph_possible = (
 					(directionPositive && (gapInGraph_next_levelI <= max_levelI) && (gapInGraph_next_seqI <= max_seqI)) ||
 					((! directionPositive) && (gapInGraph_next_levelI >= min_levelI) && (gapInGraph_next_seqI >= min_seqI))
-				)
-			{
-				double score_gapInGraph_open = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + S_openGap + S_extendGap;
-				if((! directionPositive) && (gapInGraph_next_levelI == 0))
-				{
-					// score_gapInGraph_open = minusInfinity;
-				}
-				int gapInGraph_next_stateI = previous_stateI;
+				);
 
-				backtraceStep_affine backtrack_gapInGraph_open;
-				backtrack_gapInGraph_open.x = previous_levelI;
-				backtrack_gapInGraph_open.y = previous_seqI;
-				backtrack_gapInGraph_open.z = previous_stateI;
-				backtrack_gapInGraph_open.usedEdge = 0;
-				backtrack_gapInGraph_open.sourceMatrix = 0;
+			int gapInSequence_next_levelI = previous_levelI + (directionPositive ? 1 : -1);
+			int gapInSequence_next_seqI = previous_seqI;
+			bool gapInSequence_possible = (
+					(directionPositive && (gapInSequence_next_levelI <= max_levelI) && (gapInSequence_next_seqI <= max_seqI)) ||
+					((! directionPositive) && (gapInSequence_next_levelI >= min_levelI) && (gapInSequence_next_seqI >= min_seqI))
+				);
 
-				thisDiagonal[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(score_gapInGraph_open);
-				thisDiagonal_backtrace[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(backtrack_gapInGraph_open);
+			if(useSlabKernels && ((m1I_end - m1I) >= NWSlab_minimumStates))
+			{
+				int states = nodesPerLevel_ordered.at(previous_levelI).size();
+				loadSlab(m1_diagonal, m1I, m1I_end, previous_levelI);
 
-				double score_gapInGraph_extend = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).GraphGap + S_extendGap;
-				if((! directionPositive) && (gapInGraph_next_levelI == 0))
+				// gap in graph
+				if(gapInGraph_possible)
 				{
-					// score_gapInGraph_extend = minusInfinity;
-				}
-
-				backtraceStep_affine backtrack_gapInGraph_extend;
-				backtrack_gapInGraph_extend.x = previous_levelI;
-				backtrack_gapInGraph_extend.y = previous_seqI;
-				backtrack_gapInGraph_extend.z = previous_stateI;
-				backtrack_gapInGraph_extend.usedEdge = 0;
-				backtrack_gapInGraph_extend.sourceMatrix = 1;
-
-				thisDiagonal[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(score_gapInGraph_extend);
-				thisDiagonal_backtrace[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(backtrack_gapInGraph_extend);
-			}
+					slab.reserveCandidates(states);
+					NWSlab_graphGap(states, slab.D.data(), slab.GraphGap.data(), (int)S_openGap, (int)S_extendGap, slab.candidates.data(), slab.candidates_sourceMatrix.data());
 
-			// gap in sequence
-			int gapInSequence_next_levelI = previous_coordinates.at(0) + (directionPositive ? 1 : -1);
-			int gapInSequence_next_seqI = previous_coordinates.at(1);
+					for(int stateI = 0; stateI < states; stateI++)
+					{
+						if(slab.candidates[stateI] == NWSlab_absent)
+							continue;
 
-			if	(
-					(directionPositive && (gapInSequence_next_levelI <= max_levelI) && (gapInSequence_next_seqI <= max_seqI)) ||
-					((! directionPositive) && (gapInSequence_next_levelI >= min_levelI) && (gapInSequence_next_seqI >= min_seqI))
-				)
-			{
-				std::vector<std::pair<int, Edge*> > nextZs = (directionPositive ? _graph_get_next_z_values_and_edges(previous_levelI, previous_stateI) : _graph_get_previous_z_values_and_edges(previous_levelI, previous_stateI));
-				assert(nextZs.size() > 0);
+						table.openCell(gapInGraph_next_levelI, gapInGraph_next_seqI, stateI).offer_GraphGap(fromSlab(slab.candidates[stateI]), bandedNWStep(slab.cell[stateI], slab.candidates_sourceMatrix[stateI], FrozenGraph::noEdge));
+					}
+				}
 
-				for(unsigned int zI = 0; zI < nextZs.size(); zI++)
+				// gap in sequence
+				if(gapInSequence_possible)
 				{
-					std::pair<int, Edge*>& thisZjump = nextZs.at(zI);
-					int next_stateI = thisZjump.first;
+					const NWSlabTransitions& T = (directionPositive ? slabTransitions_forward.at(previous_levelI) : slabTransitions_backward.at(previous_levelI));
+					slab.reserveCandidates(T.edges());
+					NWSlab_sequenceGap(T, slab.D.data(), slab.SequenceGap.data(), (int)S_openGap, (int)S_extendGap, (int)S_graphGap, slab.candidates.data(), slab.candidates_sourceMatrix.data(), slab.candidates_nonAffine.data());
 
-					std::string edgeEmission = g->CODE.deCode(thisZjump.second->locus_id, thisZjump.second->emission);
-					assert(edgeEmission.size() == 1);
+					for(int next_stateI = 0; next_stateI < T.targetStates(); next_stateI++)
+					{
+						int edgeI = slabBestEdge(T, next_stateI, slab.candidates);
+						if(edgeI == -1)
+							continue;
 
-					// open sequence gap
+						bandedNWCandidates& gapInSequence_next = table.openCell(gapInSequence_next_levelI, gapInSequence_next_seqI, next_stateI);
+						gapInSequence_next.offer_SequenceGap(fromSlab(slab.candidates[edgeI]), bandedNWStep(slab.cell[T.edge_source_z[edgeI]], slab.candidates_sourceMatrix[edgeI], T.edge_id[edgeI]));
 
-					double score_gapInSequence_open = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + S_openGap + S_extendGap;
-					if(edgeEmission == "_")
-					{
-						score_gapInSequence_open = minusInfinity;
-					}
-					if((! directionPositive) && (gapInSequence_next_seqI == 0))
-					{
-						// score_gapInSequence_open = minusInfinity;
+						int nonAffine_edgeI = slabBestEdge(T, next_stateI, slab.candidates_nonAffine);
+						if(nonAffine_edgeI != -1)
+						{
+							gapInSequence_next.offer_D(fromSlab(slab.candidates_nonAffine[nonAffine_edgeI]), bandedNWStep(slab.cell[T.edge_source_z[nonAffine_edgeI]], 0, T.edge_id[nonAffine_edgeI]));
+						}
 					}
+				}
 
-					backtraceStep_affine backtrack_gapInSequence_open;
-					backtrack_gapInSequence_open.x = previous_levelI;
-					backtrack_gapInSequence_open.y = previous_seqI;
-					backtrack_gapInSequence_open.z = previous_stateI;
-					backtrack_gapInSequence_open.usedEdge = thisZjump.second;
-					backtrack_gapInSequence_open.sourceMatrix = 0;
+				m1I = m1I_end;
+				continue;
+			}
 
-					thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(score_gapInSequence_open);
-					thisDiagonal_backtrace[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(backtrack_gapInSequence_open);
+			for(int runI = m1I; runI < m1I_end; runI++)
+			{
+				int previous_cellI = m1_diagonal.at(runI);
+				const bandedNWCell& previous_cell = table.cell(previous_cellI);
+				int previous_stateI = previous_cell.z;
 
-					// extend sequence gap
+				// gap in graph
+				if(gapInGraph_possible)
+				{
+					int gapInGraph_next_stateI = previous_stateI;
+					bandedNWCandidates& gapInGraph_next = table.openCell(gapInGraph_next_levelI, gapInGraph_next_seqI, gapInGraph_next_stateI);
 
-					double score_gapInSequence_extend = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).SequenceGap + S_extendGap;
-//					if(edgeEmission == "_")
-//					{
-//						score_gapInSequence_extend = minusInfinity;
-//					}
-					if(edgeEmission == "_")
-					{
-						if(scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).SequenceGap == minusInfinity)
-						{
-							score_gapInSequence_extend = minusInfinity;
-						}
-						else
-						{
-							score_gapInSequence_extend = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).SequenceGap +  S_graphGap;
-						}
-					}
-					if((! directionPositive) && (gapInSequence_next_seqI == 0))
-					{
-						// score_gapInSequence_extend = minusInfinity;
-					}
+					double score_gapInGraph_open = previous_cell.D + S_openGap + S_extendGap;
+					gapInGraph_next.offer_GraphGap(score_gapInGraph_open, bandedNWStep(previous_cellI, 0, FrozenGraph::noEdge));
 
-					backtraceStep_affine backtrack_gapInSequence_extend;
-					backtrack_gapInSequence_extend.x = previous_levelI;
-					backtrack_gapInSequence_extend.y = previous_seqI;
-					backtrack_gapInSequence_extend.z = previous_stateI;
-					backtrack_gapInSequence_extend.usedEdge = thisZjump.second;
-					backtrack_gapInSequence_extend.sourceMatrix = 2;
+					double score_gapInGraph_extend = previous_cell.GraphGap + S_extendGap;
+					gapInGraph_next.offer_GraphGap(score_gapInGraph_extend, bandedNWStep(previous_cellI, 1, FrozenGraph::noEdge));
+				}
 
-					thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(score_gapInSequence_extend);
-					thisDiagonal_backtrace[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(backtrack_gapInSequence_extend);
+				// gap in sequence
+				if(gapInSequence_possible)
+				{
+					unsigned int previous_nodeID = fG.levelFirstNode(previous_levelI) + previous_stateI;
+					assert(fG.endDirected(previous_nodeID, directionPositive) > fG.firstDirected(previous_nodeID, directionPositive));
 
-					// non-affine sequence gap
-					if(edgeEmission == "_")
+					for(unsigned int directedI = fG.firstDirected(previous_nodeID, directionPositive); directedI < fG.endDirected(previous_nodeID, directionPositive); directedI++)
 					{
-						double score_gapInSequence_nonAffine = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + S_graphGap;
+						unsigned int edgeID = fG.directedEdge(directedI, directionPositive);
+						int next_stateI = fG.nodeZ(fG.directedTarget(edgeID, directionPositive));
 
-						backtraceStep_affine backtrack_gapInSequence_nonAffine;
-						backtrack_gapInSequence_nonAffine.x = previous_levelI;
-						backtrack_gapInSequence_nonAffine.y = previous_seqI;
-						backtrack_gapInSequence_nonAffine.z = previous_stateI;
-						backtrack_gapInSequence_nonAffine.usedEdge = thisZjump.second;
-						backtrack_gapInSequence_nonAffine.sourceMatrix = 0;
+						bool edgeIsGap = fG.edgeIsGap(edgeID);
 
-						thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].D.push_back(score_gapInSequence_nonAffine);
-						thisDiagonal_backtrace[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].D.push_back(backtrack_gapInSequence_nonAffine);
+						bandedNWCandidates& gapInSequence_next = table.openCell(gapInSequence_next_levelI, gapInSequence_next_seqI, next_stateI);
+
+						// open sequence gap
+
+						double score_gapInSequence_open = previous_cell.D + S_openGap + S_extendGap;
+						if(edgeIsGap)
+						{
+							score_gapInSequence_open = minusInfinity;
+						}
+						gapInSequence_next.offer_SequenceGap(score_gapInSequence_open, bandedNWStep(previous_cellI, 0, edgeID));
+
+						// extend sequence gap
+
+						double score_gapInSequence_extend = previous_cell.SequenceGap + S_extendGap;
+						if(edgeIsGap)
+						{
+							if(previous_cell.SequenceGap == minusInfinity)
+							{
+								score_gapInSequence_extend = minusInfinity;
+							}
+							else
+							{
+								score_gapInSequence_extend = previous_cell.SequenceGap +  S_graphGap;
+							}
+						}
+						gapInSequence_next.offer_SequenceGap(score_gapInSequence_extend, bandedNWStep(previous_cellI, 2, edgeID));
+
+						// non-affine sequence gap
+						if(edgeIsGap)
+						{
+							double score_gapInSequence_nonAffine = previous_cell.D + S_graphGap;
+							gapInSequence_next.offer_D(score_gapInSequence_nonAffine, bandedNWStep(previous_cellI, 0, edgeID));
+						}
 					}
 				}
 			}
+
+			m1I = m1I_end;
 		}
 
 		if(verbose)
 			std::cout << "\t\tmaximal" << "\n" << std::flush;
 
-		// call maxima for this diagonal
-		std::vector<std::vector<int> > m_thisDiagonal;
-		for(std::map<int, std::map<int, std::map<int, mScore_alternatives > > >::iterator diagIt = thisDiagonal.begin(); diagIt != thisDiagonal.end(); diagIt++)
+		// call maxima for this diagonal, in (x, y, z) order
+		m_thisDiagonal.clear();
+		const std::vector<std::pair<unsigned int, int> >& openCells = table.openCellsSorted();
+		for(unsigned int openI = 0; openI < openCells.size(); openI++)
 		{
-			int levelI = diagIt->first;
-			for(std::map<int, std::map<int, mScore_alternatives > >::iterator diagIt2 = diagIt->second.begin(); diagIt2 != diagIt->second.end(); diagIt2++)
-			{
-				int seqI = diagIt2->first;
-				for(std::map<int, mScore_alternatives >::iterator diagIt3 = diagIt2->second.begin(); diagIt3 != diagIt2->second.end(); diagIt3++)
-				{
-					int stateI = diagIt3->first;
+			bandedNWCandidates& candidates = table.openCandidates(openCells.at(openI).second);
+			int levelI = candidates.x;
+			int seqI = candidates.y;
+			int stateI = candidates.z;
 
-					// call maxima for GraphGap
-					std::vector<double>& scores_GraphGap = diagIt2->second.at(stateI).GraphGap;
-					std::vector<backtraceStep_affine>& scores_GraphGap_bt = thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).GraphGap;
-					double selectedScore_GraphGap;
-					backtraceStep_affine selectedStep_GraphGap;
+			// the index this cell will have if it is stored
+			int thisCellI = table.nextCellIndex();
 
-					if(scores_GraphGap.size() > 0)
-					{
-						std::pair<double, unsigned int> maxScore_GraphGap = Utilities::findVectorMaxP_nonCritical(scores_GraphGap, &(rng_seeds.at(omp_get_thread_num())));
-						selectedScore_GraphGap = maxScore_GraphGap.first;
-						selectedStep_GraphGap = scores_GraphGap_bt.at(maxScore_GraphGap.second);
-					}
-					else
-					{
-						selectedScore_GraphGap = minusInfinity;
-					}
+			// maxima for GraphGap and SequenceGap
+			double selectedScore_GraphGap = (candidates.have_GraphGap ? candidates.GraphGap : minusInfinity);
+			bandedNWStep selectedStep_GraphGap = (candidates.have_GraphGap ? candidates.GraphGap_backtrace : bandedNWStep());
 
-					// call maxima for SequenceGap
-					std::vector<double>& scores_SequenceGap = diagIt2->second.at(stateI).SequenceGap;
-					std::vector<backtraceStep_affine>& scores_SequenceGap_bt = thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).SequenceGap;
+			double selectedScore_SequenceGap = (candidates.have_SequenceGap ? candidates.SequenceGap : minusInfinity);
+			bandedNWStep selectedStep_SequenceGap = (candidates.have_SequenceGap ? candidates.SequenceGap_backtrace : bandedNWStep());
 
-					double selectedScore_SequenceGap;
-					backtraceStep_affine selectedStep_SequenceGap;
-					if(scores_SequenceGap.size() > 0)
+			// two additional steps for D, jumping from the two gap matrices
+			candidates.offer_D(selectedScore_GraphGap, bandedNWStep(thisCellI, 1, FrozenGraph::noEdge));
+			candidates.offer_D(selectedScore_SequenceGap, bandedNWStep(thisCellI, 2, FrozenGraph::noEdge));
+
+			// final maximum for D
+			assert(candidates.have_D);
+			double maxScore_D = candidates.D;
+
+			bool blockOutCell = false;
+			if(directionPositive)
+			{
+				std::set<NWEdge*> emanatingNWEdges = blockedPathsTable->getEdgesEmanatingFrom(levelI, seqI, stateI);
+				if((emanatingNWEdges.size() > 0) && (! returnGlobalScore))
+				{
+					for(std::set<NWEdge*>::iterator edgeIt = emanatingNWEdges.begin(); edgeIt != emanatingNWEdges.end(); edgeIt++)
 					{
-						std::pair<double, unsigned int> maxScore_SequenceGap = Utilities::findVectorMaxP_nonCritical(scores_SequenceGap, &(rng_seeds.at(omp_get_thread_num())));
-						selectedScore_SequenceGap = maxScore_SequenceGap.first;
-						selectedStep_SequenceGap = scores_SequenceGap_bt.at(maxScore_SequenceGap.second);
+						NWEdge* e = *edgeIt;
+						NWPath* correspondingPath = e->path;
+						if(hit_NW_paths.count(correspondingPath) == 0)
+						{
+							hit_NW_paths[correspondingPath] = std::make_pair(maxScore_D, thisCellI);
+						}
 					}
-					else
+					blockOutCell = true;
+				}
+			}
+			else
+			{
+				std::set<NWEdge*> incomingNWEdges = blockedPathsTable->getEdgesGoingInto(levelI, seqI, stateI);
+				if((incomingNWEdges.size() > 0) && (! returnGlobalScore))
+				{
+					for(std::set<NWEdge*>::iterator edgeIt = incomingNWEdges.begin(); edgeIt != incomingNWEdges.end(); edgeIt++)
 					{
-						selectedScore_SequenceGap = minusInfinity;
+						NWEdge* e = *edgeIt;
+						NWPath* correspondingPath = e->path;
+						if(hit_NW_paths.count(correspondingPath) == 0)
+						{
+							hit_NW_paths[correspondingPath] = std::make_pair(maxScore_D, thisCellI);
+						}
 					}
+					blockOutCell = true;
+				}
+			}
 
-					// two additional steps for D, jumping from the two gap matrices
-
-					double score_intoD_fromGraphGap = selectedScore_GraphGap;
-					backtraceStep_affine step_intoD_fromGraphGap;
-					step_intoD_fromGraphGap.x = levelI;
-					step_intoD_fromGraphGap.y = seqI;
-					step_intoD_fromGraphGap.z = stateI;
-					step_intoD_fromGraphGap.sourceMatrix = 1;
-					step_intoD_fromGraphGap.usedEdge = 0;
-					thisDiagonal.at(levelI).at(seqI).at(stateI).D.push_back(score_intoD_fromGraphGap);
-					thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).D.push_back(step_intoD_fromGraphGap);
-
-					double score_intoD_fromSequenceGap = selectedScore_SequenceGap;
-					backtraceStep_affine step_intoD_fromSequenceGap;
-					step_intoD_fromSequenceGap.x = levelI;
-					step_intoD_fromSequenceGap.y = seqI;
-					step_intoD_fromSequenceGap.z = stateI;
-					step_intoD_fromSequenceGap.sourceMatrix = 2;
-					step_intoD_fromSequenceGap.usedEdge = 0;
-					thisDiagonal.at(levelI).at(seqI).at(stateI).D.push_back(score_intoD_fromSequenceGap);
-					thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).D.push_back(step_intoD_fromSequenceGap);
+			bandedNWCell thisCell;
+			thisCell.x = levelI;
+			thisCell.y = seqI;
+			thisCell.z = stateI;
+			thisCell.D_backtrace = candidates.D_backtrace;
+			thisCell.GraphGap_backtrace = selectedStep_GraphGap;
+			thisCell.SequenceGap_backtrace = selectedStep_SequenceGap;
+			assert(thisCell.D_backtrace.cell != -1);
 
-					// find final maximum for D
-					std::vector<double>& scores_D = diagIt2->second.at(stateI).D;
-					std::vector<backtraceStep_affine>& scores_D_bt = thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).D;
-					assert(scores_D.size() == scores_D_bt.size());
+			if(blockOutCell)
+			{
+				double scoreThatWillBeDeleted = maxScore_D;
+				if(scoreThatWillBeDeleted == currentMaximum)
+				{
+					currentMaxima_cells.push_back(thisCellI);
+					lastMaximumIncrease_at_diagonalI = diagonalI;
+				}
+				else if(scoreThatWillBeDeleted > currentMaximum)
+				{
+					currentMaximum = scoreThatWillBeDeleted;
+					currentMaxima_cells.clear();
+					currentMaxima_cells.push_back(thisCellI);
+					lastMaximumIncrease_at_diagonalI = diagonalI;
+				}
 
-					std::pair<double, unsigned int> maxScore_D = Utilities::findVectorMaxP_nonCritical(scores_D, &(rng_seeds.at(omp_get_thread_num())));
+				thisCell.D = minusInfinity;
+				thisCell.GraphGap = minusInfinity;
+				thisCell.SequenceGap = minusInfinity;
+				table.addCell(thisCell);
+			}
+			else
+			{
+				if(maxScore_D >= diagonal_stop_threshold)
+				{
+					thisCell.D = maxScore_D;
+					thisCell.GraphGap = selectedScore_GraphGap;
+					thisCell.SequenceGap = selectedScore_SequenceGap;
+					table.addCell(thisCell);
 
-					bool blockOutCell = false;
-					if(directionPositive)
+					if(preferSequenceCompleAlignments)
 					{
-						std::set<NWEdge*> emanatingNWEdges = blockedPathsTable->getEdgesEmanatingFrom(levelI, seqI, stateI);
-						if((emanatingNWEdges.size() > 0) && (! returnGlobalScore))
+						std::string id_levelI_stateI = Utilities::ItoStr(levelI) + "/" + Utilities::ItoStr(stateI);
+						if(directionPositive)
 						{
-							for(std::set<NWEdge*>::iterator edgeIt = emanatingNWEdges.begin(); edgeIt != emanatingNWEdges.end(); edgeIt++)
+							if(seqI == max_seqI)
 							{
-								NWEdge* e = *edgeIt;
-								NWPath* correspondingPath = e->path;
-								if(hit_NW_paths.count(correspondingPath) == 0)
-								{
-									std::pair<double, std::vector<int> > pathEntry;
-									pathEntry.first = maxScore_D.first;
-									pathEntry.second.push_back(levelI);
-									pathEntry.second.push_back(seqI);
-									pathEntry.second.push_back(stateI);
-									hit_NW_paths[correspondingPath] = pathEntry;
-								}
+								achieved_complete_sequence_alignments.insert(id_levelI_stateI);
 							}
-							blockOutCell = true;
 						}
-					}
-					else
-					{
-						std::set<NWEdge*> incomingNWEdges = blockedPathsTable->getEdgesGoingInto(levelI, seqI, stateI);
-						if((incomingNWEdges.size() > 0) && (! returnGlobalScore))
+						else
 						{
-							for(std::set<NWEdge*>::iterator edgeIt = incomingNWEdges.begin(); edgeIt != incomingNWEdges.end(); edgeIt++)
+							if(seqI == min_seqI)
 							{
-								NWEdge* e = *edgeIt;
-								NWPath* correspondingPath = e->path;
-								if(hit_NW_paths.count(correspondingPath) == 0)
-								{
-									std::pair<double, std::vector<int> > pathEntry;
-									pathEntry.first = maxScore_D.first;
-									pathEntry.second.push_back(levelI);
-									pathEntry.second.push_back(seqI);
-									pathEntry.second.push_back(stateI);
-									hit_NW_paths[correspondingPath] = pathEntry;
-								}
+								achieved_complete_sequence_alignments.insert(id_levelI_stateI);
 							}
-							blockOutCell = true;
 						}
 					}
 
-					if(blockOutCell)
+					m_thisDiagonal.push_back(thisCellI);
+
+					bandedNWStep oneRealStepBackwards = thisCell.D_backtrace;
+					while(oneRealStepBackwards.cell == thisCellI)
 					{
-						double scoreThatWillBeDeleted = maxScore_D.first;
-						std::vector<int> thisCoordinates;
-						thisCoordinates.push_back(levelI);
-						thisCoordinates.push_back(seqI);
-						thisCoordinates.push_back(stateI);
-						if(scoreThatWillBeDeleted == currentMaximum)
+						assert(oneRealStepBackwards.sourceMatrix != 0);
+						if(oneRealStepBackwards.sourceMatrix == 1)
 						{
-							currentMaxima_coordinates.push_back(thisCoordinates);
-							lastMaximumIncrease_at_diagonalI = diagonalI;
+							oneRealStepBackwards = thisCell.GraphGap_backtrace;
 						}
-						else if(scoreThatWillBeDeleted > currentMaximum)
+						else if(oneRealStepBackwards.sourceMatrix == 2)
 						{
-							currentMaximum = scoreThatWillBeDeleted;
-							currentMaxima_coordinates.clear();
-							currentMaxima_coordinates.push_back(thisCoordinates);
-							lastMaximumIncrease_at_diagonalI = diagonalI;
+							oneRealStepBackwards = thisCell.SequenceGap_backtrace;
 						}
-
-						scores[levelI][seqI][stateI].D = minusInfinity;
-						scores_backtrace[levelI][seqI][stateI].D = scores_D_bt.at(maxScore_D.second);
-
-						assert(scores_backtrace[levelI][seqI][stateI].D.x != -1);
-
-						scores[levelI][seqI][stateI].GraphGap = minusInfinity;
-						scores_backtrace[levelI][seqI][stateI].GraphGap = selectedStep_GraphGap;
-
-						scores[levelI][seqI][stateI].SequenceGap = minusInfinity;
-						scores_backtrace[levelI][seqI][stateI].SequenceGap = selectedStep_SequenceGap;
+						else
+						{
+							assert(1 == 0);
+						}
+					}
+					const bandedNWCell& previousCell = table.cell(oneRealStepBackwards.cell);
+					int previousScore;
+					if(oneRealStepBackwards.sourceMatrix == 0)
+					{
+						previousScore = previousCell.D;
+					}
+					else if(oneRealStepBackwards.sourceMatrix == 1)
+					{
+						previousScore = previousCell.GraphGap;
+					}
+					else if(oneRealStepBackwards.sourceMatrix == 2)
+					{
+						previousScore = previousCell.SequenceGap;
 					}
 					else
 					{
-						if(maxScore_D.first >= diagonal_stop_threshold)
-						{
-							scores[levelI][seqI][stateI].D = maxScore_D.first;
-							scores_backtrace[levelI][seqI][stateI].D = scores_D_bt.at(maxScore_D.second);
-
-							assert(scores_backtrace[levelI][seqI][stateI].D.x != -1);
-
-							scores[levelI][seqI][stateI].GraphGap = selectedScore_GraphGap;
-							scores_backtrace[levelI][seqI][stateI].GraphGap = selectedStep_GraphGap;
-
-							scores[levelI][seqI][stateI].SequenceGap = selectedScore_SequenceGap;
-							scores_backtrace[levelI][seqI][stateI].SequenceGap = selectedStep_SequenceGap;
-
-							if(preferSequenceCompleAlignments)
-							{
-								std::string id_levelI_stateI = Utilities::ItoStr(levelI) + "/" + Utilities::ItoStr(stateI);
-								if(directionPositive)
-								{
-									if(seqI == max_seqI)
-									{
-										achieved_complete_sequence_alignments.insert(id_levelI_stateI);
-									}
-								}
-								else
-								{
-									if(seqI == min_seqI)
-									{
-										achieved_complete_sequence_alignments.insert(id_levelI_stateI);
-									}
-								}
-							}
-
-							std::vector<int> thisCoordinates;
-							thisCoordinates.push_back(levelI);
-							thisCoordinates.push_back(seqI);
-							thisCoordinates.push_back(stateI);
-							m_thisDiagonal.push_back(thisCoordinates);
-
-							backtraceStep_affine oneRealStepBackwards = scores_backtrace[levelI][seqI][stateI].D;
-							while((oneRealStepBackwards.x == levelI) && (oneRealStepBackwards.y == seqI))
-							{
-								assert(oneRealStepBackwards.sourceMatrix != 0);
-								if(oneRealStepBackwards.sourceMatrix == 1)
-								{
-									oneRealStepBackwards = scores_backtrace[oneRealStepBackwards.x][oneRealStepBackwards.y][oneRealStepBackwards.z].GraphGap;
-								}
-								else if(oneRealStepBackwards.sourceMatrix == 2)
-								{
-									oneRealStepBackwards = scores_backtrace[oneRealStepBackwards.x][oneRealStepBackwards.y][oneRealStepBackwards.z].SequenceGap;
-								}
-								else
-								{
-									assert(1 == 0);
-								}
-							}
-							int previousScore;
-							if(oneRealStepBackwards.sourceMatrix == 0)
-							{
-								previousScore = scores[oneRealStepBackwards.x][oneRealStepBackwards.y][oneRealStepBackwards.z].D;
-							}
-							else if(oneRealStepBackwards.sourceMatrix == 1)
-							{
-								previousScore = scores[oneRealStepBackwards.x][oneRealStepBackwards.y][oneRealStepBackwards.z].GraphGap;
-							}
-							else if(oneRealStepBackwards.sourceMatrix == 2)
-							{
-								previousScore = scores[oneRealStepBackwards.x][oneRealStepBackwards.y][oneRealStepBackwards.z].SequenceGap;
-							}
-							else
-							{
-								assert( 1 == 0 );
-							}
-							int scoreDifference = maxScore_D.first - previousScore;
+						assert( 1 == 0 );
+					}
+					int scoreDifference = maxScore_D - previousScore;
 
-							if(maxScore_D.first == currentMaximum)
-							{
-								if(scoreDifference != 0)
-								{
-									currentMaxima_coordinates.push_back(thisCoordinates);
-									lastMaximumIncrease_at_diagonalI = diagonalI;
-								}
-							}
-							else if(maxScore_D.first > currentMaximum)
-							{
-								currentMaximum = maxScore_D.first;
-								currentMaxima_coordinates.clear();
-								currentMaxima_coordinates.push_back(thisCoordinates);
-								lastMaximumIncrease_at_diagonalI = diagonalI;
-							}
-						}
-						else
+					if(maxScore_D == currentMaximum)
+					{
+						if(scoreDifference != 0)
 						{
-							// assert(1 == 0);
+							currentMaxima_cells.push_back(thisCellI);
+							lastMaximumIncrease_at_diagonalI = diagonalI;
 						}
 					}
+					else if(maxScore_D > currentMaximum)
+					{
+						currentMaximum = maxScore_D;
+						currentMaxima_cells.clear();
+						currentMaxima_cells.push_back(thisCellI);
+						lastMaximumIncrease_at_diagonalI = diagonalI;
+					}
+				}
+				else
+				{
+					// assert(1 == 0);
 				}
 			}
 		}
 
+		table.closeDiagonal();
+
 		if(verbose)
 			std::cout << "\t\tfiltering" << "\n" << std::flush;
 
-		std::vector<std::vector<int> > m_thisDiagonal_filtered;
 		if(m_thisDiagonal.size() > 0)
 		{
 			double max;
 			for(unsigned int i = 0; i < m_thisDiagonal.size(); i++)
 			{
-				std::vector<int> coordinates = m_thisDiagonal.at(i);
-				double S = scores.at(coordinates.at(0)).at(coordinates.at(1)).at(coordinates.at(2)).D;
+				double S = table.cell(m_thisDiagonal.at(i)).D;
 				if((i == 0) || (max < S))
 				{
 					max = S;
 				}
 			}
 
+			m_thisDiagonal_filtered.clear();
 			for(unsigned int i = 0; i < m_thisDiagonal.size(); i++)
 			{
-				std::vector<int> coordinates = m_thisDiagonal.at(i);
-				double S = scores.at(coordinates.at(0)).at(coordinates.at(1)).at(coordinates.at(2)).D;
+				double S = table.cell(m_thisDiagonal.at(i)).D;
 				assert(S <= max);
 				if((max - S) <= threshold_for_filtering)
 				{
-					m_thisDiagonal_filtered.push_back(coordinates);
+					m_thisDiagonal_filtered.push_back(m_thisDiagonal.at(i));
 				}
 			}
 
-			m_thisDiagonal = m_thisDiagonal_filtered;
+			m_thisDiagonal.swap(m_thisDiagonal_filtered);
 		}
 
-		m2_diagonal = m1_diagonal;
-		m1_diagonal = m_thisDiagonal;
+		m2_diagonal.swap(m1_diagonal);
+		m1_diagonal.swap(m_thisDiagonal);
 	}
 
 	std::vector<localExtension_pathDescription> forReturn;
-	auto backtraceFrom = [&](int start_x, int start_y, int start_z, double StartScore) {
-		int backtrace_x = start_x;
-		int backtrace_y = start_y;
-		int backtrace_z = start_z;
+	auto backtraceFrom = [&](int start_cellI, double StartScore) {
+		int backtrace_cellI = start_cellI;
 		int backtrace_matrix = 0;
 
 		std::string reconstructed_graph;
 		std::string reconstructed_sequence;
 		std::vector<int> reconstructed_graph_levels;
 		std::vector<std::vector<int>> edge_coordinates;
-		std::vector<Edge*> utilizedEdges;
+		std::vector<unsigned int> utilizedEdges;
+
+		const bandedNWCell& startCell = table.cell(start_cellI);
 
 		std::vector<int> startCoordinates;
-		startCoordinates.push_back(start_x);
-		startCoordinates.push_back(start_y);
-		startCoordinates.push_back(start_z);
+		startCoordinates.push_back(startCell.x);
+		startCoordinates.push_back(startCell.y);
+		startCoordinates.push_back(startCell.z);
 		edge_coordinates.push_back(startCoordinates);
 
 		if(verbose)
@@ -10169,8 +9996,13 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			std::cout << "\tbacktraceFrom() called.\n";
 
 		}
-		while((backtrace_x != startLevel_graph) || (backtrace_y != start_sequence))
+		while((table.cell(backtrace_cellI).x != startLevel_graph) || (table.cell(backtrace_cellI).y != start_sequence))
 		{
+			const bandedNWCell& backtrace_cell = table.cell(backtrace_cellI);
+			int backtrace_x = backtrace_cell.x;
+			int backtrace_y = backtrace_cell.y;
+			int backtrace_z = backtrace_cell.z;
+
 			if(verbose)
 			{
 				std::cout << "\t\tbacktrace_x: " << backtrace_x << "\n";
@@ -10195,24 +10027,24 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			}
 
 			double Score;
-			backtraceStep_affine step;
+			bandedNWStep step;
 			if(backtrace_matrix == 0)
 			{
-				Score = scores.at(backtrace_x).at(backtrace_y).at(backtrace_z).D;
-				step = scores_backtrace.at(backtrace_x).at(backtrace_y).at(backtrace_z).D;
+				Score = backtrace_cell.D;
+				step = backtrace_cell.D_backtrace;
 			}
 			else if(backtrace_matrix == 1)
 			{
-				Score = scores.at(backtrace_x).at(backtrace_y).at(backtrace_z).GraphGap;
-				step = scores_backtrace.at(backtrace_x).at(backtrace_y).at(backtrace_z).GraphGap;
+				Score = backtrace_cell.GraphGap;
+				step = backtrace_cell.GraphGap_backtrace;
 			}
 			else if(backtrace_matrix == 2)
 			{
-				Score = scores.at(backtrace_x).at(backtrace_y).at(backtrace_z).SequenceGap;
-				step = scores_backtrace.at(backtrace_x).at(backtrace_y).at(backtrace_z).SequenceGap;
+				Score = backtrace_cell.SequenceGap;
+				step = backtrace_cell.SequenceGap_backtrace;
 			}
 
-			if((backtrace_x == start_x) && (backtrace_y == start_y) && (backtrace_z == start_z))
+			if(backtrace_cellI == start_cellI)
 			{
 				Score = StartScore;
 			}
@@ -10223,10 +10055,9 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			}
 
 			std::string edgeEmission;
-			if(step.usedEdge != 0)
+			if(step.usedEdgeID != FrozenGraph::noEdge)
 			{
-				edgeEmission = g->CODE.deCode(step.usedEdge->locus_id, step.usedEdge->emission);
-				assert(edgeEmission.size() == 1);
+				edgeEmission = std::string(1, fG.edgeEmission(step.usedEdgeID));
 			}
 			std::string sequenceEmission;
 			if((backtrace_y >= 1) && (directionPositive))
@@ -10238,9 +10069,10 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				sequenceEmission = sequence.substr(backtrace_y, 1);
 			}
 
-			int next_x = step.x;
-			int next_y = step.y;
-			int next_z = step.z;
+			const bandedNWCell& next_cell = table.cell(step.cell);
+			int next_x = next_cell.x;
+			int next_y = next_cell.y;
+			int next_z = next_cell.z;
 			int next_matrix = step.sourceMatrix;
 
 			bool dontAddCoordinates = false; // if we jump from one matrix to the other without changing coordinates, we don't store the coordinates...
@@ -10249,11 +10081,11 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				if((next_x == (backtrace_x - 1)) && (next_y == (backtrace_y - 1)))
 				{
 					// match or mismatch
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x - 1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else if((next_x == backtrace_x) && (next_y == (backtrace_y - 1)))
 				{
@@ -10261,17 +10093,17 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					reconstructed_graph.append("_");
 					reconstructed_graph_levels.push_back(-1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(0);
+					utilizedEdges.push_back(FrozenGraph::noEdge);
 
 				}
 				else if((next_x == (backtrace_x - 1)) && (next_y == backtrace_y))
 				{
 					// gap in sequence
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x - 1);
 					reconstructed_sequence.append("_");
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else
 				{
@@ -10284,11 +10116,11 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				if((next_x == (backtrace_x + 1)) && (next_y == (backtrace_y + 1)))
 				{
 					// match or mismatch
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else if((next_x == backtrace_x) && (next_y == (backtrace_y + 1)))
 				{
@@ -10296,16 +10128,16 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					reconstructed_graph.append("_");
 					reconstructed_graph_levels.push_back(-1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(0);
+					utilizedEdges.push_back(FrozenGraph::noEdge);
 				}
 				else if((next_x == (backtrace_x + 1)) && (next_y == backtrace_y))
 				{
 					// gap in sequence
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x);
 					reconstructed_sequence.append("_");
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else
 				{
@@ -10323,9 +10155,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				std::cout << "\t\t\t" << "next_matrix: " << next_matrix << "\n\n" << std::flush;
 			}
 
-			backtrace_x = next_x;
-			backtrace_y = next_y;
-			backtrace_z = next_z;
+			backtrace_cellI = step.cell;
 			backtrace_matrix = next_matrix;
 
 			if( ! dontAddCoordinates)
@@ -10352,7 +10182,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 
 		localExtension_pathDescription pathReturn;
 		pathReturn.Score = StartScore;
-		pathReturn.usedEdges = utilizedEdges;
+		pathReturn.usedEdgeIDs = utilizedEdges;
 		pathReturn.coordinates = edge_coordinates;
 		pathReturn.alignedSequence = reconstructed_sequence;
 		pathReturn.alignedGraph = reconstructed_graph;
@@ -10361,78 +10191,21 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 		forReturn.push_back(pathReturn);
 	};
 
-	if(verbose)
-	{
-		for(unsigned int x = 231412; x <= 231418; x++)
-		{
-			for(unsigned int y = 0; y <= 5; y++)
-			{
-				std::cerr << "x = " << x << ", y = " << y << ": ";
-				if((scores.count(x) == 0) || (scores.at(x).count(y) == 0) || (scores.at(x).at(y).size() == 0))
-				{
-					std::cerr << "Undefined.";
-				}
-				else
-				{
-					for(unsigned int z = 0; z < scores.at(x).at(y).size(); z++)
-					{
-						std::cerr << "\n\t z = " << z << ": " << scores.at(x).at(y).at(z).D;
-					}
-				}
-				std::cerr << "\n\n" << std::flush;
-			}
-		}
-	}
-
 	if(! returnGlobalScore)
 	{
 		bool have_backtrace_sequenceComplete = false;
 
-		int sequenceCompleteBacktrace_levelI;
-		int sequenceCompleteBacktrace_seqI;
-		int sequenceCompleteBacktrace_stateI;
+		int sequenceCompleteBacktrace_cellI;
 		double sequenceCompleteBacktrace_score;
 
 
 		if(preferSequenceCompleAlignments)
 		{
-		
 			int coordinate_seqI = (directionPositive ? max_seqI : min_seqI);
 
-			if(0 && directionPositive && (_dbg_local_chainI == 0))
-			{				
-				std::cout << "fullNeedleman_affine_diagonal_extension(..) called, direction " << directionPositive << ".\n" << std::flush;
-				std::cout << "\t" << "_dbg_local_chainI" << ": " << _dbg_local_chainI << "\n";
-				std::cout << "\t" << "start_sequence" << ": " << start_sequence << "\n";
-				std::cout << "\t" << "maxPosition_sequence" << ": " << maxPosition_sequence << "\n";
-				std::cout << "\t" << "startLevel_graph" << ": " << startLevel_graph << "\n";
-				std::cout << "\t" << "maxLevel_graph" << ": " << maxLevel_graph << "\n";
-				std::cout << "\t" << "achieved_complete_sequence_alignments.size()" << ": " << achieved_complete_sequence_alignments.size() << "\n";
-				
-				for(std::set<std::string>::iterator coordinateIt = achieved_complete_sequence_alignments.begin(); coordinateIt != achieved_complete_sequence_alignments.end(); coordinateIt++)
-				{
-					std::string coordinates = *coordinateIt;
-					std::vector<std::string> coordinate_components = Utilities::split(coordinates, "/");
-					assert(coordinate_components.size() == 2);
-					int coordinate_levelI = Utilities::StrtoI(coordinate_components.at(0));
-					int coordinate_stateI = Utilities::StrtoI(coordinate_components.at(1));
-
-					double S = scores.at(coordinate_levelI).at(coordinate_seqI).at(coordinate_stateI).D;
-					
-					std::cout << "\t\t\tAlternative:\n";
-					std::cout << "\t\t\t\t" << "coordinate_seqI" << ": " << coordinate_seqI << "\n";
-					std::cout << "\t\t\t\t" << "coordinate_levelI" << ": " << coordinate_levelI << "\n";
-					std::cout << "\t\t\t\t" << "coordinate_stateI" << ": " << coordinate_stateI << "\n";
-					std::cout << "\t\t\t\t" << "S" << ": " << S << "\n";
-				}
-				
-				std::cout << std::flush;
-			}
-			
-			std::vector<std::string> sequenceComplete_backtraceCoordinates_maxScores;
+			std::vector<int> sequenceComplete_backtraceCells_maxScores;
 			double maxScore;
 
-
 			for(std::set<std::string>::iterator coordinateIt = achieved_complete_sequence_alignments.begin(); coordinateIt != achieved_complete_sequence_alignments.end(); coordinateIt++)
 			{
 				std::string coordinates = *coordinateIt;
@@ -10441,43 +10214,38 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				int coordinate_levelI = Utilities::StrtoI(coordinate_components.at(0));
 				int coordinate_stateI = Utilities::StrtoI(coordinate_components.at(1));
 
-				double S = scores.at(coordinate_levelI).at(coordinate_seqI).at(coordinate_stateI).D;
+				int coordinate_cellI = table.find(coordinate_levelI, coordinate_seqI, coordinate_stateI);
+				assert(coordinate_cellI != -1);
+				double S = table.cell(coordinate_cellI).D;
 
 				if((coordinateIt == achieved_complete_sequence_alignments.begin()) || (S > maxScore))
 				{
-					sequenceComplete_backtraceCoordinates_maxScores.clear();
-					sequenceComplete_backtraceCoordinates_maxScores.push_back(coordinates);
+					sequenceComplete_backtraceCells_maxScores.clear();
+					sequenceComplete_backtraceCells_maxScores.push_back(coordinate_cellI);
 					maxScore = S;
 				}
 				else if(S == maxScore)
 				{
-					sequenceComplete_backtraceCoordinates_maxScores.push_back(coordinates);
+					sequenceComplete_backtraceCells_maxScores.push_back(coordinate_cellI);
 				}
 			}
 
-			if(sequenceComplete_backtraceCoordinates_maxScores.size() > 0)
+			if(sequenceComplete_backtraceCells_maxScores.size() > 0)
 			{
 				have_backtrace_sequenceComplete = true;
 
-				int selectedIndex = Utilities::randomNumber_nonCritical(sequenceComplete_backtraceCoordinates_maxScores.size() - 1, &(rng_seeds.at(omp_get_thread_num())));
+				int selectedIndex = Utilities::randomNumber_nonCritical(sequenceComplete_backtraceCells_maxScores.size() - 1, &(rng_seeds.at(omp_get_thread_num())));
 				assert(selectedIndex >= 0);
-				assert(selectedIndex < (int)sequenceComplete_backtraceCoordinates_maxScores.size());
-				std::string coordinates = sequenceComplete_backtraceCoordinates_maxScores.at(selectedIndex);
-
-				std::vector<std::string> coordinate_components = Utilities::split(coordinates, "/");
-				assert(coordinate_components.size() == 2);
+				assert(selectedIndex < (int)sequenceComplete_backtraceCells_maxScores.size());
 
-				sequenceCompleteBacktrace_levelI = Utilities::StrtoI(coordinate_components.at(0));
-				sequenceCompleteBacktrace_seqI = coordinate_seqI;
-				sequenceCompleteBacktrace_stateI = Utilities::StrtoI(coordinate_components.at(1));
+				sequenceCompleteBacktrace_cellI = sequenceComplete_backtraceCells_maxScores.at(selectedIndex);
 				sequenceCompleteBacktrace_score = maxScore;
-
 			}
 
 		}
 		if(preferSequenceCompleAlignments && have_backtrace_sequenceComplete)
 		{
-			backtraceFrom(sequenceCompleteBacktrace_levelI, sequenceCompleteBacktrace_seqI, sequenceCompleteBacktrace_stateI, sequenceCompleteBacktrace_score);
+			backtraceFrom(sequenceCompleteBacktrace_cellI, sequenceCompleteBacktrace_score);
 		}
 		else
 		{
@@ -10485,18 +10253,18 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			{
 				if(verbose)
 				{
-					std::cout << "\tMaximum " << currentMaximum << ", achieved at " << currentMaxima_coordinates.size() << " positions!\n" << std::flush;
+					std::cout << "\tMaximum " << currentMaximum << ", achieved at " << currentMaxima_cells.size() << " positions!\n" << std::flush;
 				}
 
-				for(int maximumI = 0; maximumI < (int)currentMaxima_coordinates.size(); maximumI++)
+				for(int maximumI = 0; maximumI < (int)currentMaxima_cells.size(); maximumI++)
 				{
-					std::vector<int> coordinates = currentMaxima_coordinates.at(maximumI);
-					if(scores.at(coordinates.at(0)).at(coordinates.at(1)).at(coordinates.at(2)).D != minusInfinity)
+					const bandedNWCell& maximumCell = table.cell(currentMaxima_cells.at(maximumI));
+					if(maximumCell.D != minusInfinity)
 					{
 						if(verbose)
-							std::cout << " - Start maximum backtrace from " <<coordinates.at(0) << ", " <<  coordinates.at(1) << ", " << coordinates.at(2) << "\n" << std::flush;
+							std::cout << " - Start maximum backtrace from " << maximumCell.x << ", " <<  maximumCell.y << ", " << maximumCell.z << "\n" << std::flush;
 
-						backtraceFrom(coordinates.at(0), coordinates.at(1), coordinates.at(2), scores.at(coordinates.at(0)).at(coordinates.at(1)).at(coordinates.at(2)).D);
+						backtraceFrom(currentMaxima_cells.at(maximumI), maximumCell.D);
 					}
 				}
 			}
@@ -10504,48 +10272,42 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			if(verbose)
 				std::cout << "Have hit " << hit_NW_paths.size() << " NW paths, backtrace independent of achieved value!\n" << std::flush;
 
-			for(std::map<NWPath*, std::pair<double, std::vector<int> > >::iterator hitPathsIt = hit_NW_paths.begin(); hitPathsIt != hit_NW_paths.end(); hitPathsIt++)
+			for(std::map<NWPath*, std::pair<double, int> >::iterator hitPathsIt = hit_NW_paths.begin(); hitPathsIt != hit_NW_paths.end(); hitPathsIt++)
 			{
 				// NWPath* path = hitPathsIt->first;
 				double score = hitPathsIt->second.first;
-				std::vector<int> coordinates = hitPathsIt->second.second;
-				assert(scores.at(coordinates.at(0)).at(coordinates.at(1)).at(coordinates.at(2)).D == minusInfinity);
+				int cellI = hitPathsIt->second.second;
+				assert(table.cell(cellI).D == minusInfinity);
 
 				if(verbose)
-					std::cout << " - Start NW path backtrace from " << coordinates.at(0) << ", " <<  coordinates.at(1) << ", " << coordinates.at(2) << "\n" << std::flush;
+					std::cout << " - Start NW path backtrace from " << table.cell(cellI).x << ", " <<  table.cell(cellI).y << ", " << table.cell(cellI).z << "\n" << std::flush;
 
-				backtraceFrom(coordinates.at(0), coordinates.at(1), coordinates.at(2), score);
+				backtraceFrom(cellI, score);
 			}
 		}
 	}
 	else
 	{
+		int final_x = (directionPositive ? (levels - 1) : 0);
+		int final_y = (directionPositive ? sequenceLength : 0);
 
-		if(directionPositive)
-		{
-			std::map<int, double> finalState_scores;
-			for(std::map<int, mScore>::iterator altIt = scores.at(levels-1).at(sequenceLength).begin(); altIt != scores.at(levels-1).at(sequenceLength).end(); altIt++)
-			{
-				finalState_scores[altIt->first] = altIt->second.D;
-			}
-			std::pair<double, int> maxFinalState = Utilities::findIntMapMaxP_nonCritical(finalState_scores, &(rng_seeds.at(omp_get_thread_num())));
+		std::pair<int, int> finalCells = table.cellsAt(final_x, final_y);
+		assert(finalCells.second > finalCells.first);
 
-			backtraceFrom(levels - 1, sequenceLength, maxFinalState.second, maxFinalState.first);
-		}
-		else
+		std::map<int, double> finalState_scores;
+		std::map<int, int> finalState_cells;
+		for(int cellI = finalCells.first; cellI < finalCells.second; cellI++)
 		{
-			std::map<int, double> finalState_scores;
-			for(std::map<int, mScore>::iterator altIt = scores.at(0).at(0).begin(); altIt != scores.at(0).at(0).end(); altIt++)
-			{
-				finalState_scores[altIt->first] = altIt->second.D;
+			const bandedNWCell& finalCell = table.cell(cellI);
+			finalState_scores[finalCell.z] = finalCell.D;
+			finalState_cells[finalCell.z] = cellI;
 
-				if(verbose)
-					std::cout << "Final state z-value " << altIt->first << ", D value " << scores.at(0).at(0).at(altIt->first).D << ", GraphGap: " <<  scores.at(0).at(0).at(altIt->first).GraphGap << ", SequenceGap: " <<  scores.at(0).at(0).at(altIt->first).SequenceGap << "\n" << std::flush;
-			}
-			std::pair<double, int> maxFinalState = Utilities::findIntMapMaxP_nonCritical(finalState_scores, &(rng_seeds.at(omp_get_thread_num())));
-
-			backtraceFrom(0, 0, maxFinalState.second, maxFinalState.first);
+			if(verbose)
+				std::cout << "Final state z-value " << finalCell.z << ", D value " << finalCell.D << ", GraphGap: " <<  finalCell.GraphGap << ", SequenceGap: " <<  finalCell.SequenceGap << "\n" << std::flush;
 		}
+		std::pair<double, int> maxFinalState = Utilities::findIntMapMaxP_nonCritical(finalState_scores, &(rng_seeds.at(omp_get_thread_num())));
+
+		backtraceFrom(finalState_cells.at(maxFinalState.second), maxFinalState.first);
 	}
 	return forReturn;
 }
@@ -10779,18 +10541,17 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			if(distance_to_diagonal > bandSize)
 				continue;
 
-			std::string sequenceEmission = (directionPositive ? sequence.substr(previous_seqI, 1) : sequence.substr(previous_seqI-1, 1));
+			char sequenceEmission = (directionPositive ? sequence.at(previous_seqI) : sequence.at(previous_seqI-1));
 
-			std::vector<std::pair<int, Edge*> > nextZs = (directionPositive ? _graph_get_next_z_values_and_edges(previous_levelI, previous_stateI) : _graph_get_previous_z_values_and_edges(previous_levelI, previous_stateI));
-			assert(nextZs.size() > 0);
+			unsigned int previous_nodeID = fG.levelFirstNode(previous_levelI) + previous_stateI;
+			assert(fG.endDirected(previous_nodeID, directionPositive) > fG.firstDirected(previous_nodeID, directionPositive));
 
-			for(unsigned int zI = 0; zI < nextZs.size(); zI++)
+			for(unsigned int directedI = fG.firstDirected(previous_nodeID, directionPositive); directedI < fG.endDirected(previous_nodeID, directionPositive); directedI++)
 			{
-				std::pair<int, Edge*>& thisZjump = nextZs.at(zI);
-				int next_stateI = thisZjump.first;
+				unsigned int edgeID = fG.directedEdge(directedI, directionPositive);
+				int next_stateI = fG.nodeZ(fG.directedTarget(edgeID, directionPositive));
 
-				std::string edgeEmission = g->CODE.deCode(thisZjump.second->locus_id, thisZjump.second->emission);
-				assert(edgeEmission.size() == 1);
+				char edgeEmission = fG.edgeEmission(edgeID);
 
 				double score_MatchMismatch = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + ((edgeEmission == sequenceEmission) ? S_match : S_mismatch);
 
@@ -10798,7 +10559,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				backtrack_MatchMismatch.x = previous_levelI;
 				backtrack_MatchMismatch.y = previous_seqI;
 				backtrack_MatchMismatch.z = previous_stateI;
-				backtrack_MatchMismatch.usedEdge = thisZjump.second;
+				backtrack_MatchMismatch.usedEdgeID = edgeID;
 				backtrack_MatchMismatch.sourceMatrix = 0;
 
 				thisDiagonal[next_levelI][next_seqI][next_stateI].D.push_back(score_MatchMismatch);
@@ -10856,7 +10617,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				backtrack_gapInGraph_open.x = previous_levelI;
 				backtrack_gapInGraph_open.y = previous_seqI;
 				backtrack_gapInGraph_open.z = previous_stateI;
-				backtrack_gapInGraph_open.usedEdge = 0;
+				backtrack_gapInGraph_open.usedEdgeID = FrozenGraph::noEdge;
 				backtrack_gapInGraph_open.sourceMatrix = 0;
 
 				thisDiagonal[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(score_gapInGraph_open);
@@ -10872,7 +10633,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				backtrack_gapInGraph_extend.x = previous_levelI;
 				backtrack_gapInGraph_extend.y = previous_seqI;
 				backtrack_gapInGraph_extend.z = previous_stateI;
-				backtrack_gapInGraph_extend.usedEdge = 0;
+				backtrack_gapInGraph_extend.usedEdgeID = FrozenGraph::noEdge;
 				backtrack_gapInGraph_extend.sourceMatrix = 1;
 
 				thisDiagonal[gapInGraph_next_levelI][gapInGraph_next_seqI][gapInGraph_next_stateI].GraphGap.push_back(score_gapInGraph_extend);
@@ -10907,21 +10668,20 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					)
 				)
 			{
-				std::vector<std::pair<int, Edge*> > nextZs = (directionPositive ? _graph_get_next_z_values_and_edges(previous_levelI, previous_stateI) : _graph_get_previous_z_values_and_edges(previous_levelI, previous_stateI));
-				assert(nextZs.size() > 0);
+				unsigned int previous_nodeID = fG.levelFirstNode(previous_levelI) + previous_stateI;
+				assert(fG.endDirected(previous_nodeID, directionPositive) > fG.firstDirected(previous_nodeID, directionPositive));
 
-				for(unsigned int zI = 0; zI < nextZs.size(); zI++)
+				for(unsigned int directedI = fG.firstDirected(previous_nodeID, directionPositive); directedI < fG.endDirected(previous_nodeID, directionPositive); directedI++)
 				{
-					std::pair<int, Edge*>& thisZjump = nextZs.at(zI);
-					int next_stateI = thisZjump.first;
+					unsigned int edgeID = fG.directedEdge(directedI, directionPositive);
+					int next_stateI = fG.nodeZ(fG.directedTarget(edgeID, directionPositive));
 
-					std::string edgeEmission = g->CODE.deCode(thisZjump.second->locus_id, thisZjump.second->emission);
-					assert(edgeEmission.size() == 1);
+					char edgeEmission = fG.edgeEmission(edgeID);
 
 					// open sequence gap
 
 					double score_gapInSequence_open = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + S_openGap + S_extendGap;
-					if(edgeEmission == "_")
+					if(edgeEmission == '_')
 					{
 						score_gapInSequence_open = minusInfinity;
 					}
@@ -10934,7 +10694,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					backtrack_gapInSequence_open.x = previous_levelI;
 					backtrack_gapInSequence_open.y = previous_seqI;
 					backtrack_gapInSequence_open.z = previous_stateI;
-					backtrack_gapInSequence_open.usedEdge = thisZjump.second;
+					backtrack_gapInSequence_open.usedEdgeID = edgeID;
 					backtrack_gapInSequence_open.sourceMatrix = 0;
 
 					thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(score_gapInSequence_open);
@@ -10943,11 +10703,11 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					// extend sequence gap
 
 					double score_gapInSequence_extend = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).SequenceGap + S_extendGap;
-//					if(edgeEmission == "_")
+//					if(edgeEmission == '_')
 //					{
 //						score_gapInSequence_extend = minusInfinity;
 //					}
-					if(edgeEmission == "_")
+					if(edgeEmission == '_')
 					{
 						if(scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).SequenceGap == minusInfinity)
 						{
@@ -10967,14 +10727,14 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					backtrack_gapInSequence_extend.x = previous_levelI;
 					backtrack_gapInSequence_extend.y = previous_seqI;
 					backtrack_gapInSequence_extend.z = previous_stateI;
-					backtrack_gapInSequence_extend.usedEdge = thisZjump.second;
+					backtrack_gapInSequence_extend.usedEdgeID = edgeID;
 					backtrack_gapInSequence_extend.sourceMatrix = 2;
 
 					thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(score_gapInSequence_extend);
 					thisDiagonal_backtrace[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].SequenceGap.push_back(backtrack_gapInSequence_extend);
 
 					// non-affine sequence gap
-					if(edgeEmission == "_")
+					if(edgeEmission == '_')
 					{
 						double score_gapInSequence_nonAffine = scores.at(previous_levelI).at(previous_seqI).at(previous_stateI).D + S_graphGap;
 
@@ -10982,7 +10742,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 						backtrack_gapInSequence_nonAffine.x = previous_levelI;
 						backtrack_gapInSequence_nonAffine.y = previous_seqI;
 						backtrack_gapInSequence_nonAffine.z = previous_stateI;
-						backtrack_gapInSequence_nonAffine.usedEdge = thisZjump.second;
+						backtrack_gapInSequence_nonAffine.usedEdgeID = edgeID;
 						backtrack_gapInSequence_nonAffine.sourceMatrix = 0;
 
 						thisDiagonal[gapInSequence_next_levelI][gapInSequence_next_seqI][next_stateI].D.push_back(score_gapInSequence_nonAffine);
@@ -11049,7 +10809,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					step_intoD_fromGraphGap.y = seqI;
 					step_intoD_fromGraphGap.z = stateI;
 					step_intoD_fromGraphGap.sourceMatrix = 1;
-					step_intoD_fromGraphGap.usedEdge = 0;
+					step_intoD_fromGraphGap.usedEdgeID = FrozenGraph::noEdge;
 					thisDiagonal.at(levelI).at(seqI).at(stateI).D.push_back(score_intoD_fromGraphGap);
 					thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).D.push_back(step_intoD_fromGraphGap);
 
@@ -11059,7 +10819,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					step_intoD_fromSequenceGap.y = seqI;
 					step_intoD_fromSequenceGap.z = stateI;
 					step_intoD_fromSequenceGap.sourceMatrix = 2;
-					step_intoD_fromSequenceGap.usedEdge = 0;
+					step_intoD_fromSequenceGap.usedEdgeID = FrozenGraph::noEdge;
 					thisDiagonal.at(levelI).at(seqI).at(stateI).D.push_back(score_intoD_fromSequenceGap);
 					thisDiagonal_backtrace.at(levelI).at(seqI).at(stateI).D.push_back(step_intoD_fromSequenceGap);
 
@@ -11174,7 +10934,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 		std::string reconstructed_sequence;
 		std::vector<int> reconstructed_graph_levels;
 		std::vector<std::vector<int>> edge_coordinates;
-		std::vector<Edge*> utilizedEdges;
+		std::vector<unsigned int> utilizedEdges;
 
 		std::vector<int> startCoordinates;
 		startCoordinates.push_back(start_x);
@@ -11241,10 +11001,9 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 			}
 
 			std::string edgeEmission;
-			if(step.usedEdge != 0)
+			if(step.usedEdgeID != FrozenGraph::noEdge)
 			{
-				edgeEmission = g->CODE.deCode(step.usedEdge->locus_id, step.usedEdge->emission);
-				assert(edgeEmission.size() == 1);
+				edgeEmission = std::string(1, fG.edgeEmission(step.usedEdgeID));
 			}
 			std::string sequenceEmission;
 			if((backtrace_y >= 1) && (directionPositive))
@@ -11267,11 +11026,11 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				if((next_x == (backtrace_x - 1)) && (next_y == (backtrace_y - 1)))
 				{
 					// match or mismatch
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x - 1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else if((next_x == backtrace_x) && (next_y == (backtrace_y - 1)))
 				{
@@ -11279,17 +11038,17 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					reconstructed_graph.append("_");
 					reconstructed_graph_levels.push_back(-1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(0);
+					utilizedEdges.push_back(FrozenGraph::noEdge);
 
 				}
 				else if((next_x == (backtrace_x - 1)) && (next_y == backtrace_y))
 				{
 					// gap in sequence
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x - 1);
 					reconstructed_sequence.append("_");
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else
 				{
@@ -11302,11 +11061,11 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 				if((next_x == (backtrace_x + 1)) && (next_y == (backtrace_y + 1)))
 				{
 					// match or mismatch
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else if((next_x == backtrace_x) && (next_y == (backtrace_y + 1)))
 				{
@@ -11314,16 +11073,16 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 					reconstructed_graph.append("_");
 					reconstructed_graph_levels.push_back(-1);
 					reconstructed_sequence.append(sequenceEmission);
-					utilizedEdges.push_back(0);
+					utilizedEdges.push_back(FrozenGraph::noEdge);
 				}
 				else if((next_x == (backtrace_x + 1)) && (next_y == backtrace_y))
 				{
 					// gap in sequence
-					assert(step.usedEdge != 0);
+					assert(step.usedEdgeID != FrozenGraph::noEdge);
 					reconstructed_graph.append(edgeEmission);
 					reconstructed_graph_levels.push_back(backtrace_x);
 					reconstructed_sequence.append("_");
-					utilizedEdges.push_back(step.usedEdge);
+					utilizedEdges.push_back(step.usedEdgeID);
 				}
 				else
 				{
@@ -11370,7 +11129,7 @@ std::vector<localExtension_pathDescription> GraphAlignerUnique::fullNeedleman_di
 
 		localExtension_pathDescription pathReturn;
 		pathReturn.Score = StartScore;
-		pathReturn.usedEdges = utilizedEdges;
+		pathReturn.usedEdgeIDs = utilizedEdges;
 		pathReturn.coordinates = edge_coordinates;
 		pathReturn.alignedSequence = reconstructed_sequence;
 		pathReturn.alignedGraph = reconstructed_graph;
@@ -13,6 +13,9 @@
 #include "VirtualNWUnique.h"
 #include "../NextGen/readSimulator.h"
 #include "coveredIntervals.h"
+#include "BandedNWTable.h"
+#include "NWSlabKernel.h"
+#include "AlignmentContext.h"
 
 
 #include <map>
@@ -20,29 +23,76 @@
 #include <string>
 #include <functional>
 #include <utility>
+#include <memory>
 
 namespace GraphAlignerUnique {
 
 
+// Like ::localExtension_pathDescription, but edges are FrozenGraph edge IDs (FrozenGraph::noEdge for gaps in the graph).
+class localExtension_pathDescription {
+public:
+	std::vector<std::vector<int> > coordinates;
+	std::vector<unsigned int> usedEdgeIDs;
+	double Score;
+	std::string alignedSequence;
+	std::string alignedGraph;
+	std::vector<int> alignedGraph_levels;
+
+	void _printExtension(const FrozenGraph& fG)
+	{
+		std::cout << "localExtension_pathDescription object:\n" << std::flush;
+		for(unsigned int cI = 0; cI < coordinates.size(); cI++)
+		{
+			for(unsigned int cII = 0; cII < coordinates.at(cI).size(); cII++)
+			{
+				std::cout << coordinates.at(cI).at(cII) << " " << std::flush;
+			}
+			std::cout << "\n" << std::flush;
+			if(cI < usedEdgeIDs.size())
+			{
+				std::cout << "\t " << usedEdgeIDs.at(cI) << "\t" << std::flush;
+				if(usedEdgeIDs.at(cI) != FrozenGraph::noEdge)
+				{
+					std::cout << fG.edgeEmission(usedEdgeIDs.at(cI)) << " " << std::flush;
+				}
+				std::cout << "\n" << std::flush;
+			}
+		}
+	}
+};
+
+// Like ::backtraceStep_affine, but the used edge is a FrozenGraph edge ID.
+class backtraceStep_affine {
+public:
+	int x;
+	int y;
+	int z;
+	int sourceMatrix;
+	unsigned int usedEdgeID;
+	bool _border_lastStep_affine;
+
+	backtraceStep_affine() : x(-1), y(-1), z(-1), sourceMatrix(-1), usedEdgeID(FrozenGraph::noEdge), _border_lastStep_affine(false)
+	{
+
+	}
+};
+
 class backtrackBookkeeper_UGA {
 public:
 	double S;
-	Edge* usedEdges;
+	unsigned int usedEdgeID;
 	char graphSequence;
 	int graphSequence_levels;
 	backtrackBookkeeper_UGA* backtrack;
 
 	int takenNodesAndEdges;
 
-	void takeNodeAndEdge(Node* nodeFrom, Edge* usedEdge)
+	void takeNodeAndEdge(unsigned int edgeID, const FrozenGraph& frozenGraph)
 	{
 		assert(takenNodesAndEdges == 0);
-		std::string edgeEmission = usedEdge->From->g->CODE.deCode(usedEdge->locus_id, usedEdge->emission);
-		assert(edgeEmission.length() == 1);
-		usedEdges = usedEdge;
-		graphSequence = edgeEmission.at(0);
-		graphSequence_levels = nodeFrom->level;
-		assert(usedEdge->From == nodeFrom);
+		usedEdgeID = edgeID;
+		graphSequence = frozenGraph.edgeEmission(edgeID);
+		graphSequence_levels = frozenGraph.edgeLevel(edgeID);
 		takenNodesAndEdges++;
 	}
 
@@ -51,7 +101,7 @@ public:
 		takenNodesAndEdges = 0;
 
 		backtrack = 0;
-		usedEdges = 0;
+		usedEdgeID = FrozenGraph::noEdge;
 		graphSequence = 0;
 		graphSequence_levels = 0;
 		S = 0;
@@ -61,11 +111,16 @@ public:
 
 class VirtualNWTable_Unique;
 
+// A GraphAlignerUnique holds scoring parameters and per-thread scratch state (random seeds, NW tables);
+// graph and index live in an AlignmentContext, which can be shared between aligners.
 class GraphAlignerUnique {
 
+	// graph, index and level tables - shared, read-only
+	std::shared_ptr<AlignmentContext> context;
 	Graph* g;
+	const FrozenGraph& fG;
 	int kMerSize;
-	GraphAndEdgeIndex gI;
+	GraphAndEdgeIndex& gI;
 	double S_match;
 	double S_mismatch;
 	double S_gap;
@@ -79,12 +134,16 @@ class GraphAlignerUnique {
 
 	int threads;
 
-	coveredIntervals myGraph_coveredIntervals;
+	const coveredIntervals& myGraph_coveredIntervals;
 
 	std::vector<unsigned int> rng_seeds;
+	std::vector<BandedNWTable> bandedNWTables;
+
+	const std::vector<std::vector<Node*> >& nodesPerLevel_ordered;
+	const std::vector<std::map<Node*, unsigned int> >& nodesPerLevel_ordered_rev;
 
-	std::vector<std::vector<Node*> > nodesPerLevel_ordered;
-	std::vector<std::map<Node*, unsigned int> > nodesPerLevel_ordered_rev;
+	const std::vector<NWSlabTransitions>& slabTransitions_forward;
+	const std::vector<NWSlabTransitions>& slabTransitions_backward;
 
 	void seedAndExtend_init_occurrence_strand_etc(std::string& sequence_nonReverse, bool& useReverse, std::string& sequence, std::vector<std::string>& kMers_sequence, std::map<std::string, int>& kMer_sequence_occurrences);
 	bool iskMerDoubleUnique(std::string& kMer, std::map<std::string, int>& occurrencesInSequence);
@@ -97,9 +156,6 @@ class GraphAlignerUnique {
 
 	void fixNonUniqueChains(std::string& sequence, std::vector<kMerEdgeChain*>& sequencePositions_covered, bool thisIterationRandomization, std::vector<kMerEdgeChain*>& allChains, std::vector<kMerEdgeChain*>& newChains);
 
-	std::vector<std::pair<int, Edge*> > _graph_get_previous_z_values_and_edges(int x, int z);
-	std::vector<std::pair<int, Edge*> > _graph_get_next_z_values_and_edges(int x, int z);
-	std::vector<int> _graph_get_previous_z_values(int x, int z);
 
 	std::vector<std::pair<int, int> > findGaps_chainCoverage(std::string& sequence, std::vector<kMerEdgeChain*>& sequencePositions_covered_input);
 	void closeOneGap_withNonUniqueChains(std::string& sequence, std::pair<int, int> gapCoordinates, std::vector<kMerEdgeChain*>& sequencePositions_covered, bool thisIterationRandomization, std::vector<kMerEdgeChain*>& chainsToConsider, std::vector<kMerEdgeChain*>& newTrimmedChains, int& assignedChains);
@@ -131,6 +187,14 @@ class GraphAlignerUnique {
 
 public:
 	GraphAlignerUnique(Graph* graph, int k);
+
+	// for multi-threaded aligning: one GraphAlignerUnique per thread, all sharing one context
+	GraphAlignerUnique(std::shared_ptr<AlignmentContext> alignmentContext);
+
+	std::shared_ptr<AlignmentContext> getContext()
+	{
+		return context;
+	}
 	seedAndExtend_return seedAndExtend(std::string sequence);
 	seedAndExtend_return_local seedAndExtend_local(std::string sequence, std::vector<seedAndExtend_return_local>& allBacktraces);
 	seedAndExtend_return_local seedAndExtend_short(std::string sequence, std::vector<seedAndExtend_return_local>& allBacktraces, bool greedyLocalExtension = false, bool MiSeq250bp = false);
@@ -14,13 +14,39 @@
 
 namespace GraphAlignerUnique {
 
-GraphAndEdgeIndex::GraphAndEdgeIndex(Graph* graph, int k) {
+GraphAndEdgeIndex::GraphAndEdgeIndex(Graph* graph, const FrozenGraph* frozenGraph, int k) {
 	kMerSize = k;
 	g = graph;
+	fG = frozenGraph;
+	assert((g == 0) || ((fG != 0) && (fG->getGraph() == g)));
 	kMerGraph = 0;
 	if(g != 0)
 	{
-		Index();
+		std::string indexFile = PersistentkMerIndex::filenameForGraph(g, kMerSize);
+		if(indexFile.length())
+		{
+			kMerIndexGraphFingerprint fingerprint(g);
+
+			// only one thread builds the index of a graph; the others wait and load it
+			#pragma omp critical(GraphAndEdgeIndex_persist)
+			{
+				persistedkMers = PersistentkMerIndex::load(indexFile, kMerSize, fingerprint);
+				if(! persistedkMers)
+				{
+					Index();
+					PersistentkMerIndex::write(indexFile, kMerSize, fingerprint, g->EdgesInFileOrder, kMers);
+					persistedkMers = PersistentkMerIndex::load(indexFile, kMerSize, fingerprint);
+					if(persistedkMers)
+					{
+						kMers.clear();
+					}
+				}
+			}
+		}
+		else
+		{
+			Index();
+		}
 	}
 }
 
@@ -28,6 +54,15 @@ std::vector<std::string> GraphAndEdgeIndex::getIndexedkMers()
 {
 	assert(g != 0);
 	std::vector<std::string> forReturn;
+	if(persistedkMers)
+	{
+		forReturn.reserve(persistedkMers->size());
+		for(uint64_t kMerI = 0; kMerI < persistedkMers->size(); kMerI++)
+		{
+			forReturn.push_back(persistedkMers->kMer(kMerI));
+		}
+		return forReturn;
+	}
 	for(std::map<std::string, std::vector<kMerInGraphSpec> >::iterator kMerIt = kMers.begin(); kMerIt != kMers.end(); kMerIt++)
 	{
 		std::string thiskMer = kMerIt->first;
@@ -129,13 +164,13 @@ std::vector<kMerEdgeChain*> GraphAndEdgeIndex::findChains(std::string sequence)
 			}
 			
 			std::vector<std::vector<Edge*>> compatibleEdgeSequences;
-			std::set<Edge*> availableStartEdges = targetNode->Outgoing_Edges;
+			unsigned int targetNodeID = fG->nodeID(targetNode);
 
-			auto forwardScan = [&](Edge* startEdge) -> std::vector<std::vector<Edge*> > {
-				std::vector<std::vector<Edge*> > foundEdgePaths;
-				std::vector<std::vector<Edge*> > runningEdges;
+			auto forwardScan = [&](unsigned int startEdge) -> std::vector<std::vector<unsigned int> > {
+				std::vector<std::vector<unsigned int> > foundEdgePaths;
+				std::vector<std::vector<unsigned int> > runningEdges;
 
-				std::vector<Edge*> firstV;
+				std::vector<unsigned int> firstV;
 				firstV.push_back(startEdge);
 
 				runningEdges.push_back(firstV);
@@ -144,42 +179,44 @@ std::vector<kMerEdgeChain*> GraphAndEdgeIndex::findChains(std::string sequence)
 				{
 					for(int eI = (runningEdges.size() - 1); eI >= 0; eI--)
 					{
-						std::vector<Edge*>& edgeSequence = runningEdges.at(eI);
-						Edge* tipEdge = edgeSequence.at(edgeSequence.size() - 1);
-						std::string tipEdgeEmission = g->CODE.deCode(tipEdge->locus_id, tipEdge->emission);
-						if(tipEdgeEmission == "_")
+						std::vector<unsigned int>& edgeSequence = runningEdges.at(eI);
+						unsigned int tipEdge = edgeSequence.at(edgeSequence.size() - 1);
+						if(fG->edgeIsGap(tipEdge))
 						{
-							Node* tipNode = tipEdge->To;
+							Node* tipNode = fG->node(fG->edgeTo(tipEdge));
 							while(nodes_jumpOverGaps.count(tipNode))
 							{
-								std::vector<Edge*> moreTraversedEdges = nodes_jumpOverGaps.at(targetNode);
-								edgeSequence.insert(edgeSequence.end(), moreTraversedEdges.begin(), moreTraversedEdges.end());
+								std::vector<Edge*>& moreTraversedEdges = nodes_jumpOverGaps.at(targetNode);
+								for(unsigned int moreI = 0; moreI < moreTraversedEdges.size(); moreI++)
+								{
+									edgeSequence.push_back(fG->edgeID(moreTraversedEdges.at(moreI)));
+								}
 								tipNode = moreTraversedEdges.back()->To;
 							}
-							std::set<Edge*> nextEdges = tipNode->Outgoing_Edges;
-							if(nextEdges.size() == 0)
+							unsigned int tipNodeID = fG->nodeID(tipNode);
+							unsigned int nextEdges_first = fG->firstOutgoing(tipNodeID);
+							unsigned int nextEdges_end = fG->endOutgoing(tipNodeID);
+							if(nextEdges_end == nextEdges_first)
 							{
 								runningEdges.erase(runningEdges.begin() + eI);
 							}
-							else if(nextEdges.size() == 1)
+							else if((nextEdges_end - nextEdges_first) == 1)
 							{
-								edgeSequence.push_back(*(nextEdges.begin()));
+								edgeSequence.push_back(nextEdges_first);
 							}
 							else
 							{
-								assert(nextEdges.size() > 1);
-								std::vector<Edge*> templateToCopy = edgeSequence;
-								for(std::set<Edge*>::iterator nextEdgeIt = nextEdges.begin(); nextEdgeIt != nextEdges.end(); nextEdgeIt++)
+								std::vector<unsigned int> templateToCopy = edgeSequence;
+								for(unsigned int nextEdge = nextEdges_first; nextEdge != nextEdges_end; nextEdge++)
 								{
-									Edge* nextEdge = *nextEdgeIt;
-									if(nextEdgeIt == nextEdges.begin())
+									if(nextEdge == nextEdges_first)
 									{
-										edgeSequence.push_back(*nextEdgeIt);
+										edgeSequence.push_back(nextEdge);
 									}
 									else
 									{
-										std::vector<Edge*> newEdgeSequence = templateToCopy;
-										newEdgeSequence.push_back(*nextEdgeIt);
+										std::vector<unsigned int> newEdgeSequence = templateToCopy;
+										newEdgeSequence.push_back(nextEdge);
 										runningEdges.push_back(newEdgeSequence);
 									}
 								}
@@ -197,21 +234,20 @@ std::vector<kMerEdgeChain*> GraphAndEdgeIndex::findChains(std::string sequence)
 			};
 
 
-			for(std::set<Edge*>::iterator availableStartEdgeIt = availableStartEdges.begin(); availableStartEdgeIt != availableStartEdges.end(); availableStartEdgeIt++)
+			for(unsigned int availableStartEdge = fG->firstOutgoing(targetNodeID); availableStartEdge != fG->endOutgoing(targetNodeID); availableStartEdge++)
 			{
-				Edge* availableStartEdge = *availableStartEdgeIt;
-				std::vector<std::vector<Edge*> > followingPaths = forwardScan(availableStartEdge);
+				std::vector<std::vector<unsigned int> > followingPaths = forwardScan(availableStartEdge);
 				
 				if(verbose)
 				{
-					std::cout << "\t\t" << "Scan forward paths from edge " << availableStartEdge << " [coming from node " << availableStartEdge->From << "]" << "\n" << std::flush;
+					std::cout << "\t\t" << "Scan forward paths from edge " << fG->edge(availableStartEdge) << " [coming from node " << fG->edge(availableStartEdge)->From << "]" << "\n" << std::flush;
 				}
 				
 				for(unsigned int fI = 0; fI < followingPaths.size(); fI++)
 				{
-					std::vector<Edge*>& impliedEdgeSequence = followingPaths.at(fI);
-					Edge* lastEdge = impliedEdgeSequence.at(impliedEdgeSequence.size() - 1);
-					std::string edgeEmission = g->CODE.deCode(lastEdge->locus_id, lastEdge->emission);
+					std::vector<unsigned int>& impliedEdgeSequence = followingPaths.at(fI);
+					unsigned int lastEdge = impliedEdgeSequence.at(impliedEdgeSequence.size() - 1);
+					char edgeEmission = fG->edgeEmission(lastEdge);
 					
 					
 					if(verbose)
@@ -219,14 +255,16 @@ std::vector<kMerEdgeChain*> GraphAndEdgeIndex::findChains(std::string sequence)
 						std::cout << "\t\t\t" << "Alternative " << fI << "/" << followingPaths.size() << ": path length " << impliedEdgeSequence.size() << " with symbol: " << edgeEmission << " [looking for " << seqCharacter << "]" << "\n" << std::flush;
 					}
 									
-					assert(edgeEmission != "_");
-//					if(chain.traversedEdges.at(0)->From->level == 77)
-//					{
-//						std::cerr << "Chain starting node " << chain.traversedEdges.at(0)->From << ": fI = " << fI << ", edgeEmission = " << edgeEmission << ", seqCharacter = " << seqCharacter << "\n" << std::flush;
-//					}
-					if(edgeEmission == seqCharacter)
+					assert(! fG->edgeIsGap(lastEdge));
+					if(edgeEmission == seqCharacter.at(0))
 					{
-						compatibleEdgeSequences.push_back(impliedEdgeSequence);
+						std::vector<Edge*> impliedEdgeSequence_edges;
+						impliedEdgeSequence_edges.reserve(impliedEdgeSequence.size());
+						for(unsigned int eI = 0; eI < impliedEdgeSequence.size(); eI++)
+						{
+							impliedEdgeSequence_edges.push_back(fG->edge(impliedEdgeSequence.at(eI)));
+						}
+						compatibleEdgeSequences.push_back(impliedEdgeSequence_edges);
 					}
 				}
 			}
@@ -374,28 +412,25 @@ void GraphAndEdgeIndex::fillEdgeJumper()
 			nodes_jumpOverGaps[firstNode] = c.traversedEdges;
 		}
 	};
-	auto nodeExtendsWithSimpleGap = [&](Node* n) -> Edge* {
-		if(n->Outgoing_Edges.size() == 1)
+	auto nodeExtendsWithSimpleGap = [&](unsigned int nodeID) -> Edge* {
+		if((fG->endOutgoing(nodeID) - fG->firstOutgoing(nodeID)) == 1)
 		{
-			Edge* e = *(n->Outgoing_Edges.begin());
-			std::string emission = g->CODE.deCode(e->locus_id, e->emission);
-			assert(emission.length() == 1);
-			if(emission == "_")
+			unsigned int e = fG->firstOutgoing(nodeID);
+			if(fG->edgeIsGap(e))
 			{
-				return e;
+				return fG->edge(e);
 			}
 		}
 		return 0;
 	};
-	int levels = g->NodesPerLevel.size();
+	int levels = fG->levels();
 	for(int level = 0; level < levels; level++)
 	{
-		std::set<Node*> nodesAtLevel_set = g->NodesPerLevel.at(level);
-		std::vector<Node*> nodesAtLevel(nodesAtLevel_set.begin(), nodesAtLevel_set.end());
-		for(unsigned int nodeI = 0; nodeI < nodesAtLevel.size(); nodeI++)
+		for(unsigned int nodeI = 0; nodeI < fG->statesAtLevel(level); nodeI++)
 		{
-			Node* n = nodesAtLevel.at(nodeI);
-			Edge* simpleExtensionEdgeIfExists = nodeExtendsWithSimpleGap(n);
+			unsigned int nodeID = fG->levelFirstNode(level) + nodeI;
+			Node* n = fG->node(nodeID);
+			Edge* simpleExtensionEdgeIfExists = nodeExtendsWithSimpleGap(nodeID);
 			if(simpleExtensionEdgeIfExists != 0)
 			{
 				Node* targetNode = simpleExtensionEdgeIfExists->To;
@@ -523,7 +558,7 @@ void GraphAndEdgeIndex::Index()
 				kMer_bookkeeping(kMer_string, firstLevel, lastLevel, kMerIt->traverseEdges);
 
 				Edge* kMerEdge = new Edge();
-				assert(g->CODE.deCode(kMerIt->traverseEdges.at(0)->locus_id, kMerIt->traverseEdges.at(0)->emission) != "_");
+				assert(! fG->edgeIsGap(fG->edgeID(kMerIt->traverseEdges.at(0))));
 
 				string km1Mer_index_string = kMerIt->traverseEdges_string.substr(pointerStrintLength);
 				edgeTargetCache[kMerIt->traverseEdges.back()->To][km1Mer_index_string].push_back(kMerEdge);
@@ -557,7 +592,7 @@ void GraphAndEdgeIndex::Index()
 				Edge* kMerEdge = new Edge();
 				kMerIt->gapEdge = true;
 
-				assert(g->CODE.deCode(kMerIt->traverseEdges.at(0)->locus_id, kMerIt->traverseEdges.at(0)->emission) == "_");
+				assert(fG->edgeIsGap(fG->edgeID(kMerIt->traverseEdges.at(0))));
 
 				string km1Mer_index_string = kMerIt->traverseEdges_string.substr(pointerStrintLength);
 
@@ -621,7 +656,7 @@ void GraphAndEdgeIndex::Index()
 					assert(BasisForNewEdges.traverseEdges.at(0)->From == originalNode);
 
 					// Wenn das erste Symbol des attachten kMers kein Gap ist, fuegen wir frohlich neue Kanten hinzu
-					if(g->CODE.deCode(BasisForNewEdges.traverseEdges.at(0)->locus_id, BasisForNewEdges.traverseEdges.at(0)->emission) != "_")
+					if(! fG->edgeIsGap(fG->edgeID(BasisForNewEdges.traverseEdges.at(0))))
 					{
 						Node* lastNodeInOriginalGraph = BasisForNewEdges.traverseEdges.back()->To;
 
@@ -739,7 +774,7 @@ void GraphAndEdgeIndex::Index()
 									for(int lI = 0; lI < (int)attachKMerIt->traverseEdges.size(); lI++)
 									{
 										Edge* traversedEdge = attachKMerIt->traverseEdges.at(lI);
-										if(g->CODE.deCode(traversedEdge->locus_id, traversedEdge->emission) != "_")
+										if(! fG->edgeIsGap(fG->edgeID(traversedEdge)))
 										{
 											kMerEdge->levelsNucleotideGraph.push_back(traversedEdge->From->level);
 										}
@@ -964,15 +999,16 @@ void GraphAndEdgeIndex::Index()
 void GraphAndEdgeIndex::printIndex()
 {
 	assert(g != 0);
-	std::cout << "GraphAndEdgeIndex::printIndex(): " << kMers.size() << " kMers.\n" << std::flush;
+	std::vector<std::string> indexedkMers = getIndexedkMers();
+	std::cout << "GraphAndEdgeIndex::printIndex(): " << indexedkMers.size() << " kMers.\n" << std::flush;
 
-	for(std::map<std::string, std::vector<kMerInGraphSpec > >::iterator kMerPosIt = kMers.begin(); kMerPosIt != kMers.end(); kMerPosIt++)
+	for(std::vector<std::string>::iterator kMerIt = indexedkMers.begin(); kMerIt != indexedkMers.end(); kMerIt++)
 	{
-		std::string kMer = kMerPosIt->first;
+		std::string kMer = *kMerIt;
 
 		std::cout << "\tkMer " << kMer << "\n";
 
-		std::vector< kMerInGraphSpec >& kMerPos = kMers.at(kMer);
+		std::vector< kMerInGraphSpec > kMerPos = queryIndex(kMer);
 		for(std::vector<kMerInGraphSpec >::iterator posIt = kMerPos.begin(); posIt != kMerPos.end(); posIt++)
 		{
 			std::vector<Edge*>& traversedEdges = posIt->traversedEdges;
@@ -988,6 +1024,15 @@ void GraphAndEdgeIndex::printIndex()
 std::vector<kMerInGraphSpec> GraphAndEdgeIndex::queryIndex(std::string kMer)
 {
 	assert(g != 0);
+	if(persistedkMers)
+	{
+		int64_t kMerI = persistedkMers->find(kMer);
+		if(kMerI == -1)
+		{
+			return std::vector<kMerInGraphSpec>();
+		}
+		return persistedkMers->occurrences(kMerI, g->EdgesInFileOrder);
+	}
 	if(kMers.count(kMer) == 0)
 	{
 		return std::vector<kMerInGraphSpec>();
@@ -1014,9 +1059,8 @@ GraphAndEdgeIndex::~GraphAndEdgeIndex()
 	}
 	generated_edges.clear();
 
-	if(g != 0)
+	if(kMerGraph != 0)
 	{
-		assert(kMerGraph != 0);
 		delete(kMerGraph);
 	}
 }
@@ -16,6 +16,8 @@
 #include <iomanip>
 
 #include "../Graph/Graph.h"
+#include "../Graph/FrozenGraph.h"
+#include "PersistentkMerIndex.h"
 
 namespace GraphAlignerUnique {
 
@@ -48,8 +50,13 @@ public:
 class GraphAndEdgeIndex {
 	int kMerSize;
 	Graph* g;
+	const FrozenGraph* fG;
 
 	std::map<std::string, std::vector<kMerInGraphSpec> > kMers;
+
+	// if the graph was read from a file, the index is persisted next to it and shared
+	// by all aligners of the process; kMers is empty then.
+	std::shared_ptr<const PersistentkMerIndex> persistedkMers;
 	std::map<Node*, std::vector<Edge*>> nodes_jumpOverGaps;
 
 	// largely useless!
@@ -60,7 +67,7 @@ class GraphAndEdgeIndex {
 
 
 public:
-	GraphAndEdgeIndex(Graph* graph, int k);
+	GraphAndEdgeIndex(Graph* graph, const FrozenGraph* frozenGraph, int k);
 	~GraphAndEdgeIndex();
 	void Index();
 	void fillEdgeJumper();
@@ -0,0 +1,407 @@
+/*
+ * NWSlabKernel.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "NWSlabKernel.h"
+
+#include <assert.h>
+#include <cmath>
+#include <string>
+#include <immintrin.h>
+
+namespace GraphAlignerUnique {
+
+void NWSlabTransitions::build(const FrozenGraph& fG, unsigned int sourceLevel, bool directionPositive)
+{
+	unsigned int targetLevel = (directionPositive ? (sourceLevel + 1) : (sourceLevel - 1));
+	unsigned int sourceFirstNode = fG.levelFirstNode(sourceLevel);
+	unsigned int targetFirstNode = fG.levelFirstNode(targetLevel);
+	int sources = fG.statesAtLevel(sourceLevel);
+	int targets = fG.statesAtLevel(targetLevel);
+
+	std::vector<std::pair<int, unsigned int> > visitedEdges;
+	auto visitEdge = [&](int sourceZ, unsigned int edgeID) -> void {
+		visitedEdges.push_back(std::make_pair(sourceZ, edgeID));
+	};
+	for(int sourceZ = 0; sourceZ < sources; sourceZ++)
+	{
+		unsigned int nodeID = sourceFirstNode + sourceZ;
+		if(directionPositive)
+		{
+			for(unsigned int edgeID = fG.firstOutgoing(nodeID); edgeID < fG.endOutgoing(nodeID); edgeID++)
+				visitEdge(sourceZ, edgeID);
+		}
+		else
+		{
+			for(unsigned int incomingI = fG.firstIncoming(nodeID); incomingI < fG.endIncoming(nodeID); incomingI++)
+				visitEdge(sourceZ, fG.incomingEdge(incomingI));
+		}
+	}
+
+	auto targetZ = [&](unsigned int edgeID) -> int {
+		return (int)((directionPositive ? fG.edgeTo(edgeID) : fG.edgeFrom(edgeID)) - targetFirstNode);
+	};
+
+	target_first_edge.assign(targets + 1, 0);
+	for(unsigned int visitedI = 0; visitedI < visitedEdges.size(); visitedI++)
+	{
+		target_first_edge.at(targetZ(visitedEdges.at(visitedI).second) + 1)++;
+	}
+	for(int z = 0; z < targets; z++)
+	{
+		target_first_edge.at(z + 1) += target_first_edge.at(z);
+	}
+
+	int E = visitedEdges.size();
+	edge_source_z.resize(E);
+	edge_emission.resize(E);
+	edge_isGap.resize(E);
+	edge_id.resize(E);
+
+	std::vector<int> target_nextEdge(target_first_edge.begin(), target_first_edge.end() - 1);
+	for(int visitedI = 0; visitedI < E; visitedI++)
+	{
+		unsigned int edgeID = visitedEdges.at(visitedI).second;
+		int edgeI = target_nextEdge.at(targetZ(edgeID))++;
+
+		edge_source_z.at(edgeI) = visitedEdges.at(visitedI).first;
+		edge_emission.at(edgeI) = fG.edgeEmission(edgeID);
+		edge_isGap.at(edgeI) = (fG.edgeIsGap(edgeID) ? -1 : 0);
+		edge_id.at(edgeI) = edgeID;
+	}
+}
+
+void NWSlabBuffers::resetSource(int states)
+{
+	D.assign(states, NWSlab_absent);
+	GraphGap.assign(states, NWSlab_absent);
+	SequenceGap.assign(states, NWSlab_absent);
+	cell.assign(states, -1);
+}
+
+void NWSlabBuffers::reserveCandidates(int n)
+{
+	if((int)candidates.size() < n)
+	{
+		candidates.resize(n);
+		candidates_sourceMatrix.resize(n);
+		candidates_nonAffine.resize(n);
+	}
+}
+
+bool NWSlab_applicable(double S_match, double S_mismatch, double S_openGap, double S_extendGap, double S_graphGap)
+{
+	double scores[5] = {S_match, S_mismatch, S_openGap, S_extendGap, S_graphGap};
+	for(unsigned int sI = 0; sI < 5; sI++)
+	{
+		if((scores[sI] != std::floor(scores[sI])) || (std::fabs(scores[sI]) > 1000))
+			return false;
+	}
+	return true;
+}
+
+namespace {
+
+inline int absorb(int v, int S)
+{
+	if((v == NWSlab_absent) || (v == NWSlab_minusInfinity))
+		return v;
+	return v + S;
+}
+
+// scalar
+
+void matchMismatch_scalar(const NWSlabTransitions& T, int from, const int* D_source, int sequenceCharacter, int S_match, int S_mismatch, int* candidates)
+{
+	int E = T.edges();
+	for(int edgeI = from; edgeI < E; edgeI++)
+	{
+		int D = D_source[T.edge_source_z[edgeI]];
+		candidates[edgeI] = absorb(D, ((T.edge_emission[edgeI] == sequenceCharacter) ? S_match : S_mismatch));
+	}
+}
+
+void sequenceGap_scalar(const NWSlabTransitions& T, int from, const int* D_source, const int* SequenceGap_source, int S_openGap, int S_extendGap, int S_graphGap, int* candidates, int* candidates_sourceMatrix, int* candidates_nonAffine)
+{
+	int E = T.edges();
+	for(int edgeI = from; edgeI < E; edgeI++)
+	{
+		int sourceZ = T.edge_source_z[edgeI];
+		int D = D_source[sourceZ];
+		int SequenceGap = SequenceGap_source[sourceZ];
+		bool isGap = T.edge_isGap[edgeI];
+
+		int open = (isGap ? NWSlab_minusInfinity : absorb(D, S_openGap + S_extendGap));
+		int extend = absorb(SequenceGap, (isGap ? S_graphGap : S_extendGap));
+		bool takeExtend = (extend > open);
+
+		candidates[edgeI] = ((D == NWSlab_absent) ? NWSlab_absent : (takeExtend ? extend : open));
+		candidates_sourceMatrix[edgeI] = (takeExtend ? 2 : 0);
+		candidates_nonAffine[edgeI] = (isGap ? absorb(D, S_graphGap) : NWSlab_absent);
+	}
+}
+
+void graphGap_scalar(int states, int from, const int* D_source, const int* GraphGap_source, int S_openGap, int S_extendGap, int* candidates, int* candidates_sourceMatrix)
+{
+	for(int z = from; z < states; z++)
+	{
+		int D = D_source[z];
+		int open = absorb(D, S_openGap + S_extendGap);
+		int extend = absorb(GraphGap_source[z], S_extendGap);
+		bool takeExtend = (extend > open);
+
+		candidates[z] = ((D == NWSlab_absent) ? NWSlab_absent : (takeExtend ? extend : open));
+		candidates_sourceMatrix[z] = (takeExtend ? 1 : 0);
+	}
+}
+
+// AVX2
+
+__attribute__((target("avx2"))) inline __m256i absorb_avx2(__m256i v, __m256i S)
+{
+	__m256i r = _mm256_add_epi32(v, S);
+	r = _mm256_blendv_epi8(r, v, _mm256_cmpeq_epi32(v, _mm256_set1_epi32(NWSlab_minusInfinity)));
+	r = _mm256_blendv_epi8(r, v, _mm256_cmpeq_epi32(v, _mm256_set1_epi32(NWSlab_absent)));
+	return r;
+}
+
+__attribute__((target("avx2"))) void matchMismatch_avx2(const NWSlabTransitions& T, const int* D_source, int sequenceCharacter, int S_match, int S_mismatch, int* candidates)
+{
+	int E = T.edges();
+	int edgeI = 0;
+	__m256i c = _mm256_set1_epi32(sequenceCharacter);
+	__m256i match = _mm256_set1_epi32(S_match);
+	__m256i mismatch = _mm256_set1_epi32(S_mismatch);
+	for(; edgeI + 8 <= E; edgeI += 8)
+	{
+		__m256i sourceZ = _mm256_loadu_si256((const __m256i*)&(T.edge_source_z[edgeI]));
+		__m256i D = _mm256_i32gather_epi32(D_source, sourceZ, 4);
+		__m256i emission = _mm256_loadu_si256((const __m256i*)&(T.edge_emission[edgeI]));
+		__m256i S = _mm256_blendv_epi8(mismatch, match, _mm256_cmpeq_epi32(emission, c));
+		_mm256_storeu_si256((__m256i*)&(candidates[edgeI]), absorb_avx2(D, S));
+	}
+	matchMismatch_scalar(T, edgeI, D_source, sequenceCharacter, S_match, S_mismatch, candidates);
+}
+
+__attribute__((target("avx2"))) void sequenceGap_avx2(const NWSlabTransitions& T, const int* D_source, const int* SequenceGap_source, int S_openGap, int S_extendGap, int S_graphGap, int* candidates, int* candidates_sourceMatrix, int* candidates_nonAffine)
+{
+	int E = T.edges();
+	int edgeI = 0;
+	__m256i absent = _mm256_set1_epi32(NWSlab_absent);
+	__m256i minusInfinity = _mm256_set1_epi32(NWSlab_minusInfinity);
+	__m256i openPlusExtend = _mm256_set1_epi32(S_openGap + S_extendGap);
+	__m256i extend = _mm256_set1_epi32(S_extendGap);
+	__m256i graphGap = _mm256_set1_epi32(S_graphGap);
+	__m256i two = _mm256_set1_epi32(2);
+	for(; edgeI + 8 <= E; edgeI += 8)
+	{
+		__m256i sourceZ = _mm256_loadu_si256((const __m256i*)&(T.edge_source_z[edgeI]));
+		__m256i isGap = _mm256_loadu_si256((const __m256i*)&(T.edge_isGap[edgeI]));
+		__m256i D = _mm256_i32gather_epi32(D_source, sourceZ, 4);
+		__m256i SequenceGap = _mm256_i32gather_epi32(SequenceGap_source, sourceZ, 4);
+
+		__m256i open_score = _mm256_blendv_epi8(absorb_avx2(D, openPlusExtend), minusInfinity, isGap);
+		__m256i extend_score = absorb_avx2(SequenceGap, _mm256_blendv_epi8(extend, graphGap, isGap));
+		__m256i takeExtend = _mm256_cmpgt_epi32(extend_score, open_score);
+
+		__m256i best = _mm256_blendv_epi8(open_score, extend_score, takeExtend);
+		best = _mm256_blendv_epi8(best, absent, _mm256_cmpeq_epi32(D, absent));
+		_mm256_storeu_si256((__m256i*)&(candidates[edgeI]), best);
+		_mm256_storeu_si256((__m256i*)&(candidates_sourceMatrix[edgeI]), _mm256_and_si256(takeExtend, two));
+		_mm256_storeu_si256((__m256i*)&(candidates_nonAffine[edgeI]), _mm256_blendv_epi8(absent, absorb_avx2(D, graphGap), isGap));
+	}
+	sequenceGap_scalar(T, edgeI, D_source, SequenceGap_source, S_openGap, S_extendGap, S_graphGap, candidates, candidates_sourceMatrix, candidates_nonAffine);
+}
+
+__attribute__((target("avx2"))) void graphGap_avx2(int states, const int* D_source, const int* GraphGap_source, int S_openGap, int S_extendGap, int* candidates, int* candidates_sourceMatrix)
+{
+	int z = 0;
+	__m256i absent = _mm256_set1_epi32(NWSlab_absent);
+	__m256i openPlusExtend = _mm256_set1_epi32(S_openGap + S_extendGap);
+	__m256i extend = _mm256_set1_epi32(S_extendGap);
+	__m256i one = _mm256_set1_epi32(1);
+	for(; z + 8 <= states; z += 8)
+	{
+		__m256i D = _mm256_loadu_si256((const __m256i*)&(D_source[z]));
+		__m256i GraphGap = _mm256_loadu_si256((const __m256i*)&(GraphGap_source[z]));
+
+		__m256i open_score = absorb_avx2(D, openPlusExtend);
+		__m256i extend_score = absorb_avx2(GraphGap, extend);
+		__m256i takeExtend = _mm256_cmpgt_epi32(extend_score, open_score);
+
+		__m256i best = _mm256_blendv_epi8(open_score, extend_score, takeExtend);
+		best = _mm256_blendv_epi8(best, absent, _mm256_cmpeq_epi32(D, absent));
+		_mm256_storeu_si256((__m256i*)&(candidates[z]), best);
+		_mm256_storeu_si256((__m256i*)&(candidates_sourceMatrix[z]), _mm256_and_si256(takeExtend, one));
+	}
+	graphGap_scalar(states, z, D_source, GraphGap_source, S_openGap, S_extendGap, candidates, candidates_sourceMatrix);
+}
+
+// SSE4.1 - no gathers, so source values are loaded one by one
+
+__attribute__((target("sse4.1"))) inline __m128i absorb_sse41(__m128i v, __m128i S)
+{
+	__m128i r = _mm_add_epi32(v, S);
+	r = _mm_blendv_epi8(r, v, _mm_cmpeq_epi32(v, _mm_set1_epi32(NWSlab_minusInfinity)));
+	r = _mm_blendv_epi8(r, v, _mm_cmpeq_epi32(v, _mm_set1_epi32(NWSlab_absent)));
+	return r;
+}
+
+__attribute__((target("sse4.1"))) inline __m128i gather_sse41(const int* source, const int* indices)
+{
+	return _mm_set_epi32(source[indices[3]], source[indices[2]], source[indices[1]], source[indices[0]]);
+}
+
+__attribute__((target("sse4.1"))) void matchMismatch_sse41(const NWSlabTransitions& T, const int* D_source, int sequenceCharacter, int S_match, int S_mismatch, int* candidates)
+{
+	int E = T.edges();
+	int edgeI = 0;
+	__m128i c = _mm_set1_epi32(sequenceCharacter);
+	__m128i match = _mm_set1_epi32(S_match);
+	__m128i mismatch = _mm_set1_epi32(S_mismatch);
+	for(; edgeI + 4 <= E; edgeI += 4)
+	{
+		__m128i D = gather_sse41(D_source, &(T.edge_source_z[edgeI]));
+		__m128i emission = _mm_loadu_si128((const __m128i*)&(T.edge_emission[edgeI]));
+		__m128i S = _mm_blendv_epi8(mismatch, match, _mm_cmpeq_epi32(emission, c));
+		_mm_storeu_si128((__m128i*)&(candidates[edgeI]), absorb_sse41(D, S));
+	}
+	matchMismatch_scalar(T, edgeI, D_source, sequenceCharacter, S_match, S_mismatch, candidates);
+}
+
+__attribute__((target("sse4.1"))) void sequenceGap_sse41(const NWSlabTransitions& T, const int* D_source, const int* SequenceGap_source, int S_openGap, int S_extendGap, int S_graphGap, int* candidates, int* candidates_sourceMatrix, int* candidates_nonAffine)
+{
+	int E = T.edges();
+	int edgeI = 0;
+	__m128i absent = _mm_set1_epi32(NWSlab_absent);
+	__m128i minusInfinity = _mm_set1_epi32(NWSlab_minusInfinity);
+	__m128i openPlusExtend = _mm_set1_epi32(S_openGap + S_extendGap);
+	__m128i extend = _mm_set1_epi32(S_extendGap);
+	__m128i graphGap = _mm_set1_epi32(S_graphGap);
+	__m128i two = _mm_set1_epi32(2);
+	for(; edgeI + 4 <= E; edgeI += 4)
+	{
+		__m128i isGap = _mm_loadu_si128((const __m128i*)&(T.edge_isGap[edgeI]));
+		__m128i D = gather_sse41(D_source, &(T.edge_source_z[edgeI]));
+		__m128i SequenceGap = gather_sse41(SequenceGap_source, &(T.edge_source_z[edgeI]));
+
+		__m128i open_score = _mm_blendv_epi8(absorb_sse41(D, openPlusExtend), minusInfinity, isGap);
+		__m128i extend_score = absorb_sse41(SequenceGap, _mm_blendv_epi8(extend, graphGap, isGap));
+		__m128i takeExtend = _mm_cmpgt_epi32(extend_score, open_score);
+
+		__m128i best = _mm_blendv_epi8(open_score, extend_score, takeExtend);
+		best = _mm_blendv_epi8(best, absent, _mm_cmpeq_epi32(D, absent));
+		_mm_storeu_si128((__m128i*)&(candidates[edgeI]), best);
+		_mm_storeu_si128((__m128i*)&(candidates_sourceMatrix[edgeI]), _mm_and_si128(takeExtend, two));
+		_mm_storeu_si128((__m128i*)&(candidates_nonAffine[edgeI]), _mm_blendv_epi8(absent, absorb_sse41(D, graphGap), isGap));
+	}
+	sequenceGap_scalar(T, edgeI, D_source, SequenceGap_source, S_openGap, S_extendGap, S_graphGap, candidates, candidates_sourceMatrix, candidates_nonAffine);
+}
+
+__attribute__((target("sse4.1"))) void graphGap_sse41(int states, const int* D_source, const int* GraphGap_source, int S_openGap, int S_extendGap, int* candidates, int* candidates_sourceMatrix)
+{
+	int z = 0;
+	__m128i absent = _mm_set1_epi32(NWSlab_absent);
+	__m128i openPlusExtend = _mm_set1_epi32(S_openGap + S_extendGap);
+	__m128i extend = _mm_set1_epi32(S_extendGap);
+	__m128i one = _mm_set1_epi32(1);
+	for(; z + 4 <= states; z += 4)
+	{
+		__m128i D = _mm_loadu_si128((const __m128i*)&(D_source[z]));
+		__m128i GraphGap = _mm_loadu_si128((const __m128i*)&(GraphGap_source[z]));
+
+		__m128i open_score = absorb_sse41(D, openPlusExtend);
+		__m128i extend_score = absorb_sse41(GraphGap, extend);
+		__m128i takeExtend = _mm_cmpgt_epi32(extend_score, open_score);
+
+		__m128i best = _mm_blendv_epi8(open_score, extend_score, takeExtend);
+		best = _mm_blendv_epi8(best, absent, _mm_cmpeq_epi32(D, absent));
+		_mm_storeu_si128((__m128i*)&(candidates[z]), best);
+		_mm_storeu_si128((__m128i*)&(candidates_sourceMatrix[z]), _mm_and_si128(takeExtend, one));
+	}
+	graphGap_scalar(states, z, D_source, GraphGap_source, S_openGap, S_extendGap, candidates, candidates_sourceMatrix);
+}
+
+// runtime selection
+
+enum NWSlab_instructionSet {NWSlab_scalar, NWSlab_SSE41, NWSlab_AVX2};
+
+NWSlab_instructionSet selectInstructionSet()
+{
+	__builtin_cpu_init();
+	if(__builtin_cpu_supports("avx2"))
+		return NWSlab_AVX2;
+	if(__builtin_cpu_supports("sse4.1"))
+		return NWSlab_SSE41;
+	return NWSlab_scalar;
+}
+
+NWSlab_instructionSet instructionSet()
+{
+	static NWSlab_instructionSet selected = selectInstructionSet();
+	return selected;
+}
+
+}
+
+const char* NWSlab_kernelName()
+{
+	switch(instructionSet())
+	{
+		case NWSlab_AVX2:
+			return "AVX2";
+		case NWSlab_SSE41:
+			return "SSE4.1";
+		default:
+			return "scalar";
+	}
+}
+
+void NWSlab_matchMismatch(const NWSlabTransitions& T, const int* D_source, int sequenceCharacter, int S_match, int S_mismatch, int* candidates)
+{
+	switch(instructionSet())
+	{
+		case NWSlab_AVX2:
+			matchMismatch_avx2(T, D_source, sequenceCharacter, S_match, S_mismatch, candidates);
+			break;
+		case NWSlab_SSE41:
+			matchMismatch_sse41(T, D_source, sequenceCharacter, S_match, S_mismatch, candidates);
+			break;
+		default:
+			matchMismatch_scalar(T, 0, D_source, sequenceCharacter, S_match, S_mismatch, candidates);
+	}
+}
+
+void NWSlab_sequenceGap(const NWSlabTransitions& T, const int* D_source, const int* SequenceGap_source, int S_openGap, int S_extendGap, int S_graphGap, int* candidates, int* candidates_sourceMatrix, int* candidates_nonAffine)
+{
+	switch(instructionSet())
+	{
+		case NWSlab_AVX2:
+			sequenceGap_avx2(T, D_source, SequenceGap_source, S_openGap, S_extendGap, S_graphGap, candidates, candidates_sourceMatrix, candidates_nonAffine);
+			break;
+		case NWSlab_SSE41:
+			sequenceGap_sse41(T, D_source, SequenceGap_source, S_openGap, S_extendGap, S_graphGap, candidates, candidates_sourceMatrix, candidates_nonAffine);
+			break;
+		default:
+			sequenceGap_scalar(T, 0, D_source, SequenceGap_source, S_openGap, S_extendGap, S_graphGap, candidates, candidates_sourceMatrix, candidates_nonAffine);
+	}
+}
+
+void NWSlab_graphGap(int states, const int* D_source, const int* GraphGap_source, int S_openGap, int S_extendGap, int* candidates, int* candidates_sourceMatrix)
+{
+	switch(instructionSet())
+	{
+		case NWSlab_AVX2:
+			graphGap_avx2(states, D_source, GraphGap_source, S_openGap, S_extendGap, candidates, candidates_sourceMatrix);
+			break;
+		case NWSlab_SSE41:
+			graphGap_sse41(states, D_source, GraphGap_source, S_openGap, S_extendGap, candidates, candidates_sourceMatrix);
+			break;
+		default:
+			graphGap_scalar(states, 0, D_source, GraphGap_source, S_openGap, S_extendGap, candidates, candidates_sourceMatrix);
+	}
+}
+
+} /* namespace GraphAlignerUnique */
@@ -0,0 +1,88 @@
+/*
+ * NWSlabKernel.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef NWSLABKERNEL_H_
+#define NWSLABKERNEL_H_
+
+#include <vector>
+#include <map>
+#include <limits>
+
+#include "../Graph/FrozenGraph.h"
+
+namespace GraphAlignerUnique {
+
+// Slab kernels for GraphAlignerUnique::fullNeedleman_diagonal_extension(..).
+// A slab is the set of cells of one diagonal that share level and sequence position, i.e. all graph
+// states z at one (x, y). The recurrences from one slab into the next one are independent across z,
+// so they are evaluated with int32 lanes (AVX2 or SSE4.1, selected at runtime, scalar otherwise).
+//
+// Scores are exact integers. NWSlab_minusInfinity stands for the -DBL_MAX "minus infinity" of the
+// double-valued table and absorbs all additions, like -DBL_MAX does; NWSlab_absent marks states which
+// are not in the slab (or candidates which are not offered at all).
+
+const int NWSlab_absent = std::numeric_limits<int>::min();
+const int NWSlab_minusInfinity = -(1 << 30);
+
+// Don't use the kernels for slabs with fewer states than this
+const int NWSlab_minimumStates = 16;
+
+// Transitions from the states of one level into the states of the next level in extension direction
+// (level + 1 for forward, level - 1 for backward extension). Edges are grouped by target state; within
+// one target state, they are in the order in which the scalar extension visits them (source state,
+// then position in the source node's outgoing / incoming edges).
+class NWSlabTransitions {
+public:
+	std::vector<int> target_first_edge;
+	std::vector<int> edge_source_z;
+	std::vector<int> edge_emission;
+	std::vector<int> edge_isGap;
+	std::vector<unsigned int> edge_id;
+
+	void build(const FrozenGraph& fG, unsigned int sourceLevel, bool directionPositive);
+
+	int targetStates() const
+	{
+		return (int)target_first_edge.size() - 1;
+	}
+
+	int edges() const
+	{
+		return (int)edge_id.size();
+	}
+};
+
+// per-thread scratch space for the kernels
+class NWSlabBuffers {
+public:
+	std::vector<int> D;
+	std::vector<int> GraphGap;
+	std::vector<int> SequenceGap;
+	std::vector<int> cell;
+
+	std::vector<int> candidates;
+	std::vector<int> candidates_sourceMatrix;
+	std::vector<int> candidates_nonAffine;
+
+	void resetSource(int states);
+	void reserveCandidates(int n);
+};
+
+bool NWSlab_applicable(double S_match, double S_mismatch, double S_openGap, double S_extendGap, double S_graphGap);
+const char* NWSlab_kernelName();
+
+// per edge: D(source) + match / mismatch score
+void NWSlab_matchMismatch(const NWSlabTransitions& T, const int* D_source, int sequenceCharacter, int S_match, int S_mismatch, int* candidates);
+
+// per edge: the better of sequence gap open and extend (sourceMatrix 0 or 2), and the non-affine D
+// candidate for gap edges
+void NWSlab_sequenceGap(const NWSlabTransitions& T, const int* D_source, const int* SequenceGap_source, int S_openGap, int S_extendGap, int S_graphGap, int* candidates, int* candidates_sourceMatrix, int* candidates_nonAffine);
+
+// per state: the better of graph gap open and extend (sourceMatrix 0 or 1)
+void NWSlab_graphGap(int states, const int* D_source, const int* GraphGap_source, int S_openGap, int S_extendGap, int* candidates, int* candidates_sourceMatrix);
+
+} /* namespace GraphAlignerUnique */
+#endif /* NWSLABKERNEL_H_ */
@@ -0,0 +1,345 @@
+/*
+ * PersistentkMerIndex.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "PersistentkMerIndex.h"
+#include "GraphAndEdgeIndex.h"
+
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <unordered_map>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace GraphAlignerUnique {
+
+static const char kMerIndex_magic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'K', 'I'};
+static const uint32_t kMerIndex_version = 1;
+
+class kMerIndexHeader {
+public:
+	char magic[8];
+	uint32_t version;
+	uint32_t k;
+	uint32_t graph_nodes;
+	uint32_t graph_edges;
+	uint64_t graph_checksum;
+	uint64_t kMers;
+	uint64_t occurrences;
+	uint64_t edgeEntries;
+};
+
+static size_t kMerIndex_padTo8(size_t n)
+{
+	return (n + 7) & ~((size_t)7);
+}
+
+static uint64_t kMerIndex_fnv(uint64_t hash, const void* data, size_t n)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	for(size_t i = 0; i < n; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+kMerIndexGraphFingerprint::kMerIndexGraphFingerprint(Graph* g)
+{
+	nodes = g->Nodes.size();
+	edges = g->EdgesInFileOrder.size();
+
+	// nodes are numbered in the order in which the file-order edges first touch them, so that
+	// the checksum covers the topology of the graph, not just its edge labels
+	std::unordered_map<Node*, uint32_t> nodeNumbers;
+	auto nodeNumber = [&](Node* n) -> uint32_t {
+		if(nodeNumbers.count(n) == 0)
+		{
+			uint32_t newNumber = nodeNumbers.size();
+			nodeNumbers[n] = newNumber;
+		}
+		return nodeNumbers.at(n);
+	};
+
+	checksum = 14695981039346656037ULL;
+	for(unsigned int edgeI = 0; edgeI < g->EdgesInFileOrder.size(); edgeI++)
+	{
+		Edge* e = g->EdgesInFileOrder.at(edgeI);
+		uint32_t from = nodeNumber(e->From);
+		uint32_t to = nodeNumber(e->To);
+		int32_t fromLevel = e->From->level;
+		std::string emission = g->CODE.deCode(e->locus_id, e->emission);
+		checksum = kMerIndex_fnv(checksum, &from, sizeof(from));
+		checksum = kMerIndex_fnv(checksum, &to, sizeof(to));
+		checksum = kMerIndex_fnv(checksum, &fromLevel, sizeof(fromLevel));
+		checksum = kMerIndex_fnv(checksum, emission.c_str(), emission.length());
+		checksum = kMerIndex_fnv(checksum, e->locus_id.c_str(), e->locus_id.length() + 1);
+	}
+}
+
+PersistentkMerIndex::PersistentkMerIndex() : mapped(0), mappedSize(0), k(0), kMerCount(0), kMers(0), kMer_first_occurrence(0), occurrence_first_edge(0), edgeIDs(0)
+{
+
+}
+
+PersistentkMerIndex::~PersistentkMerIndex()
+{
+	if(mapped != 0)
+	{
+		munmap(mapped, mappedSize);
+	}
+}
+
+std::string PersistentkMerIndex::filenameForGraph(Graph* g, int k)
+{
+	if((g->filename_last_read.length() == 0) || (g->EdgesInFileOrder.size() == 0))
+		return "";
+
+	std::string graphFile = g->filename_last_read;
+	std::string txt = ".txt";
+	if((graphFile.length() >= txt.length()) && (graphFile.substr(graphFile.length() - txt.length()) == txt))
+	{
+		graphFile = graphFile.substr(0, graphFile.length() - txt.length());
+	}
+
+	std::ostringstream indexFile;
+	indexFile << graphFile << ".kMerIndex_k" << k << ".bin";
+	return indexFile.str();
+}
+
+bool PersistentkMerIndex::open(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint)
+{
+	assert(mapped == 0);
+
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+		return false;
+
+	struct stat fileInfo;
+	if((fstat(fd, &fileInfo) != 0) || ((size_t)fileInfo.st_size < sizeof(kMerIndexHeader)))
+	{
+		close(fd);
+		return false;
+	}
+
+	size_t fileSize = fileInfo.st_size;
+	void* fileMap = mmap(0, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if(fileMap == MAP_FAILED)
+		return false;
+
+	mapped = fileMap;
+	mappedSize = fileSize;
+
+	kMerIndexHeader header;
+	memcpy(&header, mapped, sizeof(header));
+	if((memcmp(header.magic, kMerIndex_magic, sizeof(kMerIndex_magic)) != 0) || (header.version != kMerIndex_version))
+	{
+		std::cerr << "k-mer index file " << filename << " has an unsupported format - ignore.\n" << std::flush;
+		return false;
+	}
+	if((header.k != (uint32_t)k) || (header.graph_nodes != fingerprint.nodes) || (header.graph_edges != fingerprint.edges) || (header.graph_checksum != fingerprint.checksum))
+	{
+		std::cerr << "k-mer index file " << filename << " was built for a different graph - ignore.\n" << std::flush;
+		return false;
+	}
+
+	size_t kMers_offset = sizeof(kMerIndexHeader);
+	size_t kMer_first_occurrence_offset = kMerIndex_padTo8(kMers_offset + header.kMers * header.k);
+	size_t occurrence_first_edge_offset = kMer_first_occurrence_offset + (header.kMers + 1) * sizeof(uint64_t);
+	size_t edgeIDs_offset = occurrence_first_edge_offset + (header.occurrences + 1) * sizeof(uint64_t);
+	size_t expectedSize = edgeIDs_offset + header.edgeEntries * sizeof(uint32_t);
+	if(expectedSize != fileSize)
+	{
+		std::cerr << "k-mer index file " << filename << " is truncated - ignore.\n" << std::flush;
+		return false;
+	}
+
+	const char* base = (const char*)mapped;
+	this->filename = filename;
+	this->k = header.k;
+	kMerCount = header.kMers;
+	kMers = base + kMers_offset;
+	kMer_first_occurrence = (const uint64_t*)(base + kMer_first_occurrence_offset);
+	occurrence_first_edge = (const uint64_t*)(base + occurrence_first_edge_offset);
+	edgeIDs = (const uint32_t*)(base + edgeIDs_offset);
+
+	if((kMer_first_occurrence[kMerCount] != header.occurrences) || (occurrence_first_edge[header.occurrences] != header.edgeEntries))
+	{
+		std::cerr << "k-mer index file " << filename << " is inconsistent - ignore.\n" << std::flush;
+		return false;
+	}
+
+	return true;
+}
+
+std::shared_ptr<const PersistentkMerIndex> PersistentkMerIndex::load(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint)
+{
+	static std::map<std::string, std::shared_ptr<const PersistentkMerIndex> > loadedIndices;
+
+	std::shared_ptr<const PersistentkMerIndex> forReturn;
+
+	#pragma omp critical(PersistentkMerIndex_load)
+	{
+		if(loadedIndices.count(filename))
+		{
+			const PersistentkMerIndex& loaded = *(loadedIndices.at(filename));
+			if((loaded.k == (uint32_t)k) && (((const kMerIndexHeader*)loaded.mapped)->graph_checksum == fingerprint.checksum))
+			{
+				forReturn = loadedIndices.at(filename);
+			}
+			else
+			{
+				loadedIndices.erase(filename);
+			}
+		}
+
+		if(! forReturn)
+		{
+			std::shared_ptr<PersistentkMerIndex> newIndex(new PersistentkMerIndex());
+			if(newIndex->open(filename, k, fingerprint))
+			{
+				forReturn = newIndex;
+				loadedIndices[filename] = forReturn;
+			}
+		}
+	}
+
+	return forReturn;
+}
+
+void PersistentkMerIndex::write(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint, const std::vector<Edge*>& edgesInFileOrder, const std::map<std::string, std::vector<kMerInGraphSpec> >& kMers)
+{
+	std::unordered_map<Edge*, uint32_t> edgeIDs;
+	for(unsigned int edgeI = 0; edgeI < edgesInFileOrder.size(); edgeI++)
+	{
+		edgeIDs[edgesInFileOrder.at(edgeI)] = edgeI;
+	}
+
+	std::string kMerTable;
+	std::vector<uint64_t> kMer_first_occurrence;
+	std::vector<uint64_t> occurrence_first_edge;
+	std::vector<uint32_t> occurrence_edges;
+
+	kMerTable.reserve(kMers.size() * k);
+	kMer_first_occurrence.reserve(kMers.size() + 1);
+	for(std::map<std::string, std::vector<kMerInGraphSpec> >::const_iterator kMerIt = kMers.begin(); kMerIt != kMers.end(); kMerIt++)
+	{
+		assert((int)kMerIt->first.length() == k);
+		kMerTable.append(kMerIt->first);
+		kMer_first_occurrence.push_back(occurrence_first_edge.size());
+
+		const std::vector<kMerInGraphSpec>& occurrences = kMerIt->second;
+		for(unsigned int occurrenceI = 0; occurrenceI < occurrences.size(); occurrenceI++)
+		{
+			occurrence_first_edge.push_back(occurrence_edges.size());
+			const std::vector<Edge*>& traversedEdges = occurrences.at(occurrenceI).traversedEdges;
+			for(unsigned int edgeI = 0; edgeI < traversedEdges.size(); edgeI++)
+			{
+				assert(edgeIDs.count(traversedEdges.at(edgeI)));
+				occurrence_edges.push_back(edgeIDs.at(traversedEdges.at(edgeI)));
+			}
+		}
+	}
+	kMer_first_occurrence.push_back(occurrence_first_edge.size());
+	occurrence_first_edge.push_back(occurrence_edges.size());
+
+	kMerIndexHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kMerIndex_magic, sizeof(kMerIndex_magic));
+	header.version = kMerIndex_version;
+	header.k = k;
+	header.graph_nodes = fingerprint.nodes;
+	header.graph_edges = fingerprint.edges;
+	header.graph_checksum = fingerprint.checksum;
+	header.kMers = kMers.size();
+	header.occurrences = occurrence_first_edge.size() - 1;
+	header.edgeEntries = occurrence_edges.size();
+
+	// write into a temporary file first, so that concurrent readers never see a partial index
+	std::ostringstream temporaryFilename;
+	temporaryFilename << filename << ".tmp" << getpid();
+	std::ofstream output;
+	output.open(temporaryFilename.str().c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if(! output.is_open())
+	{
+		std::cerr << "Cannot write k-mer index file " << temporaryFilename.str() << " - index will not be persisted.\n" << std::flush;
+		return;
+	}
+
+	output.write((const char*)&header, sizeof(header));
+	output.write(kMerTable.data(), kMerTable.size());
+	std::string padding(kMerIndex_padTo8(sizeof(header) + kMerTable.size()) - (sizeof(header) + kMerTable.size()), 0);
+	output.write(padding.data(), padding.size());
+	output.write((const char*)kMer_first_occurrence.data(), kMer_first_occurrence.size() * sizeof(uint64_t));
+	output.write((const char*)occurrence_first_edge.data(), occurrence_first_edge.size() * sizeof(uint64_t));
+	output.write((const char*)occurrence_edges.data(), occurrence_edges.size() * sizeof(uint32_t));
+	output.close();
+
+	if(output.fail() || (rename(temporaryFilename.str().c_str(), filename.c_str()) != 0))
+	{
+		std::cerr << "Cannot write k-mer index file " << filename << " - index will not be persisted.\n" << std::flush;
+		unlink(temporaryFilename.str().c_str());
+	}
+}
+
+std::string PersistentkMerIndex::kMer(uint64_t kMerI) const
+{
+	assert(kMerI < kMerCount);
+	return std::string(kMers + kMerI * k, k);
+}
+
+int64_t PersistentkMerIndex::find(const std::string& kMer) const
+{
+	if(kMer.length() != k)
+		return -1;
+
+	uint64_t lower = 0;
+	uint64_t upper = kMerCount;
+	while(lower < upper)
+	{
+		uint64_t middle = lower + (upper - lower) / 2;
+		int comparison = memcmp(kMers + middle * k, kMer.data(), k);
+		if(comparison == 0)
+		{
+			return middle;
+		}
+		else if(comparison < 0)
+		{
+			lower = middle + 1;
+		}
+		else
+		{
+			upper = middle;
+		}
+	}
+	return -1;
+}
+
+std::vector<kMerInGraphSpec> PersistentkMerIndex::occurrences(uint64_t kMerI, const std::vector<Edge*>& edgesInFileOrder) const
+{
+	assert(kMerI < kMerCount);
+	std::vector<kMerInGraphSpec> forReturn;
+	forReturn.resize(kMer_first_occurrence[kMerI+1] - kMer_first_occurrence[kMerI]);
+	for(uint64_t occurrenceI = kMer_first_occurrence[kMerI]; occurrenceI < kMer_first_occurrence[kMerI+1]; occurrenceI++)
+	{
+		std::vector<Edge*>& traversedEdges = forReturn.at(occurrenceI - kMer_first_occurrence[kMerI]).traversedEdges;
+		traversedEdges.reserve(occurrence_first_edge[occurrenceI+1] - occurrence_first_edge[occurrenceI]);
+		for(uint64_t edgeI = occurrence_first_edge[occurrenceI]; edgeI < occurrence_first_edge[occurrenceI+1]; edgeI++)
+		{
+			traversedEdges.push_back(edgesInFileOrder.at(edgeIDs[edgeI]));
+		}
+	}
+	return forReturn;
+}
+
+} /* namespace GraphAlignerUnique */
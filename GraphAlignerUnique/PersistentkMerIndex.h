@@ -0,0 +1,87 @@
+/*
+ * PersistentkMerIndex.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef PERSISTENTKMERINDEX_H_
+#define PERSISTENTKMERINDEX_H_
+
+#include <vector>
+#include <map>
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+#include "../Graph/Graph.h"
+
+namespace GraphAlignerUnique {
+
+class kMerInGraphSpec;
+
+// Identifies the graph an index file was built for: edge IDs in the file are positions in
+// Graph::EdgesInFileOrder, so they are only meaningful for a graph read from the same file.
+class kMerIndexGraphFingerprint {
+public:
+	uint32_t nodes;
+	uint32_t edges;
+	uint64_t checksum;
+
+	kMerIndexGraphFingerprint(Graph* g);
+	bool operator==(const kMerIndexGraphFingerprint& other) const
+	{
+		return ((nodes == other.nodes) && (edges == other.edges) && (checksum == other.checksum));
+	}
+};
+
+// Read-only, mmap-backed k-mer index for GraphAndEdgeIndex.
+// File layout (native byte order):
+//	char[8]		"MHCPRGKI"
+//	uint32		version
+//	uint32		k
+//	uint32		graph nodes, uint32 graph edges, uint64 graph checksum
+//	uint64		number of k-mers K, number of occurrences O, number of edge entries E
+//	char[K*k]	k-mers, sorted
+//	uint64[K+1]	first occurrence of each k-mer
+//	uint64[O+1]	first edge entry of each occurrence
+//	uint32[E]	edge IDs
+// Files are opened through load(..), which keeps one instance per file and process, so that all
+// aligners of a process share the same mapping.
+class PersistentkMerIndex {
+protected:
+	std::string filename;
+	void* mapped;
+	size_t mappedSize;
+
+	uint32_t k;
+	uint64_t kMerCount;
+	const char* kMers;
+	const uint64_t* kMer_first_occurrence;
+	const uint64_t* occurrence_first_edge;
+	const uint32_t* edgeIDs;
+
+	PersistentkMerIndex();
+	bool open(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint);
+
+public:
+	~PersistentkMerIndex();
+
+	static std::string filenameForGraph(Graph* g, int k);
+	static std::shared_ptr<const PersistentkMerIndex> load(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint);
+	static void write(std::string filename, int k, const kMerIndexGraphFingerprint& fingerprint, const std::vector<Edge*>& edgesInFileOrder, const std::map<std::string, std::vector<kMerInGraphSpec> >& kMers);
+
+	uint64_t size() const
+	{
+		return kMerCount;
+	}
+	std::string kMer(uint64_t kMerI) const;
+
+	// index of kMer, -1 if not present
+	int64_t find(const std::string& kMer) const;
+
+	// occurrences of one k-mer, translated into edges of a graph read from the indexed file
+	std::vector<kMerInGraphSpec> occurrences(uint64_t kMerI, const std::vector<Edge*>& edgesInFileOrder) const;
+};
+
+} /* namespace GraphAlignerUnique */
+#endif /* PERSISTENTKMERINDEX_H_ */
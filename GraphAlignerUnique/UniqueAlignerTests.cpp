@@ -19,11 +19,17 @@
 #include "../Utilities.h"
 #include "../NextGen/Validation.h"
 #include <ctime>
+#include <sstream>
+#include <functional>
+#include <unistd.h>
+#include <sys/wait.h>
 
 #include "../GraphAligner/GraphAlignerAffine.h"
 #include "../GraphAligner/AlignerTests.h"
 #include "GraphAlignerUnique.h"
+#include "PersistentkMerIndex.h"
 #include "../NextGen/readSimulator.h"
+#include "../NextGen/shortReadAlignmentsFile.h"
 
 #include <omp.h>
 
@@ -1654,6 +1660,377 @@ void sampleExactStringFromGraph(Graph* g, int minLength_string, int maxLength_st
 	}
 }
 
+// true if f() ends the process it runs in - errEx(..) exits with 1, failed assertions abort.
+// f() runs in a child process with stderr silenced, so that the test can carry on.
+static bool stopsProcess(std::function<void()> f)
+{
+	std::cout << std::flush;
+	std::cerr << std::flush;
+	pid_t pid = fork();
+	assert(pid != -1);
+	if(pid == 0)
+	{
+		if(freopen("/dev/null", "w", stderr) == 0)
+		{
+			_exit(0);
+		}
+		f();
+		_exit(0);
+	}
+	int status;
+	waitpid(pid, &status, 0);
+	return (! (WIFEXITED(status) && (WEXITSTATUS(status) == 0)));
+}
+
+static std::string readFileBytes(std::string filename)
+{
+	std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+	assert(input.is_open());
+	std::ostringstream contents;
+	contents << input.rdbuf();
+	return contents.str();
+}
+
+static void writeFileBytes(std::string filename, const std::string& contents)
+{
+	std::ofstream output(filename.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
+	assert(output.is_open());
+	output.write(contents.data(), contents.size());
+	output.close();
+}
+
+// same nodes, edges in file order, edge attributes and locus codes
+static void assertSameGraph(Graph* g1, Graph* g2)
+{
+	assert(g1->Nodes.size() == g2->Nodes.size());
+	assert(g1->Edges.size() == g2->Edges.size());
+	assert(g1->NodesPerLevel.size() == g2->NodesPerLevel.size());
+	assert(g1->EdgesInFileOrder.size() == g2->EdgesInFileOrder.size());
+	for(unsigned int levelI = 0; levelI < g1->NodesPerLevel.size(); levelI++)
+	{
+		assert(g1->NodesPerLevel.at(levelI).size() == g2->NodesPerLevel.at(levelI).size());
+	}
+	for(unsigned int edgeI = 0; edgeI < g1->EdgesInFileOrder.size(); edgeI++)
+	{
+		Edge* e1 = g1->EdgesInFileOrder.at(edgeI);
+		Edge* e2 = g2->EdgesInFileOrder.at(edgeI);
+		assert(e1->locus_id == e2->locus_id);
+		assert(g1->CODE.deCode(e1->locus_id, e1->emission) == g2->CODE.deCode(e2->locus_id, e2->emission));
+		assert(e1->count == e2->count);
+		assert(e1->label == e2->label);
+		assert(e1->pgf_protect == e2->pgf_protect);
+		assert(e1->From->level == e2->From->level);
+		assert(e1->To->level == e2->To->level);
+		assert(e1->From->terminal == e2->From->terminal);
+		assert(e1->To->terminal == e2->To->terminal);
+	}
+	assert(kMerIndexGraphFingerprint(g1) == kMerIndexGraphFingerprint(g2));
+}
+
+void testGraphBinaryFile(std::string temp_dir)
+{
+	std::string graph_text = temp_dir + "/testGraphBinaryFile.txt";
+	std::string graph_binary = Graph::binaryFilename(graph_text);
+	std::string graph_binary_2 = temp_dir + "/testGraphBinaryFile_2.bin";
+	std::string graph_binary_broken = temp_dir + "/testGraphBinaryFile_broken.bin";
+
+	for(unsigned int graphIteration = 1; graphIteration <= 5; graphIteration++)
+	{
+		Graph* g = genomeString2Graph(generateRandomGenome(800));
+		unsigned int edgeI = 0;
+		for(std::set<Edge*>::iterator edgeIt = g->Edges.begin(); edgeIt != g->Edges.end(); edgeIt++, edgeI++)
+		{
+			if((edgeI % 3) == 0)
+			{
+				(*edgeIt)->label = "label" + Utilities::ItoStr(edgeI);
+			}
+			(*edgeIt)->count = 0.5 * edgeI;
+		}
+		g->writeToFile(graph_text);
+
+		// text -> binary -> graph, and binary files do not depend on the graph having been read from a binary file
+		Graph* g_text = new Graph();
+		g_text->readFromTextFile(graph_text);
+		g_text->writeToBinaryFile(graph_binary);
+
+		Graph* g_binary = new Graph();
+		g_binary->readFromBinaryFile(graph_binary);
+		assertSameGraph(g_text, g_binary);
+
+		g_binary->writeToBinaryFile(graph_binary_2);
+		std::string graph_binary_bytes = readFileBytes(graph_binary);
+		assert(graph_binary_bytes == readFileBytes(graph_binary_2));
+
+		Graph* g_readFromFile = new Graph();
+		g_readFromFile->readFromFile(graph_text);
+		assertSameGraph(g_text, g_readFromFile);
+
+		// truncated files, trailing data and corrupt headers are errors ...
+		std::vector<size_t> truncateAt = {0, 4, 12, 20, graph_binary_bytes.size() / 2, graph_binary_bytes.size() - 1};
+		for(unsigned int truncateI = 0; truncateI < truncateAt.size(); truncateI++)
+		{
+			writeFileBytes(graph_binary_broken, graph_binary_bytes.substr(0, truncateAt.at(truncateI)));
+			assert(stopsProcess([&]() { Graph g_broken; g_broken.readFromBinaryFile(graph_binary_broken); }));
+		}
+
+		writeFileBytes(graph_binary_broken, graph_binary_bytes + "x");
+		assert(stopsProcess([&]() { Graph g_broken; g_broken.readFromBinaryFile(graph_binary_broken); }));
+
+		std::vector<size_t> corruptAt = {0, 7, 8, 12};
+		for(unsigned int corruptI = 0; corruptI < corruptAt.size(); corruptI++)
+		{
+			std::string corrupt_bytes = graph_binary_bytes;
+			corrupt_bytes.at(corruptAt.at(corruptI)) ^= 0x20;
+			writeFileBytes(graph_binary_broken, corrupt_bytes);
+			assert(stopsProcess([&]() { Graph g_broken; g_broken.readFromBinaryFile(graph_binary_broken); }));
+		}
+
+		// ... but readFromFile(..) falls back to the text file if the binary file has an unknown format
+		std::vector<size_t> corruptHeaderAt = {0, 8};
+		for(unsigned int corruptI = 0; corruptI < corruptHeaderAt.size(); corruptI++)
+		{
+			std::string corrupt_bytes = graph_binary_bytes;
+			corrupt_bytes.at(corruptHeaderAt.at(corruptI)) ^= 0x20;
+			writeFileBytes(graph_binary, corrupt_bytes);
+			Graph* g_fallback = new Graph();
+			g_fallback->readFromFile(graph_text);
+			assertSameGraph(g_text, g_fallback);
+			g_fallback->freeMemory();
+			delete(g_fallback);
+		}
+		writeFileBytes(graph_binary, "");
+		Graph* g_fallback = new Graph();
+		g_fallback->readFromFile(graph_text);
+		assertSameGraph(g_text, g_fallback);
+
+		g_fallback->freeMemory();
+		delete(g_fallback);
+		g_readFromFile->freeMemory();
+		delete(g_readFromFile);
+		g_binary->freeMemory();
+		delete(g_binary);
+		g_text->freeMemory();
+		delete(g_text);
+		g->freeMemory();
+		delete(g);
+
+		std::cout << "testGraphBinaryFile(): graph " << graphIteration << " OK.\n" << std::flush;
+	}
+
+	// empty graph
+	Graph* g_empty = new Graph();
+	g_empty->writeToBinaryFile(graph_binary_2);
+	Graph* g_empty_binary = new Graph();
+	g_empty_binary->readFromBinaryFile(graph_binary_2);
+	assert(g_empty_binary->Nodes.size() == 0);
+	assert(g_empty_binary->Edges.size() == 0);
+	assert(g_empty_binary->EdgesInFileOrder.size() == 0);
+	g_empty_binary->freeMemory();
+	delete(g_empty_binary);
+	g_empty->freeMemory();
+	delete(g_empty);
+
+	std::cout << "testGraphBinaryFile(): all tests passed.\n" << std::flush;
+}
+
+// random aligned read; values are chosen so that they also survive the text format (6 significant digits)
+static void randomAlignedRead(int readLength, std::string readName, seedAndExtend_return_local& alignment_ret, oneRead& originalRead_ret)
+{
+	std::string sequence;
+	std::string quality;
+	for(int i = 0; i < readLength; i++)
+	{
+		sequence.push_back((Utilities::randomNumber(20) == 0) ? 'N' : Utilities::randomNucleotide());
+		quality.push_back((char)('!' + Utilities::randomNumber(40)));
+	}
+
+	seedAndExtend_return_local a;
+	a.Score = Utilities::randomNumber(1000) - 200;
+	a.reverse = (Utilities::randomNumber(1) == 1);
+	a.mapQ = Utilities::randomNumber(8) / 8.0;
+	a.mapQ_genomic = Utilities::randomNumber(8) / 8.0;
+
+	int level = Utilities::randomNumber(100000);
+	for(int i = 0; i < readLength; i++)
+	{
+		bool graphGap = (Utilities::randomNumber(15) == 0);
+		bool sequenceGap = ((! graphGap) && (Utilities::randomNumber(15) == 0));
+		a.graph_aligned.push_back(graphGap ? '_' : Utilities::randomNucleotide());
+		a.sequence_aligned.push_back(sequenceGap ? '_' : sequence.at(i));
+		a.graph_aligned_levels.push_back(graphGap ? -1 : level++);
+		if(Utilities::randomNumber(50) == 0)
+		{
+			level += Utilities::randomNumber(5000);
+		}
+	}
+	if(Utilities::randomNumber(1) == 1)
+	{
+		for(int i = 0; i < readLength; i++)
+		{
+			a.mapQ_genomic_perPosition.push_back((char)('0' + Utilities::randomNumber(9)));
+		}
+	}
+
+	alignment_ret = a;
+	originalRead_ret = oneRead(readName, sequence, quality);
+}
+
+static void assertSameAlignedRead(const seedAndExtend_return_local& alignment_1, const oneRead& originalRead_1, const seedAndExtend_return_local& alignment_2, const oneRead& originalRead_2)
+{
+	assert(alignment_1.Score == alignment_2.Score);
+	assert(alignment_1.reverse == alignment_2.reverse);
+	assert(alignment_1.mapQ == alignment_2.mapQ);
+	assert(alignment_1.mapQ_genomic == alignment_2.mapQ_genomic);
+	assert(alignment_1.mapQ_genomic_perPosition == alignment_2.mapQ_genomic_perPosition);
+	assert(alignment_1.graph_aligned == alignment_2.graph_aligned);
+	assert(alignment_1.sequence_aligned == alignment_2.sequence_aligned);
+	assert(alignment_1.graph_aligned_levels == alignment_2.graph_aligned_levels);
+	assert(originalRead_1.name == originalRead_2.name);
+	assert(originalRead_1.sequence == originalRead_2.sequence);
+	assert(originalRead_1.quality == originalRead_2.quality);
+}
+
+// reads an alignments file completely, both record by record and with readAllAlignmentPairs(..); false if the file is rejected
+static bool readAlignmentsFile(std::string filename, std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>>& ret_alignments, std::vector<oneReadPair>& ret_originalReads, double& ret_IS_mean, double& ret_IS_sd, size_t& ret_blocks)
+{
+	try
+	{
+		shortReadAlignmentsReader reader_next(filename);
+		std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> alignments_next;
+		std::vector<oneReadPair> originalReads_next;
+		seedAndExtend_return_local alignment_1;
+		seedAndExtend_return_local alignment_2;
+		oneRead originalRead_1("", "", "");
+		oneRead originalRead_2("", "", "");
+		while(reader_next.nextAlignmentPair(alignment_1, originalRead_1, alignment_2, originalRead_2))
+		{
+			alignments_next.push_back(make_pair(alignment_1, alignment_2));
+			originalReads_next.push_back(oneReadPair(originalRead_1, originalRead_2, 0));
+		}
+
+		shortReadAlignmentsReader reader_all(filename);
+		reader_all.readAllAlignmentPairs(ret_alignments, ret_originalReads);
+
+		assert(ret_alignments.size() == alignments_next.size());
+		assert(ret_originalReads.size() == ret_alignments.size());
+		for(unsigned int pairI = 0; pairI < ret_alignments.size(); pairI++)
+		{
+			assertSameAlignedRead(ret_alignments.at(pairI).first, ret_originalReads.at(pairI).reads.first, alignments_next.at(pairI).first, originalReads_next.at(pairI).reads.first);
+			assertSameAlignedRead(ret_alignments.at(pairI).second, ret_originalReads.at(pairI).reads.second, alignments_next.at(pairI).second, originalReads_next.at(pairI).reads.second);
+		}
+
+		assert(reader_all.getInsertSizeMean() == reader_next.getInsertSizeMean());
+		assert(reader_all.getInsertSizeSD() == reader_next.getInsertSizeSD());
+		ret_IS_mean = reader_all.getInsertSizeMean();
+		ret_IS_sd = reader_all.getInsertSizeSD();
+		ret_blocks = reader_all.getBlockOffsets().size();
+	}
+	catch(std::runtime_error& e)
+	{
+		return false;
+	}
+	return true;
+}
+
+void testShortReadAlignmentsFile(std::string temp_dir)
+{
+	std::string alignments_file = temp_dir + "/testShortReadAlignmentsFile.aligned";
+	std::string alignments_file_broken = temp_dir + "/testShortReadAlignmentsFile_broken.aligned";
+
+	// no pairs, a few pairs, more than shortReadAlignmentsWriter::blockSize bytes of pairs, and a single pair larger than blockSize
+	std::vector<size_t> pairs_per_test = {0, 5, 8000, 1};
+	std::vector<int> maxReadLength_per_test = {0, 150, 150, 600000};
+	for(unsigned int testI = 0; testI < pairs_per_test.size(); testI++)
+	{
+		std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> alignments;
+		std::vector<oneReadPair> originalReads;
+		for(size_t pairI = 0; pairI < pairs_per_test.at(testI); pairI++)
+		{
+			seedAndExtend_return_local alignment_1;
+			seedAndExtend_return_local alignment_2;
+			oneRead originalRead_1("", "", "");
+			oneRead originalRead_2("", "", "");
+			int readLength_1 = maxReadLength_per_test.at(testI) - Utilities::randomNumber(maxReadLength_per_test.at(testI) / 2);
+			int readLength_2 = maxReadLength_per_test.at(testI) - Utilities::randomNumber(maxReadLength_per_test.at(testI) / 2);
+			randomAlignedRead(readLength_1, "read" + Utilities::ItoStr(pairI) + "/1", alignment_1, originalRead_1);
+			randomAlignedRead(readLength_2, "read" + Utilities::ItoStr(pairI) + "/2", alignment_2, originalRead_2);
+			alignments.push_back(make_pair(alignment_1, alignment_2));
+			originalReads.push_back(oneReadPair(originalRead_1, originalRead_2, 0));
+		}
+
+		double IS_mean = 200 + testI;
+		double IS_sd = 15.5;
+
+		// text, binary and uncompressed binary
+		for(unsigned int formatI = 0; formatI < 3; formatI++)
+		{
+			bool binaryFormat = (formatI > 0);
+			bool compressBlocks = (formatI == 1);
+
+			shortReadAlignmentsWriter writer(alignments_file, IS_mean, IS_sd, binaryFormat, compressBlocks);
+			for(size_t pairI = 0; pairI < alignments.size(); pairI++)
+			{
+				writer.beginPair(pairI);
+				writer.writeAlignmentPair(alignments.at(pairI).first, originalReads.at(pairI).reads.first, alignments.at(pairI).second, originalReads.at(pairI).reads.second, "_A0");
+			}
+			writer.close();
+
+			std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> alignments_read;
+			std::vector<oneReadPair> originalReads_read;
+			double IS_mean_read;
+			double IS_sd_read;
+			size_t blocks_read;
+			bool fileOK = readAlignmentsFile(alignments_file, alignments_read, originalReads_read, IS_mean_read, IS_sd_read, blocks_read);
+			assert(fileOK);
+
+			assert(IS_mean_read == IS_mean);
+			assert(IS_sd_read == IS_sd);
+			assert(alignments_read.size() == alignments.size());
+			for(size_t pairI = 0; pairI < alignments.size(); pairI++)
+			{
+				oneRead originalRead_1 = originalReads.at(pairI).reads.first;
+				oneRead originalRead_2 = originalReads.at(pairI).reads.second;
+				originalRead_1.name += "_A0";
+				originalRead_2.name += "_A0";
+				assertSameAlignedRead(alignments.at(pairI).first, originalRead_1, alignments_read.at(pairI).first, originalReads_read.at(pairI).reads.first);
+				assertSameAlignedRead(alignments.at(pairI).second, originalRead_2, alignments_read.at(pairI).second, originalReads_read.at(pairI).reads.second);
+			}
+			if(binaryFormat && (pairs_per_test.at(testI) == 8000))
+			{
+				assert(blocks_read > 1);
+			}
+
+			if(formatI != 1)
+				continue;
+
+			// truncated files, corrupt headers, blocks and block indices are rejected
+			std::string file_bytes = readFileBytes(alignments_file);
+			std::vector<size_t> truncateAt = {0, 4, 12, 30, file_bytes.size() / 2, file_bytes.size() - 1};
+			for(unsigned int truncateI = 0; truncateI < truncateAt.size(); truncateI++)
+			{
+				writeFileBytes(alignments_file_broken, file_bytes.substr(0, truncateAt.at(truncateI)));
+				assert(! readAlignmentsFile(alignments_file_broken, alignments_read, originalReads_read, IS_mean_read, IS_sd_read, blocks_read));
+			}
+
+			std::vector<size_t> corruptAt = {0, 8, file_bytes.size() - 1};
+			if(alignments.size())
+			{
+				corruptAt.push_back(48 + (file_bytes.size() - 48) / 3);
+			}
+			for(unsigned int corruptI = 0; corruptI < corruptAt.size(); corruptI++)
+			{
+				std::string corrupt_bytes = file_bytes;
+				corrupt_bytes.at(corruptAt.at(corruptI)) ^= 0x20;
+				writeFileBytes(alignments_file_broken, corrupt_bytes);
+				assert(! readAlignmentsFile(alignments_file_broken, alignments_read, originalReads_read, IS_mean_read, IS_sd_read, blocks_read));
+			}
+		}
+
+		std::cout << "testShortReadAlignmentsFile(): " << pairs_per_test.at(testI) << " pairs OK.\n" << std::flush;
+	}
+
+	std::cout << "testShortReadAlignmentsFile(): all tests passed.\n" << std::flush;
+}
 
 
 };
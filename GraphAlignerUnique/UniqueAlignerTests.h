@@ -21,6 +21,10 @@ namespace tests {
 	void testSeedAndExtend();
 	void testSeedAndExtend_local();
 	void testSeedAndExtend_short();
+	// binary file round trips; temp_dir receives the test files
+	void testGraphBinaryFile(std::string temp_dir);
+	void testShortReadAlignmentsFile(std::string temp_dir);
+
 	void testSeedAndExtend_local_realGraph(std::string graph_filename, int read_length, double insertSize_mean, double insertSize_sd, std::string qualityMatrixFile, bool longBadReads, bool greedyLocalExtension);
 
 }
@@ -22,7 +22,7 @@ namespace GraphAlignerUnique {
 NWEdge::NWEdge()
 {
 	path = 0;
-	usedGraphEdge = 0;
+	usedGraphEdgeID = FrozenGraph::noEdge;
 	scoreComputed = false;
 	endsFree_previousEdgeAffineSequenceGap = false;
 }
@@ -93,14 +93,14 @@ void VirtualNWTable_Unique::printSequenceCoverageStats()
 
 void VirtualNWTable_Unique::print()
 {
-	int maxX = gA->g->NodesPerLevel.size() - 1;
+	int maxX = gA->fG.levels() - 1;
 	int maxY = S->length();
 
 	std::vector<std::vector<std::vector<std::string>> > printMatrix;
 	printMatrix.resize(maxX + 1);
 	for(int levelI = 0; levelI <= maxX; levelI++)
 	{
-		int zMax = gA->g->NodesPerLevel.at(levelI).size();
+		int zMax = gA->fG.statesAtLevel(levelI);
 		printMatrix.at(levelI).resize(maxY+1);
 		for(int seqI = 0; seqI <= maxY; seqI++)
 		{
@@ -144,9 +144,9 @@ void VirtualNWTable_Unique::print()
 				printMatrix.at(e->from_x).at(e->from_y).at(e->from_z) += ( "ENTRY " + Utilities::ItoStr(path_index) + "; FROM "+backtrackPathID + ". ");
 			}
 			std::string edgeLabel;
-			if(e->usedGraphEdge != 0)
+			if(e->usedGraphEdgeID != FrozenGraph::noEdge)
 			{
-				edgeLabel = gA->g->CODE.deCode(e->usedGraphEdge->locus_id, e->usedGraphEdge->emission);
+				edgeLabel = std::string(1, gA->fG.edgeEmission(e->usedGraphEdgeID));
 			}
 
 			std::string exitLabel;
@@ -221,9 +221,9 @@ void VirtualNWTable_Unique::addPath(NWPath* p)
 		index_edges_from[edge->from_x][edge->from_y][edge->from_z].insert(edge);
 		index_edges_to[edge->to_x][edge->to_y][edge->to_z].insert(edge);
 
-		if(edge->usedGraphEdge != 0)
+		if(edge->usedGraphEdgeID != FrozenGraph::noEdge)
 		{
-			index_graphEdges_2_NWEdges[edge->usedGraphEdge].insert(edge);
+			index_graphEdges_2_NWEdges[edge->usedGraphEdgeID].insert(edge);
 		}
 	}
 
@@ -249,9 +249,9 @@ void VirtualNWTable_Unique::removePath(NWPath* p)
 		index_edges_to[edge->to_x][edge->to_y][edge->to_z].erase(edge);
 
 
-		if(edge->usedGraphEdge != 0)
+		if(edge->usedGraphEdgeID != FrozenGraph::noEdge)
 		{
-			index_graphEdges_2_NWEdges[edge->usedGraphEdge].erase(edge);
+			index_graphEdges_2_NWEdges[edge->usedGraphEdgeID].erase(edge);
 		}
 	}
 
@@ -356,12 +356,12 @@ void VirtualNWTable_Unique::_testTracePath(NWPath* p, std::string& reconstructed
 		int next_x = thisStepEdge->to_x;
 		int next_y = thisStepEdge->to_y;
 
-		Edge* usedGraphEdge = thisStepEdge->usedGraphEdge;
+		unsigned int usedGraphEdgeID = thisStepEdge->usedGraphEdgeID;
 
 		std::string edgeEmission;
-		if(usedGraphEdge != 0)
+		if(usedGraphEdgeID != FrozenGraph::noEdge)
 		{
-			edgeEmission = gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+			edgeEmission = std::string(1, gA->fG.edgeEmission(usedGraphEdgeID));
 			assert(edgeEmission.size() == 1);
 		}
 
@@ -374,7 +374,7 @@ void VirtualNWTable_Unique::_testTracePath(NWPath* p, std::string& reconstructed
 		if((next_x == (this_x + 1)) && (next_y == (this_y + 1)))
 		{
 			// match or mismatch
-			assert(usedGraphEdge != 0);
+			assert(usedGraphEdgeID != FrozenGraph::noEdge);
 			reconstructed_graph.append(edgeEmission);
 			reconstructed_graph_levels.push_back(this_x);
 			reconstructed_sequence.append(sequenceEmission);
@@ -389,7 +389,7 @@ void VirtualNWTable_Unique::_testTracePath(NWPath* p, std::string& reconstructed
 		else if((next_x == (this_x + 1)) && (next_y == this_y))
 		{
 			// gap in sequence
-			assert(usedGraphEdge != 0);
+			assert(usedGraphEdgeID != FrozenGraph::noEdge);
 			reconstructed_graph.append(edgeEmission);
 			reconstructed_graph_levels.push_back(this_x);
 			reconstructed_sequence.append("_");
@@ -499,21 +499,21 @@ NWPath::NWPath()
 	table = 0;
 }
 
-std::vector<Edge*> NWPath::graphEdgesPath()
+std::vector<unsigned int> NWPath::graphEdgesPath()
 {
 	assert(first_edges.size() == 1);
 	NWEdge* currentEdge = *(first_edges.begin());
 
-	std::vector<Edge*> forReturn;
+	std::vector<unsigned int> forReturn;
 	if(last_edges.count(currentEdge) > 0)
 	{
-		forReturn.push_back(currentEdge->usedGraphEdge);
+		forReturn.push_back(currentEdge->usedGraphEdgeID);
 		return forReturn;
 	}
 
 	do
 	{
-		forReturn.push_back(currentEdge->usedGraphEdge);
+		forReturn.push_back(currentEdge->usedGraphEdgeID);
 		assert(edges_from.at(currentEdge->to_x).at(currentEdge->to_y).at(currentEdge->to_z).size() == 1);
 		currentEdge = *(edges_from.at(currentEdge->to_x).at(currentEdge->to_y).at(currentEdge->to_z).begin());
 
@@ -521,7 +521,7 @@ std::vector<Edge*> NWPath::graphEdgesPath()
 
 	assert(last_edges.count(currentEdge) > 0);
 
-	forReturn.push_back(currentEdge->usedGraphEdge);
+	forReturn.push_back(currentEdge->usedGraphEdgeID);
 
 	return forReturn;
 }
@@ -567,23 +567,24 @@ void NWEdge::checkConsistency()
 			assert(path->table->index_edges_from.at(from_x).at(from_y).at(from_z).count(selfPointer) > 0);
 			assert(path->table->index_edges_to.at(to_x).at(to_y).at(to_z).count(selfPointer) > 0);
 
-			if(usedGraphEdge != 0)
+			if(usedGraphEdgeID != FrozenGraph::noEdge)
 			{
-				assert(path->table->gA->g->Edges.count(usedGraphEdge) > 0);
-				assert(path->table->gA->nodesPerLevel_ordered.at(from_x).at(from_z)->Outgoing_Edges.count(usedGraphEdge) > 0);
-				if(! (path->table->gA->nodesPerLevel_ordered.at(to_x).at(to_z)->Incoming_Edges.count(usedGraphEdge) > 0))
+				const FrozenGraph& fG = path->table->gA->fG;
+				assert(usedGraphEdgeID < fG.edgeCount());
+				assert(fG.edgeFrom(usedGraphEdgeID) == (fG.levelFirstNode(from_x) + from_z));
+				if(! (fG.edgeTo(usedGraphEdgeID) == (fG.levelFirstNode(to_x) + to_z)))
 				{
 					std::cerr << "Problem with path: specified edge not present in graph! to_x = " << to_x << ", to_z = " << to_z << "\n" << std::flush;
 				}
-				assert(path->table->gA->nodesPerLevel_ordered.at(to_x).at(to_z)->Incoming_Edges.count(usedGraphEdge) > 0);
+				assert(fG.edgeTo(usedGraphEdgeID) == (fG.levelFirstNode(to_x) + to_z));
 
-				assert(path->table->index_graphEdges_2_NWEdges[usedGraphEdge].count(selfPointer) > 0);
+				assert(path->table->index_graphEdges_2_NWEdges[usedGraphEdgeID].count(selfPointer) > 0);
 			}
 		}
 	}
 }
 
-bool NWPath::edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge)
+bool NWPath::edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID)
 {
 	if(
 			(edges_from.count(from_x) && edges_from.at(from_x).count(from_y) && edges_from.at(from_x).at(from_y).count(from_z)) &&
@@ -597,7 +598,7 @@ bool NWPath::edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y,
 			NWEdge* e = *eIt;
 			if(candidates_to.count(e) > 0)
 			{
-				if(e->usedGraphEdge == graphEdge)
+				if(e->usedGraphEdgeID == graphEdgeID)
 				{
 					return true;
 				}
@@ -611,7 +612,7 @@ bool NWPath::edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y,
 	}
 }
 
-NWEdge* NWPath::retrieveEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge)
+NWEdge* NWPath::retrieveEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID)
 {
 	std::set<NWEdge*>& candidates_from = edges_from.at(from_x).at(from_y).at(from_z);
 	std::set<NWEdge*>& candidates_to =  edges_to.at(to_x).at(to_y).at(to_z);
@@ -620,7 +621,7 @@ NWEdge* NWPath::retrieveEdge(int from_x, int from_y, int from_z, int to_x, int t
 		NWEdge* e = *eIt;
 		if(candidates_to.count(e) > 0)
 		{
-			if(e->usedGraphEdge == graphEdge)
+			if(e->usedGraphEdgeID == graphEdgeID)
 			{
 				return e;
 			}
@@ -648,7 +649,7 @@ void NWPath::extendToZero(int whichEnd, int lastYCoordinate)
 				for(int y = 1; y <= entryEdge->from_y; y++)
 				{
 					int entryExitStatus = (y == 1) ? -1 : 0;
-					createAndAddEdge(entryEdge->from_x, y - 1, entryEdge->from_z, entryEdge->from_x, y, entryEdge->from_z, 0, 0, entryExitStatus);
+					createAndAddEdge(entryEdge->from_x, y - 1, entryEdge->from_z, entryEdge->from_x, y, entryEdge->from_z, FrozenGraph::noEdge, 0, entryExitStatus);
 					// std::cerr << "CreateAdd edge (" << entryEdge->from_x << ", " << (y - 1) << ", " << entryEdge->from_z << ") -> " <<
 				}
 			}
@@ -673,7 +674,7 @@ void NWPath::extendToZero(int whichEnd, int lastYCoordinate)
 				for(int y = exitEdge->to_y + 1; y <= lastYCoordinate; y++)
 				{
 					int entryExitStatus = (y == lastYCoordinate) ? 1 : 0;
-					createAndAddEdge(exitEdge->to_x, y - 1, exitEdge->to_z, exitEdge->to_x, y, exitEdge->to_z, 0, 0, entryExitStatus);
+					createAndAddEdge(exitEdge->to_x, y - 1, exitEdge->to_z, exitEdge->to_x, y, exitEdge->to_z, FrozenGraph::noEdge, 0, entryExitStatus);
 				}
 			}
 		}
@@ -685,16 +686,16 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 	assert((entryExit == -1) || (entryExit == 1));
 	assert((completeToEnd == 0) || (completeToEnd == 1) || (completeToEnd == -1));
 
-	assert(pD->usedEdges.size() > 0);
-	assert(pD->coordinates.size() == (pD->usedEdges.size() + 1));
+	assert(pD->usedEdgeIDs.size() > 0);
+	assert(pD->coordinates.size() == (pD->usedEdgeIDs.size() + 1));
 	if(completeToEnd == 0)
 	{
 		for(unsigned int coordinateI = 0; coordinateI < (pD->coordinates.size() - 1); coordinateI++)
 		{
 			std::vector<int>& thisCoordinates = pD->coordinates.at(coordinateI);
 			std::vector<int>& nextCoordinates = pD->coordinates.at(coordinateI+1);
-			Edge* usedGraphEdge = pD->usedEdges.at(coordinateI);
-			if(! edgeExists(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdge))
+			unsigned int usedGraphEdgeID = pD->usedEdgeIDs.at(coordinateI);
+			if(! edgeExists(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdgeID))
 			{
 				int entryExitStatus = 0;
 				if((entryExit == -1) && (coordinateI == 0))
@@ -706,7 +707,7 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 					entryExitStatus = 1;
 				}
 
-				createAndAddEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdge, 0, entryExitStatus);
+				createAndAddEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdgeID, 0, entryExitStatus);
 			}
 			else
 			{
@@ -721,7 +722,7 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 				}
 				if(entryExitStatus != 0)
 				{
-					addStatusEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdge, 0, entryExitStatus);
+					addStatusEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdgeID, 0, entryExitStatus);
 				}
 
 			}
@@ -733,11 +734,11 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 		{
 			std::vector<int>& thisCoordinates = pD->coordinates.at(coordinateI);
 			std::vector<int>& nextCoordinates = pD->coordinates.at(coordinateI+1);
-			Edge* usedGraphEdge = pD->usedEdges.at(coordinateI);
-			if(! edgeExists(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdge))
+			unsigned int usedGraphEdgeID = pD->usedEdgeIDs.at(coordinateI);
+			if(! edgeExists(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdgeID))
 			{
 				int entryExitStatus = 0;
-				createAndAddEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdge, 0, entryExitStatus);
+				createAndAddEdge(thisCoordinates.at(0), thisCoordinates.at(1), thisCoordinates.at(2), nextCoordinates.at(0), nextCoordinates.at(1), nextCoordinates.at(2), usedGraphEdgeID, 0, entryExitStatus);
 			}
 			else
 			{
@@ -757,20 +758,20 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 			{
 				int entryExitStatus = 0;
 				std::cerr << "[completeToEnd == 1] Add edge " << lastCoordinates.at(0) << ", " << (y-1) << ", " << lastCoordinates.at(2) << " to " << lastCoordinates.at(0) << ", " << y << ", " << lastCoordinates.at(2) << "\n" << std::flush;
-				createAndAddEdge(lastCoordinates.at(0), y - 1, lastCoordinates.at(2), lastCoordinates.at(0), y, lastCoordinates.at(2), 0, 0, entryExitStatus);
+				createAndAddEdge(lastCoordinates.at(0), y - 1, lastCoordinates.at(2), lastCoordinates.at(0), y, lastCoordinates.at(2), FrozenGraph::noEdge, 0, entryExitStatus);
 			}
 
 			if(entryExit != 0)
 			{
 				if(missingYs > 0)
 				{
-					addStatusEdge(lastCoordinates.at(0), lastYCoordinate - 1, lastCoordinates.at(2), lastCoordinates.at(0), lastYCoordinate, lastCoordinates.at(2), 0, 0, entryExit);
+					addStatusEdge(lastCoordinates.at(0), lastYCoordinate - 1, lastCoordinates.at(2), lastCoordinates.at(0), lastYCoordinate, lastCoordinates.at(2), FrozenGraph::noEdge, 0, entryExit);
 				}
 				else
 				{
-					Edge* usedGraphEdge = pD->usedEdges.at(pD->usedEdges.size() - 1);
+					unsigned int usedGraphEdgeID = pD->usedEdgeIDs.at(pD->usedEdgeIDs.size() - 1);
 					std::vector<int> secondLastCoordinates = pD->coordinates.at(pD->coordinates.size() - 1);
-					addStatusEdge(secondLastCoordinates.at(0), secondLastCoordinates.at(1), secondLastCoordinates.at(2), lastCoordinates.at(0), lastCoordinates.at(1), lastCoordinates.at(2), usedGraphEdge, 0, entryExit);
+					addStatusEdge(secondLastCoordinates.at(0), secondLastCoordinates.at(1), secondLastCoordinates.at(2), lastCoordinates.at(0), lastCoordinates.at(1), lastCoordinates.at(2), usedGraphEdgeID, 0, entryExit);
 				}
 			}
 		}
@@ -787,21 +788,21 @@ void NWPath::takeInExtensionPath(localExtension_pathDescription* pD, int entryEx
 			{
 				int entryExitStatus = 0;
 				std::cerr << "[completeToEnd == -1] Add edge " << firstCoordinates.at(0) << ", " << (y-1) << ", " << firstCoordinates.at(2) << " to " << firstCoordinates.at(0) << ", " << y << ", " << firstCoordinates.at(2) << "\n" << std::flush;
-				createAndAddEdge(firstCoordinates.at(0), y - 1, firstCoordinates.at(2), firstCoordinates.at(0), y, firstCoordinates.at(2), 0, 0, entryExitStatus);
+				createAndAddEdge(firstCoordinates.at(0), y - 1, firstCoordinates.at(2), firstCoordinates.at(0), y, firstCoordinates.at(2), FrozenGraph::noEdge, 0, entryExitStatus);
 			}
 
 			if(entryExit != 0)
 			{
 				if(missingYs > 0)
 				{
-					addStatusEdge(firstCoordinates.at(0), 0, firstCoordinates.at(2), firstCoordinates.at(0), 1, firstCoordinates.at(2), 0, 0, entryExit);
+					addStatusEdge(firstCoordinates.at(0), 0, firstCoordinates.at(2), firstCoordinates.at(0), 1, firstCoordinates.at(2), FrozenGraph::noEdge, 0, entryExit);
 				}
 				else
 				{
-					Edge* usedGraphEdge = pD->usedEdges.at(0);
+					unsigned int usedGraphEdgeID = pD->usedEdgeIDs.at(0);
 
 					std::vector<int> secondCoordinates = pD->coordinates.at(1);
-					addStatusEdge(firstCoordinates.at(0), firstCoordinates.at(1), firstCoordinates.at(2), secondCoordinates.at(0), secondCoordinates.at(1), secondCoordinates.at(2), 0, 0, entryExit);
+					addStatusEdge(firstCoordinates.at(0), firstCoordinates.at(1), firstCoordinates.at(2), secondCoordinates.at(0), secondCoordinates.at(1), secondCoordinates.at(2), FrozenGraph::noEdge, 0, entryExit);
 				}
 			}
 		}
@@ -856,9 +857,9 @@ NWPath* NWPath::clonePathWithoutTable()
 	return newPath;
 }
 
-void NWPath::eraseStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge)
+void NWPath::eraseStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID)
 {
-	NWEdge* e = retrieveEdge(from_x, from_y, from_z, to_x, to_y, to_z, graphEdge);
+	NWEdge* e = retrieveEdge(from_x, from_y, from_z, to_x, to_y, to_z, graphEdgeID);
 	first_edges.erase(e);
 	last_edges.erase(e);
 	entry_edges.erase(e);
@@ -866,9 +867,9 @@ void NWPath::eraseStatusEdge(int from_x, int from_y, int from_z, int to_x, int t
 }
 
 
-void NWPath::addStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge, int firstOrLast, int entryExitStatus)
+void NWPath::addStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID, int firstOrLast, int entryExitStatus)
 {
-	NWEdge* e = retrieveEdge(from_x, from_y, from_z, to_x, to_y, to_z, graphEdge);
+	NWEdge* e = retrieveEdge(from_x, from_y, from_z, to_x, to_y, to_z, graphEdgeID);
 
 	if(firstOrLast == -1)
 	{
@@ -888,7 +889,7 @@ void NWPath::addStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_
 	}
 }
 
-NWEdge* NWPath::createAndAddEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge, int firstOrLast, int entryExitStatus)
+NWEdge* NWPath::createAndAddEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID, int firstOrLast, int entryExitStatus)
 {
 	NWEdge* edge = new NWEdge();
 	edge->from_x = from_x;
@@ -897,7 +898,7 @@ NWEdge* NWPath::createAndAddEdge(int from_x, int from_y, int from_z, int to_x, i
 	edge->to_x = to_x;
 	edge->to_y = to_y;
 	edge->to_z = to_z;
-	edge->usedGraphEdge = graphEdge;
+	edge->usedGraphEdgeID = graphEdgeID;
 	addEdge(edge);
 
 	assert((firstOrLast == -1) || (firstOrLast == 0) || (firstOrLast == 1));
@@ -1200,7 +1201,7 @@ void NWEdge::_printEdge()
 	std::cout << "\t" << "to_y: " << to_y << "\n";
 	std::cout << "\t" << "to_z: " << to_z << "\n";
 
-	std::cout << "\t" << "usedGraphEdge: " << usedGraphEdge << "\n" << std::flush;
+	std::cout << "\t" << "usedGraphEdgeID: " << usedGraphEdgeID << "\n" << std::flush;
 
 }
 
@@ -1226,14 +1227,14 @@ void NWEdge::takeScore(double Score, NWEdge* backtrackEdge, double S_match, doub
 
 //			std::cout << "scoreEdge " << "3.1" << "\n" << std::flush;
 
-			assert(e->usedGraphEdge != 0);
+			assert(e->usedGraphEdgeID != FrozenGraph::noEdge);
 			assert(e->path != 0);
 			assert(e->path->table != 0);
 			assert(e->path->table->gA != 0);
 
 //			std::cout << "scoreEdge " << "3.1.1" << "\n" << std::flush;
 
-			std::string edge_emission = e->path->table->gA->g->CODE.deCode(e->usedGraphEdge->locus_id, e->usedGraphEdge->emission);
+			std::string edge_emission = std::string(1, e->path->table->gA->fG.edgeEmission(e->usedGraphEdgeID));
 
 //			std::cout << "scoreEdge " << "3.1.2" << "\n" << std::flush;
 			assert(edge_emission.length() == 1);
@@ -1258,8 +1259,8 @@ void NWEdge::takeScore(double Score, NWEdge* backtrackEdge, double S_match, doub
 			if((diff_x == 1) && (diff_y == 0))
 			{
 				// gap in sequence
-				assert(e->usedGraphEdge != 0);
-				std::string edge_emission = e->path->table->gA->g->CODE.deCode(e->usedGraphEdge->locus_id, e->usedGraphEdge->emission);
+				assert(e->usedGraphEdgeID != FrozenGraph::noEdge);
+				std::string edge_emission = std::string(1, e->path->table->gA->fG.edgeEmission(e->usedGraphEdgeID));
 				assert(edge_emission.length() == 1);
 				if(edge_emission == "_")
 				{
@@ -1776,10 +1777,10 @@ double NWEdge::calculateScore(bool comingFromAffineSequenceGap, bool comingFromA
 	else
 	{
 		assert(((to_x - from_x) == 1) && ((to_y - from_y) == 1));
-		assert(usedGraphEdge != 0);
+		assert(usedGraphEdgeID != FrozenGraph::noEdge);
 		assert(path && path->table && path->table->gA);
 
-		std::string edgeLabel = path->table->gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+		std::string edgeLabel = std::string(1, path->table->gA->fG.edgeEmission(usedGraphEdgeID));
 		assert(edgeLabel.length() == 1);
 
 		std::string sequenceEmission = path->table->S->substr(from_y, 1);
@@ -1821,9 +1822,9 @@ double NWEdge::calculateScore_endsFree(bool comingFromAffineSequenceGap, bool co
 	}
 	else if(isSequenceGap())
 	{
-		assert(usedGraphEdge != 0);
+		assert(usedGraphEdgeID != FrozenGraph::noEdge);
 		assert(path && path->table && path->table->gA);
-		std::string edgeLabel = path->table->gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+		std::string edgeLabel = std::string(1, path->table->gA->fG.edgeEmission(usedGraphEdgeID));
 		assert(edgeLabel.length() == 1);
 
 		if(edgeLabel != "_")
@@ -1845,10 +1846,10 @@ double NWEdge::calculateScore_endsFree(bool comingFromAffineSequenceGap, bool co
 	else
 	{
 		assert(((to_x - from_x) == 1) && ((to_y - from_y) == 1));
-		assert(usedGraphEdge != 0);
+		assert(usedGraphEdgeID != FrozenGraph::noEdge);
 		assert(path && path->table && path->table->gA);
 
-		std::string edgeLabel = path->table->gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+		std::string edgeLabel = std::string(1, path->table->gA->fG.edgeEmission(usedGraphEdgeID));
 		assert(edgeLabel.length() == 1);
 
 		std::string sequenceEmission = path->table->S->substr(from_y, 1);
@@ -1879,9 +1880,9 @@ bool NWEdge::isSequenceGap_affine()
 		return false;
 	}
 
-	assert(usedGraphEdge != 0);
+	assert(usedGraphEdgeID != FrozenGraph::noEdge);
 	assert(path && path->table && path->table->gA);
-	std::string edgeLabel = path->table->gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+	std::string edgeLabel = std::string(1, path->table->gA->fG.edgeEmission(usedGraphEdgeID));
 
 	if(edgeLabel == "_")
 	{
@@ -1901,9 +1902,9 @@ bool NWEdge::isSequenceGap_endsFree()
 		return false;
 	}
 
-	assert(usedGraphEdge != 0);
+	assert(usedGraphEdgeID != FrozenGraph::noEdge);
 	assert(path && path->table && path->table->gA);
-	std::string edgeLabel = path->table->gA->g->CODE.deCode(usedGraphEdge->locus_id, usedGraphEdge->emission);
+	std::string edgeLabel = std::string(1, path->table->gA->fG.edgeEmission(usedGraphEdgeID));
 
 	if(edgeLabel == "_")
 	{
@@ -15,10 +15,9 @@
 #include "GraphAlignerUnique.h"
 #include <assert.h>
 
-class localExtension_pathDescription;
-
 namespace GraphAlignerUnique {
 
+class localExtension_pathDescription;
 class NWPath;
 class NWEdge;
 class NWPath;
@@ -33,7 +32,7 @@ public:
 	std::map<int, std::set<NWEdge*>> index_edges_start_y;
 	std::map<int, std::set<NWEdge*>> index_edges_stop_y;
 
-	std::map<Edge*, std::set<NWEdge*> > index_graphEdges_2_NWEdges;
+	std::map<unsigned int, std::set<NWEdge*> > index_graphEdges_2_NWEdges;
 
 	std::map<int, std::map<int, std::map<int, std::set<NWEdge*> > > > index_edges_from;
 	std::map<int, std::map<int, std::map<int, std::set<NWEdge*> > > > index_edges_to;
@@ -61,7 +60,7 @@ public:
 	bool hasEdgeEmanatingFrom(int x, int y, int z);
 	bool hasEdgeGoingInto(int x, int y, int z);
 
-	bool edgePresentInPath(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* usedEdge);
+	bool edgePresentInPath(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int usedEdgeID);
 
 	std::set<NWEdge*> getEdgesEmanatingFrom(int x, int y, int z);
 	std::set<NWEdge*> getEdgesGoingInto(int x, int y, int z);
@@ -114,17 +113,17 @@ public:
 	std::set<NWEdge*> backwardEdges(NWEdge* e);
 
 	void verify_edges();
-	NWEdge* createAndAddEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge, int firstOrLast = 0, int entryExitStatus = 0);
-	void addStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge, int firstOrLast = 0, int entryExitStatus = 0);
-	void eraseStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge);
+	NWEdge* createAndAddEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID, int firstOrLast = 0, int entryExitStatus = 0);
+	void addStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID, int firstOrLast = 0, int entryExitStatus = 0);
+	void eraseStatusEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID);
 	void eraseAllEdgeStatus();
 
-	bool edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge);
-	NWEdge* retrieveEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, Edge* graphEdge);
+	bool edgeExists(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID);
+	NWEdge* retrieveEdge(int from_x, int from_y, int from_z, int to_x, int to_y, int to_z, unsigned int graphEdgeID);
 
 	void addEdge(NWEdge* e);
 
-	std::vector<Edge*> graphEdgesPath();
+	std::vector<unsigned int> graphEdgesPath();
 
 	void takeInExtensionPath(localExtension_pathDescription* pD, int entryExit, int completeToEnd);
 
@@ -151,7 +150,7 @@ public:
 	int to_y;
 	int to_z;
 
-	Edge* usedGraphEdge;
+	unsigned int usedGraphEdgeID;
 	NWPath* path;
 
 	bool scoreComputed;
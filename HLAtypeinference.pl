@@ -51,6 +51,7 @@ my $only_4_dig = 1;
 my $reduce_to_4_dig = 0;
 my $HiSeq250bp = 0;
 my $MiSeq250bp = 0;
+my $exhaustivePairs = 0;
 
 my $fastExtraction = 0;
 
@@ -80,6 +81,7 @@ GetOptions ('graph:s' => \$graph,
  'only_4_dig:s' => \$only_4_dig,
  'HiSeq250bp:s' => \$HiSeq250bp, 
  'MiSeq250bp:s' => \$MiSeq250bp, 
+ 'exhaustivePairs:s' => \$exhaustivePairs, 
  'fastExtraction:s' => \$fastExtraction, 
  'fromPHLAT:s' => \$fromPHLAT,
  'fromHLAreporter:s' => \$fromHLAreporter,
@@ -587,6 +589,11 @@ if($actions =~ /i/)
 		{
 			$command .= ' --MiSeq250bp ';
 		}
+		
+		if($exhaustivePairs)
+		{
+			$command .= ' --exhaustivePairs ';
+		}
 			
 		$command .= ' > ' . $stdout_file;
 		
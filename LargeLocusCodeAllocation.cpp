@@ -17,7 +17,9 @@
 string separatorForSerialization = "|||";
 
 LargeLocusCodeAllocation::LargeLocusCodeAllocation() {
-
+	kMerIDs_kMerSize = -1;
+	kMerIDs_words = 0;
+	kMerIDs_n = 0;
 }
 
 LargeLocusCodeAllocation::~LargeLocusCodeAllocation() {
@@ -85,6 +87,22 @@ int LargeLocusCodeAllocation::doCode(std::string locus, std::string value)
 		coded_values[locus][value] = new_index;
 		coded_values_rev[locus][new_index] = value;
 
+		if(kMerIDs_kMerSize != -1)
+		{
+			if((value == "_") || (value == "*"))
+			{
+				vector<int>& locus_kMerIDs = kMerIDs_locus[locus];
+				if((int)locus_kMerIDs.size() <= new_index)
+				{
+					locus_kMerIDs.resize(new_index + 1, -1);
+				}
+			}
+			else
+			{
+				kMerIDs_kMerSize = -1;
+			}
+		}
+
 		return new_index;
 	}
 }
@@ -353,6 +371,8 @@ vector<string> LargeLocusCodeAllocation::serializeIntoVector()
 
 void LargeLocusCodeAllocation::readFromVector(vector<string> lines)
 {
+	kMerIDs_kMerSize = -1;
+
 	for(unsigned int i = 0; i < lines.size(); i++)
 	{
 		string line = lines.at(i);
@@ -383,3 +403,207 @@ void LargeLocusCodeAllocation::readFromVector(vector<string> lines)
 	}
 }
 
+bool LargeLocusCodeAllocation::kMerIDs_pack(const string& kMer, uint64_t* ret_words) const
+{
+	if((int)kMer.length() != kMerIDs_kMerSize)
+	{
+		return false;
+	}
+
+	// left-aligned, so that comparing the words compares the k-mers
+	for(int wI = 0; wI < kMerIDs_words; wI++)
+	{
+		ret_words[wI] = 0;
+	}
+	for(int i = 0; i < (int)kMer.length(); i++)
+	{
+		uint64_t b;
+		switch(kMer[i])
+		{
+		case 'A':
+			b = 0;
+			break;
+		case 'C':
+			b = 1;
+			break;
+		case 'G':
+			b = 2;
+			break;
+		case 'T':
+			b = 3;
+			break;
+		default:
+			return false;
+		}
+		ret_words[i / 32] |= (b << (62 - 2 * (i % 32)));
+	}
+	return true;
+}
+
+static bool kMerIDs_stringPointerLess(const string* a, const string* b)
+{
+	return (*a < *b);
+}
+
+static bool kMerIDs_stringPointerEqual(const string* a, const string* b)
+{
+	return (*a == *b);
+}
+
+void LargeLocusCodeAllocation::buildkMerIDs(int kMerSize)
+{
+	assert(kMerSize > 0);
+	kMerIDs_kMerSize = kMerSize;
+	kMerIDs_words = (kMerSize + 31) / 32;
+
+	vector<const string*> kMers;
+	for(map<string, map<string, int> >::iterator locusIt = coded_values.begin(); locusIt != coded_values.end(); locusIt++)
+	{
+		for(map<string, int>::iterator codeIt = locusIt->second.begin(); codeIt != locusIt->second.end(); codeIt++)
+		{
+			if((codeIt->first != "_") && (codeIt->first != "*"))
+			{
+				kMers.push_back(&(codeIt->first));
+			}
+		}
+	}
+	sort(kMers.begin(), kMers.end(), kMerIDs_stringPointerLess);
+	kMers.erase(unique(kMers.begin(), kMers.end(), kMerIDs_stringPointerEqual), kMers.end());
+	kMerIDs_n = kMers.size();
+
+	kMerIDs_packed.clear();
+	kMerIDs_packed_ID.clear();
+	kMerIDs_irregular.clear();
+	kMerIDs_irregular_ID.clear();
+	kMerIDs_ID2index.resize(kMerIDs_n);
+
+	vector<uint64_t> words(kMerIDs_words);
+	for(int ID = 0; ID < kMerIDs_n; ID++)
+	{
+		const string& kMer = *(kMers.at(ID));
+		if(kMerIDs_pack(kMer, words.data()))
+		{
+			kMerIDs_ID2index.at(ID) = kMerIDs_packed_ID.size();
+			kMerIDs_packed.insert(kMerIDs_packed.end(), words.begin(), words.end());
+			kMerIDs_packed_ID.push_back(ID);
+		}
+		else
+		{
+			kMerIDs_ID2index.at(ID) = -1 - (int)kMerIDs_irregular.size();
+			kMerIDs_irregular.push_back(kMer);
+			kMerIDs_irregular_ID.push_back(ID);
+		}
+	}
+
+	kMerIDs_locus.clear();
+	for(map<string, map<string, int> >::iterator locusIt = coded_values.begin(); locusIt != coded_values.end(); locusIt++)
+	{
+		vector<int>& locus_kMerIDs = kMerIDs_locus[locusIt->first];
+		for(map<string, int>::iterator codeIt = locusIt->second.begin(); codeIt != locusIt->second.end(); codeIt++)
+		{
+			int code = codeIt->second;
+			assert(code >= 0);
+			if((int)locus_kMerIDs.size() <= code)
+			{
+				locus_kMerIDs.resize(code + 1, -1);
+			}
+			if((codeIt->first != "_") && (codeIt->first != "*"))
+			{
+				vector<const string*>::iterator kMerIt = lower_bound(kMers.begin(), kMers.end(), &(codeIt->first), kMerIDs_stringPointerLess);
+				assert((kMerIt != kMers.end()) && (**kMerIt == codeIt->first));
+				locus_kMerIDs.at(code) = kMerIt - kMers.begin();
+			}
+		}
+	}
+}
+
+bool LargeLocusCodeAllocation::havekMerIDs(int kMerSize) const
+{
+	return (kMerIDs_kMerSize != -1) && (kMerIDs_kMerSize == kMerSize);
+}
+
+int LargeLocusCodeAllocation::kMerIDs() const
+{
+	assert(kMerIDs_kMerSize != -1);
+	return kMerIDs_n;
+}
+
+const vector<int>& LargeLocusCodeAllocation::kMerIDsForLocus(string locus) const
+{
+	assert(kMerIDs_kMerSize != -1);
+	map<string, vector<int> >::const_iterator locusIt = kMerIDs_locus.find(locus);
+	assert(locusIt != kMerIDs_locus.end());
+	return locusIt->second;
+}
+
+int LargeLocusCodeAllocation::kMerID(string locus, int code) const
+{
+	const vector<int>& locus_kMerIDs = kMerIDsForLocus(locus);
+	if((code < 0) || (code >= (int)locus_kMerIDs.size()))
+	{
+		return -1;
+	}
+	return locus_kMerIDs.at(code);
+}
+
+int LargeLocusCodeAllocation::kMerID(const string& kMer) const
+{
+	assert(kMerIDs_kMerSize != -1);
+
+	vector<uint64_t> words(kMerIDs_words);
+	if(kMerIDs_pack(kMer, words.data()))
+	{
+		// binary search over the packed k-mers
+		size_t first = 0;
+		size_t last = kMerIDs_packed_ID.size();
+		while(first < last)
+		{
+			size_t middle = first + (last - first) / 2;
+			const uint64_t* middle_words = kMerIDs_packed.data() + middle * kMerIDs_words;
+			if(lexicographical_compare(middle_words, middle_words + kMerIDs_words, words.begin(), words.end()))
+			{
+				first = middle + 1;
+			}
+			else
+			{
+				last = middle;
+			}
+		}
+		if((first < kMerIDs_packed_ID.size()) && equal(words.begin(), words.end(), kMerIDs_packed.begin() + first * kMerIDs_words))
+		{
+			return kMerIDs_packed_ID.at(first);
+		}
+		return -1;
+	}
+	else
+	{
+		vector<string>::const_iterator kMerIt = lower_bound(kMerIDs_irregular.begin(), kMerIDs_irregular.end(), kMer);
+		if((kMerIt != kMerIDs_irregular.end()) && (*kMerIt == kMer))
+		{
+			return kMerIDs_irregular_ID.at(kMerIt - kMerIDs_irregular.begin());
+		}
+		return -1;
+	}
+}
+
+string LargeLocusCodeAllocation::kMerForID(int ID) const
+{
+	assert(kMerIDs_kMerSize != -1);
+	assert((ID >= 0) && (ID < kMerIDs_n));
+
+	int index = kMerIDs_ID2index.at(ID);
+	if(index < 0)
+	{
+		return kMerIDs_irregular.at(-1 - index);
+	}
+
+	static const char bases[4] = {'A', 'C', 'G', 'T'};
+	const uint64_t* words = kMerIDs_packed.data() + (size_t)index * kMerIDs_words;
+	string forReturn;
+	forReturn.resize(kMerIDs_kMerSize);
+	for(int i = 0; i < kMerIDs_kMerSize; i++)
+	{
+		forReturn[i] = bases[(words[i / 32] >> (62 - 2 * (i % 32))) & 3];
+	}
+	return forReturn;
+}
@@ -12,6 +12,7 @@
 #include <map>
 #include <vector>
 #include <set>
+#include <stdint.h>
 
 using namespace std;
 
@@ -28,6 +29,19 @@ protected:
 	map<string, map<string, int> > coded_values;
 	map<string, map<int, string> > coded_values_rev;
 	map<string, set<int> > restrictedHLAcache;
+
+	// k-mer dictionary, see buildkMerIDs(..)
+	int kMerIDs_kMerSize;
+	int kMerIDs_words;
+	int kMerIDs_n;
+	vector<uint64_t> kMerIDs_packed;
+	vector<int> kMerIDs_packed_ID;
+	vector<string> kMerIDs_irregular;
+	vector<int> kMerIDs_irregular_ID;
+	vector<int> kMerIDs_ID2index;
+	map<string, vector<int> > kMerIDs_locus;
+
+	bool kMerIDs_pack(const string& kMer, uint64_t* ret_words) const;
 	
 public:
 	LargeLocusCodeAllocation();
@@ -50,6 +64,19 @@ public:
 	bool allele4D(string locus, int allele);
 	bool locusIsHLA(string locus);
 
+	// Dictionary of all coded k-mers (values other than "_" and "*"): dense IDs 0 .. kMerIDs()-1 in
+	// lexicographic order of the k-mers, shared by all loci. k-mers of length kMerSize over ACGT are
+	// stored 2-bit packed, others as strings. Coding a new k-mer invalidates the dictionary.
+	void buildkMerIDs(int kMerSize);
+	bool havekMerIDs(int kMerSize) const;
+	int kMerIDs() const;
+	// by emission code, -1 for symbols that are not k-mers
+	const vector<int>& kMerIDsForLocus(string locus) const;
+	int kMerID(string locus, int code) const;
+	// -1 for k-mers that are not in the dictionary
+	int kMerID(const string& kMer) const;
+	string kMerForID(int ID) const;
+
 	vector<string> serializeIntoVector();
 	void readFromVector(vector<string> lines);
 };
@@ -36,15 +36,20 @@
 #include "GraphAligner/GraphAligner.h"
 #include "GraphAligner/AlignerTests.h"
 #include "GraphAlignerUnique/UniqueAlignerTests.h"
+#include "GraphAlignerUnique/PersistentkMerIndex.h"
 
 #include "readFilter/readFilter.h"
 #include "readFilter/filterLongOverlappingReads.h"
+#include "hash/deBruijn/DeBruijnGraph.h"
+#include "hash/sequence/compactkMerSet.h"
+#include "hash/sequence/packedkMerSet.h"
+#include "hash/sequence/kMerCountsFile.h"
 
 #include "Utilities.h"
 
 using namespace std;
 
-void testing();
+void testing(string temp_dir);
 Config CONFIG;
 double epsilon = 1.0e-7;
 
@@ -82,6 +87,33 @@ int main(int argc, char *argv[])
 		g->makeEdgesGaps(0.1);
 		g->writeToFile(graph_file+".gaps");
 	}
+	else if((arguments.size() > 0) && (arguments.at(1) == "convertGraphToBinary"))
+	{
+		// usage: domode convertGraphToBinary graph.txt [graph.bin]
+		string graph_file = arguments.at(2);
+		string binary_file = (arguments.size() > 3) ? arguments.at(3) : Graph::binaryFilename(graph_file);
+
+		Graph* g = new Graph();
+		g->readFromTextFile(graph_file);
+		g->writeToBinaryFile(binary_file);
+
+		// the binary file has to reproduce the text file's edge order, otherwise persisted k-mer
+		// indices built from one representation would be rejected for the other
+		Graph* g_binary = new Graph();
+		g_binary->readFromBinaryFile(binary_file);
+		if(!(GraphAlignerUnique::kMerIndexGraphFingerprint(g) == GraphAlignerUnique::kMerIndexGraphFingerprint(g_binary)))
+		{
+			errEx("Graph read from "+binary_file+" differs from graph read from "+graph_file);
+		}
+
+		cout << "Wrote " << binary_file << " (" << g->Nodes.size() << " nodes, " << g->Edges.size() << " edges).\n" << flush;
+	}
+	else if((arguments.size() > 0) && (arguments.at(1) == "testFileFormats"))
+	{
+		// usage: domode testFileFormats temp_dir
+		string temp_dir = arguments.at(2);
+		testing(temp_dir);
+	}
 	else if((arguments.size() > 0) && (arguments.at(1) == "determineRequiredKMers"))
 	{
 		omp_set_num_threads(CONFIG.threads);
@@ -406,6 +438,7 @@ int main(int argc, char *argv[])
 		
 		bool debug = false;
 		bool MiSeq250bp = false;
+		bool binaryAlignments = false;
 		
 		for(unsigned int i = 0; i < arguments.size(); i++)
 		{
@@ -434,6 +467,11 @@ int main(int argc, char *argv[])
 				MiSeq250bp = true;
 			}
 
+			if(arguments.at(i) == "--binaryAlignments")
+			{
+				binaryAlignments = true;
+			}
+
 			if(arguments.at(i) == "--IS_mean")
 			{
 				IS_mean = arguments.at(i+1);
@@ -477,7 +515,7 @@ int main(int argc, char *argv[])
 			estimateInsertSizeFromGraph(input_FASTQ, graph_dir, inserSize_mean_sd_perFile, true);
 		}
 		
-		alignShortReadsToHLAGraph_multipleAlignments(input_FASTQ, graph_dir, referenceGenome, inserSize_mean_sd_perFile, debug, MiSeq250bp);
+		alignShortReadsToHLAGraph_multipleAlignments(input_FASTQ, graph_dir, referenceGenome, inserSize_mean_sd_perFile, debug, MiSeq250bp, binaryAlignments);
 	}
 	else if((arguments.size() > 0) && (arguments.at(1) == "alignLongUnpairedReadsToHLAGraph"))
 	{
@@ -610,6 +648,7 @@ int main(int argc, char *argv[])
 
 		bool longUnpairedReads = false;
 		bool MiSeq250bp = false;
+		bool exhaustivePairs = false;
 		
 		for(unsigned int i = 0; i < arguments.size(); i++)
 		{
@@ -638,6 +677,11 @@ int main(int argc, char *argv[])
 			{
 				MiSeq250bp = true;
 			}
+
+			if(arguments.at(i) == "--exhaustivePairs")
+			{
+				exhaustivePairs = true;
+			}
 		}
 
 		assert(input_alignedReads.length());
@@ -661,7 +705,7 @@ int main(int argc, char *argv[])
 		
 		// todo activate
 		   
-		HLATypeInference(input_alignedReads, graph_dir, sampleID, false, loci_string, starting_haplotypes_perLocus_1_str, starting_haplotypes_perLocus_2_str, longUnpairedReads, MiSeq250bp);
+		HLATypeInference(input_alignedReads, graph_dir, sampleID, false, loci_string, starting_haplotypes_perLocus_1_str, starting_haplotypes_perLocus_2_str, longUnpairedReads, MiSeq250bp, exhaustivePairs);
 		
 		// HLAHaplotypeInference(input_alignedReads, graph_dir, sampleID, loci_string, starting_haplotypes_perLocus_1_str, starting_haplotypes_perLocus_2_str, longUnpairedReads);
 	}
@@ -778,6 +822,8 @@ int main(int argc, char *argv[])
 		assert(test3_split.size() == 7);
 
 		int genotypingMode = 5;
+		bool forwardCheckpoints = false;
+		string forwardEmissionsFile;
 		for(unsigned int i = 5; i < arguments.size(); i++)
 		{
 			if(arguments.at(i) == "--labelonly")
@@ -789,6 +835,16 @@ int main(int argc, char *argv[])
 			{
 				genotypingMode = Utilities::StrtoI(arguments.at(i+1));
 			}
+
+			if(arguments.at(i) == "--forwardCheckpoints")
+			{
+				forwardCheckpoints = true;
+			}
+
+			if(arguments.at(i) == "--forwardEmissions")
+			{
+				forwardEmissionsFile = arguments.at(i+1);
+			}
 		}
 
 		LargeGraph* kMerG = new LargeGraph();
@@ -811,13 +867,15 @@ int main(int argc, char *argv[])
 		MultiGraph* multiG = multiBeautifyForAlpha2(kMerG, "");
 		set<int> emptySet;
 
-		map<string, long long> estimatedEmissions = AlphaHMM::estimateEmissions(sampleCount, wholeGenomeButGraphCount, multiG->kMerSize);
+		map<string, long long> estimatedEmissions = AlphaHMM::estimateEmissions(sampleCount, wholeGenomeButGraphCount, multiG->kMerSize, multiG);
 
 		MultiGraph* multiGsimple = simplifyAccordingToCoverage(multiG, estimatedEmissions, emptySet);
 
 		// multiG->stats();
 
 		AlphaHMM* aHMM = new AlphaHMM(multiGsimple, genotypingMode);
+		aHMM->setForwardCheckpoints(forwardCheckpoints);
+		aHMM->setForwardEmissionsFile(forwardEmissionsFile);
 		aHMM->fillForwardBackwardTable(estimatedEmissions);
 		// aHMM->debug(estimatedEmissions);
 
@@ -1547,6 +1605,78 @@ int main(int argc, char *argv[])
 		F.doFilter2();
 
 	}	
+	else if((arguments.size() > 0) && (arguments.at(1) == "buildCompactkMerSet"))
+	{
+		// membership-only version of a (k = 25) Cortex graph, e.g. for filterReads --negativeFilter
+		vector<string> arguments (argv + 1, argv + argc + !argc);
+
+		std::string cortexBinary;
+		std::string output;
+		int fingerprintBits = 8;
+
+		for(unsigned int i = 2; i < arguments.size(); i++)
+		{
+			if(arguments.at(i) == "--cortexBinary")
+			{
+				cortexBinary = arguments.at(i+1);
+			}
+			if(arguments.at(i) == "--output")
+			{
+				output = arguments.at(i+1);
+			}
+			if(arguments.at(i) == "--fingerprintBits")
+			{
+				fingerprintBits = Utilities::StrtoI(arguments.at(i+1));
+			}
+		}
+
+		if((cortexBinary.length() == 0) || (output.length() == 0))
+		{
+			errEx("Please specify --cortexBinary and --output.");
+		}
+
+		std::vector<uint64_t> kMerCodes;
+		{
+			DeBruijnGraph<1, 25, 1> binaryReader(1, 1);
+			binaryReader.readMultiColourBinarykMerCodes(cortexBinary, kMerCodes);
+		}
+		std::cout << Utilities::timestamp() << "Read " << kMerCodes.size() << " k-mers from " << cortexBinary << "\n" << std::flush;
+
+		compactkMerSet kMers;
+		kMers.build(25, kMerCodes, fingerprintBits);
+		kMers.save(output);
+
+		std::cout << Utilities::timestamp() << "Saved " << kMers.size() << " k-mers to " << output << ": " << kMers.bytes() << " bytes, " << ((double)kMers.bytes() / (double)std::max(kMers.size(), (size_t)1)) << " bytes per k-mer\n" << std::flush;
+	}
+	else if((arguments.size() > 0) && (arguments.at(1) == "convertkMerCounts"))
+	{
+		// binary version of a text k-mer counts file (sample or genome counts for nextGenInference)
+		vector<string> arguments (argv + 1, argv + argc + !argc);
+
+		std::string input;
+		std::string output;
+
+		for(unsigned int i = 2; i < arguments.size(); i++)
+		{
+			if(arguments.at(i) == "--input")
+			{
+				input = arguments.at(i+1);
+			}
+			if(arguments.at(i) == "--output")
+			{
+				output = arguments.at(i+1);
+			}
+		}
+
+		if((input.length() == 0) || (output.length() == 0))
+		{
+			errEx("Please specify --input and --output.");
+		}
+
+		size_t kMers = kMerCountsFile::convertTextFile(input, output);
+
+		std::cout << Utilities::timestamp() << "Saved " << kMers << " k-mers from " << input << " to " << output << "\n" << std::flush;
+	}
 	else
 	{
 		errEx("Please specify valid mode.");
@@ -1560,7 +1690,344 @@ void errEx(std::string message)
 	exit(1);
 }
 
-void testing()
+static std::string readFileBytes(std::string filename)
+{
+	ifstream input(filename.c_str(), ios::in | ios::binary);
+	assert(input.is_open());
+	std::string contents((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+	return contents;
+}
+
+static void writeFileBytes(std::string filename, const std::string& contents)
+{
+	ofstream output(filename.c_str(), ios::out | ios::trunc | ios::binary);
+	assert(output.is_open());
+	output.write(contents.data(), contents.size());
+	output.close();
+}
+
+static uint64_t randomkMerCode(int k)
+{
+	uint64_t code = ((uint64_t)rand() << 32) ^ ((uint64_t)rand() << 16) ^ (uint64_t)rand();
+	return (code & ((~(uint64_t)0) >> (64 - 2*k)));
+}
+
+// compactkMerSet files: build -> save -> load -> compare, sequences with N, empty sets, truncated and corrupt files
+void testCompactkMerSetFile(string temp_dir)
+{
+	string set_file = temp_dir + "/testCompactkMerSetFile.kmers";
+	string set_file_2 = temp_dir + "/testCompactkMerSetFile_2.kmers";
+	string set_file_broken = temp_dir + "/testCompactkMerSetFile_broken.kmers";
+
+	vector<int> k_per_test = {25, 25, 25, 31, 3};
+	vector<size_t> kMers_per_test = {0, 1, 300000, 1000, 100};
+	vector<int> fingerprintBits_per_test = {8, 16, 8, 16, 8};
+	vector<bool> sequencekMers_per_test = {false, false, true, true, true};
+	for(unsigned int testI = 0; testI < k_per_test.size(); testI++)
+	{
+		int k = k_per_test.at(testI);
+		int fingerprintBits = fingerprintBits_per_test.at(testI);
+
+		// members: random codes, and for some tests the canonical codes of all valid k-mers of a sequence with Ns
+		packedkMerSet encoder(k);
+		string sequence;
+		for(int i = 0; i < 2000; i++)
+		{
+			sequence.push_back((Utilities::randomNumber(30) == 0) ? 'N' : Utilities::randomNucleotide());
+		}
+		vector<uint64_t> sequence_forward;
+		vector<uint64_t> sequence_reverse;
+		encoder.kMerCodes(sequence, sequence_forward, sequence_reverse);
+		assert(sequence_forward.size() == (sequence.length() - k + 1));
+
+		vector<uint64_t> members;
+		int sequence_validkMers = 0;
+		if(sequencekMers_per_test.at(testI))
+		{
+			for(unsigned int i = 0; i < sequence_forward.size(); i++)
+			{
+				assert((sequence_forward.at(i) == packedkMerSet::invalidCode) == (sequence.substr(i, k).find('N') != string::npos));
+				if(sequence_forward.at(i) != packedkMerSet::invalidCode)
+				{
+					members.push_back(min(sequence_forward.at(i), sequence_reverse.at(i)));
+					sequence_validkMers++;
+				}
+			}
+		}
+		while(members.size() < kMers_per_test.at(testI))
+		{
+			members.push_back(randomkMerCode(k));
+		}
+
+		vector<uint64_t> members_sorted = members;
+		sort(members_sorted.begin(), members_sorted.end());
+
+		vector<uint64_t> members_for_build = members;
+		compactkMerSet set_built;
+		set_built.build(k, members_for_build, fingerprintBits);
+		set_built.save(set_file);
+
+		assert(compactkMerSet::isCompactkMerSetFile(set_file));
+		compactkMerSet set_loaded;
+		set_loaded.load(set_file);
+		assert(set_loaded.getK() == k);
+		assert(set_loaded.size() == set_built.size());
+		assert(set_loaded.bytes() == set_built.bytes());
+
+		for(unsigned int i = 0; i < members.size(); i++)
+		{
+			assert(set_built.contains(members.at(i)));
+			assert(set_loaded.contains(members.at(i)));
+		}
+		assert(! set_loaded.contains(compactkMerSet::invalidCode));
+		if(sequencekMers_per_test.at(testI) || (members.size() == 0))
+		{
+			assert(set_loaded.countContained_canonical(sequence_forward, sequence_reverse) == sequence_validkMers);
+		}
+
+		// same answers for non-members, with a false positive rate of about 2^-fingerprintBits
+		size_t falsePositives = 0;
+		size_t nonMember_tests = 100000;
+		for(size_t i = 0; i < nonMember_tests; i++)
+		{
+			uint64_t code = randomkMerCode(k);
+			bool contained = set_loaded.contains(code);
+			assert(contained == set_built.contains(code));
+			if(contained && (! binary_search(members_sorted.begin(), members_sorted.end(), code)))
+			{
+				falsePositives++;
+			}
+		}
+		assert(falsePositives <= (3 * nonMember_tests / (1 << fingerprintBits) + 10));
+
+		// saving a loaded set gives the same file
+		set_loaded.save(set_file_2);
+		string file_bytes = readFileBytes(set_file);
+		assert(file_bytes == readFileBytes(set_file_2));
+
+		// truncated files and corrupt headers (magic, version, k, fingerprint bits, levels, k-mers) are rejected
+		vector<size_t> truncateAt = {0, 4, 20, 39, file_bytes.size() / 2, file_bytes.size() - 1};
+		for(unsigned int truncateI = 0; truncateI < truncateAt.size(); truncateI++)
+		{
+			writeFileBytes(set_file_broken, file_bytes.substr(0, truncateAt.at(truncateI)));
+			bool rejected = false;
+			try
+			{
+				compactkMerSet set_broken;
+				set_broken.load(set_file_broken);
+			}
+			catch(std::runtime_error& e)
+			{
+				rejected = true;
+			}
+			assert(rejected);
+		}
+		vector<size_t> corruptAt = {0, 8, 12, 16, 20, 24};
+		for(unsigned int corruptI = 0; corruptI < corruptAt.size(); corruptI++)
+		{
+			string corrupt_bytes = file_bytes;
+			corrupt_bytes.at(corruptAt.at(corruptI)) ^= 0x20;
+			writeFileBytes(set_file_broken, corrupt_bytes);
+			bool rejected = false;
+			try
+			{
+				compactkMerSet set_broken;
+				set_broken.load(set_file_broken);
+			}
+			catch(std::runtime_error& e)
+			{
+				rejected = true;
+			}
+			assert(rejected);
+		}
+
+		cout << "testCompactkMerSetFile(): k = " << k << ", " << set_loaded.size() << " k-mers OK.\n" << flush;
+	}
+
+	// invalid codes (k-mers with N) cannot be members
+	vector<uint64_t> invalidMembers = {randomkMerCode(25), compactkMerSet::invalidCode};
+	bool rejected = false;
+	try
+	{
+		compactkMerSet set_invalid;
+		set_invalid.build(25, invalidMembers);
+	}
+	catch(std::runtime_error& e)
+	{
+		rejected = true;
+	}
+	assert(rejected);
+
+	cout << "testCompactkMerSetFile(): all tests passed.\n" << flush;
+}
+
+// kMerCountsFile: text -> binary -> compare with the text file's counts, with N and lower-case k-mers,
+// more than blockSize k-mers, repeated k-mers, empty files, truncated and corrupt files
+void testkMerCountsFile(string temp_dir)
+{
+	string counts_text = temp_dir + "/testkMerCountsFile.txt";
+	string counts_binary = temp_dir + "/testkMerCountsFile.binary";
+	string counts_binary_broken = temp_dir + "/testkMerCountsFile_broken.binary";
+
+	int k = 25;
+	vector<size_t> kMers_per_test = {0, 0, 10, 3 * kMerCountsFile::blockSize + 17};
+	vector<bool> metadata_per_test = {false, true, true, true};
+	for(unsigned int testI = 0; testI < kMers_per_test.size(); testI++)
+	{
+		// expected counts as read from the text file - for repeated k-mers, the last line counts
+		map<string, long long> expected_metadata;
+		map<string, long long> expected_kMers;
+		ofstream textOutput(counts_text.c_str(), ios::out | ios::trunc);
+		assert(textOutput.is_open());
+		if(metadata_per_test.at(testI))
+		{
+			expected_metadata["MeanReadLen"] = 100;
+			expected_metadata["TotalKMerCoverage"] = 123456789012LL;
+			expected_metadata["TotalSeq"] = 987654321;
+			for(map<string, long long>::iterator metadataIt = expected_metadata.begin(); metadataIt != expected_metadata.end(); metadataIt++)
+			{
+				textOutput << metadataIt->first << " " << metadataIt->second << "\n";
+			}
+		}
+		for(size_t kMerI = 0; kMerI < kMers_per_test.at(testI); kMerI++)
+		{
+			string kMer;
+			for(int i = 0; i < k; i++)
+			{
+				kMer.push_back(Utilities::randomNucleotide());
+			}
+			if((kMerI % 50) == 1)
+			{
+				kMer.at(Utilities::randomNumber(k - 1)) = 'N';
+			}
+			if((kMerI % 50) == 2)
+			{
+				kMer.at(Utilities::randomNumber(k - 1)) = 'a';
+			}
+			long long count = Utilities::randomNumber(1000);
+			if((kMerI % 100) == 3)
+			{
+				count = (1LL << 40) + kMerI;
+			}
+			if((kMerI % 100) == 4)
+			{
+				count = -1;
+			}
+			textOutput << kMer << " " << count << ((kMerI % 10) == 5 ? "\r\n" : "\n");
+			expected_kMers[kMer] = count;
+
+			if((kMerI % 20) == 6)
+			{
+				textOutput << "\n" << kMer << " " << (count + 1) << "\n";
+				expected_kMers[kMer] = count + 1;
+			}
+		}
+		textOutput.close();
+
+		size_t converted = kMerCountsFile::convertTextFile(counts_text, counts_binary);
+		assert(converted == expected_kMers.size());
+		assert(kMerCountsFile::isKMerCountsFile(counts_binary));
+		assert(! kMerCountsFile::isKMerCountsFile(counts_text));
+
+		kMerCountsFile countsFile;
+		countsFile.load(counts_binary);
+		assert(countsFile.size() == expected_kMers.size());
+		if(expected_kMers.size())
+		{
+			assert(countsFile.getK() == k);
+		}
+		assert(countsFile.getMetadata() == expected_metadata);
+
+		map<string, long long> read_kMers;
+		countsFile.readAll(read_kMers);
+		assert(read_kMers == expected_kMers);
+
+		// lookups of present and absent k-mers, including absent ones with N
+		vector<string> lookup_kMers;
+		vector<long long> lookup_expected;
+		for(map<string, long long>::iterator kMerIt = expected_kMers.begin(); kMerIt != expected_kMers.end(); kMerIt++)
+		{
+			lookup_kMers.push_back(kMerIt->first);
+			lookup_expected.push_back(kMerIt->second);
+		}
+		for(unsigned int i = 0; i < 200; i++)
+		{
+			string kMer;
+			for(int j = 0; j < k; j++)
+			{
+				kMer.push_back(((i % 4) == 0) ? 'N' : Utilities::randomNucleotide());
+			}
+			if(expected_kMers.count(kMer) == 0)
+			{
+				lookup_kMers.push_back(kMer);
+				lookup_expected.push_back(-2);
+			}
+		}
+		vector<long long> lookup_counts;
+		countsFile.lookup(lookup_kMers, lookup_counts, -2);
+		assert(lookup_counts == lookup_expected);
+
+		// truncated files and corrupt headers are rejected, when loading or at the latest when decoding
+		string file_bytes = readFileBytes(counts_binary);
+		vector<size_t> truncateAt = {0, 4, 30, 55, file_bytes.size() / 2, file_bytes.size() - 1};
+		for(unsigned int truncateI = 0; truncateI < truncateAt.size(); truncateI++)
+		{
+			writeFileBytes(counts_binary_broken, file_bytes.substr(0, truncateAt.at(truncateI)));
+			bool rejected = false;
+			try
+			{
+				kMerCountsFile countsFile_broken;
+				countsFile_broken.load(counts_binary_broken);
+				countsFile_broken.readAll(read_kMers);
+			}
+			catch(std::runtime_error& e)
+			{
+				rejected = true;
+			}
+			assert(rejected);
+		}
+		vector<size_t> corruptAt = {0, 8, 12, 16, 24, 32, 40, 48};
+		for(unsigned int corruptI = 0; corruptI < corruptAt.size(); corruptI++)
+		{
+			string corrupt_bytes = file_bytes;
+			corrupt_bytes.at(corruptAt.at(corruptI)) ^= 0x20;
+			writeFileBytes(counts_binary_broken, corrupt_bytes);
+			bool rejected = false;
+			try
+			{
+				kMerCountsFile countsFile_broken;
+				countsFile_broken.load(counts_binary_broken);
+				countsFile_broken.readAll(read_kMers);
+			}
+			catch(std::runtime_error& e)
+			{
+				rejected = true;
+			}
+			assert(rejected);
+		}
+
+		cout << "testkMerCountsFile(): " << expected_kMers.size() << " k-mers, " << expected_metadata.size() << " metadata entries OK.\n" << flush;
+	}
+
+	// k-mers of different lengths are rejected
+	ofstream textOutput(counts_text.c_str(), ios::out | ios::trunc);
+	textOutput << "ACGTA 1\nACGT 2\n";
+	textOutput.close();
+	bool rejected = false;
+	try
+	{
+		kMerCountsFile::convertTextFile(counts_text, counts_binary_broken);
+	}
+	catch(std::runtime_error& e)
+	{
+		rejected = true;
+	}
+	assert(rejected);
+
+	cout << "testkMerCountsFile(): all tests passed.\n" << flush;
+}
+
+void testing(string temp_dir)
 {
 	LocusCodeAllocation CODE;
 	unsigned char codedHLA = CODE.doCode("HLA", "0101");
@@ -1568,4 +2035,9 @@ void testing()
 	// std::cout << "Coded HLA: " << codedHLA << " -- original allele: " << originalAllele << "\n";
 	assert(originalAllele == "0101");
 
+	GraphAlignerUnique::tests::testGraphBinaryFile(temp_dir);
+	GraphAlignerUnique::tests::testShortReadAlignmentsFile(temp_dir);
+	testCompactkMerSetFile(temp_dir);
+	testkMerCountsFile(temp_dir);
+
 }
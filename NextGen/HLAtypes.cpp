@@ -21,11 +21,13 @@
 #include <set>
 #include <limits>
 #include <unordered_map>
+#include <memory>
 
 #include "HLAtypes.h"
 
 
 #include "readSimulator.h"
+#include "clusterPairLikelihoods.h"
 #include "../Utilities.h"
 #include <boost/math/distributions/poisson.hpp>
 
@@ -65,6 +67,9 @@ double minimumPerPositionMappingQuality = 0.7;
 
 bool combineReadAndBaseLikelihoods = false;
 
+// number of best cluster pairs HLATypeInference(..) evaluates exactly if not in exhaustivePairs mode
+size_t HLATypeInference_topPairs = 10;
+
 
 using namespace boost::math::policies;
 using namespace boost::math;
@@ -712,6 +717,199 @@ double read_likelihood_per_position(const std::string& exonGenotypeR, const std:
 	return log_likelihood;
 }
 
+// One usable read position (mapQ_position and allele filters applied), encoded for HLATypeInference_readLikelihoods(..)
+class encodedExonObservation {
+public:
+	unsigned int positionInExon;
+	unsigned int l_diff; // read genotype length - 1
+	unsigned char firstCharacter;
+	unsigned char quality;
+	bool isGap; // genotype == "_"
+	bool gapInGenotype;
+	bool gapAfterFirst;
+	bool graphLevelKnown;
+};
+
+// Log-likelihoods (and mismatch counts) of all reads conditional on each cluster sequence, the same
+// quantities as read_likelihood_per_position(..) sums with HLATypeInference's scoring. Read positions
+// are encoded once, quality-dependent terms come from a per-quality table, and blocks of clusters x
+// reads are scored in parallel. Ignored reads get log(10) and 0 mismatches.
+void HLATypeInference_readLikelihoods(const std::vector<std::vector<oneExonPosition> >& exonPositions_fromReads, const std::set<size_t>& ignoreReads, const std::map<unsigned int, std::set<std::string>>& perPosition_ignore_alleles, const std::vector<std::string>& cluster_2_sequence, std::vector<std::vector<double> >& ret_likelihoods_perCluster_perRead, std::vector<std::vector<int> >& ret_mismatches_perCluster_perRead, std::vector<std::vector<double> >& ret_likelihoods_perCluster_perObservedBase, size_t& ret_bases_used)
+{
+	size_t nReads = exonPositions_fromReads.size();
+	size_t nClusters = cluster_2_sequence.size();
+
+	std::vector<encodedExonObservation> observations;
+	std::vector<size_t> read_firstObservation(nReads + 1, 0);
+	std::vector<bool> qualityUsed(256, false);
+	std::vector<bool> read_ignored(nReads, false);
+	for(size_t readI = 0; readI < nReads; readI++)
+	{
+		read_firstObservation.at(readI) = observations.size();
+		if(ignoreReads.count(readI))
+		{
+			read_ignored.at(readI) = true;
+			continue;
+		}
+
+		const std::vector<oneExonPosition>& individualPositions = exonPositions_fromReads.at(readI);
+		if(individualPositions.size() > 0)
+		{
+			assert(! combineReadAndBaseLikelihoods); // this would not make sense, or at least one would have to think more about it
+		}
+		for(unsigned int positionI = 0; positionI < individualPositions.size(); positionI++)
+		{
+			const oneExonPosition& onePositionSpecifier = individualPositions.at(positionI);
+
+			assert((onePositionSpecifier.mapQ_position >= 0) && (onePositionSpecifier.mapQ_position <= 1));
+			if(onePositionSpecifier.mapQ_position < minimumPerPositionMappingQuality)
+			{
+				continue;
+			}
+			if(perPosition_ignore_alleles.count(onePositionSpecifier.positionInExon) && (perPosition_ignore_alleles.at(onePositionSpecifier.positionInExon).count(onePositionSpecifier.genotype)))
+			{
+				continue;
+			}
+
+			const std::string& readGenotype = onePositionSpecifier.genotype;
+			assert(readGenotype.length() >= 1);
+
+			encodedExonObservation o;
+			o.positionInExon = onePositionSpecifier.positionInExon;
+			o.l_diff = readGenotype.length() - 1;
+			o.firstCharacter = readGenotype.at(0);
+			o.isGap = (readGenotype == "_");
+			o.gapInGenotype = (readGenotype.find("_") != std::string::npos);
+			o.gapAfterFirst = ((readGenotype.length() > 1) && (readGenotype.find("_", 1) != std::string::npos));
+			o.graphLevelKnown = (onePositionSpecifier.graphLevel != -1);
+			o.quality = 0;
+			if(o.firstCharacter != '_')
+			{
+				assert(onePositionSpecifier.qualities.length());
+				o.quality = onePositionSpecifier.qualities.at(0);
+				qualityUsed.at(o.quality) = true;
+			}
+			observations.push_back(o);
+		}
+	}
+	read_firstObservation.at(nReads) = observations.size();
+
+	ret_bases_used = (nClusters > 0) ? observations.size() : 0;
+
+	// log-likelihoods of a matching / mismatching base, per quality character
+	std::vector<double> quality_LL_match(256, 0);
+	std::vector<double> quality_LL_mismatch(256, 0);
+	for(unsigned int q = 0; q < 256; q++)
+	{
+		if(! qualityUsed.at(q))
+			continue;
+
+		double pCorrect = Utilities::PhredToPCorrect(q);
+		if(veryConservativeReadLikelihoods)
+		{
+			if(pCorrect > 0.999)
+				pCorrect = 0.999;
+		}
+		assert((pCorrect >= 0) && (pCorrect <= 1));
+		if(pCorrect == 0)
+		{
+			pCorrect = 0.001;
+		}
+
+		double pIncorrect = (1 - pCorrect)*(1.0/3.0);
+		assert(pIncorrect <= 0.75);
+		assert((pIncorrect > 0) && (pIncorrect < 1));
+
+		quality_LL_match.at(q) = log_likelihood_match_mismatch + log(pCorrect);
+		quality_LL_mismatch.at(q) = log_likelihood_match_mismatch + log(pIncorrect);
+	}
+
+	ret_likelihoods_perCluster_perRead.assign(nClusters, std::vector<double>(nReads, log(10)));
+	ret_mismatches_perCluster_perRead.assign(nClusters, std::vector<int>(nReads, 0));
+	ret_likelihoods_perCluster_perObservedBase.assign(nClusters, std::vector<double>(observations.size(), 0));
+
+	// a block of reads is scored against a block of clusters, so that the observations stay in cache
+	const size_t clustersPerBlock = 16;
+	const size_t readsPerBlock = 1024;
+	size_t clusterBlocks = (nClusters + clustersPerBlock - 1) / clustersPerBlock;
+	size_t readBlocks = (nReads + readsPerBlock - 1) / readsPerBlock;
+	long long blocks = clusterBlocks * readBlocks;
+
+	#pragma omp parallel for schedule(dynamic)
+	for(long long blockI = 0; blockI < blocks; blockI++)
+	{
+		size_t firstCluster = (blockI / readBlocks) * clustersPerBlock;
+		size_t stopCluster = std::min(firstCluster + clustersPerBlock, nClusters);
+		size_t firstRead = (blockI % readBlocks) * readsPerBlock;
+		size_t stopRead = std::min(firstRead + readsPerBlock, nReads);
+
+		for(size_t clusterI = firstCluster; clusterI < stopCluster; clusterI++)
+		{
+			const std::string& clusterSequence = cluster_2_sequence.at(clusterI);
+			std::vector<double>& likelihoods_perObservedBase = ret_likelihoods_perCluster_perObservedBase.at(clusterI);
+
+			for(size_t readI = firstRead; readI < stopRead; readI++)
+			{
+				if(read_ignored[readI])
+				{
+					continue;
+				}
+
+				double log_likelihood_read = 0;
+				int mismatches = 0;
+				for(size_t observationI = read_firstObservation[readI]; observationI < read_firstObservation[readI + 1]; observationI++)
+				{
+					const encodedExonObservation& o = observations[observationI];
+					unsigned char exonCharacter = clusterSequence.at(o.positionInExon);
+
+					double log_likelihood_position = 0;
+					if(exonCharacter == '_')
+					{
+						if(o.isGap)
+						{
+							// likelihood 1 - intrinsic graph gap
+							assert(o.graphLevelKnown);
+						}
+						else
+						{
+							assert(! o.gapInGenotype);
+							log_likelihood_position += (log_likelihood_insertion_actualAllele * (1 + o.l_diff));
+						}
+					}
+					else
+					{
+						assert(! o.gapAfterFirst);
+						if(o.firstCharacter == '_')
+						{
+							log_likelihood_position += log_likelihood_deletion;
+						}
+						else
+						{
+							log_likelihood_position += ((exonCharacter == o.firstCharacter) ? quality_LL_match[o.quality] : quality_LL_mismatch[o.quality]);
+						}
+						// if read allele is longer
+						log_likelihood_position += (log_likelihood_insertion_actualAllele * o.l_diff);
+					}
+
+					if((! o.isGap) && (! ((o.l_diff == 0) && (exonCharacter == o.firstCharacter))))
+					{
+						mismatches++;
+					}
+
+					log_likelihood_read += log_likelihood_position;
+					likelihoods_perObservedBase[observationI] = log_likelihood_position;
+				}
+
+				assert(exp(log_likelihood_read) >= 0);
+				assert(exp(log_likelihood_read) <= 1);
+
+				ret_likelihoods_perCluster_perRead[clusterI][readI] = log_likelihood_read;
+				ret_mismatches_perCluster_perRead[clusterI][readI] = mismatches;
+			}
+		}
+	}
+}
+
 void simulateHLAreads_perturbHaplotype(std::vector<std::string>& haplotype, std::vector<int>& perturbedPositions)
 {
 	// std::cout << "simulateHLAreads_perturbHaplotype:\n";
@@ -2169,6 +2367,36 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 		pileUpStream.open(fileName_pileUp.c_str());
 		assert(pileUpStream.is_open());
 
+		// likelihoods of one pileup position, shared by all alternatives: per distinct underlying allele
+		// (per read), and per distinct pair of underlying alleles (summed over reads)
+		class haplotypePositionLikelihoods {
+		public:
+			std::vector<unsigned int> pileUp_readIndex;
+			std::vector<unsigned int> modifiedReads_byID; // in order of read ID
+			std::map<std::string, std::vector<double> > readLL_perAllele;
+			std::map<std::pair<std::string, std::string>, double> LL2_perAllelePair;
+		};
+
+		// per-read likelihoods of one alternative, in chunks of reads (indexed in order of first
+		// appearance) that are shared copy-on-write between alternatives with a common history
+		class haplotypeReadLikelihoodsChunk {
+		public:
+			enum {readsPerChunk = 64};
+			double ll_h1[readsPerChunk];
+			double ll_h2[readsPerChunk];
+			double averaged_ll[readsPerChunk];
+
+			haplotypeReadLikelihoodsChunk()
+			{
+				for(unsigned int i = 0; i < readsPerChunk; i++)
+				{
+					ll_h1[i] = 0;
+					ll_h2[i] = 0;
+					averaged_ll[i] = 0;
+				}
+			}
+		};
+
 		class haplotypeAlternative {
 		protected:
 
@@ -2180,8 +2408,7 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 			double Pexternal;
 			bool setPexternal;
 			
-			std::map<std::string, std::pair<double, double> > ll_per_read;
-			std::map<std::string, double> averaged_ll_per_read;
+			std::vector<std::shared_ptr<haplotypeReadLikelihoodsChunk> > ll_per_read;
 
 			int ll_computed_until_position;
 
@@ -2270,7 +2497,28 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 				return ll_computed_until_position;
 			}
 
-			void updateLikelihood(const std::set<std::string>& alleles_from_h1, const std::set<std::string>& alleles_from_h2, const std::vector<oneExonPosition>& pileUpPerPosition)
+			// make the chunks of the reads at a position exclusive to this alternative (not thread-safe)
+			void makeReadLikelihoodsWritable(const std::vector<unsigned int>& readIndices)
+			{
+				for(unsigned int i = 0; i < readIndices.size(); i++)
+				{
+					unsigned int chunkI = readIndices.at(i) / haplotypeReadLikelihoodsChunk::readsPerChunk;
+					if(chunkI >= ll_per_read.size())
+					{
+						ll_per_read.resize(chunkI + 1);
+					}
+					if(! ll_per_read.at(chunkI))
+					{
+						ll_per_read.at(chunkI) = std::make_shared<haplotypeReadLikelihoodsChunk>();
+					}
+					else if(ll_per_read.at(chunkI).use_count() > 1)
+					{
+						ll_per_read.at(chunkI) = std::make_shared<haplotypeReadLikelihoodsChunk>(*(ll_per_read.at(chunkI)));
+					}
+				}
+			}
+
+			void updateLikelihood(const std::set<std::string>& alleles_from_h1, const std::set<std::string>& alleles_from_h2, const haplotypePositionLikelihoods& positionLikelihoods)
 			{
 				const std::string& h1_underlying_position = h1.back();
 				const std::string& h2_underlying_position = h2.back();
@@ -2331,67 +2579,28 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 						std::cout << "\t\tBefore update LL1: " << LL1 << "\n" << std::flush;
 					}
 					
-					std::set<std::string> read_IDs_modified;
-					for(unsigned int rI = 0; rI < pileUpPerPosition.size(); rI++)
+					const std::vector<double>& readLL_h1 = positionLikelihoods.readLL_perAllele.at(h1_underlying_position);
+					const std::vector<double>& readLL_h2 = positionLikelihoods.readLL_perAllele.at(h2_underlying_position);
+					const unsigned int readsPerChunk = haplotypeReadLikelihoodsChunk::readsPerChunk;
+					for(unsigned int rI = 0; rI < positionLikelihoods.pileUp_readIndex.size(); rI++)
 					{
-						const oneExonPosition& r = pileUpPerPosition.at(rI);
-						const std::string& readID = r.thisRead_ID;
-
-						double position_likelihood_h1 = read_likelihood_per_position(h1_underlying_position, r.genotype, r.qualities, r.graphLevel);
-						double position_likelihood_h2 = read_likelihood_per_position(h2_underlying_position, r.genotype, r.qualities, r.graphLevel);
-
-						if(ll_per_read.count(readID) == 0)
-						{
-							ll_per_read[readID].first = 0;
-							ll_per_read[readID].second = 0;
-						}
-
-						// double first_before = ll_per_read.at(readID).first;
-						// double second_before = ll_per_read.at(readID).second;
-						
-						// std::cout << "\t\t\tRead " << readID << ": " << r.genotype << "\n";
-
-						ll_per_read.at(readID).first += position_likelihood_h1;
-						ll_per_read.at(readID).second += position_likelihood_h2;
-
-						// std::cout << "\t\t\t\tOn H1 [" << h1_underlying_position << "]: " << first_before << " -> " << ll_per_read.at(readID).first << "\n";
-						// std::cout << "\t\t\t\tOn H2 [" << h2_underlying_position << "]: " << second_before << " -> " << ll_per_read.at(readID).second << "\n";
-						
-						read_IDs_modified.insert(readID);
-						
-						
+						unsigned int readI = positionLikelihoods.pileUp_readIndex.at(rI);
+						haplotypeReadLikelihoodsChunk& chunk = *(ll_per_read.at(readI / readsPerChunk));
+						chunk.ll_h1[readI % readsPerChunk] += readLL_h1.at(rI);
+						chunk.ll_h2[readI % readsPerChunk] += readLL_h2.at(rI);
 					}
 
-					for(std::set<std::string>::iterator readIDit = read_IDs_modified.begin(); readIDit != read_IDs_modified.end(); readIDit++)
+					for(unsigned int mI = 0; mI < positionLikelihoods.modifiedReads_byID.size(); mI++)
 					{
-						if(averaged_ll_per_read.count(*readIDit))
-						{
-							LL1 -= averaged_ll_per_read.at(*readIDit);
-						}
-						else
-						{
-							averaged_ll_per_read[*readIDit] = 0;
-						}
+						unsigned int readI = positionLikelihoods.modifiedReads_byID.at(mI);
+						haplotypeReadLikelihoodsChunk& chunk = *(ll_per_read.at(readI / readsPerChunk));
 
-						// std::cout << *readIDit << "\n";
-						// std::cout << "\t" << ll_per_read.at(*readIDit).first << "\n";
-						// std::cout << "\t" << ll_per_read.at(*readIDit).second << "\n" << std::flush;
-						
-						// double new_average_p = 0.5 * exp(ll_per_read.at(*readIDit).first) + 0.5 * exp(ll_per_read.at(*readIDit).second);
-						
-						// std::cout << "\t" << new_average_p << "\n" << std::flush;
-						
-						// assert(new_average_p >= 0);
-						// assert(new_average_p <= 1);
-
-						double new_average_logP = Utilities::logAvg(ll_per_read.at(*readIDit).first, ll_per_read.at(*readIDit).second);
-						// if(new_average_p == 0)
-						// {
-							// new_average_logP = -1e100;
-						// }
-						// std::cout << new_average_logP << " " << new_average_p << "\n" << std::flush;
+						// 0 for reads not seen before
+						LL1 -= chunk.averaged_ll[readI % readsPerChunk];
+
+						double new_average_logP = Utilities::logAvg(chunk.ll_h1[readI % readsPerChunk], chunk.ll_h2[readI % readsPerChunk]);
 						LL1 += new_average_logP;
-						averaged_ll_per_read.at(*readIDit) = new_average_logP;
+						chunk.averaged_ll[readI % readsPerChunk] = new_average_logP;
 					}
 
 					if(verbose)
@@ -2408,35 +2617,7 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 						std::cout << "\t\tBefore update LL2: " << LL2 << "\n" << std::flush;
 					}	
 					
-					double thisPosition_LL2 = 0;
-					for(unsigned int rI = 0; rI < pileUpPerPosition.size(); rI++)
-					{
-						const oneExonPosition& r = pileUpPerPosition.at(rI);
-						// const std::string& readID = r.thisRead_ID;
-					
-						double position_likelihood_h1 = read_likelihood_per_position(h1_underlying_position, r.genotype, r.qualities, r.graphLevel);
-						double position_likelihood_h2 = read_likelihood_per_position(h2_underlying_position, r.genotype, r.qualities, r.graphLevel);
-						
-						double combined_LL =  Utilities::logAvg(position_likelihood_h1, position_likelihood_h2);
-						double combined_L = exp(combined_LL);
-						if(!((combined_L >= 0) && (combined_L <= 1)))
-						{
-							std::cerr << "h1_underlying_position" << ": " << h1_underlying_position << "\n";
-							std::cerr << "h2_underlying_position" << ": " << h2_underlying_position << "\n";
-							std::cerr << "r.genotype" << ": " << r.genotype << "\n";
-							std::cerr << "r.qualities" << ": " << r.qualities << "\n";
-							std::cerr << "r.graphLevel" << ": " << r.graphLevel << "\n\n";
-						
-							std::cerr << "position_likelihood_h1" << ": " << position_likelihood_h1 << "\n";
-							std::cerr << "position_likelihood_h2" << ": " << position_likelihood_h2 << "\n";
-							std::cerr << "combined_L" << ": " << combined_L << "\n";
-							std::cerr << std::flush;
-						}
-						assert(combined_L >= 0);
-						assert(combined_L <= 1);
-						
-						thisPosition_LL2 += combined_LL;
-					}
+					double thisPosition_LL2 = positionLikelihoods.LL2_perAllelePair.at(std::make_pair(h1_underlying_position, h2_underlying_position));
 					
 					LL2 += thisPosition_LL2;
 					
@@ -2530,6 +2711,8 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 			
 			int completedLevel;
 
+			std::map<std::string, unsigned int> readID_2_index;
+
 			haplotypeAlternatives()
 			{
 				completedLevel = -1;
@@ -2635,16 +2818,101 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 
 			void updateLikelihood(std::set<std::string>& alleles_from_h1, std::set<std::string>& alleles_from_h2, std::vector<oneExonPosition>& pileUpPerPosition)
 			{
-				unsigned int aI = 0;
+				std::vector<haplotypeAlternative*> alternatives;
 				for(std::list<haplotypeAlternative>::iterator alternativeIt = runningAlternatives.begin(); alternativeIt != runningAlternatives.end(); alternativeIt++)
 				{
-					if(completedLevel > 502)
+					alternatives.push_back(&(*alternativeIt));
+				}
+
+				// read likelihoods depend only on the trailing alleles - compute them once per distinct allele (pair)
+				haplotypePositionLikelihoods positionLikelihoods;
+				std::map<std::string, unsigned int> modifiedReads;
+				for(unsigned int rI = 0; rI < pileUpPerPosition.size(); rI++)
+				{
+					const std::string& readID = pileUpPerPosition.at(rI).thisRead_ID;
+					if(readID_2_index.count(readID) == 0)
 					{
-						// std::cout << "Update likelihood for alternative " << aI << "\n" << std::flush;
+						unsigned int newIndex = readID_2_index.size();
+						readID_2_index[readID] = newIndex;
 					}
-					alternativeIt->updateLikelihood(alleles_from_h1, alleles_from_h2, pileUpPerPosition);
-					
-					aI++;
+					positionLikelihoods.pileUp_readIndex.push_back(readID_2_index.at(readID));
+					modifiedReads[readID] = readID_2_index.at(readID);
+				}
+				for(std::map<std::string, unsigned int>::iterator readIt = modifiedReads.begin(); readIt != modifiedReads.end(); readIt++)
+				{
+					positionLikelihoods.modifiedReads_byID.push_back(readIt->second);
+				}
+
+				std::set<std::string> trailingAlleles;
+				std::set<std::pair<std::string, std::string> > trailingAllelePairs;
+				for(unsigned int aI = 0; aI < alternatives.size(); aI++)
+				{
+					std::pair<std::string, std::string> trailing = alternatives.at(aI)->getTrailingHaplotypeAlleles();
+					trailingAlleles.insert(trailing.first);
+					trailingAlleles.insert(trailing.second);
+					trailingAllelePairs.insert(trailing);
+				}
+
+				std::vector<std::string> trailingAlleles_vector(trailingAlleles.begin(), trailingAlleles.end());
+				std::vector<std::vector<double> > readLL_perAllele(trailingAlleles_vector.size());
+				long long trailingAlleles_size = trailingAlleles_vector.size();
+				#pragma omp parallel for schedule(dynamic)
+				for(long long alleleI = 0; alleleI < trailingAlleles_size; alleleI++)
+				{
+					readLL_perAllele.at(alleleI).resize(pileUpPerPosition.size());
+					for(unsigned int rI = 0; rI < pileUpPerPosition.size(); rI++)
+					{
+						const oneExonPosition& r = pileUpPerPosition.at(rI);
+						readLL_perAllele.at(alleleI).at(rI) = read_likelihood_per_position(trailingAlleles_vector.at(alleleI), r.genotype, r.qualities, r.graphLevel);
+					}
+				}
+				for(unsigned int alleleI = 0; alleleI < trailingAlleles_vector.size(); alleleI++)
+				{
+					positionLikelihoods.readLL_perAllele[trailingAlleles_vector.at(alleleI)].swap(readLL_perAllele.at(alleleI));
+				}
+
+				for(std::set<std::pair<std::string, std::string> >::iterator pairIt = trailingAllelePairs.begin(); pairIt != trailingAllelePairs.end(); pairIt++)
+				{
+					const std::vector<double>& readLL_h1 = positionLikelihoods.readLL_perAllele.at(pairIt->first);
+					const std::vector<double>& readLL_h2 = positionLikelihoods.readLL_perAllele.at(pairIt->second);
+
+					double thisPosition_LL2 = 0;
+					for(unsigned int rI = 0; rI < pileUpPerPosition.size(); rI++)
+					{
+						double combined_LL =  Utilities::logAvg(readLL_h1.at(rI), readLL_h2.at(rI));
+						double combined_L = exp(combined_LL);
+						if(!((combined_L >= 0) && (combined_L <= 1)))
+						{
+							const oneExonPosition& r = pileUpPerPosition.at(rI);
+							std::cerr << "h1_underlying_position" << ": " << pairIt->first << "\n";
+							std::cerr << "h2_underlying_position" << ": " << pairIt->second << "\n";
+							std::cerr << "r.genotype" << ": " << r.genotype << "\n";
+							std::cerr << "r.qualities" << ": " << r.qualities << "\n";
+							std::cerr << "r.graphLevel" << ": " << r.graphLevel << "\n\n";
+
+							std::cerr << "position_likelihood_h1" << ": " << readLL_h1.at(rI) << "\n";
+							std::cerr << "position_likelihood_h2" << ": " << readLL_h2.at(rI) << "\n";
+							std::cerr << "combined_L" << ": " << combined_L << "\n";
+							std::cerr << std::flush;
+						}
+						assert(combined_L >= 0);
+						assert(combined_L <= 1);
+
+						thisPosition_LL2 += combined_LL;
+					}
+					positionLikelihoods.LL2_perAllelePair[*pairIt] = thisPosition_LL2;
+				}
+
+				for(unsigned int aI = 0; aI < alternatives.size(); aI++)
+				{
+					alternatives.at(aI)->makeReadLikelihoodsWritable(positionLikelihoods.modifiedReads_byID);
+				}
+
+				long long alternatives_size = alternatives.size();
+				#pragma omp parallel for schedule(dynamic, 16)
+				for(long long aI = 0; aI < alternatives_size; aI++)
+				{
+					alternatives.at(aI)->updateLikelihood(alleles_from_h1, alleles_from_h2, positionLikelihoods);
 				}
 				
 				setNormalizedLikelihoods();
@@ -3851,7 +4119,7 @@ void HLAHaplotypeInference(std::string alignedReads_file, std::string graphDir,
 	outputFN_parameters_outputStream.close();
 }
 
-void HLATypeInference(std::string alignedReads_file, std::string graphDir, std::string sampleName, bool restrictToFullHaplotypes, std::string& forReturn_lociString, std::string& forReturn_starting_haplotype_1, std::string& forReturn_starting_haplotype_2, bool longUnpairedReads, bool MiSeq250bp)
+void HLATypeInference(std::string alignedReads_file, std::string graphDir, std::string sampleName, bool restrictToFullHaplotypes, std::string& forReturn_lociString, std::string& forReturn_starting_haplotype_1, std::string& forReturn_starting_haplotype_2, bool longUnpairedReads, bool MiSeq250bp, bool exhaustivePairs)
 {
 	std::string graph = graphDir + "/graph.txt";
 	assert(Utilities::fileReadable(graph));
@@ -4643,252 +4911,11 @@ void HLATypeInference(std::string alignedReads_file, std::string graphDir, std::
 		std::vector<std::vector<double> > likelihoods_perCluster_perObservedBase;
 		std::vector<std::vector<int> > mismatches_perCluster_perRead;
 
-		likelihoods_perCluster_perRead.resize(HLAtype_clusters.size());
-		mismatches_perCluster_perRead.resize(HLAtype_clusters.size());
-		likelihoods_perCluster_perObservedBase.resize(HLAtype_clusters.size());
-
-
-		// std::cout << "\n\n" << HLAtype_2_clusterID.at("A*30:73N") << " " << HLAtype_2_clusterID.at("A*29:02:08") << "\n" << std::flush;
-		// assert( 1 == 0 );
-
-		std::set<int> printClusters;
-		// printClusters.insert(1789);
-		// printClusters.insert(1646);
-
-
-		// can be removed later, will lead to problems during final normalization
-//		assert(exonPositions_fromReads.size() > 0);
-		for(unsigned int clusterI = 0; clusterI < HLAtype_clusters.size(); clusterI++)
-		{
-			std::vector<std::string> typesInCluster(HLAtype_clusters.at(clusterI).begin(), HLAtype_clusters.at(clusterI).end());
-			std::string clusterName = Utilities::join(typesInCluster, "|");
-
-			bool verbose = printClusters.count(clusterI);
-			// verbose = (clusterI == 0);
-			
-			if(verbose)
-			{
-				std::cout << "CLUSTER " << clusterI << " " << clusterName << "\n";
-			}
-
-			std::string& clusterSequence = cluster_2_sequence.at(clusterI);
-
-			likelihoods_perCluster_perRead.at(clusterI).resize(exonPositions_fromReads.size(), log(10));
-			mismatches_perCluster_perRead.at(clusterI).resize(exonPositions_fromReads.size(), 0);
-
-			// this is really readI
-			for(unsigned int readI = 0; readI < exonPositions_fromReads.size(); readI++)
-			{			
-				if(ignore_exonPositions_fromReads.count(readI))
-				{
-					continue;
-				}
-
-				std::vector<oneExonPosition>& individualPositions = exonPositions_fromReads.at(readI);
-				double log_likelihood_read = 0;
-				int mismatches = 0;
-
-				std::string readID;
-				std::string read1_ID;
-				if(individualPositions.size() > 0)
-				{
-					readID = individualPositions.at(0).thisRead_ID;
-					read1_ID = individualPositions.at(0).read1_ID;
-
-//					double mapQ_thisAlignment = (individualPositions.at(0).mapQ_genomic != 2) ? individualPositions.at(0).mapQ_genomic : individualPositions.at(0).mapQ;
-//					assert((mapQ_thisAlignment >= 0) && (mapQ_thisAlignment <= 1));
-
-					// log_likelihood_read += log(mapQ_thisAlignment);
-					assert(! combineReadAndBaseLikelihoods); // this would not make sense, or at least one would have to think more about it
-	
-				}
-
-				// bool verbose = ((clusterI == 1127) && (readID == "@@B81EP5ABXX:8:2208:11879:23374#GATCAGAT/2") && 0);
-
-				if(verbose)
-					std::cout << "Likelihood calculation for read " << readID << " / cluster " << clusterI << "\n";
-
-
-				for(unsigned int positionI = 0; positionI < individualPositions.size(); positionI++)
-				{
-					oneExonPosition& onePositionSpecifier = individualPositions.at(positionI);
-
-					assert((onePositionSpecifier.mapQ_position >= 0) && (onePositionSpecifier.mapQ_position <= 1));
-					if(onePositionSpecifier.mapQ_position < minimumPerPositionMappingQuality)
-					{
-						if(verbose)
-						{
-							std::cout << "\t" << positionI << " mapQ_position " << onePositionSpecifier.mapQ_position << " too low (below " << minimumPerPositionMappingQuality << ").\n" << std::flush;
-						}					
-						continue;
-					}
-					
-					if(perPosition_ignore_alleles.count(onePositionSpecifier.positionInExon) && (perPosition_ignore_alleles.at(onePositionSpecifier.positionInExon).count(onePositionSpecifier.genotype)))
-					{
-						continue;
-					}
-
-					if(clusterI == 0)
-					{
-						HLATypeInference_thisLocus_bases_used++;
-						HLATypeInference_totalBases_used++;
-					}
-				
-					double log_likelihood_position = 0;
-
-					std::string exonGenotype = clusterSequence.substr(onePositionSpecifier.positionInExon, 1);
-					std::string readGenotype = onePositionSpecifier.genotype;
-					std::string readQualities = onePositionSpecifier.qualities;
-
-					if(verbose)
-					{
-						std::cout << "\t" << positionI << " exon pos " << onePositionSpecifier.positionInExon << ": " << exonGenotype << " " << readGenotype << "\n" << std::flush;
-					}
-
-					assert(exonGenotype.length() == 1);
-					assert(readGenotype.length() >= 1);
-					unsigned int l_diff = readGenotype.length() - exonGenotype.length();
-					if(exonGenotype == "_")
-					{
-						// assert(l_diff == 0);
-						if(readGenotype == "_")
-						{
-							assert(onePositionSpecifier.graphLevel != -1);
-							// likelihood 1 - intrinsic graph gap
-
-							if(verbose)
-							{
-								std::cout << "\t\t" << "Intrinsic graph gap" << "\n";
-							}
-
-						}
-						else
-						{
-							if(verbose)
-							{
-								std::cout << "\t\t" << "Insertion " << (1 + l_diff) << "\n";
-							}
-
-							assert(readGenotype.find("_") == std::string::npos);
-							log_likelihood_position += (log_likelihood_insertion_actualAllele * (1 + l_diff));
-						}
-					}
-					else
-					{
-
-						if(readGenotype.length() > 1)
-						{
-							std::string readGenotype_after1 = readGenotype.substr(1);
-							assert(readGenotype_after1.find("_") == std::string::npos);
-						}
-						// score from first position match
-						if(readGenotype.substr(0, 1) == "_")
-						{
-							log_likelihood_position += log_likelihood_deletion;
-
-							if(verbose)
-							{
-								std::cout << "\t\t" << "Deletion" << "\n";
-							}
-						}
-						else
-						{
-							log_likelihood_position += log_likelihood_match_mismatch;
-							
-							assert(readQualities.length());
-							double pCorrect = Utilities::PhredToPCorrect(readQualities.at(0));
-							if(veryConservativeReadLikelihoods)
-							{
-								if(pCorrect > 0.999)
-									pCorrect = 0.999;
-							}
-							assert((pCorrect >= 0) && (pCorrect <= 1));
-
-							if(pCorrect == 0)
-							{
-								pCorrect = 0.001;
-							}
-							
-							// if(!(pCorrect >= 0.25))
-							// {
-								// std::cerr << "pCorrect = " << pCorrect << "\n" << std::flush;
-							// }
-							// assert(pCorrect >= 0.25);
-					
-							if(exonGenotype == readGenotype.substr(0, 1))
-							{
-								if(verbose)
-								{
-									std::cout << "\t\t" << "Match " << pCorrect << "\n";
-								}
-
-								log_likelihood_position += log(pCorrect);
-							}
-							else
-							{
-								double pIncorrect = (1 - pCorrect)*(1.0/3.0);
-								assert(pIncorrect <= 0.75);
-								assert((pIncorrect > 0) && (pIncorrect < 1));
-								log_likelihood_position += log(pIncorrect);
-
-								if(verbose)
-								{
-									std::cout << "\t\t" << "Mismatch " << pIncorrect << "\n";
-								}
-							}
-						}
-						// if read allele is longer
-						log_likelihood_position += (log_likelihood_insertion_actualAllele * l_diff);
-
-						if(l_diff > 0)
-						{
-							if(verbose)
-							{
-								std::cout << "\t\t" << "Insertion " << l_diff << "\n";
-							}
-						}
-					}
-
-					if(readGenotype != "_")
-					{
-						if(readGenotype != exonGenotype)
-						{
-							mismatches++;
-						}
-					}
-
-
-					log_likelihood_read += log_likelihood_position;
-
-					if(verbose)
-					{
-						std::cout << "\t\t" << "Running log likelihood: " << log_likelihood_read << "\n";
-					}
-
-
-					likelihoods_perCluster_perObservedBase.at(clusterI).push_back(log_likelihood_position);
-				}
-
-				if(individualPositions.size() > 0)
-				{
-					if((clusterI == 1160) || (clusterI == 1127))
-					{
-						// std::cout << locus << " " << readID << " cluster " << clusterI << ": " << log_likelihood << "\n" << std::flush;
-					}
-				}
-
-				// std::cout << "cluster " << clusterI << ", position sequence " << positionSpecifierI << ": " << log_likelihood << "\n";
-
-				assert(exp(log_likelihood_read) >= 0);
-				assert(exp(log_likelihood_read) <= 1);
-				
-				likelihoods_perCluster_perRead.at(clusterI).at(readI) = log_likelihood_read;
-				mismatches_perCluster_perRead.at(clusterI).at(readI) = mismatches;
-			}
-
-			assert(likelihoods_perCluster_perRead.at(clusterI).size() == exonPositions_fromReads.size());
-			assert(mismatches_perCluster_perRead.at(clusterI).size() == exonPositions_fromReads.size());
-		}
+		assert(cluster_2_sequence.size() == HLAtype_clusters.size());
+		size_t readLikelihoods_bases_used;
+		HLATypeInference_readLikelihoods(exonPositions_fromReads, ignore_exonPositions_fromReads, perPosition_ignore_alleles, cluster_2_sequence, likelihoods_perCluster_perRead, mismatches_perCluster_perRead, likelihoods_perCluster_perObservedBase, readLikelihoods_bases_used);
+		HLATypeInference_thisLocus_bases_used += readLikelihoods_bases_used;
+		HLATypeInference_totalBases_used += readLikelihoods_bases_used;
 
 		// std::cout << Utilities::timestamp() << "Compute normalized likelihoods (over multiple alignments, if there are any)." << std::flush;
 		//  std::cout << "\t" << "exonPositions_fromReads.size(): " << exonPositions_fromReads.size() << "\n" << std::flush;
@@ -5025,157 +5052,35 @@ void HLATypeInference(std::string alignedReads_file, std::string graphDir, std::
 		std::cout << "Threads: " << omp_get_num_threads() << "\n";
 		
 		
-		size_t HLAtype_cluster_SIZE = HLAtype_clusters.size();
-		
-		#pragma omp parallel for schedule(dynamic)
-		for(unsigned int clusterI1 = 0; clusterI1 < HLAtype_cluster_SIZE; clusterI1++)
-		{	
-			if(omp_get_thread_num() == 0)
-			{
-				std::cout << "\rClusterI1 = " << clusterI1 << std::flush;
-			}
-			
-			std::vector<double> LLs_completeReads_perThread;
-
-			std::vector<double> LLs_observedBases_perThread;
-
-			std::vector<double> Mismatches_avg_perThread;
-			std::vector<double> Mismatches_min_perThread;
-
-			std::vector<std::pair<unsigned int, unsigned int> > LLs_clusterIs_perThread;
-			// std::vector<unsigned int> LLs_completeReads_indices_perThread;
-		
-			for(unsigned int clusterI2 = clusterI1; clusterI2 < HLAtype_clusters.size(); clusterI2++)
-			{
-
-				double mismatches_sum_averages = 0;
-				double mismatches_sum_min = 0;
-
-				double pair_log_likelihood = 0;
-
-				for(unsigned int readI = 0; readI < exonPositions_fromReads.size(); readI++)
-				{
-					if(ignore_exonPositions_fromReads.count(readI))
-					{
-						continue;
-					}
-
-					// now use allAlignments likelihoods instead!
-//					std::string readID;
-//					if(exonPositions_fromReads.at(readI).size() > 0)
-//					{
-//						readID = exonPositions_fromReads.at(readI).at(0).thisRead_ID;
-//					}
-
-
-					double LL_thisRead_cluster1 = likelihoods_perCluster_perRead.at(clusterI1).at(readI);
-					double LL_thisRead_cluster2 = likelihoods_perCluster_perRead.at(clusterI2).at(readI);
-
-					assert(exp(LL_thisRead_cluster1 <= 1));
-					assert(exp(LL_thisRead_cluster2 <= 1));
-
-					// double LL_average = log( (1 + (exp(LL_thisPositionSpecifier_cluster2+log(0.5)))/exp(LL_thisPositionSpecifier_cluster1+log(0.5)) )) + (LL_thisPositionSpecifier_cluster1+log(0.5));
-
-					// double LL_average_2 = log(0.5 * exp(LL_thisRead_cluster1) + 0.5 * exp(LL_thisRead_cluster2));
-					double LL_average_2_2 = Utilities::logAvg(LL_thisRead_cluster1, LL_thisRead_cluster2);
-					
-					// if((exp(LL_thisRead_cluster1) == 0) && (exp(LL_thisRead_cluster2) == 0))
-					// {
-						// LL_average_2_2 = -1 * std::numeric_limits<double>::infinity();
-					// }
-					
-					// std::cerr << LL_average_2_2 << "\n";
-					
-					if(!((exp(LL_average_2_2) >= 0) && (exp(LL_average_2_2) <= 1)))
-					{  
-						#pragma omp critical
-						{
-							std::cerr << "Problem with readI " << readI << " conditional on clusters " << clusterI1 << "/" << clusterI2 << "\n";
-							std::cerr << "LL_average_2_2" << ": " << LL_average_2_2 << " exp: " << exp(LL_average_2_2) << "\n";
-							std::cerr << "LL_thisRead_cluster1" << ": " << LL_thisRead_cluster1 << " exp: " << exp(LL_thisRead_cluster1) << "\n";
-							std::cerr << "LL_thisRead_cluster2" << ": " << LL_thisRead_cluster2 << " exp: " << exp(LL_thisRead_cluster2) << "\n";
-							std::cerr << std::flush;	
-						}						
-					}
-					
-					assert((exp(LL_average_2_2) >= 0) && (exp(LL_average_2_2) <= 1));
-					
-					// if(! (abs(LL_average_2 - LL_average_2_2) < 1e-5))
-					// {
-						// std::cerr << "Cluster 1: " << LL_thisRead_cluster1 << " " << exp(LL_thisRead_cluster1) << "\n";
-						// std::cerr << "Cluster 2: " << LL_thisRead_cluster2 << " " << exp(LL_thisRead_cluster2) << "\n";
-						// std::cerr << LL_average_2 << "\n";
-						// std::cerr << LL_average_2_2 << "\n" << std::flush;
-					// }
-					// assert(abs(LL_average_2 - LL_average_2_2) < 1e-5);
-
-					int mismatches_cluster1 = mismatches_perCluster_perRead.at(clusterI1).at(readI);
-					int mismatches_cluster2 = mismatches_perCluster_perRead.at(clusterI2).at(readI);
-
-					mismatches_sum_averages += ((double)(mismatches_cluster1 + mismatches_cluster2) / 2.0);
-					mismatches_sum_min += ((mismatches_cluster1 < mismatches_cluster2) ? mismatches_cluster1 : mismatches_cluster2);
-
-					 pair_log_likelihood += LL_average_2_2;
-
-					// if ( ((clusterI1 == 1160) && (clusterI2 == 1640)) || ((clusterI1 == 1127) && (clusterI2 == 1640)))
-					// {
-						// std::cout << "Cluster pair " << clusterI1 << " / " << clusterI2 << " read " << readID << ": " << LL_thisPositionSpecifier_cluster1 << " and " << LL_thisPositionSpecifier_cluster2 << ": " << LL_average_2 << "\n" << std::flush;
-					// }
-				}
-
-				/*
-				assert(! combineReadAndBaseLikelihoods);
-				for(std::map<std::string, std::set<unsigned int> >::const_iterator readIDit = readID_noAlignment_2_readIndex.begin(); readIDit != readID_noAlignment_2_readIndex.end(); readIDit++)
-				{
-					const std::string readID = readIDit->first;
-					unsigned int idx_for_readID = readID_noAlignment_2_idx.at(readIDit->first);
-					double LL_thisRead_cluster1 = likelihoods_perCluster_perReads_allAlignments.at(clusterI1).at(idx_for_readID);
-					double LL_thisRead_cluster2 = likelihoods_perCluster_perReads_allAlignments.at(clusterI2).at(idx_for_readID);
-					double LL_average_2_2 = logAvg(LL_thisRead_cluster1, LL_thisRead_cluster2);
-
-					pair_log_likelihood += LL_average_2_2;
-				}
-				
-				*/
-				
-
-				LLs_completeReads_perThread.push_back(pair_log_likelihood);
-
-				Mismatches_avg_perThread.push_back(mismatches_sum_averages);
-				Mismatches_min_perThread.push_back(mismatches_sum_min);
-
-				LLs_clusterIs_perThread.push_back(make_pair(clusterI1, clusterI2));
-
-				// LLs_completeReads_indices_perThread.push_back(LLs_completeReads.size() - 1);
-
-				double pair_log_likelihood_fromBases = 0;
-				if(combineReadAndBaseLikelihoods)
-				{
-					assert(likelihoods_perCluster_perObservedBase.at(clusterI1).size() == likelihoods_perCluster_perObservedBase.at(clusterI2).size());
-					for(unsigned int baseI = 0; baseI < likelihoods_perCluster_perObservedBase.at(clusterI1).size(); baseI++)
-					{
-						double LL_thisBase_cluster1 = likelihoods_perCluster_perObservedBase.at(clusterI1).at(baseI);
-						double LL_thisBase_cluster2 = likelihoods_perCluster_perObservedBase.at(clusterI2).at(baseI);
-
-						double LL_thisBase_avg = Utilities::logAvg(LL_thisBase_cluster1, LL_thisBase_cluster2);
-						pair_log_likelihood_fromBases += LL_thisBase_avg;
-					}
-				}
-				LLs_observedBases_perThread.push_back(pair_log_likelihood_fromBases);
-			}
-			
-			#pragma omp critical
-			{
-				LLs_completeReads.insert(LLs_completeReads.end(), LLs_completeReads_perThread.begin(), LLs_completeReads_perThread.end());
-
-				LLs_observedBases.insert(LLs_observedBases.end(), LLs_observedBases_perThread.begin(), LLs_observedBases_perThread.end());
+		// dense cluster x read-profile matrices without the ignored reads, pairs evaluated in tiles by a SIMD kernel
+		clusterPairLikelihoods pairLikelihoods_reads(likelihoods_perCluster_perRead, mismatches_perCluster_perRead, ignore_exonPositions_fromReads);
+		std::cout << Utilities::timestamp() << "\tReads: " << pairLikelihoods_reads.getReads() << ", distinct informative likelihood profiles: " << pairLikelihoods_reads.getColumns() << ", kernel: " << clusterPairLikelihoods_kernelName() << "\n" << std::flush;
+		if(exhaustivePairs || combineReadAndBaseLikelihoods)
+		{
+			pairLikelihoods_reads.computeAllPairs(LLs_clusterIs, LLs_completeReads, &Mismatches_avg, &Mismatches_min);
+		}
+		else
+		{
+			// only the best pairs (and whatever carries non-negligible posterior mass) are needed for the calls
+			size_t pairs_evaluated = pairLikelihoods_reads.computeTopPairs(HLATypeInference_topPairs, LLs_clusterIs, LLs_completeReads, &Mismatches_avg, &Mismatches_min);
+			std::cout << Utilities::timestamp() << "\tBranch-and-bound: evaluated " << pairs_evaluated << " of " << (HLAtype_clusters.size() * (HLAtype_clusters.size() + 1) / 2) << " pairs, kept " << LLs_clusterIs.size() << "\n" << std::flush;
+		}
 
-				Mismatches_avg.insert(Mismatches_avg.end(), Mismatches_avg_perThread.begin(), Mismatches_avg_perThread.end());
-				Mismatches_min.insert(Mismatches_min.end(), Mismatches_min_perThread.begin(), Mismatches_min_perThread.end());
+		if(combineReadAndBaseLikelihoods)
+		{
+			std::vector<std::pair<unsigned int, unsigned int> > LLs_clusterIs_observedBases;
+			clusterPairLikelihoods pairLikelihoods_observedBases(likelihoods_perCluster_perObservedBase, std::set<size_t>());
+			pairLikelihoods_observedBases.computeAllPairs(LLs_clusterIs_observedBases, LLs_observedBases, 0, 0);
+			assert(LLs_clusterIs_observedBases == LLs_clusterIs);
+		}
+		else
+		{
+			LLs_observedBases.assign(LLs_completeReads.size(), 0);
+		}
 
-				LLs_clusterIs.insert(LLs_clusterIs.end(), LLs_clusterIs_perThread.begin(), LLs_clusterIs_perThread.end());
-				// LLs_completeReads_indices.insert(LLs_completeReads_indices.end(), LLs_completeReads_indices_perThread.begin(), LLs_completeReads_indices_perThread.end());
-			}
+		for(size_t pairI = 0; pairI < LLs_completeReads.size(); pairI++)
+		{
+			assert(LLs_completeReads.at(pairI) <= 1e-10);
 		}
 
 		std::vector<size_t> LLs_completeReads_indices;		
@@ -984,52 +984,51 @@ Graph* HLAalignmentGraph(string hla_allele_dir, string locus)
 
 MultiGraph* simplifyAccordingToCoverage(MultiGraph* mG, map<string, long long> estimatedEmissions, set<int> protectLevels)
 {
-	set<string> utilizekMers;
-	set<string> ignorekMers;
 	kMerPositionInfo kMersInGraphInfo;
-	set<string> kMersInGraph;
+	vector<int> kMersInGraph;
 	kMerUniquenessInfo uniqueMers;
 
 	kMersInGraphInfo = mG->getkMerPositions();
 	kMersInGraph = kMersInGraphInfo.kMers;
 	uniqueMers = mG->kMerUniqueness();
 
+	vector<long long> kMerCounts = mG->kMerCountsByID(estimatedEmissions);
+	vector<bool> utilizekMers(kMerCounts.size(), false);
+	int utilizekMers_count = 0;
+
 	// find out which kMers we want to keep
-	for(set<string>::iterator kMerIt = kMersInGraph.begin(); kMerIt != kMersInGraph.end(); kMerIt++)
+	for(vector<int>::iterator kMerIt = kMersInGraph.begin(); kMerIt != kMersInGraph.end(); kMerIt++)
 	{
-		string kMer = *kMerIt;
+		int kMerID = *kMerIt;
 		bool usekMer = true;
 
 		// non-unique within graph
-		if(uniqueMers.levelUniqueKMers.count(kMer) == 0)
+		if(! uniqueMers.levelUniqueKMers.at(kMerID))
 		{
 			usekMer = false;
 		}
 
-		assert(kMersInGraphInfo.kMerEdgeNum.count(kMer) > 0);
-		if(kMersInGraphInfo.kMerEdgeNum[kMer] != 1)
+		assert(kMersInGraphInfo.kMerEdgeNum.at(kMerID) > 0);
+		if(kMersInGraphInfo.kMerEdgeNum.at(kMerID) != 1)
 		{
 			usekMer = false;
 		}
 
 		// non-unique within genome
-		assert(estimatedEmissions.count(kMer) > 0);
-		if(estimatedEmissions[kMer] == -1)
+		assert(kMerCounts.at(kMerID) != MultiGraph::kMerCountMissing);
+		if(kMerCounts.at(kMerID) == -1)
 		{
 			usekMer = false;
 		}
 
 		if(usekMer)
 		{
-			utilizekMers.insert(kMer);
-		}
-		else
-		{
-			ignorekMers.insert(kMer);
+			utilizekMers.at(kMerID) = true;
+			utilizekMers_count++;
 		}
 	}
 
-	cout << "Graph simplification: out of " << kMersInGraph.size() << " kMers, we are now using " << utilizekMers.size() << "\n";
+	cout << "Graph simplification: out of " << kMersInGraph.size() << " kMers, we are now using " << utilizekMers_count << "\n";
 	cout << "\t\t Number of protected levels: " << protectLevels.size() << "\n";
 
 	set<Edge*> deleteEdge;
@@ -1094,25 +1093,27 @@ MultiGraph* simplifyAccordingToCoverage(MultiGraph* mG, map<string, long long> e
 			int kMer_present_all = 0;
 			int kMer_total_all = 0;
 
+			const vector<int>& locus_kMerIDs = mG->CODE.kMerIDsForLocus(e->locus_id);
 			for(map<int, int>::iterator emissionIt = edgeEmissions.begin(); emissionIt != edgeEmissions.end(); emissionIt++)
 			{
-				string kMer = mG->CODE.deCode(e->locus_id, emissionIt->first);
-				if((kMer == "*") || (kMer == "_"))
+				int kMerID = locus_kMerIDs.at(emissionIt->first);
+				if(kMerID == -1)
 				{
 					continue;
 				}
 
-				assert(estimatedEmissions.count(kMer) > 0);
-				if((estimatedEmissions[kMer] > 0) || (estimatedEmissions[kMer] == -1))
+				long long kMerCount = kMerCounts.at(kMerID);
+				assert(kMerCount != MultiGraph::kMerCountMissing);
+				if((kMerCount > 0) || (kMerCount == -1))
 				{
 					kMer_present_all++;
 				}
 				kMer_total_all++;
 
-				if(utilizekMers.count(kMer) > 0)
+				if(utilizekMers.at(kMerID))
 				{
-					assert(estimatedEmissions[kMer] != -1);
-					if(estimatedEmissions[kMer] > 0)
+					assert(kMerCount != -1);
+					if(kMerCount > 0)
 					{
 						kMer_present++;
 					}
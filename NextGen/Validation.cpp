@@ -19,6 +19,7 @@
 #include <set>
 
 #include "Validation.h"
+#include "shortReadAlignmentsFile.h"
 #include "../Utilities.h"
 #include <boost/math/distributions/poisson.hpp>
 
@@ -143,6 +144,33 @@ std::vector<oneRead> getUnpairedReadsFromFastQ(std::string fastq_path)
 }
 
 std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_base_path)
+{
+	fastQPairReader reader(fastq_base_path);
+
+	std::vector<oneReadPair> forReturn;
+	std::vector<oneReadPair> batch;
+	while(reader.getPairs(batch, 100000))
+	{
+		forReturn.insert(forReturn.end(), batch.begin(), batch.end());
+	}
+	return forReturn;
+}
+
+
+std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_1_path, std::string fastq_2_path)
+{
+	fastQPairReader reader(fastq_1_path, fastq_2_path);
+
+	std::vector<oneReadPair> forReturn;
+	std::vector<oneReadPair> batch;
+	while(reader.getPairs(batch, 100000))
+	{
+		forReturn.insert(forReturn.end(), batch.begin(), batch.end());
+	}
+	return forReturn;
+}
+
+fastQPairReader::fastQPairReader(std::string fastq_base_path)
 {
 	std::string f1 = fastq_base_path + "_1";
 	std::string f2 = fastq_base_path + "_2";
@@ -157,69 +185,58 @@ std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_base_path)
 		throw std::runtime_error("Expected file "+f2+" can't be opened.");
 	}
 
-	return getReadsFromFastQ(f1, f2);
-}
+	fastQ_1_stream.open(f1.c_str());
+	assert(fastQ_1_stream.is_open());
 
+	fastQ_2_stream.open(f2.c_str());
+	assert(fastQ_2_stream.is_open());
+}
 
-std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_1_path, std::string fastq_2_path)
+fastQPairReader::fastQPairReader(std::string fastq_1_path, std::string fastq_2_path)
 {
-	std::vector<oneReadPair> forReturn;
-
-	std::ifstream fastQ_1_stream;
 	fastQ_1_stream.open(fastq_1_path.c_str());
 	assert(fastQ_1_stream.is_open());
 
-	std::ifstream fastQ_2_stream;
 	fastQ_2_stream.open(fastq_2_path.c_str());
 	assert(fastQ_2_stream.is_open());
+}
 
-	auto getLinesFromFastQ = [](std::ifstream& inputStream, unsigned int lines) -> std::vector<std::string> {
-		std::vector<std::string> forReturn;
-		assert(lines > 0);
-		for(unsigned int lI = 0; lI < lines; lI++)
-		{
-			if(!inputStream.good())
-			{
-				return forReturn;
-			}
-			assert(inputStream.good());
-			std::string thisLine;
-			std::getline(inputStream, thisLine);
-			Utilities::eraseNL(thisLine);
-			forReturn.push_back(thisLine);
-		}
-		assert(forReturn.size() == lines);
-		return forReturn;
-	};
-
-	auto getReadFromFastQ = [&](std::ifstream& inputStream, std::string& ret_readID, std::string& ret_sequence, std::string& ret_qualities) -> void {
-		assert(inputStream.good());
-		std::vector<std::string> lines = getLinesFromFastQ(inputStream, 4);
-		if(lines.size() == 4)
-		{
-			assert(lines.at(2) == "+");
-			ret_readID = lines.at(0);
-			ret_sequence = lines.at(1);
-			ret_qualities = lines.at(3);
-			assert(ret_sequence.length() == ret_qualities.length());
-		}
-		else
+bool fastQPairReader::getRead(std::ifstream& inputStream, std::string& ret_readID, std::string& ret_sequence, std::string& ret_qualities)
+{
+	std::string lines[4];
+	for(unsigned int lI = 0; lI < 4; lI++)
+	{
+		if(!inputStream.good())
 		{
 			ret_readID.clear();
 			ret_sequence.clear();
 			ret_qualities.clear();
+			return false;
 		}
-	};
+		std::getline(inputStream, lines[lI]);
+		Utilities::eraseNL(lines[lI]);
+	}
+
+	assert(lines[2] == "+");
+	ret_readID = lines[0];
+	ret_sequence = lines[1];
+	ret_qualities = lines[3];
+	assert(ret_sequence.length() == ret_qualities.length());
+	return true;
+}
 
-	while(fastQ_1_stream.good())
+size_t fastQPairReader::getPairs(std::vector<oneReadPair>& batch, size_t maxPairs)
+{
+	batch.clear();
+	while(fastQ_1_stream.good() && (batch.size() < maxPairs))
 	{
 		assert(fastQ_2_stream.good());
 
 		std::string read1_ID; std::string read1_sequence; std::string read1_qualities;
-		getReadFromFastQ(fastQ_1_stream, read1_ID, read1_sequence, read1_qualities);
+		getRead(fastQ_1_stream, read1_ID, read1_sequence, read1_qualities);
 
 		std::string read2_ID; std::string read2_sequence; std::string read2_qualities;
-		getReadFromFastQ(fastQ_2_stream, read2_ID, read2_sequence, read2_qualities);
+		getRead(fastQ_2_stream, read2_ID, read2_sequence, read2_qualities);
 
 		assert((read1_ID.length() && read2_ID.length()) || ((!read1_ID.length()) && (!read2_ID.length())));
 		if((!read1_ID.length()) && (!read2_ID.length()))
@@ -240,10 +257,10 @@ std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_1_path, std::string
 		oneRead r1(read1_ID, read1_sequence, read1_qualities);
 		oneRead r2(read2_ID, read2_sequence, read2_qualities);
 		oneReadPair thisPair(r1, r2, 0);
-		forReturn.push_back(thisPair);
+		batch.push_back(thisPair);
 	}
 
-	return forReturn;
+	return batch.size();
 }
 
 void alignedShortReads2SAM(std::ofstream& SAMoutputStream, std::vector<int>& uncompressed_graph_referencePositions, std::string& referenceSequence, std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> >& alignments, std::vector<oneReadPair>& originalReads)
@@ -585,153 +602,12 @@ void read_shortReadAlignments_fromFile (std::string file, std::vector<std::pair<
 {
 	ret_alignments.clear();
 	ret_alignments_originalReads.clear();
-	
-	std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> forReturn;
-
-	auto getLines = [](std::ifstream& inputStream, unsigned int lines) -> std::vector<std::string> {
-		std::vector<std::string> forReturn;
-		assert(lines > 0);
-		for(unsigned int lI = 0; lI < lines; lI++)
-		{
-			if(!inputStream.good())
-			{
-				return forReturn;
-			}
-			assert(inputStream.good());
-			std::string thisLine;
-			std::getline(inputStream, thisLine);
-			Utilities::eraseNL(thisLine);
-			forReturn.push_back(thisLine);
-
-		}
-		assert(forReturn.size() == lines);
-		return forReturn;
-	};
-
-
-	auto getAlignment = [&](std::ifstream& inputStream, bool& fail, seedAndExtend_return_local& ret_alignment, oneRead& ret_originalRead, std::string insertFirstLine) -> void {
-		fail = false;
-		int readLines = 9;
-		if(insertFirstLine.length())
-		{
-			readLines = 8;
-		}
-		std::vector<std::string> lines = getLines(inputStream, readLines);
-		
-		if(insertFirstLine.length())
-		{
-			lines.insert(lines.begin(), insertFirstLine);
-		}
-		
-		if(lines.size() != 9)
-		{
-			fail = true;
-		}
-		else
-		{
-
-			if(!(lines.at(0).substr(0, 5) == "\tRead"))
-			{
-				std::cerr << "Line 0 should be TABRead, but is not!\n" << lines.at(0) << "\n" << std::flush;
-			}
-			assert(lines.at(0).substr(0, 6) == "\tRead ");
-
-			std::string str_readID = lines.at(0).substr(6);
-			std::string str_score = lines.at(1).substr(2);
-			std::string str_reverse = lines.at(2).substr(2);
-			std::string str_mapQ = lines.at(3).substr(2);
-			std::string str_graph_aligned = lines.at(4).substr(2);
-			std::string str_sequence_aligned = lines.at(5).substr(2);
-			std::string str_levels = lines.at(6).substr(2);
-			std::string str_originalSequence = lines.at(7).substr(2);
-			std::string str_qualities = lines.at(8).substr(2);
-
-			std::vector<std::string> mapQs = Utilities::split(str_mapQ, " ");
-
-			seedAndExtend_return_local a;
-			a.Score = Utilities::StrtoD(str_score);
-			a.reverse = Utilities::StrtoB(str_reverse);
-			if(mapQs.size() == 2)
-			{
-				a.mapQ = Utilities::StrtoD(mapQs.at(0));
-				a.mapQ_genomic = Utilities::StrtoD(mapQs.at(1));
-			}
-			else if(mapQs.size() == 3)
-			{
-				a.mapQ = Utilities::StrtoD(mapQs.at(0));
-				a.mapQ_genomic = Utilities::StrtoD(mapQs.at(1));
-				a.mapQ_genomic_perPosition = mapQs.at(2);
-				assert(a.mapQ_genomic_perPosition.length() == str_graph_aligned.length());
-			}
-			else
-			{
-				a.mapQ = Utilities::StrtoD(mapQs.at(0));
-				a.mapQ_genomic = 2;
-			}
-			a.graph_aligned = str_graph_aligned;
-			a.sequence_aligned = str_sequence_aligned;
-			a.graph_aligned_levels = Utilities::StrtoI(Utilities::split(str_levels, " "));			
-			ret_alignment = a;
-			
-			oneRead r(str_readID, str_originalSequence, str_qualities);
-			ret_originalRead = r;			
-		}
-	};
-	std::ifstream inputStream;
-	inputStream.open(file.c_str());
-	assert(inputStream.is_open());
-	std::string line;
-	assert(inputStream.good());
-	std::getline(inputStream, line);
-	
-	std::vector<std::string> firstLine_fields = Utilities::split(line, " ");
-	assert(firstLine_fields.size() == 3);
-	assert(firstLine_fields.at(0) == "IS");
 
-	ret_IS_mean = Utilities::StrtoD(firstLine_fields.at(1));
-	ret_IS_sd = Utilities::StrtoD(firstLine_fields.at(2));
-	
-	while(inputStream.good())
-	{
-		std::getline(inputStream, line);
-		Utilities::eraseNL(line);
-		if(line.length())
-		{
-
-			std::string lineForInsertion;
-			
-			assert( (line.substr(0, std::string("Aligned pair").length()) == "Aligned pair") ||
-					(line.substr(0, std::string("\tRead").length()) == "\tRead")
-			);
-			
-			if(line.substr(0, std::string("\tRead").length()) == "\tRead")
-			{
-				lineForInsertion = line;
-			}
-			
-			bool fail_1; bool fail_2;
-
-			seedAndExtend_return_local a1;
-			seedAndExtend_return_local a2;
-			oneRead r1("", "", "");
-			oneRead r2("", "", "");
-			
-			getAlignment(inputStream, fail_1, a1, r1, lineForInsertion);
-			getAlignment(inputStream, fail_2, a2, r2, "");
+	shortReadAlignmentsReader alignmentsReader(file);
+	ret_IS_mean = alignmentsReader.getInsertSizeMean();
+	ret_IS_sd = alignmentsReader.getInsertSizeSD();
 
-			oneReadPair rP(r1, r2, 0);			 
-			if(fail_1 || fail_2)
-			{
-				assert(! inputStream.good());
-			}
-
-			if((! fail_1) && (! fail_2))
-			{
-				ret_alignments.push_back(make_pair(a1, a2));
-				ret_alignments_originalReads.push_back(rP);
-			}
-		}
-	}
+	alignmentsReader.readAllAlignmentPairs(ret_alignments, ret_alignments_originalReads);
 }
 
 void read_longReadAlignments_fromFile (std::string file, std::vector<seedAndExtend_return_local>& ret_alignments, std::vector<oneRead>& ret_alignments_originalReads)
@@ -1041,6 +917,10 @@ void alignLongUnpairedReadsToHLAGraph(std::string FASTQs, std::string graphDir,
 
 	std::cout << Utilities::timestamp() << "alignLongUnpairedReadsToHLAGraph(..): Loading graph.\n" << std::flush;
 
+	Graph* g = new Graph();
+	g->readFromFile(graph);
+	std::shared_ptr<GraphAlignerUnique::AlignmentContext> alignmentContext = std::make_shared<GraphAlignerUnique::AlignmentContext>(g, aligner_kMerSize);
+
 	std::cout << Utilities::timestamp() << "alignLongUnpairedReadsToHLAGraph(..): Create GraphAlignerUnique(s).\n" << std::flush;
 
 	omp_set_num_threads(outerThreads);
@@ -1049,24 +929,15 @@ void alignLongUnpairedReadsToHLAGraph(std::string FASTQs, std::string graphDir,
 	std::vector<std::map<int, int>> printedAlignments_perRead_combinedLL_perThread;
 	std::vector<std::map<int, int>> printedAlignments_perRead_combinedGenomicLL_perThread;
 
-	std::vector<Graph*> graphs;
+	// one graph and index for all threads, one aligner per thread
 	std::vector<GraphAlignerUnique::GraphAlignerUnique*> graphAligners;
-	graphs.resize(outerThreads);
 	graphAligners.resize(outerThreads);
 
-	#pragma omp parallel for
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
-		// std::cout << "Thread " << tI << "\n" << std::flush;
-
-		Graph* g = new Graph();
-		g->readFromFile(graph);
-
-		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(g, aligner_kMerSize);
+		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(alignmentContext);
 		graphAligners.at(tI)->setIterationsMainRandomizationLoop(4);
 		graphAligners.at(tI)->setThreads(1);
-
-		graphs.at(tI) = g;
 	}
 
 	printedAlignments_perRead_perThread.resize(outerThreads);
@@ -1341,11 +1212,12 @@ void alignLongUnpairedReadsToHLAGraph(std::string FASTQs, std::string graphDir,
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
 		delete(graphAligners.at(tI));
-		delete(graphs.at(tI));
 	}
+	alignmentContext.reset();
+	delete(g);
 }
 
-void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool debug, bool MiSeq250bp)
+void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool debug, bool MiSeq250bp, bool binaryAlignments)
 {
 	int aligner_kMerSize = 25;
 	int outerThreads = (debug ? 1: 40);
@@ -1363,6 +1235,10 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 
 	std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph_multipleAlignments(..): Loading graph.\n" << std::flush;
 
+	Graph* g = new Graph();
+	g->readFromFile(graph);
+	std::shared_ptr<GraphAlignerUnique::AlignmentContext> alignmentContext = std::make_shared<GraphAlignerUnique::AlignmentContext>(g, aligner_kMerSize);
+
 	std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph_multipleAlignments(..): Create GraphAlignerUnique(s).\n" << std::flush;
 
 	omp_set_num_threads(outerThreads);
@@ -1371,24 +1247,15 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 	std::vector<std::map<int, int>> printedAlignments_perRead_combinedLL_perThread;
 	std::vector<std::map<int, int>> printedAlignments_perRead_combinedGenomicLL_perThread;
 
-	std::vector<Graph*> graphs;
+	// one graph and index for all threads, one aligner per thread
 	std::vector<GraphAlignerUnique::GraphAlignerUnique*> graphAligners;
-	graphs.resize(outerThreads);
 	graphAligners.resize(outerThreads);
 
-	#pragma omp parallel for
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
-		// std::cout << "Thread " << tI << "\n" << std::flush;
-
-		Graph* g = new Graph();
-		g->readFromFile(graph);
-
-		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(g, aligner_kMerSize);
+		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(alignmentContext);
 		graphAligners.at(tI)->setIterationsMainRandomizationLoop(4);
 		graphAligners.at(tI)->setThreads(1);
-
-		graphs.at(tI) = g;
 	}
 
 	printedAlignments_perRead_perThread.resize(outerThreads);
@@ -1471,23 +1338,9 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 	
 		double printingThreshold = 0.01;
 		
-		std::ofstream outputStream;
-		outputStream.open(outputFilename.c_str());
-		assert(outputStream.is_open());
-
-		outputStream << "IS " << insertSize_mean << " " << insertSize_sd << "\n";
-		
-		auto printOneRead = [&](seedAndExtend_return_local alignment, oneRead originalRead, int aI) -> void {
-			outputStream << "\t" << "Read " << originalRead.name << "A" << aI << "\n";
-			outputStream << "\t\t" << alignment.Score << "\n";
-			outputStream << "\t\t" << alignment.reverse << "\n";
-			outputStream << "\t\t" << alignment.mapQ << " " << alignment.mapQ_genomic << " " << alignment.mapQ_genomic_perPosition << "\n";
-			outputStream << "\t\t" << alignment.graph_aligned << "\n";
-			outputStream << "\t\t" << alignment.sequence_aligned << "\n";
-			outputStream << "\t\t" << Utilities::join(Utilities::ItoStr(alignment.graph_aligned_levels), " ") << "\n";
-			outputStream << "\t\t" << originalRead.sequence << "\n";
-			outputStream << "\t\t" << originalRead.quality << "\n";
+		shortReadAlignmentsWriter alignmentsWriter(outputFilename, insertSize_mean, insertSize_sd, binaryAlignments);
 
+		auto countPrintedBases = [&](const seedAndExtend_return_local& alignment) -> void {
 			totalPrintedBases += alignment.graph_aligned.length();
 			if((alignment.mapQ_genomic < 0.9) && (alignment.mapQ_genomic_perPosition.length()))
 			{
@@ -1501,7 +1354,6 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 					}
 				}
 			}
-
 		};
 
 		for(unsigned int pairI = 0; pairI < alignments.size(); pairI++)
@@ -1518,18 +1370,19 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 			
 			if(printAtLeastOneAlignment)
 			{
-				outputStream << "Aligned pair " << pairI << "\n";   
+				alignmentsWriter.beginPair(pairI);
 				for(unsigned int aI = 0; aI < alignments.at(pairI).size(); aI++)
 				{
 					if(alignments.at(pairI).at(aI).first.mapQ_genomic > printingThreshold)
 					{
-						printOneRead(alignments.at(pairI).at(aI).first, originalReads.at(pairI).reads.first, aI);
-						printOneRead(alignments.at(pairI).at(aI).second, originalReads.at(pairI).reads.second, aI);
+						alignmentsWriter.writeAlignmentPair(alignments.at(pairI).at(aI).first, originalReads.at(pairI).reads.first, alignments.at(pairI).at(aI).second, originalReads.at(pairI).reads.second, "A" + Utilities::ItoStr(aI));
+						countPrintedBases(alignments.at(pairI).at(aI).first);
+						countPrintedBases(alignments.at(pairI).at(aI).second);
 					}
 				}
 			}
 		}
-		outputStream.close();
+		alignmentsWriter.close();
 	};       
 
 
@@ -1713,11 +1566,12 @@ void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::strin
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
 		delete(graphAligners.at(tI));
-		delete(graphs.at(tI));
 	}
+	alignmentContext.reset();
+	delete(g);
 }
 
-void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile)
+void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool binaryAlignments)
 {
 	int aligner_kMerSize = 25;
 	int outerThreads = 8;
@@ -1732,33 +1586,37 @@ void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::st
 
 	std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph(..): Loading graph.\n" << std::flush;
 
+	Graph* g = new Graph();
+	g->readFromFile(graph);
+	std::shared_ptr<GraphAlignerUnique::AlignmentContext> alignmentContext = std::make_shared<GraphAlignerUnique::AlignmentContext>(g, aligner_kMerSize);
+
 	std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph(..): Create GraphAlignerUnique(s).\n" << std::flush;
 
 	omp_set_num_threads(outerThreads);
 
-	std::vector<Graph*> graphs;
+	// one graph and index for all threads, one aligner per thread
 	std::vector<GraphAlignerUnique::GraphAlignerUnique*> graphAligners;
-	graphs.resize(outerThreads);
 	graphAligners.resize(outerThreads);
 
-	#pragma omp parallel for
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
-		// std::cout << "Thread " << tI << "\n" << std::flush;
-
-		Graph* g = new Graph();
-		g->readFromFile(graph);
-
-		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(g, aligner_kMerSize);
+		graphAligners.at(tI) = new GraphAlignerUnique::GraphAlignerUnique(alignmentContext);
 		graphAligners.at(tI)->setIterationsMainRandomizationLoop(4);
 		graphAligners.at(tI)->setThreads(1);
-
-		graphs.at(tI) = g;
 	}
 
 
-	auto alignReadPairs = [&](std::vector<oneReadPair>& readPairs, std::vector< std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> >& alignments_perThread, std::vector< std::vector<int> >& alignments_readPairI_perThread, bool usePairing, double insertSize_mean, double insertSize_sd) -> void
+	// Reads are processed in batches of readPairs_perBatch pairs: read a batch, align it with all
+	// threads, write its alignments in input order, discard it. Memory use is bounded by the batch
+	// size, not by the size of the input.
+	size_t readPairs_perBatch = 500 * outerThreads;
+
+	auto alignReadPairs = [&](std::vector<oneReadPair>& readPairs, std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> >& alignments, size_t firstPairI, bool usePairing, double insertSize_mean, double insertSize_sd) -> void
 	{
+		// one slot per input pair, so that results come out in input order
+		alignments.clear();
+		alignments.resize(readPairs.size());
+
 		unsigned int pairI = 0;
 		unsigned int pairMax = readPairs.size();
 		#pragma omp parallel for schedule(dynamic)
@@ -1769,170 +1627,118 @@ void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::st
 			assert((tI >= 0) && (tI < outerThreads));
 
 			assert((pairI >= 0) && (pairI < readPairs.size()));
-			oneReadPair rP = readPairs.at(pairI);
+			oneReadPair& rP = readPairs.at(pairI);
 
 			assert((tI >= 0) && (tI < graphAligners.size()));
 
 			std::map<int, double> _IS_ignore;
-			std::pair<seedAndExtend_return_local, seedAndExtend_return_local> alignment_pair = graphAligners.at(tI)->seedAndExtend_local_paired_or_short(rP, usePairing, useShort, insertSize_mean, insertSize_sd, false, _IS_ignore);
-
-			alignments_perThread.at(tI).push_back(alignment_pair);
-			alignments_readPairI_perThread.at(tI).push_back(pairI);
+			alignments.at(pairI) = graphAligners.at(tI)->seedAndExtend_local_paired_or_short(rP, usePairing, useShort, insertSize_mean, insertSize_sd, false, _IS_ignore);
 
 			if(tI == 0)
 			{
-				std::cout  << Utilities::timestamp() << "\t\t" << "Thread " << tI << ": align pair " << pairI << "\n" << std::flush;
+				std::cout  << Utilities::timestamp() << "\t\t" << "Thread " << tI << ": align pair " << (firstPairI + pairI) << "\n" << std::flush;
 			}
 		}
 	};
 
+	// Get graph loci and reference positions
+	std::vector<int> uncompressed_graph_referencePositions;
+	std::vector<std::string> graphLoci = readGraphLoci(graphDir);
 
-
-	// auto printAlignmentsToFile = [&](std::string outputFilename, std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> >& alignments, std::vector<std::pair<std::string, std::string> > alignments_readIDs) -> void {
-	auto printAlignmentsToFile = [&](std::string outputFilename, std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> >& alignments, std::vector<oneReadPair>& originalReads, double insertSize_mean, double insertSize_sd) -> void {
-		std::ofstream outputStream;
-		outputStream.open(outputFilename.c_str());
-		assert(outputStream.is_open());
-
-		outputStream << "IS " << insertSize_mean << " " << insertSize_sd << "\n";
-
-		auto printOneRead = [&](seedAndExtend_return_local alignment, oneRead originalRead) -> void {
-			outputStream << "\t" << "Read " << originalRead.name << "\n";
-			outputStream << "\t\t" << alignment.Score << "\n";
-			outputStream << "\t\t" << alignment.reverse << "\n";
-			outputStream << "\t\t" << alignment.mapQ << " " << alignment.mapQ_genomic << "\n";
-			outputStream << "\t\t" << alignment.graph_aligned << "\n";
-			outputStream << "\t\t" << alignment.sequence_aligned << "\n";
-			outputStream << "\t\t" << Utilities::join(Utilities::ItoStr(alignment.graph_aligned_levels), " ") << "\n";
-			outputStream << "\t\t" << originalRead.sequence << "\n";
-			outputStream << "\t\t" << originalRead.quality << "\n";
-		};
-
-		for(unsigned int pairI = 0; pairI < alignments.size(); pairI++)
+	int lastReferencePosition = -1;
+	for(unsigned int i = 0; i < graphLoci.size(); i++)
+	{
+		std::string locusID = graphLoci.at(i);
+		std::vector<std::string> locusParts = Utilities::split(locusID, "_");
+		if(locusParts.size() != 3)
 		{
-			outputStream << "Aligned pair " << pairI << "\n";
-			printOneRead(alignments.at(pairI).first, originalReads.at(pairI).reads.first);
-			printOneRead(alignments.at(pairI).second, originalReads.at(pairI).reads.second);
+			throw std::runtime_error("alignShortReadsToHLAGraph(..): Cannot decompose locus ID " +locusID);
 		}
-		outputStream.close();
-	};
-
-
-	std::vector<std::string> FASTQ_files = Utilities::split(FASTQs, ",");
-	assert(inserSize_mean_sd_perFile.size() == FASTQ_files.size());
-
-	for(unsigned int fI = 0; fI < FASTQ_files.size(); fI++)
-	{
-		std::string FASTQ = FASTQ_files.at(fI);
-
-		std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph(..): Loading reads from " << FASTQ << ".\n" << std::flush;
-		std::vector<oneReadPair> combinedPairs_for_alignment = getReadsFromFastQ(FASTQ);
-
-		if(skipPairs_MOD != 1)
+		int thisLocus_refPos = Utilities::StrtoI(locusParts.at(2));
+		if(thisLocus_refPos != -1)
 		{
-			std::vector<oneReadPair> pairs_after_filtering;
-			for(unsigned int pairI = 0; pairI < combinedPairs_for_alignment.size(); pairI++)
-			{
-				if((pairI % skipPairs_MOD) == 0)
-				{
-					pairs_after_filtering.push_back(combinedPairs_for_alignment.at(pairI));
-				}
-			}
-			combinedPairs_for_alignment = pairs_after_filtering;
+			thisLocus_refPos = thisLocus_refPos + 1;
 		}
-
-		std::cout << "\t" << "Now align " << combinedPairs_for_alignment.size() << " read pairs." << "\n" << std::flush;
-
-		std::vector< std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>> > withPairing_alignments_perThread;
-		std::vector< std::vector<int> > withPairing_alignments_readPairI_perThread;
-
-		withPairing_alignments_perThread.resize(outerThreads);
-		withPairing_alignments_readPairI_perThread.resize(outerThreads);
-
-		alignReadPairs(combinedPairs_for_alignment, withPairing_alignments_perThread, withPairing_alignments_readPairI_perThread, true, inserSize_mean_sd_perFile.at(fI).first, inserSize_mean_sd_perFile.at(fI).second);
-
-		// merge
-
-		std::cout  << Utilities::timestamp() << "\t\t" << "All pairs aligned - merge.\n" << std::flush;
-
-		std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> > withPairing_alignments;
-		std::vector< int > withPairing_alignments_readPairI;
-		for(unsigned int tI = 0; (int)tI < outerThreads; tI++)
+		if((i == 0) || (lastReferencePosition != thisLocus_refPos))
 		{
-			withPairing_alignments.insert(withPairing_alignments.end(), withPairing_alignments_perThread.at(tI).begin(), withPairing_alignments_perThread.at(tI).end());
-			withPairing_alignments_readPairI.insert(withPairing_alignments_readPairI.end(), withPairing_alignments_readPairI_perThread.at(tI).begin(), withPairing_alignments_readPairI_perThread.at(tI).end());
+			uncompressed_graph_referencePositions.push_back(thisLocus_refPos);
+			lastReferencePosition = thisLocus_refPos;
 		}
-
-		// Produce normal output file
-		std::string alignments_output_file = FASTQ + ".aligned";
-		std::cout  << Utilities::timestamp() << "\t\t\t" << "Produce alignments file " << alignments_output_file << ".\n" << std::flush;
-
-		// std::vector<std::pair<std::string, std::string> > alignments_readIDs;
-		std::vector<oneReadPair> combinedPairs_for_alignment_inAlignmentOrder;
-		for(unsigned int pairII = 0; pairII < withPairing_alignments_readPairI.size(); pairII++)
+		else
 		{
-			int readPairI = withPairing_alignments_readPairI.at(pairII);
-			// std::string ID1 = combinedPairs_for_alignment.at(readPairI).reads.first.name;
-			// std::string ID2 = combinedPairs_for_alignment.at(readPairI).reads.second.name;
-			// alignments_readIDs.push_back(make_pair(ID1, ID2));
-			combinedPairs_for_alignment_inAlignmentOrder.push_back(combinedPairs_for_alignment.at(readPairI));
+			uncompressed_graph_referencePositions.push_back(-1);
 		}
+	}
 
-		assert(combinedPairs_for_alignment_inAlignmentOrder.size() == withPairing_alignments.size());
+	std::vector<std::string> FASTQ_files = Utilities::split(FASTQs, ",");
+	assert(inserSize_mean_sd_perFile.size() == FASTQ_files.size());
 
+	for(unsigned int fI = 0; fI < FASTQ_files.size(); fI++)
+	{
+		std::string FASTQ = FASTQ_files.at(fI);
+		double insertSize_mean = inserSize_mean_sd_perFile.at(fI).first;
+		double insertSize_sd = inserSize_mean_sd_perFile.at(fI).second;
 
-		printAlignmentsToFile(alignments_output_file, withPairing_alignments, combinedPairs_for_alignment_inAlignmentOrder, inserSize_mean_sd_perFile.at(fI).first, inserSize_mean_sd_perFile.at(fI).second);
+		std::cout << Utilities::timestamp() << "alignShortReadsToHLAGraph(..): Streaming reads from " << FASTQ << ".\n" << std::flush;
+		fastQPairReader FASTQ_reader(FASTQ);
 
+		// Normal output file
+		std::string alignments_output_file = FASTQ + ".aligned";
+		shortReadAlignmentsWriter alignmentsWriter(alignments_output_file, insertSize_mean, insertSize_sd, binaryAlignments);
 
-		// Produce SAM
+		// SAM
 		std::string SAM_output_file = FASTQ + ".sam";
-		std::cout  << Utilities::timestamp() << "\t\t\t" << "Produce SAM " << SAM_output_file << ".\n" << std::flush;
-
-
-		// Get graph loci and reference positions
 		std::ofstream SAM_output_stream;
 		SAM_output_stream.open(SAM_output_file.c_str());
 		assert(SAM_output_stream.is_open());
 
-		std::vector<int> uncompressed_graph_referencePositions;
-		std::vector<std::string> graphLoci = readGraphLoci(graphDir);
+		std::cout  << Utilities::timestamp() << "\t\t\t" << "Produce alignments file " << alignments_output_file << " and SAM " << SAM_output_file << ".\n" << std::flush;
 
-		int lastReferencePosition = -1;
-		for(unsigned int i = 0; i < graphLoci.size(); i++)
+		std::vector<oneReadPair> readPairs_batch;
+		std::vector<oneReadPair> readPairs_batch_for_alignment;
+		std::vector< std::pair<seedAndExtend_return_local, seedAndExtend_return_local> > withPairing_alignments;
+		size_t readPairs_read = 0;
+		size_t readPairs_aligned = 0;
+		while(FASTQ_reader.getPairs(readPairs_batch, readPairs_perBatch))
 		{
-			std::string locusID = graphLoci.at(i);
-			std::vector<std::string> locusParts = Utilities::split(locusID, "_");
-			if(locusParts.size() != 3)
+			readPairs_batch_for_alignment.clear();
+			for(unsigned int pairI = 0; pairI < readPairs_batch.size(); pairI++)
 			{
-				throw std::runtime_error("alignShortReadsToHLAGraph(..): Cannot decompose locus ID " +locusID);
-			}
-			int thisLocus_refPos = Utilities::StrtoI(locusParts.at(2));
-			if(thisLocus_refPos != -1)
-			{
-				thisLocus_refPos = thisLocus_refPos + 1;
-			}
-			if((i == 0) || (lastReferencePosition != thisLocus_refPos))
-			{
-				uncompressed_graph_referencePositions.push_back(thisLocus_refPos);
-				lastReferencePosition = thisLocus_refPos;
+				if(((readPairs_read + pairI) % skipPairs_MOD) == 0)
+				{
+					readPairs_batch_for_alignment.push_back(readPairs_batch.at(pairI));
+				}
 			}
-			else
+			readPairs_read += readPairs_batch.size();
+
+			std::cout << "\t" << "Now align " << readPairs_batch_for_alignment.size() << " read pairs (" << readPairs_aligned << " aligned so far)." << "\n" << std::flush;
+
+			alignReadPairs(readPairs_batch_for_alignment, withPairing_alignments, readPairs_aligned, true, insertSize_mean, insertSize_sd);
+
+			assert(withPairing_alignments.size() == readPairs_batch_for_alignment.size());
+			for(unsigned int pairI = 0; pairI < withPairing_alignments.size(); pairI++)
 			{
-				uncompressed_graph_referencePositions.push_back(-1);
+				alignmentsWriter.beginPair(readPairs_aligned + pairI);
+				alignmentsWriter.writeAlignmentPair(withPairing_alignments.at(pairI).first, readPairs_batch_for_alignment.at(pairI).reads.first, withPairing_alignments.at(pairI).second, readPairs_batch_for_alignment.at(pairI).reads.second);
 			}
+			alignedShortReads2SAM(SAM_output_stream, uncompressed_graph_referencePositions, referenceChromosomes.at("ref"), withPairing_alignments, readPairs_batch_for_alignment);
+
+			readPairs_aligned += readPairs_batch_for_alignment.size();
 		}
 
-		alignedShortReads2SAM(SAM_output_stream, uncompressed_graph_referencePositions, referenceChromosomes.at("ref"), withPairing_alignments, combinedPairs_for_alignment_inAlignmentOrder);
+		alignmentsWriter.close();
+		SAM_output_stream.close();
 
-		std::cout  << Utilities::timestamp() << "\t\t\t" << "Done. Output in " << SAM_output_file << ".\n" << std::flush;
+		std::cout  << Utilities::timestamp() << "\t\t\t" << "Done - aligned " << readPairs_aligned << " read pairs. Output in " << SAM_output_file << ".\n" << std::flush;
 	}
 
 	std::cout  << Utilities::timestamp() << "\t\t\t" << "All alignments done, free memory.\n" << std::flush;
 	for(int tI = 0; tI < outerThreads; tI++)
 	{
 		delete(graphAligners.at(tI));
-		delete(graphs.at(tI));
 	}
+	alignmentContext.reset();
+	delete(g);
 }
 
 
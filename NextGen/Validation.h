@@ -12,6 +12,7 @@
 #include <vector>
 #include <set>
 #include <map>
+#include <fstream>
 #include "../Graph/Graph.h"
 
 #include "../NextGen/readSimulator.h"
@@ -43,8 +44,8 @@ void validateCompleteVCF(std::string VCFfile, std::string referenceGenome, std::
 void validateAmendedChromotypesVsVCF(std::string amended_chromotypes_file, int chromotypes_startCoordinate, int chromotypes_stopCoordinate, std::string VCFfile, int VCF_minRange, int VCF_maxRange, std::string referenceGenome, std::string deBruijnGraph, int kMer_size, int cortex_height, int cortex_width);
 void validateAllChromotypesVsVCF(std::string chromotypes_file, std::string amended_chromotypes_file, int chromotypes_startCoordinate, int chromotypes_stopCoordinate, std::string VCFfile, int VCF_minRange, int VCF_maxRange, std::string referenceGenome, std::string deBruijnGraph, int kMer_size, int cortex_height, int cortex_width, std::string outputDirectory, std::string graphDir);
 void alignContigsToAllChromotypes(std::string chromotypes_file, std::string amended_chromotypes_file, int chromotypes_startCoordinate, int chromotypes_stopCoordinate, std::string VCFfile, int VCF_minRange, int VCF_maxRange, std::string referenceGenome, std::string deBruijnGraph, int kMer_size, int cortex_height, int cortex_width, std::string outputDir_contigs, std::string contigsFile_Fasta, std::string graphDir);
-void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::string referenceGenome, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile);
-void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool debug = false, bool MiSeq250bp = false);
+void alignShortReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::string referenceGenome, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool binaryAlignments = false);
+void alignShortReadsToHLAGraph_multipleAlignments(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile, std::vector<std::pair<double, double>> inserSize_mean_sd_perFile, bool debug = false, bool MiSeq250bp = false, bool binaryAlignments = false);
 void alignLongUnpairedReadsToHLAGraph(std::string FASTQs, std::string graphDir, std::string referenceGenomeFile);
 
 void vennDiagrams(std::vector<std::string> setNames, std::vector<std::set<std::string>*> kMers, std::vector<std::set<std::string>*> kMers_present, std::vector<std::map<std::string, double>* > kMer_optimalities, std::string outputFile);
@@ -62,6 +63,23 @@ std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_base_path);
 std::vector<oneReadPair> getReadsFromFastQ(std::string fastq_1_path, std::string fastq_2_path);
 std::vector<oneRead> getUnpairedReadsFromFastQ(std::string fastq_path);
 
+// Reads read pairs from two FASTQ files (or <base>_1 and <base>_2) batch by batch, so that
+// input files don't have to be held in memory as a whole.
+class fastQPairReader {
+protected:
+	std::ifstream fastQ_1_stream;
+	std::ifstream fastQ_2_stream;
+
+	bool getRead(std::ifstream& inputStream, std::string& ret_readID, std::string& ret_sequence, std::string& ret_qualities);
+
+public:
+	fastQPairReader(std::string fastq_base_path);
+	fastQPairReader(std::string fastq_1_path, std::string fastq_2_path);
+
+	// replaces the contents of batch with the next (up to) maxPairs pairs; returns the number of pairs read, 0 at the end of the input
+	size_t getPairs(std::vector<oneReadPair>& batch, size_t maxPairs);
+};
+
 void read_shortReadAlignments_fromFile (std::string file, std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>>& ret_alignments, std::vector<oneReadPair>& ret_alignments_originalReads, double& ret_IS_mean, double& ret_IS_sd);
 void read_longReadAlignments_fromFile (std::string file, std::vector<seedAndExtend_return_local>& ret_alignments, std::vector<oneRead>& ret_alignments_originalReads);
 
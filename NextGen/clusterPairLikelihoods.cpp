@@ -0,0 +1,705 @@
+/*
+ * clusterPairLikelihoods.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "clusterPairLikelihoods.h"
+
+#include <assert.h>
+#include <cmath>
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <functional>
+#include <limits>
+#include <unordered_map>
+#include <stdexcept>
+#include <immintrin.h>
+#include <omp.h>
+
+namespace {
+
+// logAvg(a, b) = max(a, b) + log(0.5) + log1p(exp(-|a - b|)); beyond |a - b| = 40 the last term is
+// below 5e-18 and the difference is clamped.
+const double logAvg_maxDifference = 40;
+const double logAvg_logHalf = -0.69314718055994530942;
+
+// exp(x) = 2^n * exp(r), x = n * log(2) + r, |r| <= log(2) / 2
+const double exp_log2e = 1.44269504088896338700;
+const double exp_ln2_hi = 6.93147180369123816490e-01;
+const double exp_ln2_lo = 1.90821492927058770002e-10;
+const int exp_terms = 12;
+const double exp_coefficients[exp_terms] = {
+	1.0,
+	1.0,
+	1.0 / 2,
+	1.0 / 6,
+	1.0 / 24,
+	1.0 / 120,
+	1.0 / 720,
+	1.0 / 5040,
+	1.0 / 40320,
+	1.0 / 362880,
+	1.0 / 3628800,
+	1.0 / 39916800
+};
+
+// computeTopPairs(..) keeps pairs within log(#pairs) + topPairs_posteriorMargin of the best pair
+const double topPairs_posteriorMargin = 40;
+
+// log1p(e) = 2 * atanh(s), s = e / (2 + e) <= 1/3 for e <= 1
+const int log1p_terms = 14;
+
+enum clusterPairLikelihoods_instructionSet {clusterPairLikelihoods_scalar, clusterPairLikelihoods_AVX2};
+
+clusterPairLikelihoods_instructionSet selectInstructionSet()
+{
+	if(__builtin_cpu_supports("avx2"))
+		return clusterPairLikelihoods_AVX2;
+	return clusterPairLikelihoods_scalar;
+}
+
+clusterPairLikelihoods_instructionSet instructionSet()
+{
+	static clusterPairLikelihoods_instructionSet selected = selectInstructionSet();
+	return selected;
+}
+
+// scalar
+
+inline double logAvg_scalar(double a, double b)
+{
+	double maximum = ((a > b) ? a : b);
+	double d = std::fabs(a - b);
+	d = ((d < logAvg_maxDifference) ? d : logAvg_maxDifference);
+	double x = -d;
+
+	double n = std::nearbyint(x * exp_log2e);
+	double r = (x - n * exp_ln2_hi) - n * exp_ln2_lo;
+	double p = exp_coefficients[exp_terms - 1];
+	for(int i = exp_terms - 2; i >= 0; i--)
+	{
+		p = p * r + exp_coefficients[i];
+	}
+	int64_t pow2n_bits = ((int64_t)((int)n + 1023)) << 52;
+	double pow2n;
+	memcpy(&pow2n, &pow2n_bits, sizeof(double));
+	double e = p * pow2n;
+
+	double s = e / (2.0 + e);
+	double z = s * s;
+	double q = 1.0 / (2 * (log1p_terms - 1) + 1);
+	for(int i = log1p_terms - 2; i >= 0; i--)
+	{
+		q = q * z + 1.0 / (2 * i + 1);
+	}
+	double g = (2.0 * s) * q;
+
+	return logAvg_logHalf + (g + maximum);
+}
+
+// sum of w[i] * logAvg(a[i], b[i]), in four interleaved lanes like the AVX2 kernel
+double logAvgSum_scalar(const double* a, const double* b, const double* w, size_t n)
+{
+	double lanes[4] = {0, 0, 0, 0};
+	size_t i = 0;
+	for(; (i + 4) <= n; i += 4)
+	{
+		for(int l = 0; l < 4; l++)
+		{
+			lanes[l] += w[i + l] * logAvg_scalar(a[i + l], b[i + l]);
+		}
+	}
+	double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for(; i < n; i++)
+	{
+		sum += w[i] * logAvg_scalar(a[i], b[i]);
+	}
+	return sum;
+}
+
+// sum of w[i] * max(a[i], b[i]), an upper bound for the sum of w[i] * logAvg(a[i], b[i])
+double maxSum_scalar(const double* a, const double* b, const double* w, size_t n)
+{
+	double lanes[4] = {0, 0, 0, 0};
+	size_t i = 0;
+	for(; (i + 4) <= n; i += 4)
+	{
+		for(int l = 0; l < 4; l++)
+		{
+			lanes[l] += w[i + l] * ((a[i + l] > b[i + l]) ? a[i + l] : b[i + l]);
+		}
+	}
+	double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for(; i < n; i++)
+	{
+		sum += w[i] * ((a[i] > b[i]) ? a[i] : b[i]);
+	}
+	return sum;
+}
+
+// sum of w[i] * min(a[i], b[i]); weights are integers, so sums stay exact below 2^53
+double minSum_scalar(const int* a, const int* b, const double* w, size_t n)
+{
+	double sum = 0;
+	for(size_t i = 0; i < n; i++)
+	{
+		sum += w[i] * ((a[i] < b[i]) ? a[i] : b[i]);
+	}
+	return sum;
+}
+
+// AVX2
+
+__attribute__((target("avx2"))) double logAvgSum_avx2(const double* a, const double* b, const double* w, size_t n)
+{
+	const __m256d signMask = _mm256_set1_pd(-0.0);
+	const __m256d maxDifference = _mm256_set1_pd(logAvg_maxDifference);
+	const __m256d logHalf = _mm256_set1_pd(logAvg_logHalf);
+	const __m256d log2e = _mm256_set1_pd(exp_log2e);
+	const __m256d ln2_hi = _mm256_set1_pd(exp_ln2_hi);
+	const __m256d ln2_lo = _mm256_set1_pd(exp_ln2_lo);
+	const __m256d two = _mm256_set1_pd(2.0);
+	const __m256i exponentBias = _mm256_set1_epi64x(1023);
+
+	__m256d sum = _mm256_setzero_pd();
+	size_t i = 0;
+	for(; (i + 4) <= n; i += 4)
+	{
+		__m256d va = _mm256_loadu_pd(a + i);
+		__m256d vb = _mm256_loadu_pd(b + i);
+		__m256d maximum = _mm256_max_pd(va, vb);
+		__m256d d = _mm256_andnot_pd(signMask, _mm256_sub_pd(va, vb));
+		d = _mm256_min_pd(d, maxDifference);
+		__m256d x = _mm256_xor_pd(d, signMask);
+
+		__m256d nd = _mm256_round_pd(_mm256_mul_pd(x, log2e), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+		__m256d r = _mm256_sub_pd(_mm256_sub_pd(x, _mm256_mul_pd(nd, ln2_hi)), _mm256_mul_pd(nd, ln2_lo));
+		__m256d p = _mm256_set1_pd(exp_coefficients[exp_terms - 1]);
+		for(int cI = exp_terms - 2; cI >= 0; cI--)
+		{
+			p = _mm256_add_pd(_mm256_mul_pd(p, r), _mm256_set1_pd(exp_coefficients[cI]));
+		}
+		__m256i n64 = _mm256_cvtepi32_epi64(_mm256_cvtpd_epi32(nd));
+		__m256d pow2n = _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_add_epi64(n64, exponentBias), 52));
+		__m256d e = _mm256_mul_pd(p, pow2n);
+
+		__m256d s = _mm256_div_pd(e, _mm256_add_pd(two, e));
+		__m256d z = _mm256_mul_pd(s, s);
+		__m256d q = _mm256_set1_pd(1.0 / (2 * (log1p_terms - 1) + 1));
+		for(int cI = log1p_terms - 2; cI >= 0; cI--)
+		{
+			q = _mm256_add_pd(_mm256_mul_pd(q, z), _mm256_set1_pd(1.0 / (2 * cI + 1)));
+		}
+		__m256d g = _mm256_mul_pd(_mm256_mul_pd(two, s), q);
+
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(w + i), _mm256_add_pd(logHalf, _mm256_add_pd(g, maximum))));
+	}
+
+	double lanes[4];
+	_mm256_storeu_pd(lanes, sum);
+	double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for(; i < n; i++)
+	{
+		total += w[i] * logAvg_scalar(a[i], b[i]);
+	}
+	return total;
+}
+
+__attribute__((target("avx2"))) double maxSum_avx2(const double* a, const double* b, const double* w, size_t n)
+{
+	__m256d sum = _mm256_setzero_pd();
+	size_t i = 0;
+	for(; (i + 4) <= n; i += 4)
+	{
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(w + i), _mm256_max_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i))));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, sum);
+	double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	for(; i < n; i++)
+	{
+		total += w[i] * ((a[i] > b[i]) ? a[i] : b[i]);
+	}
+	return total;
+}
+
+__attribute__((target("avx2"))) double minSum_avx2(const int* a, const int* b, const double* w, size_t n)
+{
+	__m256d sum = _mm256_setzero_pd();
+	size_t i = 0;
+	for(; (i + 4) <= n; i += 4)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+		__m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+		__m256d m = _mm256_cvtepi32_pd(_mm_min_epi32(va, vb));
+		sum = _mm256_add_pd(sum, _mm256_mul_pd(_mm256_loadu_pd(w + i), m));
+	}
+	double lanes[4];
+	_mm256_storeu_pd(lanes, sum);
+	double total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+	return total + minSum_scalar(a + i, b + i, w + i, n - i);
+}
+
+double logAvgSum(const double* a, const double* b, const double* w, size_t n)
+{
+	if(instructionSet() == clusterPairLikelihoods_AVX2)
+		return logAvgSum_avx2(a, b, w, n);
+	return logAvgSum_scalar(a, b, w, n);
+}
+
+double maxSum(const double* a, const double* b, const double* w, size_t n)
+{
+	if(instructionSet() == clusterPairLikelihoods_AVX2)
+		return maxSum_avx2(a, b, w, n);
+	return maxSum_scalar(a, b, w, n);
+}
+
+double minSum(const int* a, const int* b, const double* w, size_t n)
+{
+	if(instructionSet() == clusterPairLikelihoods_AVX2)
+		return minSum_avx2(a, b, w, n);
+	return minSum_scalar(a, b, w, n);
+}
+
+// FNV-1a over the bits of a profile
+inline uint64_t profileHash(uint64_t h, uint64_t bits)
+{
+	return (h ^ bits) * 1099511628211ULL;
+}
+
+}
+
+double clusterPairLikelihoods_logAvg(double a, double b)
+{
+	return logAvg_scalar(a, b);
+}
+
+const char* clusterPairLikelihoods_kernelName()
+{
+	switch(instructionSet())
+	{
+		case clusterPairLikelihoods_AVX2:
+			return "AVX2";
+		default:
+			return "scalar";
+	}
+}
+
+clusterPairLikelihoods::clusterPairLikelihoods(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::set<size_t>& ignoreReads)
+{
+	compact(likelihoods_perCluster_perRead, 0, ignoreReads);
+}
+
+clusterPairLikelihoods::clusterPairLikelihoods(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::vector<std::vector<int> >& mismatches_perCluster_perRead, const std::set<size_t>& ignoreReads)
+{
+	compact(likelihoods_perCluster_perRead, &mismatches_perCluster_perRead, ignoreReads);
+}
+
+void clusterPairLikelihoods::compact(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::vector<std::vector<int> >* mismatches_perCluster_perRead, const std::set<size_t>& ignoreReads)
+{
+	clusters = likelihoods_perCluster_perRead.size();
+	size_t allReads = (clusters ? likelihoods_perCluster_perRead.at(0).size() : 0);
+	for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+	{
+		assert(likelihoods_perCluster_perRead.at(clusterI).size() == allReads);
+	}
+	if(mismatches_perCluster_perRead)
+	{
+		assert(mismatches_perCluster_perRead->size() == clusters);
+		mismatches_total.assign(clusters, 0);
+		for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+		{
+			assert(mismatches_perCluster_perRead->at(clusterI).size() == allReads);
+		}
+	}
+
+	reads = 0;
+	weights.clear();
+	constant_LL = 0;
+	constant_mismatches = 0;
+
+	// one column per distinct (likelihood, mismatch) profile across clusters, weighted by its number of
+	// reads. Profiles that are the same for all clusters add the same amount to every pair and are
+	// only kept as an offset.
+	std::vector<double> unique_LL;
+	std::vector<int> unique_mismatches;
+	std::unordered_map<uint64_t, std::vector<size_t> > profileHash_2_columns;
+	std::vector<double> profile_LL(clusters);
+	std::vector<int> profile_mismatches(mismatches_perCluster_perRead ? clusters : 0);
+	for(size_t readI = 0; readI < allReads; readI++)
+	{
+		if(ignoreReads.count(readI))
+			continue;
+		reads++;
+
+		bool constant = true;
+		uint64_t h = 14695981039346656037ULL;
+		for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+		{
+			double v = likelihoods_perCluster_perRead[clusterI][readI];
+			assert(! std::isnan(v));
+			profile_LL[clusterI] = v;
+			constant = constant && (v == profile_LL[0]);
+
+			uint64_t v_bits;
+			memcpy(&v_bits, &v, sizeof(double));
+			h = profileHash(h, v_bits);
+		}
+		if(mismatches_perCluster_perRead)
+		{
+			for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+			{
+				int m = (*mismatches_perCluster_perRead)[clusterI][readI];
+				profile_mismatches[clusterI] = m;
+				mismatches_total[clusterI] += m;
+				constant = constant && (m == profile_mismatches[0]);
+				h = profileHash(h, (uint32_t)m);
+			}
+		}
+
+		if(constant)
+		{
+			constant_LL += logAvg_scalar(profile_LL[0], profile_LL[0]);
+			if(mismatches_perCluster_perRead)
+			{
+				constant_mismatches += profile_mismatches[0];
+			}
+			continue;
+		}
+
+		std::vector<size_t>& candidateColumns = profileHash_2_columns[h];
+		bool found = false;
+		for(size_t cI = 0; cI < candidateColumns.size(); cI++)
+		{
+			size_t columnI = candidateColumns.at(cI);
+			bool equal = (memcmp(&(unique_LL[columnI * clusters]), profile_LL.data(), clusters * sizeof(double)) == 0);
+			if(equal && mismatches_perCluster_perRead)
+			{
+				equal = (memcmp(&(unique_mismatches[columnI * clusters]), profile_mismatches.data(), clusters * sizeof(int)) == 0);
+			}
+			if(equal)
+			{
+				weights.at(columnI) += 1;
+				found = true;
+				break;
+			}
+		}
+		if(! found)
+		{
+			candidateColumns.push_back(weights.size());
+			weights.push_back(1);
+			unique_LL.insert(unique_LL.end(), profile_LL.begin(), profile_LL.end());
+			unique_mismatches.insert(unique_mismatches.end(), profile_mismatches.begin(), profile_mismatches.end());
+		}
+	}
+	columns = weights.size();
+
+	// cluster-major for the kernels
+	LL.resize(clusters * columns);
+	mismatches.resize(mismatches_perCluster_perRead ? (clusters * columns) : 0);
+	for(size_t columnI = 0; columnI < columns; columnI++)
+	{
+		for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+		{
+			LL[clusterI * columns + columnI] = unique_LL[columnI * clusters + clusterI];
+			if(mismatches_perCluster_perRead)
+			{
+				mismatches[clusterI * columns + columnI] = unique_mismatches[columnI * clusters + clusterI];
+			}
+		}
+	}
+}
+
+double clusterPairLikelihoods::pairLogLikelihood(size_t clusterI1, size_t clusterI2) const
+{
+	assert(clusterI1 < clusters);
+	assert(clusterI2 < clusters);
+	double forReturn = 0;
+	for(size_t readStart = 0; readStart < columns; readStart += tileReads)
+	{
+		size_t n = std::min(tileReads, columns - readStart);
+		forReturn += logAvgSum(&(LL[clusterI1 * columns + readStart]), &(LL[clusterI2 * columns + readStart]), &(weights[readStart]), n);
+	}
+	return forReturn + constant_LL;
+}
+
+size_t clusterPairLikelihoods::computeTopPairs(size_t K, std::vector<std::pair<unsigned int, unsigned int> >& ret_clusterIs, std::vector<double>& ret_LL, std::vector<double>* ret_mismatches_avg, std::vector<double>* ret_mismatches_min) const
+{
+	bool withMismatches = ((ret_mismatches_avg != 0) || (ret_mismatches_min != 0));
+	if(withMismatches && (mismatches_total.size() != clusters))
+	{
+		throw std::runtime_error("clusterPairLikelihoods::computeTopPairs(..): no mismatches available.");
+	}
+	assert(K > 0);
+
+	ret_clusterIs.clear();
+	ret_LL.clear();
+	if(ret_mismatches_avg)
+		ret_mismatches_avg->clear();
+	if(ret_mismatches_min)
+		ret_mismatches_min->clear();
+	if(clusters == 0)
+		return 0;
+
+	size_t pairs = (clusters * (clusters + 1)) / 2;
+	double margin = log((double)pairs) + topPairs_posteriorMargin;
+
+	// the bounds are partial sums over a prefix of the reads; the remaining reads can add at most
+	// their positive parts (0 for proper log-likelihoods)
+	std::vector<double> positive_suffix(columns + 1, 0);
+	for(size_t readI = columns; readI > 0; readI--)
+	{
+		double readMax = 0;
+		for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+		{
+			readMax = std::max(readMax, LL[clusterI * columns + (readI - 1)]);
+		}
+		positive_suffix.at(readI - 1) = positive_suffix.at(readI) + weights.at(readI - 1) * readMax;
+	}
+
+	// visit clusters (and partners) by decreasing single-cluster likelihood, so that good pairs set a high cutoff early
+	std::vector<double> clusterLL(clusters, 0);
+	for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+	{
+		clusterLL.at(clusterI) = std::inner_product(LL.begin() + clusterI * columns, LL.begin() + (clusterI + 1) * columns, weights.begin(), 0.0);
+	}
+	std::vector<size_t> clusters_ordered(clusters);
+	for(size_t clusterI = 0; clusterI < clusters; clusterI++)
+	{
+		clusters_ordered.at(clusterI) = clusterI;
+	}
+	std::stable_sort(clusters_ordered.begin(), clusters_ordered.end(), [&](size_t a, size_t b){
+		return (clusterLL.at(a) > clusterLL.at(b));
+	});
+
+	// cutoff = min(K-th best, best - margin) over the pairs evaluated so far; it only increases,
+	// so a stale value read by another thread prunes less, never wrongly
+	std::priority_queue<double, std::vector<double>, std::greater<double> > topK;
+	double best = -std::numeric_limits<double>::infinity();
+	double cutoff = -std::numeric_limits<double>::infinity();
+	size_t evaluated = 0;
+
+	std::vector<std::vector<std::pair<std::pair<unsigned int, unsigned int>, double> > > evaluated_perRank(clusters);
+
+	long long clusters_signed = clusters;
+	#pragma omp parallel for schedule(dynamic)
+	for(long long rankI = 0; rankI < clusters_signed; rankI++)
+	{
+		size_t clusterI1 = clusters_ordered.at(rankI);
+		const double* LL_1 = &(LL[clusterI1 * columns]);
+		for(size_t rankJ = rankI; rankJ < clusters; rankJ++)
+		{
+			size_t clusterI2 = clusters_ordered.at(rankJ);
+			const double* LL_2 = &(LL[clusterI2 * columns]);
+
+			double currentCutoff;
+			#pragma omp atomic read
+			currentCutoff = cutoff;
+
+			// slack for rounding and the logAvg approximation
+			double slack = 1e-6 * (1 + std::fabs(currentCutoff));
+
+			// cheap bound: logAvg(a, b) <= max(a, b)
+			bool pruned = false;
+			double bound = constant_LL;
+			for(size_t blockStart = 0; blockStart < columns; blockStart += boundBlockReads)
+			{
+				size_t n = std::min(boundBlockReads, columns - blockStart);
+				bound += maxSum(LL_1 + blockStart, LL_2 + blockStart, &(weights[blockStart]), n);
+				if((bound + positive_suffix[blockStart + n] + slack) < currentCutoff)
+				{
+					pruned = true;
+					break;
+				}
+			}
+			if(pruned)
+				continue;
+
+			// exact, chunked like computeAllPairs(..)
+			double pair_LL = 0;
+			for(size_t readStart = 0; readStart < columns; readStart += tileReads)
+			{
+				size_t n = std::min(tileReads, columns - readStart);
+				pair_LL += logAvgSum(LL_1 + readStart, LL_2 + readStart, &(weights[readStart]), n);
+				if((pair_LL + constant_LL + positive_suffix[readStart + n] + slack) < currentCutoff)
+				{
+					pruned = true;
+					break;
+				}
+			}
+			if(pruned)
+				continue;
+			pair_LL += constant_LL;
+
+			std::pair<unsigned int, unsigned int> clusterIs = std::make_pair((unsigned int)std::min(clusterI1, clusterI2), (unsigned int)std::max(clusterI1, clusterI2));
+			evaluated_perRank.at(rankI).push_back(std::make_pair(clusterIs, pair_LL));
+
+			#pragma omp critical(clusterPairLikelihoods_topPairs)
+			{
+				evaluated++;
+				topK.push(pair_LL);
+				if(topK.size() > K)
+				{
+					topK.pop();
+				}
+				best = std::max(best, pair_LL);
+
+				double newCutoff = (topK.size() == K) ? std::min(topK.top(), best - margin) : -std::numeric_limits<double>::infinity();
+				#pragma omp atomic write
+				cutoff = newCutoff;
+			}
+		}
+	}
+
+	// every pair above the final cutoff has been evaluated, so the selection doesn't depend on the schedule
+	std::vector<std::pair<std::pair<unsigned int, unsigned int>, double> > selected;
+	for(size_t rankI = 0; rankI < clusters; rankI++)
+	{
+		for(size_t pI = 0; pI < evaluated_perRank.at(rankI).size(); pI++)
+		{
+			if(evaluated_perRank.at(rankI).at(pI).second >= cutoff)
+			{
+				selected.push_back(evaluated_perRank.at(rankI).at(pI));
+			}
+		}
+	}
+	std::sort(selected.begin(), selected.end());
+	for(size_t pI = 0; pI < selected.size(); pI++)
+	{
+		ret_clusterIs.push_back(selected.at(pI).first);
+		ret_LL.push_back(selected.at(pI).second);
+	}
+
+	for(size_t pairI = 0; pairI < ret_clusterIs.size(); pairI++)
+	{
+		size_t clusterI1 = ret_clusterIs.at(pairI).first;
+		size_t clusterI2 = ret_clusterIs.at(pairI).second;
+		if(ret_mismatches_avg)
+		{
+			ret_mismatches_avg->push_back((mismatches_total.at(clusterI1) + mismatches_total.at(clusterI2)) / 2.0);
+		}
+		if(ret_mismatches_min)
+		{
+			double mismatches_min = 0;
+			for(size_t readStart = 0; readStart < columns; readStart += tileReads)
+			{
+				size_t n = std::min(tileReads, columns - readStart);
+				mismatches_min += minSum(&(mismatches[clusterI1 * columns + readStart]), &(mismatches[clusterI2 * columns + readStart]), &(weights[readStart]), n);
+			}
+			mismatches_min += constant_mismatches;
+			ret_mismatches_min->push_back(mismatches_min);
+		}
+	}
+
+	return evaluated;
+}
+
+void clusterPairLikelihoods::computeAllPairs(std::vector<std::pair<unsigned int, unsigned int> >& ret_clusterIs, std::vector<double>& ret_LL, std::vector<double>* ret_mismatches_avg, std::vector<double>* ret_mismatches_min) const
+{
+	bool withMismatches = ((ret_mismatches_avg != 0) || (ret_mismatches_min != 0));
+	if(withMismatches && (mismatches_total.size() != clusters))
+	{
+		throw std::runtime_error("clusterPairLikelihoods::computeAllPairs(..): no mismatches available.");
+	}
+
+	// pair (clusterI1, clusterI2) is at pairsBefore(clusterI1) + (clusterI2 - clusterI1)
+	auto pairsBefore = [&](size_t clusterI1) -> size_t {
+		return clusterI1 * clusters - (clusterI1 * (clusterI1 - 1)) / 2;
+	};
+	size_t pairs = (clusters * (clusters + 1)) / 2;
+
+	ret_clusterIs.resize(pairs);
+	ret_LL.assign(pairs, 0);
+	std::vector<double> mismatches_min(withMismatches ? pairs : 0, 0);
+
+	for(size_t clusterI1 = 0; clusterI1 < clusters; clusterI1++)
+	{
+		for(size_t clusterI2 = clusterI1; clusterI2 < clusters; clusterI2++)
+		{
+			ret_clusterIs.at(pairsBefore(clusterI1) + (clusterI2 - clusterI1)) = std::make_pair((unsigned int)clusterI1, (unsigned int)clusterI2);
+		}
+	}
+
+	// one task per tile pair (tile1 <= tile2); each task owns the output slots of its pairs
+	size_t tiles = (clusters + tileClusters - 1) / tileClusters;
+	std::vector<std::pair<size_t, size_t> > tasks;
+	for(size_t tile1 = 0; tile1 < tiles; tile1++)
+	{
+		for(size_t tile2 = tile1; tile2 < tiles; tile2++)
+		{
+			tasks.push_back(std::make_pair(tile1, tile2));
+		}
+	}
+
+	long long tasks_signed = tasks.size();
+	#pragma omp parallel for schedule(dynamic)
+	for(long long taskI = 0; taskI < tasks_signed; taskI++)
+	{
+		size_t first1 = tasks.at(taskI).first * tileClusters;
+		size_t stop1 = std::min(first1 + tileClusters, clusters);
+		size_t first2 = tasks.at(taskI).second * tileClusters;
+		size_t stop2 = std::min(first2 + tileClusters, clusters);
+
+		double tile_LL[tileClusters][tileClusters];
+		double tile_min[tileClusters][tileClusters];
+		for(size_t i = 0; i < tileClusters; i++)
+		{
+			for(size_t j = 0; j < tileClusters; j++)
+			{
+				tile_LL[i][j] = 0;
+				tile_min[i][j] = 0;
+			}
+		}
+
+		for(size_t readStart = 0; readStart < columns; readStart += tileReads)
+		{
+			size_t n = std::min(tileReads, columns - readStart);
+			for(size_t clusterI1 = first1; clusterI1 < stop1; clusterI1++)
+			{
+				const double* LL_1 = &(LL[clusterI1 * columns + readStart]);
+				for(size_t clusterI2 = std::max(first2, clusterI1); clusterI2 < stop2; clusterI2++)
+				{
+					const double* LL_2 = &(LL[clusterI2 * columns + readStart]);
+					tile_LL[clusterI1 - first1][clusterI2 - first2] += logAvgSum(LL_1, LL_2, &(weights[readStart]), n);
+					if(withMismatches)
+					{
+						tile_min[clusterI1 - first1][clusterI2 - first2] += minSum(&(mismatches[clusterI1 * columns + readStart]), &(mismatches[clusterI2 * columns + readStart]), &(weights[readStart]), n);
+					}
+				}
+			}
+		}
+
+		for(size_t clusterI1 = first1; clusterI1 < stop1; clusterI1++)
+		{
+			for(size_t clusterI2 = std::max(first2, clusterI1); clusterI2 < stop2; clusterI2++)
+			{
+				size_t pairI = pairsBefore(clusterI1) + (clusterI2 - clusterI1);
+				ret_LL.at(pairI) = tile_LL[clusterI1 - first1][clusterI2 - first2] + constant_LL;
+				if(withMismatches)
+				{
+					mismatches_min.at(pairI) = tile_min[clusterI1 - first1][clusterI2 - first2] + constant_mismatches;
+				}
+			}
+		}
+	}
+
+	if(ret_mismatches_avg)
+	{
+		ret_mismatches_avg->resize(pairs);
+		for(size_t pairI = 0; pairI < pairs; pairI++)
+		{
+			ret_mismatches_avg->at(pairI) = (mismatches_total.at(ret_clusterIs.at(pairI).first) + mismatches_total.at(ret_clusterIs.at(pairI).second)) / 2.0;
+		}
+	}
+	if(ret_mismatches_min)
+	{
+		ret_mismatches_min->resize(pairs);
+		for(size_t pairI = 0; pairI < pairs; pairI++)
+		{
+			ret_mismatches_min->at(pairI) = mismatches_min.at(pairI);
+		}
+	}
+}
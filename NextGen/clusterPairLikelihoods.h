@@ -0,0 +1,84 @@
+/*
+ * clusterPairLikelihoods.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef CLUSTERPAIRLIKELIHOODS_H_
+#define CLUSTERPAIRLIKELIHOODS_H_
+
+#include <vector>
+#include <set>
+#include <utility>
+#include <stddef.h>
+#include <stdint.h>
+
+// Likelihoods of all unordered pairs of HLA type clusters, as used by HLATypeInference(..):
+// the log-likelihood of a pair is the sum over reads of logAvg(LL(read | cluster 1), LL(read | cluster 2)).
+//
+// The per-cluster read log-likelihoods are compacted into a dense cluster x column matrix: ignored
+// reads are removed, reads with identical likelihood (and mismatch) profiles across all clusters
+// share one column weighted by their number, and reads with the same profile for every cluster are
+// folded into a constant. Pairs are evaluated in tiles of tileClusters x tileClusters clusters and
+// tileReads columns, so that the rows of a tile stay in L2, with AVX2 lanes (selected at runtime,
+// scalar otherwise). logAvg uses a branch-free exp / log1p approximation; its absolute error per
+// read is below 1e-14, and the scalar path does the same operations in the same order, so results
+// don't depend on the instruction set.
+
+class clusterPairLikelihoods {
+protected:
+	size_t clusters;
+	size_t reads;
+	size_t columns;
+	std::vector<double> LL;
+	std::vector<int> mismatches;
+	std::vector<double> weights;
+	double constant_LL;
+	double constant_mismatches;
+	std::vector<double> mismatches_total;
+
+	void compact(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::vector<std::vector<int> >* mismatches_perCluster_perRead, const std::set<size_t>& ignoreReads);
+
+public:
+	static const size_t tileClusters = 16;
+	static const size_t tileReads = 2048;
+	static const size_t boundBlockReads = 256;
+
+	clusterPairLikelihoods(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::set<size_t>& ignoreReads);
+	clusterPairLikelihoods(const std::vector<std::vector<double> >& likelihoods_perCluster_perRead, const std::vector<std::vector<int> >& mismatches_perCluster_perRead, const std::set<size_t>& ignoreReads);
+
+	size_t getClusters() const
+	{
+		return clusters;
+	}
+	size_t getReads() const
+	{
+		return reads;
+	}
+	size_t getColumns() const
+	{
+		return columns;
+	}
+
+	// all pairs clusterI1 <= clusterI2, ordered by clusterI1, then clusterI2. Mismatch statistics
+	// (sum over reads of the average and of the minimum of the two clusters' mismatches) are only
+	// available if mismatches were given; pass 0 to skip them.
+	void computeAllPairs(std::vector<std::pair<unsigned int, unsigned int> >& ret_clusterIs, std::vector<double>& ret_LL, std::vector<double>* ret_mismatches_avg, std::vector<double>* ret_mismatches_min) const;
+
+	// Branch-and-bound search for the best pairs. Returns, in the order of computeAllPairs(..), all
+	// pairs with a log-likelihood of at least min(K-th best, best - margin), margin = log(#pairs) + 40 -
+	// i.e. the top K pairs plus everything that carries more than e^-40 of the posterior mass of the best
+	// pair. Likelihoods of returned pairs are identical to computeAllPairs(..). Candidate partners are
+	// visited in order of single-cluster likelihood, and a pair is abandoned as soon as an upper bound
+	// (sum of max(LL1, LL2), then the running exact sum) falls below the current cutoff.
+	// Returns the number of pairs whose likelihood was evaluated exactly.
+	size_t computeTopPairs(size_t K, std::vector<std::pair<unsigned int, unsigned int> >& ret_clusterIs, std::vector<double>& ret_LL, std::vector<double>* ret_mismatches_avg, std::vector<double>* ret_mismatches_min) const;
+
+	double pairLogLikelihood(size_t clusterI1, size_t clusterI2) const;
+};
+
+// the approximation of Utilities::logAvg(a, b) used by the kernels
+double clusterPairLikelihoods_logAvg(double a, double b);
+const char* clusterPairLikelihoods_kernelName();
+
+#endif /* CLUSTERPAIRLIKELIHOODS_H_ */
@@ -0,0 +1,1013 @@
+/*
+ * shortReadAlignmentsFile.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "shortReadAlignmentsFile.h"
+
+#include <assert.h>
+#include <string.h>
+#include <iostream>
+#include <stdexcept>
+#include <zlib.h>
+#include <omp.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <limits>
+#include <algorithm>
+#include <ctype.h>
+#include <stdlib.h>
+
+#include "../Utilities.h"
+
+static const char alignmentsFile_magic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'A', 'L'};
+static const char alignmentsFile_indexMagic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'A', 'X'};
+static const uint32_t alignmentsFile_version = 1;
+static const uint32_t alignmentsFile_flag_compressed = 1;
+
+// binary encoding helpers
+
+static void alignmentsFile_putVarint(std::string& buffer, uint64_t value)
+{
+	while(value >= 0x80)
+	{
+		buffer.push_back((char)((value & 0x7F) | 0x80));
+		value >>= 7;
+	}
+	buffer.push_back((char)value);
+}
+
+template<typename T>
+static void alignmentsFile_put(std::string& buffer, T value)
+{
+	buffer.append((const char*)&value, sizeof(T));
+}
+
+static void alignmentsFile_putString(std::string& buffer, const std::string& S)
+{
+	alignmentsFile_putVarint(buffer, S.length());
+	buffer.append(S);
+}
+
+class alignmentsFile_decoder {
+public:
+	const char* position;
+	const char* end;
+
+	alignmentsFile_decoder(const char* begin, const char* end) : position(begin), end(end)
+	{
+
+	}
+
+	uint64_t getVarint()
+	{
+		uint64_t value = 0;
+		for(unsigned int shift = 0; shift < 64; shift += 7)
+		{
+			if(position >= end)
+				throw std::runtime_error("Binary alignments file: truncated record.");
+			unsigned char byte = (unsigned char)*(position++);
+			value |= ((uint64_t)(byte & 0x7F)) << shift;
+			if((byte & 0x80) == 0)
+				return value;
+		}
+		throw std::runtime_error("Binary alignments file: invalid varint.");
+	}
+
+	template<typename T>
+	T get()
+	{
+		if((size_t)(end - position) < sizeof(T))
+			throw std::runtime_error("Binary alignments file: truncated record.");
+		T value;
+		memcpy(&value, position, sizeof(T));
+		position += sizeof(T);
+		return value;
+	}
+
+	std::string getString()
+	{
+		uint64_t length = getVarint();
+		if((uint64_t)(end - position) < length)
+			throw std::runtime_error("Binary alignments file: truncated record.");
+		std::string S(position, length);
+		position += length;
+		return S;
+	}
+};
+
+static void alignmentsFile_encodeRead(std::string& buffer, const seedAndExtend_return_local& alignment, const oneRead& originalRead, const std::string& nameSuffix)
+{
+	alignmentsFile_putString(buffer, originalRead.name + nameSuffix);
+	alignmentsFile_put<double>(buffer, alignment.Score);
+	alignmentsFile_put<unsigned char>(buffer, alignment.reverse ? 1 : 0);
+	alignmentsFile_put<double>(buffer, alignment.mapQ);
+	alignmentsFile_put<double>(buffer, alignment.mapQ_genomic);
+	alignmentsFile_putString(buffer, alignment.mapQ_genomic_perPosition);
+	alignmentsFile_putString(buffer, alignment.graph_aligned);
+	alignmentsFile_putString(buffer, alignment.sequence_aligned);
+
+	alignmentsFile_putVarint(buffer, alignment.graph_aligned_levels.size());
+	int64_t previousLevel = 0;
+	for(unsigned int i = 0; i < alignment.graph_aligned_levels.size(); i++)
+	{
+		int64_t delta = (int64_t)alignment.graph_aligned_levels.at(i) - previousLevel;
+		alignmentsFile_putVarint(buffer, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+		previousLevel = alignment.graph_aligned_levels.at(i);
+	}
+
+	alignmentsFile_putString(buffer, originalRead.sequence);
+	alignmentsFile_putString(buffer, originalRead.quality);
+}
+
+static void alignmentsFile_decodeRead(alignmentsFile_decoder& input, seedAndExtend_return_local& alignment, oneRead& originalRead)
+{
+	std::string name = input.getString();
+
+	seedAndExtend_return_local a;
+	a.Score = input.get<double>();
+	a.reverse = (input.get<unsigned char>() != 0);
+	a.mapQ = input.get<double>();
+	a.mapQ_genomic = input.get<double>();
+	a.mapQ_genomic_perPosition = input.getString();
+	a.graph_aligned = input.getString();
+	a.sequence_aligned = input.getString();
+
+	uint64_t levels = input.getVarint();
+	a.graph_aligned_levels.resize(levels);
+	int64_t previousLevel = 0;
+	for(uint64_t i = 0; i < levels; i++)
+	{
+		uint64_t zigzag = input.getVarint();
+		int64_t delta = (int64_t)(zigzag >> 1) ^ -(int64_t)(zigzag & 1);
+		previousLevel += delta;
+		a.graph_aligned_levels.at(i) = previousLevel;
+	}
+
+	std::string sequence = input.getString();
+	std::string quality = input.getString();
+
+	alignment = a;
+	originalRead = oneRead(name, sequence, quality);
+}
+
+// writer
+
+shortReadAlignmentsWriter::shortReadAlignmentsWriter(std::string filename, double insertSize_mean, double insertSize_sd, bool binaryFormat, bool compressBlocks) : filename(filename), binary(binaryFormat), compress(compressBlocks), block_records(0), records(0), fileOffset(0)
+{
+	output.open(filename.c_str(), (binary ? (std::ios::out | std::ios::binary) : std::ios::out));
+	if(! output.is_open())
+	{
+		throw std::runtime_error("Cannot open alignments file " + filename + " for writing.");
+	}
+
+	if(binary)
+	{
+		std::string header;
+		header.append(alignmentsFile_magic, sizeof(alignmentsFile_magic));
+		alignmentsFile_put<uint32_t>(header, alignmentsFile_version);
+		alignmentsFile_put<uint32_t>(header, (compress ? alignmentsFile_flag_compressed : 0));
+		alignmentsFile_put<double>(header, insertSize_mean);
+		alignmentsFile_put<double>(header, insertSize_sd);
+		output.write(header.data(), header.size());
+		fileOffset = header.size();
+	}
+	else
+	{
+		output << "IS " << insertSize_mean << " " << insertSize_sd << "\n";
+	}
+}
+
+shortReadAlignmentsWriter::~shortReadAlignmentsWriter()
+{
+	// callers are expected to close() explicitly - a destructor must not throw, so failures are only reported here
+	try
+	{
+		close();
+	}
+	catch(std::exception& e)
+	{
+		std::cerr << "shortReadAlignmentsWriter: could not close " << filename << ": " << e.what() << "\n" << std::flush;
+	}
+}
+
+void shortReadAlignmentsWriter::beginPair(size_t pairI)
+{
+	assert(output.is_open());
+	if(! binary)
+	{
+		output << "Aligned pair " << pairI << "\n";
+	}
+}
+
+void shortReadAlignmentsWriter::writeTextRead(const seedAndExtend_return_local& alignment, const oneRead& originalRead, const std::string& nameSuffix)
+{
+	output << "\t" << "Read " << originalRead.name << nameSuffix << "\n";
+	output << "\t\t" << alignment.Score << "\n";
+	output << "\t\t" << alignment.reverse << "\n";
+	output << "\t\t" << alignment.mapQ << " " << alignment.mapQ_genomic;
+	if(alignment.mapQ_genomic_perPosition.length())
+	{
+		output << " " << alignment.mapQ_genomic_perPosition;
+	}
+	output << "\n";
+	output << "\t\t" << alignment.graph_aligned << "\n";
+	output << "\t\t" << alignment.sequence_aligned << "\n";
+	output << "\t\t" << Utilities::join(Utilities::ItoStr(alignment.graph_aligned_levels), " ") << "\n";
+	output << "\t\t" << originalRead.sequence << "\n";
+	output << "\t\t" << originalRead.quality << "\n";
+}
+
+void shortReadAlignmentsWriter::writeAlignmentPair(const seedAndExtend_return_local& alignment_1, const oneRead& originalRead_1, const seedAndExtend_return_local& alignment_2, const oneRead& originalRead_2, const std::string& nameSuffix)
+{
+	assert(output.is_open());
+	if(! binary)
+	{
+		writeTextRead(alignment_1, originalRead_1, nameSuffix);
+		writeTextRead(alignment_2, originalRead_2, nameSuffix);
+		return;
+	}
+
+	std::string record;
+	alignmentsFile_encodeRead(record, alignment_1, originalRead_1, nameSuffix);
+	alignmentsFile_encodeRead(record, alignment_2, originalRead_2, nameSuffix);
+
+	if((block.size() > 0) && ((block.size() + record.size() + 10) > blockSize))
+	{
+		flushBlock();
+	}
+
+	alignmentsFile_putVarint(block, record.size());
+	block.append(record);
+	block_records++;
+}
+
+void shortReadAlignmentsWriter::flushBlock()
+{
+	if(block_records == 0)
+		return;
+
+	std::string stored;
+	if(compress)
+	{
+		uLongf storedSize = compressBound(block.size());
+		stored.resize(storedSize);
+		int ret = compress2((Bytef*)&(stored[0]), &storedSize, (const Bytef*)block.data(), block.size(), Z_DEFAULT_COMPRESSION);
+		if(ret != Z_OK)
+		{
+			throw std::runtime_error("Cannot compress alignments block.");
+		}
+		stored.resize(storedSize);
+	}
+	else
+	{
+		stored = block;
+	}
+
+	index_offsets.push_back(fileOffset);
+	index_firstRecords.push_back(records);
+
+	std::string blockHeader;
+	alignmentsFile_put<uint32_t>(blockHeader, stored.size());
+	alignmentsFile_put<uint32_t>(blockHeader, block.size());
+	alignmentsFile_put<uint32_t>(blockHeader, block_records);
+	output.write(blockHeader.data(), blockHeader.size());
+	output.write(stored.data(), stored.size());
+	fileOffset += blockHeader.size() + stored.size();
+
+	records += block_records;
+	block.clear();
+	block_records = 0;
+}
+
+void shortReadAlignmentsWriter::close()
+{
+	if(! output.is_open())
+		return;
+
+	if(binary)
+	{
+		flushBlock();
+
+		std::string index;
+		for(unsigned int blockI = 0; blockI < index_offsets.size(); blockI++)
+		{
+			alignmentsFile_put<uint64_t>(index, index_offsets.at(blockI));
+			alignmentsFile_put<uint64_t>(index, index_firstRecords.at(blockI));
+		}
+		alignmentsFile_put<uint64_t>(index, index_offsets.size());
+		index.append(alignmentsFile_indexMagic, sizeof(alignmentsFile_indexMagic));
+		output.write(index.data(), index.size());
+	}
+
+	output.close();
+	if(output.fail())
+	{
+		throw std::runtime_error("Error while writing alignments file " + filename + ".");
+	}
+}
+
+// reader
+
+shortReadAlignmentsReader::shortReadAlignmentsReader(std::string filename) : filename(filename), binary(false), compressed(false), IS_mean(0), IS_sd(0), block_position(0), dataEnd(0)
+{
+	input.open(filename.c_str(), std::ios::in | std::ios::binary);
+	if(! input.is_open())
+	{
+		throw std::runtime_error("Cannot open alignments file " + filename + ".");
+	}
+
+	char magic[sizeof(alignmentsFile_magic)];
+	if(input.read(magic, sizeof(magic)) && (memcmp(magic, alignmentsFile_magic, sizeof(magic)) == 0))
+	{
+		binary = true;
+
+		char header[2 * sizeof(uint32_t) + 2 * sizeof(double)];
+		if(! input.read(header, sizeof(header)))
+		{
+			throw std::runtime_error("Binary alignments file " + filename + " is truncated.");
+		}
+		alignmentsFile_decoder headerDecoder(header, header + sizeof(header));
+		uint32_t version = headerDecoder.get<uint32_t>();
+		uint32_t flags = headerDecoder.get<uint32_t>();
+		if(version != alignmentsFile_version)
+		{
+			throw std::runtime_error("Binary alignments file " + filename + " has an unsupported version.");
+		}
+		compressed = ((flags & alignmentsFile_flag_compressed) != 0);
+		IS_mean = headerDecoder.get<double>();
+		IS_sd = headerDecoder.get<double>();
+
+		std::streampos dataStart = input.tellg();
+		input.seekg(0, std::ios::end);
+		uint64_t fileEnd = input.tellg();
+
+		char trailer[sizeof(uint64_t) + sizeof(alignmentsFile_indexMagic)];
+		if((fileEnd < ((uint64_t)dataStart + sizeof(trailer))) || (! input.seekg(fileEnd - sizeof(trailer))) || (! input.read(trailer, sizeof(trailer))) || (memcmp(trailer + sizeof(uint64_t), alignmentsFile_indexMagic, sizeof(alignmentsFile_indexMagic)) != 0))
+		{
+			throw std::runtime_error("Binary alignments file " + filename + " has no block index - incompletely written?");
+		}
+		uint64_t indexBlocks;
+		memcpy(&indexBlocks, trailer, sizeof(uint64_t));
+		uint64_t indexSize = indexBlocks * 2 * sizeof(uint64_t);
+		if((fileEnd - sizeof(trailer) - (uint64_t)dataStart) < indexSize)
+		{
+			throw std::runtime_error("Binary alignments file " + filename + " has a corrupt block index.");
+		}
+		dataEnd = fileEnd - sizeof(trailer) - indexSize;
+
+		std::string index;
+		index.resize(indexSize);
+		input.seekg(dataEnd);
+		if(indexSize && (! input.read(&(index[0]), indexSize)))
+		{
+			throw std::runtime_error("Binary alignments file " + filename + " has a corrupt block index.");
+		}
+		alignmentsFile_decoder indexDecoder(index.data(), index.data() + index.size());
+		for(uint64_t blockI = 0; blockI < indexBlocks; blockI++)
+		{
+			index_offsets.push_back(indexDecoder.get<uint64_t>());
+			index_firstRecords.push_back(indexDecoder.get<uint64_t>());
+		}
+
+		input.seekg(dataStart);
+	}
+	else
+	{
+		input.clear();
+		input.seekg(0);
+
+		std::string line;
+		std::getline(input, line);
+		Utilities::eraseNL(line);
+
+		std::vector<std::string> firstLine_fields = Utilities::split(line, " ");
+		if((firstLine_fields.size() != 3) || (firstLine_fields.at(0) != "IS"))
+		{
+			throw std::runtime_error("Alignments file " + filename + " is neither a binary alignments file nor starts with an \"IS mean sd\" line.");
+		}
+
+		IS_mean = Utilities::StrtoD(firstLine_fields.at(1));
+		IS_sd = Utilities::StrtoD(firstLine_fields.at(2));
+	}
+}
+
+bool shortReadAlignmentsReader::readBlock()
+{
+	block.clear();
+	block_position = 0;
+
+	if((uint64_t)input.tellg() >= dataEnd)
+	{
+		return false;
+	}
+
+	char blockHeader[3 * sizeof(uint32_t)];
+	if(! input.read(blockHeader, sizeof(blockHeader)))
+	{
+		throw std::runtime_error("Binary alignments file: truncated block.");
+	}
+
+	alignmentsFile_decoder headerDecoder(blockHeader, blockHeader + sizeof(blockHeader));
+	uint32_t storedSize = headerDecoder.get<uint32_t>();
+	uint32_t rawSize = headerDecoder.get<uint32_t>();
+	uint32_t blockRecords = headerDecoder.get<uint32_t>();
+	if((blockRecords == 0) || (((uint64_t)input.tellg() + storedSize) > dataEnd))
+	{
+		throw std::runtime_error("Binary alignments file: corrupt block header.");
+	}
+
+	std::string stored;
+	stored.resize(storedSize);
+	if(! input.read(&(stored[0]), storedSize))
+	{
+		throw std::runtime_error("Binary alignments file: truncated block.");
+	}
+
+	if(compressed)
+	{
+		block.resize(rawSize);
+		uLongf decompressedSize = rawSize;
+		int ret = uncompress((Bytef*)&(block[0]), &decompressedSize, (const Bytef*)stored.data(), stored.size());
+		if((ret != Z_OK) || (decompressedSize != rawSize))
+		{
+			throw std::runtime_error("Binary alignments file: corrupt compressed block.");
+		}
+	}
+	else
+	{
+		if(storedSize != rawSize)
+		{
+			throw std::runtime_error("Binary alignments file: inconsistent block sizes.");
+		}
+		block.swap(stored);
+	}
+
+	return true;
+}
+
+bool shortReadAlignmentsReader::readTextRead(seedAndExtend_return_local& alignment, oneRead& originalRead, std::string firstLine)
+{
+	std::vector<std::string> lines;
+	if(firstLine.length())
+	{
+		lines.push_back(firstLine);
+	}
+	while(lines.size() < 9)
+	{
+		if(! input.good())
+		{
+			return false;
+		}
+		std::string thisLine;
+		std::getline(input, thisLine);
+		Utilities::eraseNL(thisLine);
+		lines.push_back(thisLine);
+	}
+
+	if(!(lines.at(0).substr(0, 5) == "\tRead"))
+	{
+		std::cerr << "Line 0 should be TABRead, but is not!\n" << lines.at(0) << "\n" << std::flush;
+	}
+	assert(lines.at(0).substr(0, 6) == "\tRead ");
+
+	std::string str_readID = lines.at(0).substr(6);
+	std::string str_score = lines.at(1).substr(2);
+	std::string str_reverse = lines.at(2).substr(2);
+	std::string str_mapQ = lines.at(3).substr(2);
+	std::string str_graph_aligned = lines.at(4).substr(2);
+	std::string str_sequence_aligned = lines.at(5).substr(2);
+	std::string str_levels = lines.at(6).substr(2);
+	std::string str_originalSequence = lines.at(7).substr(2);
+	std::string str_qualities = lines.at(8).substr(2);
+
+	std::vector<std::string> mapQs = Utilities::split(str_mapQ, " ");
+
+	seedAndExtend_return_local a;
+	a.Score = Utilities::StrtoD(str_score);
+	a.reverse = Utilities::StrtoB(str_reverse);
+	if(mapQs.size() == 2)
+	{
+		a.mapQ = Utilities::StrtoD(mapQs.at(0));
+		a.mapQ_genomic = Utilities::StrtoD(mapQs.at(1));
+	}
+	else if(mapQs.size() == 3)
+	{
+		a.mapQ = Utilities::StrtoD(mapQs.at(0));
+		a.mapQ_genomic = Utilities::StrtoD(mapQs.at(1));
+		a.mapQ_genomic_perPosition = mapQs.at(2);
+		assert(a.mapQ_genomic_perPosition.length() == str_graph_aligned.length());
+	}
+	else
+	{
+		a.mapQ = Utilities::StrtoD(mapQs.at(0));
+		a.mapQ_genomic = 2;
+	}
+	a.graph_aligned = str_graph_aligned;
+	a.sequence_aligned = str_sequence_aligned;
+	a.graph_aligned_levels = Utilities::StrtoI(Utilities::split(str_levels, " "));
+	alignment = a;
+
+	originalRead = oneRead(str_readID, str_originalSequence, str_qualities);
+	return true;
+}
+
+bool shortReadAlignmentsReader::nextAlignmentPair(seedAndExtend_return_local& alignment_1, oneRead& originalRead_1, seedAndExtend_return_local& alignment_2, oneRead& originalRead_2)
+{
+	if(binary)
+	{
+		while(block_position >= block.size())
+		{
+			if(! readBlock())
+			{
+				return false;
+			}
+		}
+
+		alignmentsFile_decoder recordDecoder(block.data() + block_position, block.data() + block.size());
+		uint64_t recordSize = recordDecoder.getVarint();
+		const char* recordStart = recordDecoder.position;
+		if((uint64_t)(recordDecoder.end - recordStart) < recordSize)
+		{
+			throw std::runtime_error("Binary alignments file: truncated record.");
+		}
+
+		alignmentsFile_decoder readDecoder(recordStart, recordStart + recordSize);
+		alignmentsFile_decodeRead(readDecoder, alignment_1, originalRead_1);
+		alignmentsFile_decodeRead(readDecoder, alignment_2, originalRead_2);
+		assert(readDecoder.position == readDecoder.end);
+
+		block_position = (recordStart + recordSize) - block.data();
+		return true;
+	}
+
+	std::string line;
+	while(input.good())
+	{
+		std::getline(input, line);
+		Utilities::eraseNL(line);
+		if(line.length() == 0)
+		{
+			continue;
+		}
+
+		assert( (line.substr(0, std::string("Aligned pair").length()) == "Aligned pair") ||
+				(line.substr(0, std::string("\tRead").length()) == "\tRead")
+		);
+
+		std::string lineForInsertion;
+		if(line.substr(0, std::string("\tRead").length()) == "\tRead")
+		{
+			lineForInsertion = line;
+		}
+
+		bool ok_1 = readTextRead(alignment_1, originalRead_1, lineForInsertion);
+		bool ok_2 = ok_1 && readTextRead(alignment_2, originalRead_2, "");
+		if(ok_1 && ok_2)
+		{
+			return true;
+		}
+
+		assert(! input.good());
+		return false;
+	}
+
+	return false;
+}
+
+
+// bulk reading
+
+// read-only mapping of a whole file
+class alignmentsFile_mapping {
+public:
+	const char* data;
+	size_t size;
+
+	alignmentsFile_mapping(std::string filename) : data(0), size(0)
+	{
+		int fd = open(filename.c_str(), O_RDONLY);
+		if(fd == -1)
+		{
+			throw std::runtime_error("Cannot open alignments file " + filename + ".");
+		}
+		struct stat fileInfo;
+		if(fstat(fd, &fileInfo) != 0)
+		{
+			::close(fd);
+			throw std::runtime_error("Cannot stat alignments file " + filename + ".");
+		}
+		size = fileInfo.st_size;
+		if(size > 0)
+		{
+			void* mapped = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if(mapped == MAP_FAILED)
+			{
+				::close(fd);
+				throw std::runtime_error("Cannot mmap alignments file " + filename + ".");
+			}
+			data = (const char*)mapped;
+		}
+		::close(fd);
+	}
+
+	~alignmentsFile_mapping()
+	{
+		if(data)
+		{
+			munmap((void*)data, size);
+		}
+	}
+};
+
+// Utilities::StrtoD(..) (i.e. std::istream >> double) without the stringstream: the longest prefix
+// that looks like a decimal floating point number is converted with strtod, 0 if that fails, and
+// overflows are clamped to the largest finite value.
+static double alignmentsFile_parseDouble(const char* begin, const char* end)
+{
+	while((begin < end) && isspace((unsigned char)*begin))
+		begin++;
+
+	const char* p = begin;
+	bool mantissa = false;
+	if((p < end) && ((*p == '+') || (*p == '-')))
+		p++;
+	while((p < end) && isdigit((unsigned char)*p))
+	{
+		p++;
+		mantissa = true;
+	}
+	if((p < end) && (*p == '.'))
+	{
+		p++;
+		while((p < end) && isdigit((unsigned char)*p))
+		{
+			p++;
+			mantissa = true;
+		}
+	}
+	if(mantissa && (p < end) && ((*p == 'e') || (*p == 'E')))
+	{
+		p++;
+		if((p < end) && ((*p == '+') || (*p == '-')))
+			p++;
+		while((p < end) && isdigit((unsigned char)*p))
+			p++;
+	}
+
+	char buffer[64];
+	std::string longNumber;
+	const char* number;
+	if((size_t)(p - begin) < sizeof(buffer))
+	{
+		memcpy(buffer, begin, p - begin);
+		buffer[p - begin] = 0;
+		number = buffer;
+	}
+	else
+	{
+		longNumber.assign(begin, p);
+		number = longNumber.c_str();
+	}
+
+	char* numberEnd;
+	double value = strtod(number, &numberEnd);
+	if((numberEnd == number) || (numberEnd != (number + (p - begin))))
+		return 0;
+	if(value == std::numeric_limits<double>::infinity())
+		return std::numeric_limits<double>::max();
+	if(value == -std::numeric_limits<double>::infinity())
+		return -std::numeric_limits<double>::max();
+	return value;
+}
+
+// Utilities::StrtoI(..): optional sign and decimal digits, 0 if there are none, clamped to the range of int
+static int alignmentsFile_parseInt(const char* begin, const char* end)
+{
+	while((begin < end) && isspace((unsigned char)*begin))
+		begin++;
+
+	bool negative = false;
+	if((begin < end) && ((*begin == '+') || (*begin == '-')))
+	{
+		negative = (*begin == '-');
+		begin++;
+	}
+	int64_t value = 0;
+	for(; (begin < end) && isdigit((unsigned char)*begin); begin++)
+	{
+		if(value <= ((int64_t)1 << 40))
+			value = 10 * value + (*begin - '0');
+	}
+	if(negative)
+		value = -value;
+	if(value > std::numeric_limits<int>::max())
+		return std::numeric_limits<int>::max();
+	if(value < std::numeric_limits<int>::min())
+		return std::numeric_limits<int>::min();
+	return (int)value;
+}
+
+// one read of the text format from its nine lines, as in shortReadAlignmentsReader::readTextRead(..)
+static void alignmentsFile_parseTextRead(const char* data, const size_t* lineStarts, const size_t* lineEnds, seedAndExtend_return_local& alignment, oneRead& originalRead)
+{
+	const char* line0 = data + lineStarts[0];
+	size_t line0_length = lineEnds[0] - lineStarts[0];
+	if(!((line0_length >= 5) && (memcmp(line0, "\tRead", 5) == 0)))
+	{
+		std::cerr << "Line 0 should be TABRead, but is not!\n" << std::string(line0, line0_length) << "\n" << std::flush;
+	}
+	assert((line0_length >= 6) && (memcmp(line0, "\tRead ", 6) == 0));
+
+	const char* fieldStarts[9];
+	const char* fieldEnds[9];
+	for(unsigned int lI = 1; lI < 9; lI++)
+	{
+		if((lineEnds[lI] - lineStarts[lI]) < 2)
+		{
+			throw std::runtime_error("Text alignments file: truncated line in read " + std::string(line0 + 6, line0_length - 6) + ".");
+		}
+		fieldStarts[lI] = data + lineStarts[lI] + 2;
+		fieldEnds[lI] = data + lineEnds[lI];
+	}
+
+	seedAndExtend_return_local a;
+	a.Score = alignmentsFile_parseDouble(fieldStarts[1], fieldEnds[1]);
+	a.reverse = (alignmentsFile_parseInt(fieldStarts[2], fieldEnds[2]) != 0);
+
+	a.graph_aligned.assign(fieldStarts[4], fieldEnds[4]);
+	a.sequence_aligned.assign(fieldStarts[5], fieldEnds[5]);
+
+	// mapQ [mapQ_genomic [mapQ_genomic_perPosition]]
+	const char* mapQ_fields[3];
+	const char* mapQ_fieldEnds[3];
+	size_t mapQ_nFields = 0;
+	const char* fieldStart = fieldStarts[3];
+	for(const char* p = fieldStarts[3]; ; p++)
+	{
+		if((p == fieldEnds[3]) || (*p == ' '))
+		{
+			if(mapQ_nFields < 3)
+			{
+				mapQ_fields[mapQ_nFields] = fieldStart;
+				mapQ_fieldEnds[mapQ_nFields] = p;
+			}
+			mapQ_nFields++;
+			fieldStart = p + 1;
+			if(p == fieldEnds[3])
+				break;
+		}
+	}
+	if(fieldStarts[3] == fieldEnds[3])
+	{
+		mapQ_nFields = 0;
+	}
+	if(mapQ_nFields == 0)
+	{
+		throw std::runtime_error("Text alignments file: no mapping quality for read " + std::string(line0 + 6, line0_length - 6) + ".");
+	}
+	a.mapQ = alignmentsFile_parseDouble(mapQ_fields[0], mapQ_fieldEnds[0]);
+	if((mapQ_nFields == 2) || (mapQ_nFields == 3))
+	{
+		a.mapQ_genomic = alignmentsFile_parseDouble(mapQ_fields[1], mapQ_fieldEnds[1]);
+	}
+	else
+	{
+		a.mapQ_genomic = 2;
+	}
+	if(mapQ_nFields == 3)
+	{
+		a.mapQ_genomic_perPosition.assign(mapQ_fields[2], mapQ_fieldEnds[2]);
+		assert(a.mapQ_genomic_perPosition.length() == a.graph_aligned.length());
+	}
+
+	// levels, split at every space
+	if(fieldStarts[6] != fieldEnds[6])
+	{
+		size_t levels = 1 + std::count(fieldStarts[6], fieldEnds[6], ' ');
+		a.graph_aligned_levels.reserve(levels);
+		const char* levelStart = fieldStarts[6];
+		for(const char* p = fieldStarts[6]; ; p++)
+		{
+			if((p == fieldEnds[6]) || (*p == ' '))
+			{
+				a.graph_aligned_levels.push_back(alignmentsFile_parseInt(levelStart, p));
+				levelStart = p + 1;
+				if(p == fieldEnds[6])
+					break;
+			}
+		}
+	}
+
+	alignment = a;
+	originalRead = oneRead(std::string(line0 + 6, line0_length - 6), std::string(fieldStarts[7], fieldEnds[7]), std::string(fieldStarts[8], fieldEnds[8]));
+}
+
+void shortReadAlignmentsReader::readAllAlignmentPairs(std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>>& ret_alignments, std::vector<oneReadPair>& ret_originalReads)
+{
+	assert(block.size() == 0);
+
+	alignmentsFile_mapping file(filename);
+	const oneReadPair emptyPair(oneRead("", "", ""), oneRead("", "", ""), 0);
+
+	// exceptions must not leave a parallel region
+	std::string error;
+
+	if(binary)
+	{
+		// block boundaries: walk the block headers, as readBlock() does
+		std::vector<uint64_t> blockOffsets;
+		std::vector<uint64_t> blockFirstRecords;
+		uint64_t totalRecords = 0;
+		uint64_t position = sizeof(alignmentsFile_magic) + 2 * sizeof(uint32_t) + 2 * sizeof(double);
+		while(position < dataEnd)
+		{
+			if((dataEnd - position) < 3 * sizeof(uint32_t))
+			{
+				throw std::runtime_error("Binary alignments file: truncated block.");
+			}
+			alignmentsFile_decoder headerDecoder(file.data + position, file.data + position + 3 * sizeof(uint32_t));
+			uint32_t storedSize = headerDecoder.get<uint32_t>();
+			headerDecoder.get<uint32_t>();
+			uint32_t blockRecords = headerDecoder.get<uint32_t>();
+			if((blockRecords == 0) || ((position + 3 * sizeof(uint32_t) + storedSize) > dataEnd))
+			{
+				throw std::runtime_error("Binary alignments file: corrupt block header.");
+			}
+			blockOffsets.push_back(position);
+			blockFirstRecords.push_back(totalRecords);
+			totalRecords += blockRecords;
+			position += 3 * sizeof(uint32_t) + storedSize;
+		}
+
+		ret_alignments.assign(totalRecords, std::pair<seedAndExtend_return_local, seedAndExtend_return_local>());
+		ret_originalReads.assign(totalRecords, emptyPair);
+
+		#pragma omp parallel for schedule(dynamic)
+		for(size_t blockI = 0; blockI < blockOffsets.size(); blockI++)
+		{
+			try
+			{
+				const char* blockStart = file.data + blockOffsets.at(blockI);
+				alignmentsFile_decoder headerDecoder(blockStart, blockStart + 3 * sizeof(uint32_t));
+				uint32_t storedSize = headerDecoder.get<uint32_t>();
+				uint32_t rawSize = headerDecoder.get<uint32_t>();
+				uint32_t blockRecords = headerDecoder.get<uint32_t>();
+				const char* stored = blockStart + 3 * sizeof(uint32_t);
+
+				std::string decompressed;
+				const char* raw = stored;
+				if(compressed)
+				{
+					decompressed.resize(rawSize);
+					uLongf decompressedSize = rawSize;
+					int ret = uncompress((Bytef*)&(decompressed[0]), &decompressedSize, (const Bytef*)stored, storedSize);
+					if((ret != Z_OK) || (decompressedSize != rawSize))
+					{
+						throw std::runtime_error("Binary alignments file: corrupt compressed block.");
+					}
+					raw = decompressed.data();
+				}
+				else if(storedSize != rawSize)
+				{
+					throw std::runtime_error("Binary alignments file: inconsistent block sizes.");
+				}
+
+				alignmentsFile_decoder recordDecoder(raw, raw + rawSize);
+				for(uint32_t recordI = 0; recordI < blockRecords; recordI++)
+				{
+					uint64_t recordSize = recordDecoder.getVarint();
+					const char* recordStart = recordDecoder.position;
+					if((uint64_t)(recordDecoder.end - recordStart) < recordSize)
+					{
+						throw std::runtime_error("Binary alignments file: truncated record.");
+					}
+
+					size_t pairI = blockFirstRecords.at(blockI) + recordI;
+					alignmentsFile_decoder readDecoder(recordStart, recordStart + recordSize);
+					alignmentsFile_decodeRead(readDecoder, ret_alignments.at(pairI).first, ret_originalReads.at(pairI).reads.first);
+					alignmentsFile_decodeRead(readDecoder, ret_alignments.at(pairI).second, ret_originalReads.at(pairI).reads.second);
+					assert(readDecoder.position == readDecoder.end);
+					recordDecoder.position = recordStart + recordSize;
+				}
+				if(recordDecoder.position != recordDecoder.end)
+				{
+					throw std::runtime_error("Binary alignments file: block size and record count disagree.");
+				}
+			}
+			catch(std::exception& e)
+			{
+				#pragma omp critical
+				{
+					if(error.length() == 0)
+						error = e.what();
+				}
+			}
+		}
+	}
+	else
+	{
+		// line boundaries, searched in parallel in equal parts of the file
+		const char* data = file.data;
+		size_t size = file.size;
+		const char* firstNewline = (size > 0) ? (const char*)memchr(data, '\n', size) : 0;
+		size_t dataStart = firstNewline ? (firstNewline - data + 1) : size;
+
+		int parts = omp_get_max_threads();
+		std::vector<std::vector<size_t> > newlines_perPart(parts);
+		#pragma omp parallel for schedule(static)
+		for(int partI = 0; partI < parts; partI++)
+		{
+			size_t partStart = dataStart + ((size - dataStart) / parts) * partI;
+			size_t partStop = (partI == (parts - 1)) ? size : (dataStart + ((size - dataStart) / parts) * (partI + 1));
+			const char* p = data + partStart;
+			const char* partEnd = data + partStop;
+			while(p < partEnd)
+			{
+				const char* newline = (const char*)memchr(p, '\n', partEnd - p);
+				if(! newline)
+					break;
+				newlines_perPart.at(partI).push_back(newline - data);
+				p = newline + 1;
+			}
+		}
+
+		// lines without their line breaks (as std::getline + Utilities::eraseNL)
+		std::vector<size_t> lineStarts;
+		std::vector<size_t> lineEnds;
+		size_t lineStart = dataStart;
+		for(int partI = 0; partI < parts; partI++)
+		{
+			for(size_t nI = 0; nI < newlines_perPart.at(partI).size(); nI++)
+			{
+				size_t lineEnd = newlines_perPart.at(partI).at(nI);
+				lineStarts.push_back(lineStart);
+				lineEnds.push_back(((lineEnd > lineStart) && (data[lineEnd - 1] == '\r')) ? (lineEnd - 1) : lineEnd);
+				lineStart = lineEnd + 1;
+			}
+			std::vector<size_t>().swap(newlines_perPart.at(partI));
+		}
+		if(lineStart < size)
+		{
+			lineStarts.push_back(lineStart);
+			lineEnds.push_back((data[size - 1] == '\r') ? (size - 1) : size);
+		}
+
+		// record boundaries: empty lines between pairs are skipped, and each pair starts either with
+		// an "Aligned pair" line or directly with the "\tRead" line of its first read
+		std::vector<size_t> pairFirstLines;
+		size_t lineI = 0;
+		while(lineI < lineStarts.size())
+		{
+			size_t lineLength = lineEnds.at(lineI) - lineStarts.at(lineI);
+			if(lineLength == 0)
+			{
+				lineI++;
+				continue;
+			}
+
+			const char* line = data + lineStarts.at(lineI);
+			bool alignedPairLine = ((lineLength >= 12) && (memcmp(line, "Aligned pair", 12) == 0));
+			bool readLine = ((lineLength >= 5) && (memcmp(line, "\tRead", 5) == 0));
+			assert(alignedPairLine || readLine);
+
+			size_t firstLine = readLine ? lineI : (lineI + 1);
+			if((firstLine + 18) > lineStarts.size())
+			{
+				break;
+			}
+			pairFirstLines.push_back(firstLine);
+			lineI = firstLine + 18;
+		}
+
+		ret_alignments.assign(pairFirstLines.size(), std::pair<seedAndExtend_return_local, seedAndExtend_return_local>());
+		ret_originalReads.assign(pairFirstLines.size(), emptyPair);
+
+		#pragma omp parallel for schedule(dynamic, 256)
+		for(size_t pairI = 0; pairI < pairFirstLines.size(); pairI++)
+		{
+			try
+			{
+				size_t firstLine = pairFirstLines.at(pairI);
+				alignmentsFile_parseTextRead(data, &(lineStarts[firstLine]), &(lineEnds[firstLine]), ret_alignments.at(pairI).first, ret_originalReads.at(pairI).reads.first);
+				alignmentsFile_parseTextRead(data, &(lineStarts[firstLine + 9]), &(lineEnds[firstLine + 9]), ret_alignments.at(pairI).second, ret_originalReads.at(pairI).reads.second);
+			}
+			catch(std::exception& e)
+			{
+				#pragma omp critical
+				{
+					if(error.length() == 0)
+						error = e.what();
+				}
+			}
+		}
+	}
+
+	if(error.length())
+	{
+		throw std::runtime_error(error);
+	}
+}
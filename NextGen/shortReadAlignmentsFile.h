@@ -0,0 +1,124 @@
+/*
+ * shortReadAlignmentsFile.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef SHORTREADALIGNMENTSFILE_H_
+#define SHORTREADALIGNMENTSFILE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <fstream>
+#include <stdint.h>
+
+#include "../GraphAligner/GraphAligner.h"
+#include "readSimulator.h"
+
+// Reading and writing of aligned read pairs (the "*.aligned" files produced by
+// alignShortReadsToHLAGraph_multipleAlignments(..) and read by HLATypeInference(..)).
+//
+// Two formats:
+// - text: the traditional line-based format ("IS mean sd", then "Aligned pair i" blocks with nine lines per read).
+// - binary:
+//		char[8]		"MHCPRGAL"
+//		uint32		version
+//		uint32		flags (bit 0: block payloads are zlib-compressed)
+//		double		insert size mean, double insert size sd
+//		blocks:		uint32 stored size, uint32 raw size, uint32 records, stored payload
+//		index:		per block uint64 file offset, uint64 first record; then uint64 blocks, char[8] "MHCPRGAX"
+//	Each record is one aligned pair: varint length, then for both reads name, alignment (score, strand,
+//	mapQs, aligned strings, levels as zig-zag delta varints), sequence and qualities.
+//	Records never span blocks, so that blocks can be decoded independently.
+//
+// Readers detect the format from the first bytes of the file. Text is what alignShortReadsToHLAGraph writes
+// by default, as the perl scripts (HLAtypeinference.pl, extractReadsAlignment.pl) parse *.aligned files
+// directly; binary output is opt-in (--binaryAlignments).
+
+class shortReadAlignmentsWriter {
+protected:
+	std::string filename;
+	std::ofstream output;
+	bool binary;
+	bool compress;
+
+	std::string block;
+	uint32_t block_records;
+	std::vector<uint64_t> index_offsets;
+	std::vector<uint64_t> index_firstRecords;
+	uint64_t records;
+	uint64_t fileOffset;
+
+	void flushBlock();
+	void writeTextRead(const seedAndExtend_return_local& alignment, const oneRead& originalRead, const std::string& nameSuffix);
+
+public:
+	static const size_t blockSize = 1 << 20;
+
+	shortReadAlignmentsWriter(std::string filename, double insertSize_mean, double insertSize_sd, bool binaryFormat, bool compressBlocks = true);
+	~shortReadAlignmentsWriter();
+
+	// start the alignments of input read pair pairI (only visible in the text format)
+	void beginPair(size_t pairI);
+	// one alignment of a read pair; nameSuffix is appended to both read names
+	void writeAlignmentPair(const seedAndExtend_return_local& alignment_1, const oneRead& originalRead_1, const seedAndExtend_return_local& alignment_2, const oneRead& originalRead_2, const std::string& nameSuffix = "");
+	// finishes the file (block index for the binary format); throws on write errors. Always call this
+	// explicitly - the destructor closes too, but can only report errors, not throw them.
+	void close();
+};
+
+class shortReadAlignmentsReader {
+protected:
+	std::string filename;
+	std::ifstream input;
+	bool binary;
+	bool compressed;
+	double IS_mean;
+	double IS_sd;
+
+	std::string block;
+	size_t block_position;
+	uint64_t dataEnd;
+	std::vector<uint64_t> index_offsets;
+	std::vector<uint64_t> index_firstRecords;
+
+	bool readBlock();
+	bool readTextRead(seedAndExtend_return_local& alignment, oneRead& originalRead, std::string firstLine);
+
+public:
+	shortReadAlignmentsReader(std::string filename);
+
+	double getInsertSizeMean() const
+	{
+		return IS_mean;
+	}
+	double getInsertSizeSD() const
+	{
+		return IS_sd;
+	}
+	bool isBinary() const
+	{
+		return binary;
+	}
+	// block index of a binary file: file offset and first record number of each block
+	const std::vector<uint64_t>& getBlockOffsets() const
+	{
+		return index_offsets;
+	}
+	const std::vector<uint64_t>& getBlockFirstRecords() const
+	{
+		return index_firstRecords;
+	}
+
+	// next aligned read pair; false at the end of the file
+	bool nextAlignmentPair(seedAndExtend_return_local& alignment_1, oneRead& originalRead_1, seedAndExtend_return_local& alignment_2, oneRead& originalRead_2);
+
+	// all aligned read pairs of the file, in file order - the same as calling nextAlignmentPair(..) until
+	// it returns false, but the file is mapped into memory, record boundaries (block headers / "\tRead"
+	// lines) are located first, and records are decoded in parallel into preallocated vectors.
+	// Must be called before nextAlignmentPair(..).
+	void readAllAlignmentPairs(std::vector<std::pair<seedAndExtend_return_local, seedAndExtend_return_local>>& ret_alignments, std::vector<oneReadPair>& ret_originalReads);
+};
+
+#endif /* SHORTREADALIGNMENTSFILE_H_ */
@@ -18,6 +18,13 @@
 #include <vector>
 #include <assert.h>
 #include <iostream>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+#include <utility>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "sequence/binarykMer.h"
 
@@ -43,6 +50,40 @@ public:
 	}
 };
 
+// Bucket tags: one byte per slot, 0 for an empty slot and 1..255 (derived from the k-mer, independent of
+// the bucket hash) for an occupied one. The tags of a bucket are stored contiguously, padded to a multiple
+// of 16 slots and 64-byte aligned, so that a lookup compares the tags of all slots of a bucket with a few
+// SIMD compares and only reads the table elements whose tags match.
+template<int m, int k>
+inline unsigned char Hsh_kMerTag(const binarykMer<m, k>& key)
+{
+	uint64_t h = 0;
+	for(int i = 0; i < m; i++)
+	{
+		h = (h ^ key.kMerBinaryRepresentation[i]) * 0x9E3779B97F4A7C15ULL;
+	}
+	unsigned char tag = (unsigned char)(h >> 56);
+	return (tag == 0) ? 1 : tag;
+}
+
+// bit j of match / empty: slot j of the 16 tags equals tag / is empty
+inline void Hsh_compareTags(const unsigned char* tags16, unsigned char tag, unsigned int& match, unsigned int& empty)
+{
+#ifdef __SSE2__
+	__m128i tags = _mm_load_si128((const __m128i*)tags16);
+	match = _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8((char)tag)));
+	empty = _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_setzero_si128()));
+#else
+	match = 0;
+	empty = 0;
+	for(unsigned int j = 0; j < 16; j++)
+	{
+		match |= (unsigned int)(tags16[j] == tag) << j;
+		empty |= (unsigned int)(tags16[j] == 0) << j;
+	}
+#endif
+}
+
 template<int m, int k, class ElementType>
 class Hsh {
 	int kmer_size;
@@ -55,16 +96,109 @@ class Hsh {
 
 	std::vector< hashTableElement<m, k, ElementType> > table;
 
+	size_t tags_stride;
+	size_t tags_offset;
+	std::vector<unsigned char> tags_storage;
+
+	unsigned char* bucket_tags(size_t hashval)
+	{
+		return tags_storage.data() + tags_offset + hashval * tags_stride;
+	}
+	// The tags start at tags_offset, the first 64-byte boundary of tags_storage's buffer. A copied
+	// buffer has its own alignment - recompute tags_offset and shift the tags there.
+	void realign_tags()
+	{
+		size_t aligned_offset = (64 - ((uintptr_t)tags_storage.data() % 64)) % 64;
+		if(aligned_offset != tags_offset)
+		{
+			memmove(tags_storage.data() + aligned_offset, tags_storage.data() + tags_offset, number_buckets * tags_stride);
+			tags_offset = aligned_offset;
+		}
+	}
+	size_t bucket_of_rehashed(binarykMer<m, k>& key, int rehash)
+	{
+		binarykMer<m, k> kMer_with_rehash = key;
+		kMer_with_rehash.at(m - 1) = (kMer_with_rehash.at(m - 1) + (bitfield_of_64bits) rehash);
+		return kMer_with_rehash.hash_value(number_buckets);
+	}
+	bool find_in_given_bucket(binarykMer<m, k>& key, size_t hashval, size_t& current_pos, bool& overflow, int rehash);
+	ElementType* find_from_bucket(binarykMer<m, k>& key, size_t hashval);
+	void assign_position(size_t current_pos, binarykMer<m, k>& key)
+	{
+		assert(table[current_pos].flags.assigned == false);
+		table[current_pos].kMer = key;
+		table[current_pos].flags.assigned = true;
+		bucket_tags(current_pos / bucket_size)[current_pos % bucket_size] = Hsh_kMerTag(key);
+	}
+
 public:
 	Hsh(int log2_buckets, long long onebucket_size);
 
+	Hsh(const Hsh& other) :
+		kmer_size(other.kmer_size), number_buckets(other.number_buckets), bucket_size(other.bucket_size),
+		next_element(other.next_element), collisions(other.collisions), unique_kmers(other.unique_kmers),
+		max_rehash_tries(other.max_rehash_tries), table(other.table),
+		tags_stride(other.tags_stride), tags_offset(other.tags_offset), tags_storage(other.tags_storage)
+	{
+		realign_tags();
+	}
+
+	Hsh(Hsh&& other) :
+		kmer_size(other.kmer_size), number_buckets(other.number_buckets), bucket_size(other.bucket_size),
+		next_element(std::move(other.next_element)), collisions(std::move(other.collisions)), unique_kmers(other.unique_kmers),
+		max_rehash_tries(other.max_rehash_tries), table(std::move(other.table)),
+		tags_stride(other.tags_stride), tags_offset(other.tags_offset), tags_storage(std::move(other.tags_storage))
+	{
+		realign_tags();
+	}
+
+	Hsh& operator=(const Hsh& other)
+	{
+		if(this != &other)
+		{
+			Hsh copy(other);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	Hsh& operator=(Hsh&& other)
+	{
+		kmer_size = other.kmer_size;
+		number_buckets = other.number_buckets;
+		bucket_size = other.bucket_size;
+		next_element = std::move(other.next_element);
+		collisions = std::move(other.collisions);
+		unique_kmers = other.unique_kmers;
+		max_rehash_tries = other.max_rehash_tries;
+		table = std::move(other.table);
+		tags_stride = other.tags_stride;
+		tags_offset = other.tags_offset;
+		tags_storage = std::move(other.tags_storage);
+		realign_tags();
+		return *this;
+	}
+
 	ElementType* hash_table_find_or_insert(binarykMer<m, k>& key, bool& found);
 	ElementType* hash_table_insert(binarykMer<m, k>& key);
+	// First-probe (rehash 0) bucket of key, and insertion into exactly that bucket: returns 0 if the
+	// bucket is full. Calls for different buckets may run concurrently - used for parallel bulk loading.
+	size_t hash_table_bucket(binarykMer<m, k>& key);
+	ElementType* hash_table_insert_into_bucket(binarykMer<m, k>& key, size_t hashval);
 	ElementType* hash_table_find(binarykMer<m, k>& key);
+	// hash_table_find(..) for each of keys, in batches: the buckets of a batch are hashed and prefetched
+	// first, then the table elements with matching tags, and only then are the keys searched - so the
+	// cache misses of a batch overlap instead of following each other
+	void hash_table_find_batch(std::vector< binarykMer<m, k> >& keys, std::vector<ElementType*>& ret_elements);
 	hashTableElement<m, k, ElementType >* hash_table_find_fullElement(binarykMer<m, k>& key);
 
 	bool hash_table_find_in_bucket(binarykMer<m, k>& key, size_t& current_pos, bool& overflow, int rehash);
 
+	size_t getNumberBuckets()
+	{
+		return number_buckets;
+	}
+
 	size_t getTableSize()
 	{
 		return table.size();
@@ -120,6 +254,10 @@ Hsh<m, k, ElementType>::Hsh(int log2_buckets, long long onebucket_size)
 
 	table.resize(number_buckets * bucket_size);
 	next_element.resize(number_buckets, 0);
+
+	tags_stride = ((bucket_size + 15) / 16) * 16;
+	tags_storage.resize(number_buckets * tags_stride + 64, 0);
+	tags_offset = (64 - ((uintptr_t)tags_storage.data() % 64)) % 64;
 }
 
 template<int m, int k, class ElementType>
@@ -156,6 +294,13 @@ hashTableElement<m, k, ElementType >* Hsh<m, k, ElementType>::hash_table_find_fu
 
 template<int m, int k, class ElementType>
 ElementType* Hsh<m, k, ElementType>::hash_table_find(binarykMer<m, k>& key)
+{
+	return find_from_bucket(key, bucket_of_rehashed(key, 0));
+}
+
+// hash_table_find(..), with the first-probe bucket already computed
+template<int m, int k, class ElementType>
+ElementType* Hsh<m, k, ElementType>::find_from_bucket(binarykMer<m, k>& key, size_t hashval)
 {
     int rehash = 0;
     bool overflow;
@@ -166,10 +311,10 @@ ElementType* Hsh<m, k, ElementType>::hash_table_find(binarykMer<m, k>& key)
 
 	do
 	{
-		found = hash_table_find_in_bucket(key, current_pos, overflow, rehash);
+		found = find_in_given_bucket(key, hashval, current_pos, overflow, rehash);
 		if (found) //then we know overflow is false - this is checked in find_in_bucket
 		{
-			forReturn =  &(table.at(current_pos).element);
+			forReturn =  &(table[current_pos].element);
 		}
 		else if (overflow)
 		{
@@ -179,6 +324,7 @@ ElementType* Hsh<m, k, ElementType>::hash_table_find(binarykMer<m, k>& key)
 				//fprintf(stderr,"too much rehashing!! Rehash=%d\n", rehash);
 				throw std::runtime_error("Dear user - you have not allocated enough memory to contain your sequence data. Either allocate more memory (have you done your calculations right? have you allowed for sequencing errors?), or threshold more harshly on quality score, and try again. Aborting mission.\n");
 			}
+			hashval = bucket_of_rehashed(key, rehash);
 		}
 	}
 	while(overflow);
@@ -186,6 +332,51 @@ ElementType* Hsh<m, k, ElementType>::hash_table_find(binarykMer<m, k>& key)
     return forReturn;
 }
 
+template<int m, int k, class ElementType>
+void Hsh<m, k, ElementType>::hash_table_find_batch(std::vector< binarykMer<m, k> >& keys, std::vector<ElementType*>& ret_elements)
+{
+	const size_t batchSize = 16;
+	size_t batch_buckets[batchSize];
+
+	ret_elements.resize(keys.size());
+	for(size_t batchStart = 0; batchStart < keys.size(); batchStart += batchSize)
+	{
+		size_t batchStop = std::min(batchStart + batchSize, keys.size());
+
+		// first pass: bucket tags, second pass: first element with a matching tag, third pass: search
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			batch_buckets[i - batchStart] = bucket_of_rehashed(keys[i], 0);
+			__builtin_prefetch(bucket_tags(batch_buckets[i - batchStart]));
+		}
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			size_t hashval = batch_buckets[i - batchStart];
+			const unsigned char* tags = bucket_tags(hashval);
+			unsigned char tag = Hsh_kMerTag(keys[i]);
+			for(size_t chunk = 0; chunk < (size_t)bucket_size; chunk += 16)
+			{
+				unsigned int match;
+				unsigned int empty;
+				Hsh_compareTags(tags + chunk, tag, match, empty);
+				if(match)
+				{
+					__builtin_prefetch(&(table[hashval * bucket_size + chunk + __builtin_ctz(match)]));
+					break;
+				}
+				if(empty)
+				{
+					break;
+				}
+			}
+		}
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			ret_elements[i] = find_from_bucket(keys[i], batch_buckets[i - batchStart]);
+		}
+	}
+}
+
 template<int m, int k, class ElementType>
 ElementType* Hsh<m, k, ElementType>::hash_table_find_or_insert(binarykMer<m, k>& key, bool& found)
 {
@@ -205,10 +396,7 @@ ElementType* Hsh<m, k, ElementType>::hash_table_find_or_insert(binarykMer<m, k>&
             if (! overflow) //it is definitely nowhere in the hashtable, so free to insert
             {
                 //sanity check
-            	assert(table.at(current_pos).flags.assigned == false);
-
-            	table.at(current_pos).kMer = key;
-            	table.at(current_pos).flags.assigned = true;
+            	assign_position(current_pos, key);
 
                 unique_kmers++;
 
@@ -252,18 +440,13 @@ ElementType* Hsh<m, k, ElementType>::hash_table_insert(binarykMer<m, k>& key)
     {
         //add the rehash to the final bitfield in the BinaryKmer
 
-    	binarykMer<m, k> kMer_with_rehash = key;
-    	kMer_with_rehash.at(m - 1) =	kMer_with_rehash.at(m - 1) + (bitfield_of_64bits) rehash;
-
-        size_t hashval = kMer_with_rehash.hash_value(number_buckets);
+        size_t hashval = bucket_of_rehashed(key, rehash);
 
         if (next_element.at(hashval) < bucket_size)
         {
             //can insert element
             size_t  current_pos   = (size_t) hashval * bucket_size + (size_t) next_element.at(hashval);   //position in hash table
-            assert(table.at(current_pos).flags.assigned == false);
-            table.at(current_pos).kMer = key;
-            table.at(current_pos).flags.assigned = true;
+            assign_position(current_pos, key);
             unique_kmers++;
             next_element.at(hashval)++;
             forReturn = &(table.at(current_pos).element);
@@ -286,6 +469,31 @@ ElementType* Hsh<m, k, ElementType>::hash_table_insert(binarykMer<m, k>& key)
 	return forReturn;
 }
 
+template<int m, int k, class ElementType>
+size_t Hsh<m, k, ElementType>::hash_table_bucket(binarykMer<m, k>& key)
+{
+	return key.hash_value(number_buckets);
+}
+
+template<int m, int k, class ElementType>
+ElementType* Hsh<m, k, ElementType>::hash_table_insert_into_bucket(binarykMer<m, k>& key, size_t hashval)
+{
+	assert(hashval < number_buckets);
+	if (next_element[hashval] >= bucket_size)
+	{
+		return 0;
+	}
+
+	size_t current_pos = (size_t) hashval * bucket_size + (size_t) next_element[hashval];
+	assign_position(current_pos, key);
+	next_element[hashval]++;
+
+	#pragma omp atomic
+	unique_kmers++;
+
+	return &(table.at(current_pos).element);
+}
+
 // Lookup for key in bucket defined by the hash value.
 // If key is in bucket, returns true and the position of the key/element in current_pos.
 // If key is not in bucket, and bucket is not full, returns the next available position in current_pos (and overflow is returned as false)
@@ -293,47 +501,60 @@ ElementType* Hsh<m, k, ElementType>::hash_table_insert(binarykMer<m, k>& key)
 template<int m, int k, class ElementType>
 bool Hsh<m, k, ElementType>::hash_table_find_in_bucket(binarykMer<m, k>& key, size_t& current_pos, bool& overflow, int rehash)
 {
+	return find_in_given_bucket(key, bucket_of_rehashed(key, rehash), current_pos, overflow, rehash);
+}
 
-	binarykMer<m, k> kMer_with_rehash = key;
-	kMer_with_rehash.at(m - 1) = (kMer_with_rehash.at(m - 1) + (bitfield_of_64bits) rehash);
+template<int m, int k, class ElementType>
+bool Hsh<m, k, ElementType>::find_in_given_bucket(binarykMer<m, k>& key, size_t hashval, size_t& current_pos, bool& overflow, int rehash)
+{
+	size_t bucket_start_pos = (size_t) hashval * bucket_size;
+	const unsigned char* tags = bucket_tags(hashval);
+	unsigned char tag = Hsh_kMerTag(key);
 
-    size_t hashval = kMer_with_rehash.hash_value(number_buckets);
+	// a full bucket means that a miss continues with the next rehash - start loading that bucket now
+	if((tags[bucket_size - 1] != 0) && (rehash < max_rehash_tries))
+	{
+		size_t next_hashval = bucket_of_rehashed(key, rehash + 1);
+		__builtin_prefetch(bucket_tags(next_hashval));
+	}
 
-	bool found = false;
 	overflow = false;
 
-	size_t i = 0; //position in bucket
-	size_t bucket_start_pos = (size_t) hashval * bucket_size;
+	// slots are filled from the start of the bucket, so the first empty slot ends the search
+	for(size_t chunk = 0; chunk < (size_t)bucket_size; chunk += 16)
+	{
+		unsigned int match;
+		unsigned int empty;
+		Hsh_compareTags(tags + chunk, tag, match, empty);
 
-    while(
-    		(i<bucket_size) &&   // still within the bucket
-            (table.at(bucket_start_pos+i).flags.assigned == true)  && // not yet reached an empty space
-            (!found)
-         )
-    {
-		if (key == table.at(bucket_start_pos+i).kMer)
+		unsigned int firstEmpty = (empty == 0) ? 16 : __builtin_ctz(empty);
+		match &= (firstEmpty == 16) ? 0xFFFF : ((1u << firstEmpty) - 1);
+		while(match)
 		{
-			found = true;
+			size_t i = chunk + __builtin_ctz(match);
+			if (key == table[bucket_start_pos+i].kMer)
+			{
+				current_pos = bucket_start_pos + i;
+				return true;
+			}
+			match &= (match - 1);
 		}
-		else
+
+		if(firstEmpty != 16)
 		{
-			i++;
+			size_t i = chunk + firstEmpty;
+			current_pos = bucket_start_pos + i;
+			if(i >= (size_t)bucket_size)
+			{
+				overflow = true;
+			}
+			return false;
 		}
-    }
-
-    current_pos = bucket_start_pos + i;
-    if (i == bucket_size)
-    {
-        overflow = true;
-    }
-
-    assert(! (found && overflow));
-
-    // I do not understand this - if found, we cannot be overflown and vice versa. But if not found,
-    // we can either be overflown or not. Have therefore substituted with above.
-    // assert( (! found) || (! overflow));
+	}
 
-    return found;
+	current_pos = bucket_start_pos + bucket_size;
+	overflow = true;
+	return false;
 }
 
 
@@ -25,6 +25,7 @@
 #include <map>
 #include <cstdlib>
 #include <queue>
+#include <algorithm>
 
 #include "../Hsh.h"
 #include "../../test.h"
@@ -172,6 +173,7 @@ protected:
 
 	bool read_next_error_cleaning_object(FILE* fp, ErrorCleaning& cl);
 	bool db_node_read_multicolour_binary(FILE* fp, binarykMer<m, k>& kMer, DeBruijnElement<colours>& node, int num_colours_in_binary, int binversion_in_binheader);
+	void db_node_decode_multicolour_binary(const char* record, binarykMer<m, k>& kMer, DeBruijnElement<colours>& node, int num_colours_in_binary);
 	bool check_binary_compatibility(FILE* fp, BinaryHeaderInfo<colours>& binfo, BinaryHeaderErrorCode& ecode, int first_colour_loading_into);
 	bool get_binversion6_extra_data(FILE* fp, BinaryHeaderInfo<colours>& binfo, BinaryHeaderErrorCode& ecode, int first_colour_loading_into);
 	bool get_read_lengths_and_total_seqs_from_header(FILE* fp, BinaryHeaderInfo<colours>& binfo, BinaryHeaderErrorCode& ecode, int first_colour_loading_into);
@@ -230,8 +232,6 @@ public:
 	        throw std::runtime_error("load_multicolour_binary_from_filename_into_graph cannot open file "+filename);
 	    }
 
-	    int count=0;
-
 	    BinaryHeaderErrorCode ecode = EValid;
 	    BinaryHeaderInfo<colours> binfo;
 	    if(! check_binary_compatibility(fp_bin, binfo, ecode, 0))
@@ -242,23 +242,156 @@ public:
 	    int num_cols_in_loaded_binary = binfo.number_of_colours;
 
 	    //always reads the multicol binary into successive colours starting from 0 - assumes the hash table is empty prior to this
+	    if((num_cols_in_loaded_binary <= 0) || (num_cols_in_loaded_binary > colours))
+	    {
+	    	throw std::runtime_error("Cannot load binary "+filename+": it has more colours than the graph.");
+	    }
+
+	    // Records (k-mer, coverage and edges per colour) have a fixed size and are read in batches.
+	    // Each thread owns a contiguous range of buckets and inserts, in file order, the records of the
+	    // batch whose first-probe bucket falls into its range - so no two threads touch the same bucket,
+	    // and the table layout does not depend on the number of threads. Records whose first bucket is
+	    // full are inserted (with rehashing) afterwards, in file order.
+	    size_t recordSize = m * sizeof(bitfield_of_64bits) + num_cols_in_loaded_binary * (sizeof(Covg) + sizeof(Edges));
+	    const size_t batchRecords = 1 << 20;
+	    std::vector<char> batch(batchRecords * recordSize);
+	    std::vector<size_t> batch_buckets(batchRecords);
+
+	    size_t number_buckets = hash->getNumberBuckets();
+	    int maxThreads = omp_get_max_threads();
+	    std::vector<std::vector<long long> > overflow_perThread(maxThreads);
+	    std::vector<char> overflow_records;
+	    long long overflow_n = 0;
+
+	    long long records = 0;
+	    while(true)
+	    {
+	    	size_t batchBytes = fread(batch.data(), 1, batch.size(), fp_bin);
+	    	size_t batchN = batchBytes / recordSize;
+	    	size_t remainder = batchBytes % recordSize;
+	    	if(remainder >= (m * sizeof(bitfield_of_64bits)))
+	    	{
+	    		throw std::runtime_error("Failed to read covg or Edges in loadMultiColourBinary - truncated binary "+filename);
+	    	}
+
+	    	#pragma omp parallel for schedule(static)
+	    	for(long long rI = 0; rI < (long long)batchN; rI++)
+	    	{
+	    		binarykMer<m, k> kMer;
+	    		memcpy(kMer.kMerBinaryRepresentation.data(), batch.data() + rI * recordSize, m * sizeof(bitfield_of_64bits));
+	    		batch_buckets[rI] = hash->hash_table_bucket(kMer);
+	    	}
+
+	    	#pragma omp parallel
+	    	{
+	    		int thisThread = omp_get_thread_num();
+	    		int nThreads = omp_get_num_threads();
+	    		size_t firstBucket = (number_buckets / nThreads) * thisThread;
+	    		size_t lastBucket = (thisThread == (nThreads - 1)) ? number_buckets : ((number_buckets / nThreads) * (thisThread + 1));
+
+	    		binarykMer<m, k> kMer;
+	    		DeBruijnElement<colours> node;
+	    		for(size_t rI = 0; rI < batchN; rI++)
+	    		{
+	    			size_t bucket = batch_buckets[rI];
+	    			if((bucket < firstBucket) || (bucket >= lastBucket))
+	    				continue;
+
+	    			db_node_decode_multicolour_binary(batch.data() + rI * recordSize, kMer, node, num_cols_in_loaded_binary);
+	    			DeBruijnElement<colours>* element_insert_position = hash->hash_table_insert_into_bucket(kMer, bucket);
+	    			if(element_insert_position)
+	    			{
+	    				*element_insert_position = node;
+	    			}
+	    			else
+	    			{
+	    				overflow_perThread.at(thisThread).push_back(rI);
+	    			}
+	    		}
+	    	}
+
+	    	std::vector<long long> batch_overflow;
+	    	for(int tI = 0; tI < maxThreads; tI++)
+	    	{
+	    		batch_overflow.insert(batch_overflow.end(), overflow_perThread.at(tI).begin(), overflow_perThread.at(tI).end());
+	    		overflow_perThread.at(tI).clear();
+	    	}
+	    	std::sort(batch_overflow.begin(), batch_overflow.end());
+	    	for(size_t oI = 0; oI < batch_overflow.size(); oI++)
+	    	{
+	    		const char* record = batch.data() + batch_overflow.at(oI) * recordSize;
+	    		overflow_records.insert(overflow_records.end(), record, record + recordSize);
+	    	}
+	    	overflow_n += batch_overflow.size();
+
+	    	records += batchN;
+	    	if(batchBytes < batch.size())
+	    	{
+	    		break;
+	    	}
+	    }
+	    fclose(fp_bin);
 
 	    binarykMer<m, k> kMer;
 	    DeBruijnElement<colours> node;
+	    for(long long oI = 0; oI < overflow_n; oI++)
+	    {
+	    	db_node_decode_multicolour_binary(overflow_records.data() + oI * recordSize, kMer, node, num_cols_in_loaded_binary);
+	    	DeBruijnElement<colours>* element_insert_position = hash->hash_table_insert(kMer);
+	    	*element_insert_position = node;
+	    }
 
-	    while (db_node_read_multicolour_binary(fp_bin, kMer, node, num_cols_in_loaded_binary, binfo.version))
+	    seq_length = records * k;
+	    return seq_length;
+	}
+
+	// k-mer codes (kMerBinaryRepresentation[0]; m = 1 only) of all records of a multicolour binary, without
+	// inserting them into the graph - input for compactkMerSet::build(..)
+	void readMultiColourBinarykMerCodes(std::string filename, std::vector<uint64_t>& ret_codes)
+	{
+		if(m != 1)
+		{
+			throw std::runtime_error("readMultiColourBinarykMerCodes(..) needs k-mers that fit into one bitfield.");
+		}
+
+	    FILE* fp_bin = fopen(filename.c_str(), "r");
+	    if (fp_bin == NULL)
 	    {
-	        count++;
+	        throw std::runtime_error("readMultiColourBinarykMerCodes cannot open file "+filename);
+	    }
 
-			
-	        DeBruijnElement<colours>* element_insert_position = hash->hash_table_insert(kMer);
-	        *element_insert_position = node;
-	        seq_length += k;
-			node.nullify();
+	    BinaryHeaderErrorCode ecode = EValid;
+	    BinaryHeaderInfo<colours> binfo;
+	    if(! check_binary_compatibility(fp_bin, binfo, ecode, 0))
+	    {
+	    	throw std::runtime_error("Cannot load binary "+filename+": binary problem detected!");
 	    }
 
+	    size_t recordSize = sizeof(bitfield_of_64bits) + binfo.number_of_colours * (sizeof(Covg) + sizeof(Edges));
+	    const size_t batchRecords = 1 << 20;
+	    std::vector<char> batch(batchRecords * recordSize);
+
+	    ret_codes.clear();
+	    while(true)
+	    {
+	    	size_t batchBytes = fread(batch.data(), 1, batch.size(), fp_bin);
+	    	size_t batchN = batchBytes / recordSize;
+	    	if((batchBytes % recordSize) >= sizeof(bitfield_of_64bits))
+	    	{
+	    		throw std::runtime_error("Failed to read covg or Edges in readMultiColourBinarykMerCodes - truncated binary "+filename);
+	    	}
+	    	for(size_t rI = 0; rI < batchN; rI++)
+	    	{
+	    		uint64_t code;
+	    		memcpy(&code, batch.data() + rI * recordSize, sizeof(uint64_t));
+	    		ret_codes.push_back(code);
+	    	}
+	    	if(batchBytes < batch.size())
+	    	{
+	    		break;
+	    	}
+	    }
 	    fclose(fp_bin);
-	    return seq_length;
 	}
 
 	void checkGraphIntegrity()
@@ -435,6 +568,99 @@ public:
 		return (hash->hash_table_find(queryKey) != 0);
 	}
 
+	// Keys (canonical k-mers) of all k-mers of sequence, i.e. ret_keys.at(i) is the key that
+	// kMerinGraph(sequence.substr(i, k)) looks up. Forward and reverse complement are rolled base by base;
+	// k-mers with characters other than ACGT go through loadSeq(..) / element_get_key(..) as before.
+	void sequenceGetKeys(const std::string& sequence, std::vector< binarykMer<m, k> >& ret_keys)
+	{
+		// the top word always holds 1..31 bases (as binarykMer assumes, k is odd) - for k % 32 == 0
+		// the shifts by (64 - top_bits) and (top_bits - 2) below would be undefined
+		static_assert((k % 32) != 0, "sequenceGetKeys needs a partially used top word (k % 32 != 0)");
+
+		ret_keys.clear();
+		if((int)sequence.length() < k)
+			return;
+		ret_keys.reserve(sequence.length() - k + 1);
+
+		const int top_word = m - (k+31)/32;
+		const int top_bits = 2 * (k % 32);
+		const bitfield_of_64bits top_mask = (~ (bitfield_of_64bits)0 >> (64 - top_bits));
+
+		binarykMer<m, k> forward;
+		binarykMer<m, k> reverse;
+		int lastInvalid = -1;
+		for(int i = 0; i < (int)sequence.length(); i++)
+		{
+			Nucleotide n = char_to_binary_nucleotide(sequence[i]);
+			if(n == Undefined)
+			{
+				lastInvalid = i;
+			}
+
+			// as bitOps_left_shift_one_base_and_insert_new_base_at_right_end(n)
+			for(int wI = top_word; wI < m-1; wI++)
+			{
+				forward.kMerBinaryRepresentation[wI] = (forward.kMerBinaryRepresentation[wI] << 2) | (forward.kMerBinaryRepresentation[wI+1] >> 62);
+			}
+			forward.kMerBinaryRepresentation[m-1] <<= 2;
+			forward.kMerBinaryRepresentation[top_word] &= top_mask;
+			forward.kMerBinaryRepresentation[m-1] |= n;
+
+			// complement of n enters at the most significant end
+			for(int wI = m-1; wI > top_word; wI--)
+			{
+				reverse.kMerBinaryRepresentation[wI] = (reverse.kMerBinaryRepresentation[wI] >> 2) | (reverse.kMerBinaryRepresentation[wI-1] << 62);
+			}
+			reverse.kMerBinaryRepresentation[top_word] >>= 2;
+			reverse.kMerBinaryRepresentation[top_word] |= ((bitfield_of_64bits)(3 - (n & 3)) << (top_bits - 2));
+
+			if(i < (k - 1))
+				continue;
+
+			if(lastInvalid > (i - k))
+			{
+				ret_keys.push_back(forward.element_get_key());
+				continue;
+			}
+
+			// element_get_key(): the smaller of the two, comparing from the most significant word
+			bool forward_smaller = true;
+			for(int wI = top_word; wI < m; wI++)
+			{
+				if(forward.kMerBinaryRepresentation[wI] != reverse.kMerBinaryRepresentation[wI])
+				{
+					forward_smaller = (forward.kMerBinaryRepresentation[wI] < reverse.kMerBinaryRepresentation[wI]);
+					break;
+				}
+			}
+			ret_keys.push_back(forward_smaller ? forward : reverse);
+		}
+	}
+
+	// Batched kMerinGraph(..) / find(..) for all k-mers of sequence: ret_elements.at(i) is the element of
+	// sequence.substr(i, k), 0 if it is not in the graph. Keys are rolled incrementally, and bucket and
+	// element accesses are prefetched batch-wise (Hsh::hash_table_find_batch(..)).
+	void sequenceFindkMers(const std::string& sequence, std::vector<DeBruijnElement<colours>*>& ret_elements)
+	{
+		std::vector< binarykMer<m, k> > keys;
+		sequenceGetKeys(sequence, keys);
+		hash->hash_table_find_batch(keys, ret_elements);
+	}
+
+	// number of k-mers of sequence that are in the graph
+	int sequenceCountkMersinGraph(const std::string& sequence)
+	{
+		std::vector<DeBruijnElement<colours>*> elements;
+		sequenceFindkMers(sequence, elements);
+		int forReturn = 0;
+		for(size_t i = 0; i < elements.size(); i++)
+		{
+			if(elements[i] != 0)
+				forReturn++;
+		}
+		return forReturn;
+	}
+
 	std::vector<binarykMer<m, k>> walkOneStep(binarykMer<m, k>& key, bool reverse)
 	{
 		return walkOneStep(0, key, reverse);
@@ -1517,4 +1743,25 @@ bool DeBruijnGraph<m, k, colours>::db_node_read_multicolour_binary(FILE* fp, bin
 }
 
 
+// one record of a multicolour binary from memory: the same layout that db_node_read_multicolour_binary(..) reads
+// (coverage is an int in version 4 and a uint32_t afterwards - 4 bytes either way)
+template<int m, int k, int colours>
+void DeBruijnGraph<m, k, colours>::db_node_decode_multicolour_binary(const char* record, binarykMer<m, k>& kMer, DeBruijnElement<colours>& node, int num_colours_in_binary)
+{
+	assert((num_colours_in_binary > 0) && (num_colours_in_binary <= colours));
+
+	memcpy(kMer.kMerBinaryRepresentation.data(), record, sizeof(bitfield_of_64bits)*m);
+	record += sizeof(bitfield_of_64bits)*m;
+
+	node.nullify();
+	for (int i = 0; i < num_colours_in_binary; i++)
+	{
+		Covg covg;
+		memcpy(&covg, record + i * sizeof(Covg), sizeof(Covg));
+		node.coverage.at(i) = covg;
+		node.individual_edges.at(i) = record[num_colours_in_binary * sizeof(Covg) + i];
+	}
+}
+
+
 #endif /* DEBRUIJNGRAPH_H_ */
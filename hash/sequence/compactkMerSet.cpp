@@ -0,0 +1,400 @@
+/*
+ * compactkMerSet.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "compactkMerSet.h"
+
+#include <assert.h>
+#include <string.h>
+#include <algorithm>
+#include <stdexcept>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+static const char compactkMerSet_magic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'K', 'S'};
+static const uint32_t compactkMerSet_version = 1;
+static const unsigned int compactkMerSet_maxLevels = 24;
+static const size_t compactkMerSet_blockBits = 512;
+
+const uint64_t compactkMerSet::invalidCode;
+
+static inline uint64_t compactkMerSet_mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+// position of code in a level of levelBits bits
+static inline uint64_t compactkMerSet_position(uint64_t code, unsigned int level, uint64_t levelBits)
+{
+	uint64_t h = compactkMerSet_mix(code + (uint64_t)(level + 1) * 0x9E3779B97F4A7C15ULL);
+	return (uint64_t)(((unsigned __int128)h * levelBits) >> 64);
+}
+
+static inline unsigned int compactkMerSet_popcount(uint64_t x)
+{
+	return __builtin_popcountll(x);
+}
+
+compactkMerSet::compactkMerSet() : k(0), fingerprintBits(8), n_kMers(0), n_words(0), n_placed(0), n_fallback(0), words(0), ranks(0), fallback(0), fingerprints(0), mapped(0), mappedSize(0)
+{
+	std::vector<uint64_t> empty;
+	build(1, empty, 8);
+}
+
+compactkMerSet::~compactkMerSet()
+{
+	unmap();
+}
+
+void compactkMerSet::unmap()
+{
+	if(mapped)
+	{
+		munmap(mapped, mappedSize);
+		mapped = 0;
+		mappedSize = 0;
+	}
+}
+
+uint64_t compactkMerSet::fingerprint(uint64_t code) const
+{
+	return compactkMerSet_mix(code ^ 0xD6E8FEB86659FD93ULL) >> (64 - fingerprintBits);
+}
+
+size_t compactkMerSet::storageWords() const
+{
+	size_t fingerprintBytes = (fingerprintBits <= 8) ? 1 : 2;
+	return n_words + (n_words / 8 + 1) + n_fallback + (n_kMers * fingerprintBytes + 7) / 8;
+}
+
+void compactkMerSet::setPointers(const uint64_t* data)
+{
+	words = data;
+	ranks = words + n_words;
+	fallback = ranks + (n_words / 8 + 1);
+	fingerprints = fallback + n_fallback;
+}
+
+void compactkMerSet::build(int k, std::vector<uint64_t>& kMerCodes, int fingerprintBits)
+{
+	if(!((k >= 1) && (k <= 31)))
+	{
+		throw std::runtime_error("compactkMerSet: k must be between 1 and 31.");
+	}
+	if(!((fingerprintBits >= 1) && (fingerprintBits <= 16)))
+	{
+		throw std::runtime_error("compactkMerSet: fingerprints must have between 1 and 16 bits.");
+	}
+	unmap();
+	this->k = k;
+	this->fingerprintBits = fingerprintBits;
+
+	uint64_t kMerMask = (~(uint64_t)0) >> (64 - 2*k);
+	std::sort(kMerCodes.begin(), kMerCodes.end());
+	kMerCodes.erase(std::unique(kMerCodes.begin(), kMerCodes.end()), kMerCodes.end());
+	if(kMerCodes.size() && (kMerCodes.back() > kMerMask))
+	{
+		throw std::runtime_error("compactkMerSet: invalid k-mer code.");
+	}
+	n_kMers = kMerCodes.size();
+
+	// levels: a key is placed in the first level in which no other remaining key has its position
+	level_bits.clear();
+	level_firstWord.clear();
+	std::vector<uint64_t> levelWords;
+	std::vector<uint64_t> remaining;
+	const std::vector<uint64_t>* levelKeys = &kMerCodes;
+	for(unsigned int level = 0; (level < compactkMerSet_maxLevels) && (levelKeys->size() > 0); level++)
+	{
+		uint64_t bits = ((2 * levelKeys->size() + compactkMerSet_blockBits - 1) / compactkMerSet_blockBits) * compactkMerSet_blockBits;
+		std::vector<uint64_t> seen(bits / 64, 0);
+		std::vector<uint64_t> collision(bits / 64, 0);
+
+		#pragma omp parallel for schedule(static)
+		for(long long kI = 0; kI < (long long)levelKeys->size(); kI++)
+		{
+			uint64_t position = compactkMerSet_position((*levelKeys)[kI], level, bits);
+			uint64_t bit = (uint64_t)1 << (position % 64);
+			uint64_t before;
+			#pragma omp atomic capture
+			{
+				before = seen[position / 64];
+				seen[position / 64] |= bit;
+			}
+			if(before & bit)
+			{
+				#pragma omp atomic
+				collision[position / 64] |= bit;
+			}
+		}
+
+		level_bits.push_back(bits);
+		level_firstWord.push_back(levelWords.size());
+		for(size_t wI = 0; wI < seen.size(); wI++)
+		{
+			levelWords.push_back(seen[wI] & ~collision[wI]);
+		}
+
+		std::vector<uint64_t> nextRemaining;
+		for(size_t kI = 0; kI < levelKeys->size(); kI++)
+		{
+			uint64_t position = compactkMerSet_position((*levelKeys)[kI], level, bits);
+			if(collision[position / 64] & ((uint64_t)1 << (position % 64)))
+			{
+				nextRemaining.push_back((*levelKeys)[kI]);
+			}
+		}
+		remaining.swap(nextRemaining);
+		levelKeys = &remaining;
+	}
+
+	n_words = levelWords.size();
+	n_fallback = levelKeys->size();
+
+	storage.assign(storageWords(), 0);
+	std::copy(levelWords.begin(), levelWords.end(), storage.begin());
+	std::vector<uint64_t>().swap(levelWords);
+	setPointers(storage.data());
+
+	uint64_t* ranks_writable = storage.data() + n_words;
+	uint64_t setBits = 0;
+	for(size_t wI = 0; wI < n_words; wI++)
+	{
+		if((wI % 8) == 0)
+		{
+			ranks_writable[wI / 8] = setBits;
+		}
+		setBits += compactkMerSet_popcount(words[wI]);
+	}
+	ranks_writable[n_words / 8] = setBits;
+	n_placed = setBits;
+	assert((n_placed + n_fallback) == n_kMers);
+
+	std::copy(levelKeys->begin(), levelKeys->end(), storage.begin() + (fallback - storage.data()));
+	std::vector<uint64_t>().swap(remaining);
+
+	uint8_t* fingerprints_8 = (uint8_t*)(storage.data() + (fallback - storage.data()) + n_fallback);
+	uint16_t* fingerprints_16 = (uint16_t*)fingerprints_8;
+	bool slotsOK = true;
+	#pragma omp parallel for schedule(static) reduction(&&:slotsOK)
+	for(long long kI = 0; kI < (long long)kMerCodes.size(); kI++)
+	{
+		uint64_t s;
+		if(! slot(kMerCodes[kI], s))
+		{
+			slotsOK = false;
+			continue;
+		}
+		if(fingerprintBits <= 8)
+		{
+			fingerprints_8[s] = fingerprint(kMerCodes[kI]);
+		}
+		else
+		{
+			fingerprints_16[s] = fingerprint(kMerCodes[kI]);
+		}
+	}
+	if(! slotsOK)
+	{
+		throw std::runtime_error("compactkMerSet: inconsistent perfect hash.");
+	}
+
+	std::vector<uint64_t>().swap(kMerCodes);
+}
+
+bool compactkMerSet::slot(uint64_t code, uint64_t& ret_slot) const
+{
+	for(unsigned int level = 0; level < level_bits.size(); level++)
+	{
+		uint64_t position = compactkMerSet_position(code, level, level_bits[level]);
+		size_t wI = level_firstWord[level] + position / 64;
+		uint64_t word = words[wI];
+		uint64_t bit = (uint64_t)1 << (position % 64);
+		if(word & bit)
+		{
+			uint64_t rank = ranks[wI / 8];
+			for(size_t blockWordI = wI & ~(size_t)7; blockWordI < wI; blockWordI++)
+			{
+				rank += compactkMerSet_popcount(words[blockWordI]);
+			}
+			rank += compactkMerSet_popcount(word & (bit - 1));
+			ret_slot = rank;
+			return true;
+		}
+	}
+
+	const uint64_t* fallback_end = fallback + n_fallback;
+	const uint64_t* fallback_position = std::lower_bound(fallback, fallback_end, code);
+	if((fallback_position != fallback_end) && (*fallback_position == code))
+	{
+		ret_slot = n_placed + (fallback_position - fallback);
+		return true;
+	}
+	return false;
+}
+
+bool compactkMerSet::contains(uint64_t code) const
+{
+	if(code == invalidCode)
+		return false;
+
+	uint64_t s;
+	if(! slot(code, s))
+		return false;
+
+	if(fingerprintBits <= 8)
+	{
+		return (((const uint8_t*)fingerprints)[s] == fingerprint(code));
+	}
+	else
+	{
+		return (((const uint16_t*)fingerprints)[s] == fingerprint(code));
+	}
+}
+
+int compactkMerSet::countContained_canonical(const std::vector<uint64_t>& forward, const std::vector<uint64_t>& reverse) const
+{
+	assert(forward.size() == reverse.size());
+
+	const size_t batchSize = 16;
+	uint64_t batch_codes[batchSize];
+
+	int forReturn = 0;
+	for(size_t batchStart = 0; batchStart < forward.size(); batchStart += batchSize)
+	{
+		size_t batchStop = std::min(batchStart + batchSize, forward.size());
+
+		// first pass: first-level words, second pass: lookups
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			uint64_t code = std::min(forward[i], reverse[i]);
+			batch_codes[i - batchStart] = code;
+			if((code != invalidCode) && (level_bits.size() > 0))
+			{
+				__builtin_prefetch(words + (compactkMerSet_position(code, 0, level_bits[0]) / 64));
+			}
+		}
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			if(contains(batch_codes[i - batchStart]))
+			{
+				forReturn++;
+			}
+		}
+	}
+	return forReturn;
+}
+
+void compactkMerSet::save(std::string filename) const
+{
+	std::ofstream output(filename.c_str(), std::ios::out | std::ios::binary);
+	if(! output.is_open())
+	{
+		throw std::runtime_error("Cannot open " + filename + " for writing.");
+	}
+
+	uint32_t header_32[4] = {compactkMerSet_version, (uint32_t)k, (uint32_t)fingerprintBits, (uint32_t)level_bits.size()};
+	uint64_t header_64[2] = {n_kMers, n_fallback};
+	output.write(compactkMerSet_magic, sizeof(compactkMerSet_magic));
+	output.write((const char*)header_32, sizeof(header_32));
+	output.write((const char*)header_64, sizeof(header_64));
+	output.write((const char*)level_bits.data(), level_bits.size() * sizeof(uint64_t));
+	output.write((const char*)words, storageWords() * sizeof(uint64_t));
+
+	output.close();
+	if(output.fail())
+	{
+		throw std::runtime_error("Error while writing " + filename + ".");
+	}
+}
+
+bool compactkMerSet::isCompactkMerSetFile(std::string filename)
+{
+	std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(compactkMerSet_magic)];
+	return (input.is_open() && input.read(magic, sizeof(magic)) && (memcmp(magic, compactkMerSet_magic, sizeof(magic)) == 0));
+}
+
+void compactkMerSet::load(std::string filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+	{
+		throw std::runtime_error("Cannot open k-mer set file " + filename + ".");
+	}
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Cannot stat k-mer set file " + filename + ".");
+	}
+	size_t fileSize = fileInfo.st_size;
+	size_t headerSize = sizeof(compactkMerSet_magic) + 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t);
+	if(fileSize < headerSize)
+	{
+		close(fd);
+		throw std::runtime_error("K-mer set file " + filename + " is truncated.");
+	}
+	void* fileData = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(fileData == MAP_FAILED)
+	{
+		throw std::runtime_error("Cannot mmap k-mer set file " + filename + ".");
+	}
+
+	const char* header = (const char*)fileData;
+	uint32_t header_32[4];
+	uint64_t header_64[2];
+	memcpy(header_32, header + sizeof(compactkMerSet_magic), sizeof(header_32));
+	memcpy(header_64, header + sizeof(compactkMerSet_magic) + sizeof(header_32), sizeof(header_64));
+	if((memcmp(header, compactkMerSet_magic, sizeof(compactkMerSet_magic)) != 0) || (header_32[0] != compactkMerSet_version) || (header_32[3] > compactkMerSet_maxLevels) || ((fileSize - headerSize) < header_32[3] * sizeof(uint64_t)))
+	{
+		munmap(fileData, fileSize);
+		throw std::runtime_error("File " + filename + " is not a k-mer set file, or has an unsupported version.");
+	}
+
+	std::vector<uint64_t> new_level_bits(header_32[3]);
+	memcpy(new_level_bits.data(), header + headerSize, new_level_bits.size() * sizeof(uint64_t));
+	headerSize += new_level_bits.size() * sizeof(uint64_t);
+
+	unmap();
+	std::vector<uint64_t>().swap(storage);
+	k = header_32[1];
+	fingerprintBits = header_32[2];
+	n_kMers = header_64[0];
+	n_fallback = header_64[1];
+	level_bits = new_level_bits;
+	level_firstWord.clear();
+	n_words = 0;
+	for(unsigned int level = 0; level < level_bits.size(); level++)
+	{
+		level_firstWord.push_back(n_words);
+		n_words += level_bits.at(level) / 64;
+	}
+	mapped = fileData;
+	mappedSize = fileSize;
+
+	if(((fileSize - headerSize) != (storageWords() * sizeof(uint64_t))) || (k < 1) || (k > 31) || (fingerprintBits < 1) || (fingerprintBits > 16))
+	{
+		unmap();
+		throw std::runtime_error("K-mer set file " + filename + " is corrupt.");
+	}
+	setPointers((const uint64_t*)(header + headerSize));
+	n_placed = ranks[n_words / 8];
+	if((n_placed + n_fallback) != n_kMers)
+	{
+		unmap();
+		throw std::runtime_error("K-mer set file " + filename + " is corrupt.");
+	}
+}
@@ -0,0 +1,92 @@
+/*
+ * compactkMerSet.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef COMPACTKMERSET_H_
+#define COMPACTKMERSET_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stddef.h>
+
+// Read-only, approximate membership for large k-mer sets (k <= 31, codes as in packedkMerSet), meant for
+// whole-genome Cortex graphs that are only queried for membership. A minimal perfect hash function
+// (levels of collision-free bit arrays with 2 bits per remaining key, as in BBHash) maps each member to
+// a slot, and each slot stores a fingerprint of its k-mer: a k-mer that is not in the set is reported
+// as a member with probability 2^-fingerprintBits. With 8-bit fingerprints the set needs ~1.5 bytes
+// per k-mer, with 16-bit fingerprints ~2.5 bytes.
+//
+// Sets are saved to one file and mapped into memory when loaded:
+//		char[8]		"MHCPRGKS"
+//		uint32		version, k, fingerprint bits, levels
+//		uint64		k-mers, fallback k-mers
+//		per level:	uint64 size in bits (a multiple of 512)
+//		uint64[]	level bit arrays, concatenated
+//		uint64[]	ranks: number of set bits before each block of 512 bits, and the total
+//		uint64[]	fallback k-mers (sorted; the keys no level could place)
+//		uint8/16[]	fingerprints, padded to 8 bytes
+class compactkMerSet {
+protected:
+	int k;
+	int fingerprintBits;
+	uint64_t n_kMers;
+
+	std::vector<uint64_t> level_bits;
+	std::vector<uint64_t> level_firstWord;
+	size_t n_words;
+	size_t n_placed;
+	size_t n_fallback;
+
+	// either in storage (after build(..)) or in the mapped file (after load(..))
+	const uint64_t* words;
+	const uint64_t* ranks;
+	const uint64_t* fallback;
+	const void* fingerprints;
+
+	std::vector<uint64_t> storage;
+	void* mapped;
+	size_t mappedSize;
+
+	void unmap();
+	void setPointers(const uint64_t* data);
+	size_t storageWords() const;
+
+	uint64_t fingerprint(uint64_t code) const;
+	// slot of code in [0, n_kMers) if it is one of the set's k-mers, arbitrary otherwise
+	bool slot(uint64_t code, uint64_t& ret_slot) const;
+
+public:
+	static const uint64_t invalidCode = ~(uint64_t)0;
+
+	compactkMerSet();
+	~compactkMerSet();
+
+	// kMerCodes: canonical k-mer codes (consumed; duplicates allowed)
+	void build(int k, std::vector<uint64_t>& kMerCodes, int fingerprintBits = 8);
+	void save(std::string filename) const;
+	void load(std::string filename);
+	static bool isCompactkMerSetFile(std::string filename);
+
+	int getK() const
+	{
+		return k;
+	}
+	size_t size() const
+	{
+		return n_kMers;
+	}
+	size_t bytes() const
+	{
+		return storageWords() * sizeof(uint64_t);
+	}
+
+	bool contains(uint64_t code) const;
+	// number of k-mers i for which the canonical code min(forward.at(i), reverse.at(i)) is in the set,
+	// with forward / reverse as from packedkMerSet::kMerCodes(..). Lookups are batched and prefetched.
+	int countContained_canonical(const std::vector<uint64_t>& forward, const std::vector<uint64_t>& reverse) const;
+};
+
+#endif /* COMPACTKMERSET_H_ */
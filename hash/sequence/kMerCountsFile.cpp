@@ -0,0 +1,557 @@
+/*
+ * kMerCountsFile.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "kMerCountsFile.h"
+
+#include <assert.h>
+#include <string.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <stdexcept>
+#include <sstream>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+static const char kMerCountsFile_magic[8] = {'M', 'H', 'C', 'P', 'R', 'G', 'K', 'C'};
+static const uint32_t kMerCountsFile_version = 1;
+static const size_t kMerCountsFile_nameLength = 32;
+static const uint64_t kMerCountsFile_readAllBatch = 256;
+
+const uint64_t kMerCountsFile::blockSize;
+const uint64_t kMerCountsFile::invalidCode;
+
+static inline void kMerCountsFile_putVarint(std::vector<unsigned char>& data, uint64_t value)
+{
+	while(value >= 0x80)
+	{
+		data.push_back((unsigned char)(value | 0x80));
+		value >>= 7;
+	}
+	data.push_back((unsigned char)value);
+}
+
+static inline bool kMerCountsFile_getVarint(const unsigned char*& p, const unsigned char* end, uint64_t& ret_value)
+{
+	ret_value = 0;
+	for(unsigned int shift = 0; shift < 64; shift += 7)
+	{
+		if(p == end)
+		{
+			return false;
+		}
+		unsigned char byte = *(p++);
+		ret_value |= ((uint64_t)(byte & 0x7F)) << shift;
+		if(! (byte & 0x80))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline uint64_t kMerCountsFile_zigzag(long long value)
+{
+	return (((uint64_t)value) << 1) ^ (uint64_t)(value >> 63);
+}
+
+static inline long long kMerCountsFile_unzigzag(uint64_t value)
+{
+	return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+static bool kMerCountsFile_isMetadata(const std::string& name)
+{
+	return ((name == "MeanReadLen") || (name == "TotalKMerCoverage") || (name == "TotalSeq"));
+}
+
+static bool kMerCountsFile_codeLess(const std::pair<uint64_t, long long>& a, const std::pair<uint64_t, long long>& b)
+{
+	return (a.first < b.first);
+}
+
+static std::string kMerCountsFile_decode(uint64_t code, int k)
+{
+	static const char bases[4] = {'A', 'C', 'G', 'T'};
+	std::string kMer(k, 'A');
+	for(int i = k - 1; i >= 0; i--)
+	{
+		kMer[i] = bases[code & 3];
+		code >>= 2;
+	}
+	return kMer;
+}
+
+kMerCountsFile::kMerCountsFile() : k(0), n_packed(0), n_blocks(0), blockDataBytes(0), blockIndex(0), blockData(0), mapped(0), mappedSize(0)
+{
+}
+
+kMerCountsFile::~kMerCountsFile()
+{
+	unmap();
+}
+
+void kMerCountsFile::unmap()
+{
+	if(mapped)
+	{
+		munmap(mapped, mappedSize);
+		mapped = 0;
+		mappedSize = 0;
+	}
+}
+
+uint64_t kMerCountsFile::kMerCode(const std::string& kMer)
+{
+	if((kMer.length() == 0) || (kMer.length() > 31))
+	{
+		return invalidCode;
+	}
+
+	uint64_t code = 0;
+	for(unsigned int i = 0; i < kMer.length(); i++)
+	{
+		code <<= 2;
+		switch(kMer[i])
+		{
+		case 'A':
+			break;
+		case 'C':
+			code |= 1;
+			break;
+		case 'G':
+			code |= 2;
+			break;
+		case 'T':
+			code |= 3;
+			break;
+		default:
+			return invalidCode;
+		}
+	}
+	return code;
+}
+
+size_t kMerCountsFile::convertTextFile(std::string textFile, std::string binaryFile)
+{
+	std::ifstream input(textFile.c_str(), std::ios::in);
+	if(! input.is_open())
+	{
+		throw std::runtime_error("Cannot open kMer counts file " + textFile + ".");
+	}
+
+	int new_k = -1;
+	std::map<std::string, long long> new_metadata;
+	std::map<std::string, long long> new_otherkMers;
+	std::vector<std::pair<uint64_t, long long> > packed;
+
+	std::string line;
+	size_t lineCounter = 0;
+	while(std::getline(input, line))
+	{
+		lineCounter++;
+		if((line.length() > 0) && (line[line.length() - 1] == '\r'))
+		{
+			line.erase(line.length() - 1);
+		}
+		if(line.length() == 0)
+		{
+			continue;
+		}
+
+		std::ostringstream lineErrorMessage;
+		lineErrorMessage << "Strange format in kMer counts file " << textFile << ". Expect two fields (kMer and count). Problem occured in line: " << lineCounter;
+
+		size_t space = line.find(' ');
+		if((space == std::string::npos) || (line.find(' ', space + 1) != std::string::npos))
+		{
+			throw std::runtime_error(lineErrorMessage.str());
+		}
+		std::string kMer = line.substr(0, space);
+		std::string countString = line.substr(space + 1);
+		char* countEnd;
+		long long count = strtoll(countString.c_str(), &countEnd, 10);
+		if((countString.length() == 0) || (*countEnd != 0))
+		{
+			throw std::runtime_error(lineErrorMessage.str());
+		}
+
+		if(kMerCountsFile_isMetadata(kMer))
+		{
+			new_metadata[kMer] = count;
+			continue;
+		}
+
+		if(new_k == -1)
+		{
+			new_k = kMer.length();
+			if((new_k < 1) || (new_k > 31))
+			{
+				throw std::runtime_error("kMerCountsFile: k must be between 1 and 31.");
+			}
+		}
+		if((int)kMer.length() != new_k)
+		{
+			throw std::runtime_error(lineErrorMessage.str() + " (k-mers of different lengths)");
+		}
+
+		uint64_t code = kMerCode(kMer);
+		if(code == invalidCode)
+		{
+			new_otherkMers[kMer] = count;
+		}
+		else
+		{
+			packed.push_back(std::make_pair(code, count));
+		}
+	}
+	input.close();
+
+	// sorted by code; for repeated k-mers, the last count counts (as when reading the text file)
+	std::stable_sort(packed.begin(), packed.end(), kMerCountsFile_codeLess);
+	size_t n_unique = 0;
+	for(size_t i = 0; i < packed.size(); i++)
+	{
+		if(((i + 1) < packed.size()) && (packed.at(i + 1).first == packed.at(i).first))
+		{
+			continue;
+		}
+		packed.at(n_unique++) = packed.at(i);
+	}
+	packed.resize(n_unique);
+
+	std::vector<uint64_t> new_blockIndex;
+	std::vector<unsigned char> new_blockData;
+	uint64_t previousCode = 0;
+	for(size_t i = 0; i < packed.size(); i++)
+	{
+		if((i % blockSize) == 0)
+		{
+			new_blockIndex.push_back(packed.at(i).first);
+			new_blockIndex.push_back(new_blockData.size());
+			previousCode = packed.at(i).first;
+		}
+		kMerCountsFile_putVarint(new_blockData, packed.at(i).first - previousCode);
+		kMerCountsFile_putVarint(new_blockData, kMerCountsFile_zigzag(packed.at(i).second));
+		previousCode = packed.at(i).first;
+	}
+	uint64_t new_blockDataBytes = new_blockData.size();
+	while((new_blockData.size() % 8) != 0)
+	{
+		new_blockData.push_back(0);
+	}
+
+	std::ofstream output(binaryFile.c_str(), std::ios::out | std::ios::binary);
+	if(! output.is_open())
+	{
+		throw std::runtime_error("Cannot open " + binaryFile + " for writing.");
+	}
+
+	if(new_k == -1)
+	{
+		new_k = 0;
+	}
+	uint32_t header_32[4] = {kMerCountsFile_version, (uint32_t)new_k, (uint32_t)new_metadata.size(), 0};
+	uint64_t header_64[4] = {packed.size(), new_blockIndex.size() / 2, new_otherkMers.size(), new_blockDataBytes};
+	output.write(kMerCountsFile_magic, sizeof(kMerCountsFile_magic));
+	output.write((const char*)header_32, sizeof(header_32));
+	output.write((const char*)header_64, sizeof(header_64));
+	for(std::map<std::string, long long>::iterator metadataIt = new_metadata.begin(); metadataIt != new_metadata.end(); metadataIt++)
+	{
+		char name[kMerCountsFile_nameLength];
+		memset(name, 0, sizeof(name));
+		assert(metadataIt->first.length() < sizeof(name));
+		memcpy(name, metadataIt->first.c_str(), metadataIt->first.length());
+		int64_t value = metadataIt->second;
+		output.write(name, sizeof(name));
+		output.write((const char*)&value, sizeof(value));
+	}
+	output.write((const char*)new_blockIndex.data(), new_blockIndex.size() * sizeof(uint64_t));
+	output.write((const char*)new_blockData.data(), new_blockData.size());
+	for(std::map<std::string, long long>::iterator kMerIt = new_otherkMers.begin(); kMerIt != new_otherkMers.end(); kMerIt++)
+	{
+		int64_t count = kMerIt->second;
+		output.write(kMerIt->first.c_str(), new_k);
+		output.write((const char*)&count, sizeof(count));
+	}
+
+	output.close();
+	if(output.fail())
+	{
+		throw std::runtime_error("Error while writing " + binaryFile + ".");
+	}
+
+	return packed.size() + new_otherkMers.size();
+}
+
+bool kMerCountsFile::isKMerCountsFile(std::string filename)
+{
+	std::ifstream input(filename.c_str(), std::ios::in | std::ios::binary);
+	char magic[sizeof(kMerCountsFile_magic)];
+	return (input.is_open() && input.read(magic, sizeof(magic)) && (memcmp(magic, kMerCountsFile_magic, sizeof(magic)) == 0));
+}
+
+void kMerCountsFile::load(std::string filename)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd == -1)
+	{
+		throw std::runtime_error("Cannot open kMer counts file " + filename + ".");
+	}
+	struct stat fileInfo;
+	if(fstat(fd, &fileInfo) != 0)
+	{
+		close(fd);
+		throw std::runtime_error("Cannot stat kMer counts file " + filename + ".");
+	}
+	size_t fileSize = fileInfo.st_size;
+	size_t headerSize = sizeof(kMerCountsFile_magic) + 4 * sizeof(uint32_t) + 4 * sizeof(uint64_t);
+	if(fileSize < headerSize)
+	{
+		close(fd);
+		throw std::runtime_error("kMer counts file " + filename + " is truncated.");
+	}
+	void* fileData = mmap(0, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(fileData == MAP_FAILED)
+	{
+		throw std::runtime_error("Cannot mmap kMer counts file " + filename + ".");
+	}
+
+	const char* data = (const char*)fileData;
+	uint32_t header_32[4];
+	uint64_t header_64[4];
+	memcpy(header_32, data + sizeof(kMerCountsFile_magic), sizeof(header_32));
+	memcpy(header_64, data + sizeof(kMerCountsFile_magic) + sizeof(header_32), sizeof(header_64));
+	if((memcmp(data, kMerCountsFile_magic, sizeof(kMerCountsFile_magic)) != 0) || (header_32[0] != kMerCountsFile_version) || (header_32[1] > 31))
+	{
+		munmap(fileData, fileSize);
+		throw std::runtime_error("File " + filename + " is not a kMer counts file, or has an unsupported version.");
+	}
+
+	uint64_t new_k = header_32[1];
+	uint64_t n_metadata = header_32[2];
+	uint64_t new_n_packed = header_64[0];
+	uint64_t new_n_blocks = header_64[1];
+	uint64_t n_other = header_64[2];
+	uint64_t new_blockDataBytes = header_64[3];
+	uint64_t paddedBlockDataBytes = ((new_blockDataBytes + 7) / 8) * 8;
+	uint64_t metadataEntrySize = kMerCountsFile_nameLength + sizeof(int64_t);
+	uint64_t otherEntrySize = new_k + sizeof(int64_t);
+	if((new_n_blocks != ((new_n_packed + blockSize - 1) / blockSize)) || (new_blockDataBytes > fileSize) || (n_metadata > fileSize) || (new_n_blocks > fileSize) || (n_other > fileSize) ||
+		(fileSize != (headerSize + n_metadata * metadataEntrySize + new_n_blocks * 2 * sizeof(uint64_t) + paddedBlockDataBytes + n_other * otherEntrySize)))
+	{
+		munmap(fileData, fileSize);
+		throw std::runtime_error("kMer counts file " + filename + " is corrupt.");
+	}
+
+	unmap();
+	k = new_k;
+	n_packed = new_n_packed;
+	n_blocks = new_n_blocks;
+	blockDataBytes = new_blockDataBytes;
+	mapped = fileData;
+	mappedSize = fileSize;
+
+	const char* position = data + headerSize;
+	metadata.clear();
+	for(uint64_t i = 0; i < n_metadata; i++)
+	{
+		char name[kMerCountsFile_nameLength + 1];
+		memcpy(name, position, kMerCountsFile_nameLength);
+		name[kMerCountsFile_nameLength] = 0;
+		int64_t value;
+		memcpy(&value, position + kMerCountsFile_nameLength, sizeof(value));
+		metadata[std::string(name)] = value;
+		position += metadataEntrySize;
+	}
+
+	blockIndex = (const uint64_t*)position;
+	position += n_blocks * 2 * sizeof(uint64_t);
+	blockData = (const unsigned char*)position;
+	position += paddedBlockDataBytes;
+
+	otherkMers.clear();
+	for(uint64_t i = 0; i < n_other; i++)
+	{
+		int64_t count;
+		memcpy(&count, position + k, sizeof(count));
+		otherkMers[std::string(position, k)] = count;
+		position += otherEntrySize;
+	}
+	assert(position == (data + fileSize));
+}
+
+void kMerCountsFile::decodeBlock(uint64_t blockI, std::vector<uint64_t>& ret_codes, std::vector<long long>& ret_counts) const
+{
+	assert(blockI < n_blocks);
+	uint64_t firstkMer = blockI * blockSize;
+	uint64_t kMers = std::min(blockSize, n_packed - firstkMer);
+	uint64_t startByte = blockIndex[2 * blockI + 1];
+	uint64_t stopByte = ((blockI + 1) < n_blocks) ? blockIndex[2 * (blockI + 1) + 1] : blockDataBytes;
+	if((startByte > stopByte) || (stopByte > blockDataBytes))
+	{
+		throw std::runtime_error("kMerCountsFile: corrupt block index.");
+	}
+
+	ret_codes.resize(kMers);
+	ret_counts.resize(kMers);
+
+	const unsigned char* p = blockData + startByte;
+	const unsigned char* end = blockData + stopByte;
+	uint64_t code = blockIndex[2 * blockI];
+	for(uint64_t i = 0; i < kMers; i++)
+	{
+		uint64_t delta;
+		uint64_t count;
+		if((! kMerCountsFile_getVarint(p, end, delta)) || (! kMerCountsFile_getVarint(p, end, count)) || ((i == 0) && (delta != 0)) || ((i > 0) && (delta == 0)))
+		{
+			throw std::runtime_error("kMerCountsFile: corrupt block data.");
+		}
+		code += delta;
+		ret_codes[i] = code;
+		ret_counts[i] = kMerCountsFile_unzigzag(count);
+	}
+	// a block that is not used up exactly holds a different number of k-mers than the header says
+	if(p != end)
+	{
+		throw std::runtime_error("kMerCountsFile: corrupt block data.");
+	}
+}
+
+void kMerCountsFile::lookup(const std::vector<std::string>& kMers, std::vector<long long>& ret_counts, long long missingValue) const
+{
+	ret_counts.assign(kMers.size(), missingValue);
+
+	std::vector<std::pair<uint64_t, size_t> > queries;
+	for(size_t i = 0; i < kMers.size(); i++)
+	{
+		if((int)kMers.at(i).length() != k)
+		{
+			continue;
+		}
+		uint64_t code = kMerCode(kMers.at(i));
+		if(code == invalidCode)
+		{
+			std::map<std::string, long long>::const_iterator otherIt = otherkMers.find(kMers.at(i));
+			if(otherIt != otherkMers.end())
+			{
+				ret_counts.at(i) = otherIt->second;
+			}
+		}
+		else
+		{
+			queries.push_back(std::make_pair(code, i));
+		}
+	}
+	std::sort(queries.begin(), queries.end());
+	const std::vector<std::pair<uint64_t, size_t> >& sortedQueries = queries;
+	typedef std::vector<std::pair<uint64_t, size_t> >::const_iterator queryIterator;
+
+	bool corrupt = false;
+
+	#pragma omp parallel
+	{
+		std::vector<uint64_t> codes;
+		std::vector<long long> counts;
+
+		#pragma omp for schedule(dynamic)
+		for(long long blockI = 0; blockI < (long long)n_blocks; blockI++)
+		{
+			// the block holds the codes from its first code up to the next block's first code
+			queryIterator firstQuery = std::lower_bound(sortedQueries.begin(), sortedQueries.end(), std::make_pair(blockIndex[2 * blockI], (size_t)0));
+			queryIterator stopQuery = sortedQueries.end();
+			if((blockI + 1) < (long long)n_blocks)
+			{
+				stopQuery = std::lower_bound(firstQuery, stopQuery, std::make_pair(blockIndex[2 * (blockI + 1)], (size_t)0));
+			}
+			if(firstQuery == stopQuery)
+			{
+				continue;
+			}
+
+			try
+			{
+				decodeBlock(blockI, codes, counts);
+			}
+			catch(std::runtime_error& e)
+			{
+				#pragma omp critical
+				{
+					corrupt = true;
+				}
+				continue;
+			}
+
+			size_t codeI = 0;
+			for(queryIterator queryIt = firstQuery; queryIt != stopQuery; queryIt++)
+			{
+				while((codeI < codes.size()) && (codes[codeI] < queryIt->first))
+				{
+					codeI++;
+				}
+				if((codeI < codes.size()) && (codes[codeI] == queryIt->first))
+				{
+					ret_counts[queryIt->second] = counts[codeI];
+				}
+			}
+		}
+	}
+
+	if(corrupt)
+	{
+		throw std::runtime_error("kMerCountsFile: corrupt block data.");
+	}
+}
+
+void kMerCountsFile::readAll(std::map<std::string, long long>& ret_counts) const
+{
+	std::vector<std::vector<uint64_t> > batch_codes(kMerCountsFile_readAllBatch);
+	std::vector<std::vector<long long> > batch_counts(kMerCountsFile_readAllBatch);
+
+	for(uint64_t firstBlock = 0; firstBlock < n_blocks; firstBlock += kMerCountsFile_readAllBatch)
+	{
+		long long batchBlocks = std::min(kMerCountsFile_readAllBatch, n_blocks - firstBlock);
+		bool corrupt = false;
+
+		#pragma omp parallel for schedule(dynamic)
+		for(long long bI = 0; bI < batchBlocks; bI++)
+		{
+			try
+			{
+				decodeBlock(firstBlock + bI, batch_codes.at(bI), batch_counts.at(bI));
+			}
+			catch(std::runtime_error& e)
+			{
+				#pragma omp critical
+				{
+					corrupt = true;
+				}
+			}
+		}
+
+		if(corrupt)
+		{
+			throw std::runtime_error("kMerCountsFile: corrupt block data.");
+		}
+
+		for(long long bI = 0; bI < batchBlocks; bI++)
+		{
+			for(size_t i = 0; i < batch_codes.at(bI).size(); i++)
+			{
+				ret_counts[kMerCountsFile_decode(batch_codes.at(bI).at(i), k)] = batch_counts.at(bI).at(i);
+			}
+		}
+	}
+
+	for(std::map<std::string, long long>::const_iterator kMerIt = otherkMers.begin(); kMerIt != otherkMers.end(); kMerIt++)
+	{
+		ret_counts[kMerIt->first] = kMerIt->second;
+	}
+}
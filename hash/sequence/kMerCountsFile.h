@@ -0,0 +1,84 @@
+/*
+ * kMerCountsFile.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef KMERCOUNTSFILE_H_
+#define KMERCOUNTSFILE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include <stddef.h>
+
+// Binary version of the k-mer count files read by AlphaHMM::estimateEmissions(..) and
+// MultiHMM::estimateEmissions(..) (text: one "kMer count" pair per line, plus the lines MeanReadLen,
+// TotalKMerCoverage and TotalSeq). K-mers (k <= 31) are 2-bit packed and sorted by code; they are
+// stored in blocks of blockSize k-mers, each a sequence of varint (code - previous code, zigzag(count))
+// pairs, so that blocks can be decoded independently and in parallel. K-mers with characters other than
+// ACGT are stored as strings. If a k-mer occurs more than once in the text file, its last count is kept.
+//
+// Files are mapped into memory when loaded:
+//		char[8]		"MHCPRGKC"
+//		uint32		version, k, metadata entries, 0
+//		uint64		packed k-mers, blocks, other k-mers, bytes of block data
+//		per metadata entry:	char[32] name (0-padded), int64 value
+//		per block:	uint64 first code, uint64 offset into block data
+//		uint8[]		block data, padded to 8 bytes
+//		per other k-mer:	char[k], int64 count
+class kMerCountsFile {
+protected:
+	int k;
+	uint64_t n_packed;
+	uint64_t n_blocks;
+	uint64_t blockDataBytes;
+	std::map<std::string, long long> metadata;
+	std::map<std::string, long long> otherkMers;
+
+	const uint64_t* blockIndex;
+	const unsigned char* blockData;
+
+	void* mapped;
+	size_t mappedSize;
+
+	void unmap();
+	void decodeBlock(uint64_t blockI, std::vector<uint64_t>& ret_codes, std::vector<long long>& ret_counts) const;
+
+public:
+	static const uint64_t blockSize = 4096;
+	static const uint64_t invalidCode = ~(uint64_t)0;
+
+	kMerCountsFile();
+	~kMerCountsFile();
+
+	// text counts file to binary; returns the number of k-mers
+	static size_t convertTextFile(std::string textFile, std::string binaryFile);
+	static bool isKMerCountsFile(std::string filename);
+	static uint64_t kMerCode(const std::string& kMer);
+
+	void load(std::string filename);
+
+	int getK() const
+	{
+		return k;
+	}
+	size_t size() const
+	{
+		return n_packed + otherkMers.size();
+	}
+	const std::map<std::string, long long>& getMetadata() const
+	{
+		return metadata;
+	}
+
+	// ret_counts.at(i): count of kMers.at(i), or missingValue if it is not in the file. Only the
+	// blocks that can contain one of kMers are decoded, in parallel.
+	void lookup(const std::vector<std::string>& kMers, std::vector<long long>& ret_counts, long long missingValue) const;
+
+	// all k-mers and their counts (without metadata)
+	void readAll(std::map<std::string, long long>& ret_counts) const;
+};
+
+#endif /* KMERCOUNTSFILE_H_ */
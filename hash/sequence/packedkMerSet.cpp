@@ -0,0 +1,206 @@
+/*
+ * packedkMerSet.cpp
+ *
+ *  Created on: 16.10.2026
+ */
+
+#include "packedkMerSet.h"
+
+#include <assert.h>
+#include <algorithm>
+#include <stdexcept>
+#include <limits>
+
+const uint64_t packedkMerSet::invalidCode;
+
+// 2-bit nucleotide codes, 4 for everything else - same mapping (including lower-case bases)
+// as char_to_binary_nucleotide(), which the DeBruijnGraph k-mer path uses
+static unsigned char packedkMerSet_baseCode(char c)
+{
+	return (unsigned char)char_to_binary_nucleotide(c);
+}
+
+packedkMerSet::packedkMerSet(int k) : k(k)
+{
+	if(!((k >= 1) && (k <= 31)))
+	{
+		throw std::runtime_error("packedkMerSet: k must be between 1 and 31.");
+	}
+	kMerMask = (~(uint64_t)0) >> (64 - 2*k);
+
+	std::vector<uint64_t> empty;
+	build(empty);
+}
+
+void packedkMerSet::build(std::vector<uint64_t>& kMerCodes)
+{
+	std::sort(kMerCodes.begin(), kMerCodes.end());
+	kMerCodes.erase(std::unique(kMerCodes.begin(), kMerCodes.end()), kMerCodes.end());
+	if(kMerCodes.size() >= std::numeric_limits<uint32_t>::max())
+	{
+		throw std::runtime_error("packedkMerSet: too many k-mers.");
+	}
+	for(size_t i = 0; i < kMerCodes.size(); i++)
+	{
+		if(kMerCodes.at(i) > kMerMask)
+		{
+			throw std::runtime_error("packedkMerSet: invalid k-mer code.");
+		}
+	}
+
+	// about two codes per bucket
+	bucketBits = 1;
+	while(((size_t)1 << bucketBits) < (kMerCodes.size() / 2))
+	{
+		bucketBits++;
+	}
+	size_t buckets = (size_t)1 << bucketBits;
+
+	bucket_first.assign(buckets + 1, 0);
+	for(size_t i = 0; i < kMerCodes.size(); i++)
+	{
+		bucket_first.at(bucket(kMerCodes.at(i)) + 1)++;
+	}
+	for(size_t bI = 0; bI < buckets; bI++)
+	{
+		bucket_first.at(bI + 1) += bucket_first.at(bI);
+	}
+
+	// stable scatter - codes stay sorted within their bucket
+	codes.resize(kMerCodes.size());
+	std::vector<uint32_t> bucket_next(bucket_first.begin(), bucket_first.end() - 1);
+	for(size_t i = 0; i < kMerCodes.size(); i++)
+	{
+		uint64_t code = kMerCodes.at(i);
+		codes.at(bucket_next.at(bucket(code))++) = code;
+	}
+
+	std::vector<uint64_t>().swap(kMerCodes);
+}
+
+uint64_t packedkMerSet::encode(const std::string& kMer) const
+{
+	if((int)kMer.length() != k)
+	{
+		throw std::runtime_error("packedkMerSet: k-mer " + kMer + " has wrong length.");
+	}
+	uint64_t code = 0;
+	for(int i = 0; i < k; i++)
+	{
+		unsigned char b = packedkMerSet_baseCode(kMer[i]);
+		if(b > 3)
+		{
+			return invalidCode;
+		}
+		code = (code << 2) | b;
+	}
+	return code;
+}
+
+std::string packedkMerSet::decode(uint64_t code) const
+{
+	assert(code <= kMerMask);
+	static const char bases[4] = {'A', 'C', 'G', 'T'};
+	std::string forReturn;
+	forReturn.resize(k);
+	for(int i = k - 1; i >= 0; i--)
+	{
+		forReturn[i] = bases[code & 3];
+		code >>= 2;
+	}
+	return forReturn;
+}
+
+bool packedkMerSet::contains(uint64_t code) const
+{
+	if(code == invalidCode)
+		return false;
+
+	size_t b = bucket(code);
+	for(uint32_t i = bucket_first[b]; i < bucket_first[b + 1]; i++)
+	{
+		if(codes[i] == code)
+			return true;
+		if(codes[i] > code)
+			return false;
+	}
+	return false;
+}
+
+int packedkMerSet::countContained(const std::vector<uint64_t>& kMerCodes) const
+{
+	const size_t batchSize = 16;
+	size_t batch_buckets[batchSize];
+
+	int forReturn = 0;
+	for(size_t batchStart = 0; batchStart < kMerCodes.size(); batchStart += batchSize)
+	{
+		size_t batchStop = std::min(batchStart + batchSize, kMerCodes.size());
+
+		// first pass: bucket boundaries, second pass: code runs, third pass: compare
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			uint64_t code = kMerCodes[i];
+			batch_buckets[i - batchStart] = (code == invalidCode) ? 0 : bucket(code);
+			__builtin_prefetch(bucket_first.data() + batch_buckets[i - batchStart]);
+		}
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			__builtin_prefetch(codes.data() + bucket_first[batch_buckets[i - batchStart]]);
+		}
+		for(size_t i = batchStart; i < batchStop; i++)
+		{
+			uint64_t code = kMerCodes[i];
+			if(code == invalidCode)
+				continue;
+
+			size_t b = batch_buckets[i - batchStart];
+			for(uint32_t cI = bucket_first[b]; cI < bucket_first[b + 1]; cI++)
+			{
+				if(codes[cI] >= code)
+				{
+					if(codes[cI] == code)
+						forReturn++;
+					break;
+				}
+			}
+		}
+	}
+	return forReturn;
+}
+
+void packedkMerSet::kMerCodes(const std::string& sequence, std::vector<uint64_t>& forward, std::vector<uint64_t>& reverse) const
+{
+	forward.clear();
+	reverse.clear();
+	if((int)sequence.length() < k)
+		return;
+
+	size_t n_kMers = sequence.length() - k + 1;
+	forward.reserve(n_kMers);
+	reverse.reserve(n_kMers);
+
+	int reverseShift = 2 * (k - 1);
+	uint64_t code_forward = 0;
+	uint64_t code_reverse = 0;
+	int lastInvalid = -1;
+	for(int i = 0; i < (int)sequence.length(); i++)
+	{
+		unsigned char b = packedkMerSet_baseCode(sequence[i]);
+		if(b > 3)
+		{
+			lastInvalid = i;
+			b = 0;
+		}
+		code_forward = ((code_forward << 2) | b) & kMerMask;
+		code_reverse = (code_reverse >> 2) | ((uint64_t)(3 - b) << reverseShift);
+
+		if(i >= (k - 1))
+		{
+			bool valid = (lastInvalid <= (i - k));
+			forward.push_back(valid ? code_forward : invalidCode);
+			reverse.push_back(valid ? code_reverse : invalidCode);
+		}
+	}
+	assert(forward.size() == n_kMers);
+}
@@ -0,0 +1,70 @@
+/*
+ * packedkMerSet.h
+ *
+ *  Created on: 16.10.2026
+ */
+
+#ifndef PACKEDKMERSET_H_
+#define PACKEDKMERSET_H_
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "binarykMer.h"
+
+// Read-only set of k-mers (k <= 31), each stored as a 2-bit code in one uint64_t. Codes use the
+// layout of binarykMer<1, k> (A = 0, C = 1, G = 2, T = 3, last base in the lowest bits), so the
+// kMerBinaryRepresentation of a binarykMer<1, k> can be used as a code directly.
+// Codes are grouped by hash bucket, with the first code of each bucket in bucket_first:
+// a lookup reads one bucket_first entry and a short run of codes, ~10 - 12 bytes per k-mer.
+// K-mers are stored as given (not canonicalised) - callers decide about orientation.
+class packedkMerSet {
+protected:
+	int k;
+	uint64_t kMerMask;
+	unsigned int bucketBits;
+	std::vector<uint32_t> bucket_first;
+	std::vector<uint64_t> codes;
+
+	size_t bucket(uint64_t code) const
+	{
+		return (size_t)((code * 0x9E3779B97F4A7C15ULL) >> (64 - bucketBits));
+	}
+
+public:
+	static const uint64_t invalidCode = ~(uint64_t)0;
+
+	packedkMerSet(int k);
+
+	// replaces the contents of the set with kMerCodes (which is consumed; duplicates allowed)
+	void build(std::vector<uint64_t>& kMerCodes);
+
+	int getK() const
+	{
+		return k;
+	}
+	size_t size() const
+	{
+		return codes.size();
+	}
+
+	// code of a k-mer, invalidCode if it contains characters other than A, C, G, T
+	uint64_t encode(const std::string& kMer) const;
+	std::string decode(uint64_t code) const;
+
+	bool contains(uint64_t code) const;
+	bool contains(const std::string& kMer) const
+	{
+		return contains(encode(kMer));
+	}
+
+	// number of elements of kMerCodes contained in the set (lookups are batched and prefetched)
+	int countContained(const std::vector<uint64_t>& kMerCodes) const;
+
+	// codes of all k-mers of sequence, rolled base by base; reverse.at(i) is the code of the
+	// reverse complement of k-mer i. K-mers with non-ACGT characters get invalidCode.
+	void kMerCodes(const std::string& sequence, std::vector<uint64_t>& forward, std::vector<uint64_t>& reverse) const;
+};
+
+#endif /* PACKEDKMERSET_H_ */
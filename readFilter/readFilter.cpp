@@ -15,11 +15,14 @@
 #include <ostream>
 #include <istream>
 #include <set>
+#include <algorithm>
 
 #include "../Utilities.h"
 
 #include "../hash/deBruijn/DeBruijnGraph.h"
 #include "../hash/sequence/basic.h"
+#include "../hash/sequence/packedkMerSet.h"
+#include "../hash/sequence/compactkMerSet.h"
 
 #include "api/BamReader.h"
 #include "api/BamAlignment.h"
@@ -79,7 +82,7 @@ void readFilter::doFilter()
 	std::cout << "\t" << "uniqueness_subtract" << ": " << uniqueness_subtract << "\n";
 	std::cout << "\t" << "threads" << ": " << threads << "\n";
 
-	std::set<std::string> positive_kMers;
+	packedkMerSet positive_kMers(k);
 
 	bool apply_filter_positive = (positiveFilter.length() > 0);
 	bool apply_filter_negative = (negativeFilter.length() > 0);
@@ -104,8 +107,10 @@ void readFilter::doFilter()
 	
 	// std::cout << "Have " << good_read_IDs.size() << " good read IDs, e.g. " << *(good_read_IDs.begin()) << "\n";
 	
-	auto load_positive_kMers_file = [&](std::string file) -> std::set<std::string> {
-		std::set<std::string> forReturn;
+	// k-mers of a file as sorted, unique 2-bit codes
+	auto load_positive_kMers_file = [&](std::string file) -> std::vector<uint64_t> {
+		std::vector<uint64_t> forReturn;
+		size_t skipped_kMers = 0;
 
 		std::ifstream positive_kMers_stream;
 		positive_kMers_stream.open(file.c_str());
@@ -132,54 +137,88 @@ void readFilter::doFilter()
 				throw std::runtime_error("readFilter::doFilter(): Expect kMers of length " + Utilities::ItoStr(k) + ", but " + positiveFilter + " contains one of length " + Utilities::ItoStr(kMer.length()) + " (line " + Utilities::ItoStr(line_number) + " ).");
 			}
 
-			forReturn.insert(kMer);
+			uint64_t kMer_code = positive_kMers.encode(kMer);
+			if(kMer_code == packedkMerSet::invalidCode)
+			{
+				// can't match a read k-mer
+				skipped_kMers++;
+				continue;
+			}
+			forReturn.push_back(kMer_code);
 		}
 
 		positive_kMers_stream.close();
 
+		if(skipped_kMers)
+		{
+			std::cerr << "readFilter::doFilter(): Warning: ignored " << skipped_kMers << " k-mers with non-ACGT characters in " << file << ".\n" << std::flush;
+		}
+
+		std::sort(forReturn.begin(), forReturn.end());
+		forReturn.erase(std::unique(forReturn.begin(), forReturn.end()), forReturn.end());
+
 		return forReturn;
 	};
 
 	if(apply_filter_positive)
 	{
 		std::cout << Utilities::timestamp() << "Load file " << positiveFilter << "\n" << std::flush;	
-		positive_kMers = load_positive_kMers_file(positiveFilter);
+		std::vector<uint64_t> positive_kMer_codes = load_positive_kMers_file(positiveFilter);
+		positive_kMers.build(positive_kMer_codes);
 	}
 
 
 	int cortex_height = 26;
 	int cortex_width = 50;
 
-	std::set<std::string> unique_kMers;
+	packedkMerSet unique_kMers(k);
 	
 	if(positiveUnique || negativePreserveUnique)
 	{
 		std::cout << Utilities::timestamp() << "Load file " << uniqueness_base << "\n" << std::flush;	
 	
-		unique_kMers = load_positive_kMers_file(uniqueness_base);
-		
-		std::cout << Utilities::timestamp() << "unique_kMers before filtering: " << unique_kMers.size() << "\n" << std::flush;
+		std::vector<uint64_t> unique_kMer_codes = load_positive_kMers_file(uniqueness_base);
 		
-		std::cout << Utilities::timestamp() << "Allocate Cortex graph object with height = " << cortex_height << ", width = " << cortex_width << " ...\n" << std::flush;
-		DeBruijnGraph<1, 25, 1> subtract_kMers_graph(cortex_height, cortex_width);
-		std::cout << Utilities::timestamp() << "Cortex graph object allocated, loading binary " << uniqueness_subtract << "..\n" << std::flush;
-		subtract_kMers_graph.loadMultiColourBinary(uniqueness_subtract);
+		std::cout << Utilities::timestamp() << "unique_kMers before filtering: " << unique_kMer_codes.size() << "\n" << std::flush;
 		
-		std::set<std::string> unique_kMers_forDeletion;
-		for(std::set<std::string>::iterator kMerIt = unique_kMers.begin(); kMerIt != unique_kMers.end(); kMerIt++)
+		// either a Cortex binary or a compact k-mer set built from one (domode buildCompactkMerSet)
+		compactkMerSet subtract_kMers_compact;
+		DeBruijnGraph<1, 25, 1>* subtract_kMers_graph = 0;
+		if(compactkMerSet::isCompactkMerSetFile(uniqueness_subtract))
 		{
-			std::string kMer = *kMerIt;
-			if(subtract_kMers_graph.kMerinGraph(kMer))
+			std::cout << Utilities::timestamp() << "Load compact k-mer set " << uniqueness_subtract << "..\n" << std::flush;
+			subtract_kMers_compact.load(uniqueness_subtract);
+			if(subtract_kMers_compact.getK() != k)
 			{
-				unique_kMers_forDeletion.insert(kMer);
+				throw std::runtime_error("readFilter::doFilter(): Expect kMers of length " + Utilities::ItoStr(k) + ", but compact k-mer set " + uniqueness_subtract + " contains kMers of length " + Utilities::ItoStr(subtract_kMers_compact.getK()) + ".");
 			}
 		}
+		else
+		{
+			std::cout << Utilities::timestamp() << "Allocate Cortex graph object with height = " << cortex_height << ", width = " << cortex_width << " ...\n" << std::flush;
+			subtract_kMers_graph = new DeBruijnGraph<1, 25, 1>(cortex_height, cortex_width);
+			std::cout << Utilities::timestamp() << "Cortex graph object allocated, loading binary " << uniqueness_subtract << "..\n" << std::flush;
+			subtract_kMers_graph->loadMultiColourBinary(uniqueness_subtract);
+		}
+		auto subtract_kMers_contains = [&](const std::string& kMer) -> bool {
+			if(subtract_kMers_graph)
+			{
+				return subtract_kMers_graph->kMerinGraph(kMer);
+			}
+			std::vector<uint64_t> kMerCode_forward; std::vector<uint64_t> kMerCode_reverse;
+			unique_kMers.kMerCodes(kMer, kMerCode_forward, kMerCode_reverse);
+			return (subtract_kMers_compact.countContained_canonical(kMerCode_forward, kMerCode_reverse) > 0);
+		};
 		
-		for(std::set<std::string>::iterator kMerIt = unique_kMers_forDeletion.begin(); kMerIt != unique_kMers_forDeletion.end(); kMerIt++)
+		std::vector<uint64_t> unique_kMer_codes_remaining;
+		for(size_t kI = 0; kI < unique_kMer_codes.size(); kI++)
 		{
-			std::string kMer = *kMerIt;	
-			unique_kMers.erase(kMer);
+			if(! subtract_kMers_contains(unique_kMers.decode(unique_kMer_codes.at(kI))))
+			{
+				unique_kMer_codes_remaining.push_back(unique_kMer_codes.at(kI));
+			}
 		}
+		unique_kMers.build(unique_kMer_codes_remaining);
 		
 		std::cout << Utilities::timestamp() << "unique_kMers after filtering: " << unique_kMers.size() << "\n" << std::flush;
 		
@@ -188,15 +227,30 @@ void readFilter::doFilter()
 		for(unsigned int kI = 0; kI < testKmers.size(); kI++)
 		{
 			std::string kMer = testKmers.at(kI);
-			std::cout << "kMer " << kMer <<  " " << (int)subtract_kMers_graph.kMerinGraph(kMer)  << " " << (int) unique_kMers.count(kMer) << "\n" << std::flush;
+			std::cout << "kMer " << kMer <<  " " << (int)subtract_kMers_contains(kMer)  << " " << (int) unique_kMers.contains(kMer) << "\n" << std::flush;
 		}
+
+		delete(subtract_kMers_graph);
 		
 		// assert ( 2 == 4);
 		
 	}
 
-	DeBruijnGraph<1, 25, 1>* negative_kMers;
-	if(apply_filter_negative)
+	DeBruijnGraph<1, 25, 1>* negative_kMers = 0;
+	compactkMerSet negative_kMers_compact;
+	if(apply_filter_negative && compactkMerSet::isCompactkMerSetFile(negativeFilter))
+	{
+		std::cout << Utilities::timestamp() << "Load compact k-mer set " << negativeFilter << "...\n" << std::flush;
+
+		negative_kMers_compact.load(negativeFilter);
+		if(negative_kMers_compact.getK() != k)
+		{
+			throw std::runtime_error("readFilter::doFilter(): Expect kMers of length " + Utilities::ItoStr(k) + ", but compact k-mer set " + negativeFilter + " contains kMers of length " + Utilities::ItoStr(negative_kMers_compact.getK()) + ".");
+		}
+
+		std::cout << Utilities::timestamp() << "\tdone - " << negative_kMers_compact.size() << " k-mers\n" << std::flush;
+	}
+	else if(apply_filter_negative)
 	{
 		std::cout << Utilities::timestamp() << "Allocate Cortex graph object with height = " << cortex_height << ", width = " << cortex_width << " ...\n" << std::flush;
 
@@ -218,11 +272,17 @@ void readFilter::doFilter()
 	
 	std::function<bool(const fastq_readPair&, bool)> decisionFunction = [&](const fastq_readPair& read, bool verboseDecisionFunction) -> bool {
 
-		std::vector<std::string> kMers_1_fwd = partitionStringIntokMers(read.a1.sequence, k);
-		std::vector<std::string> kMers_2_fwd = partitionStringIntokMers(seq_reverse_complement(read.a2.sequence), k);
+		std::vector<uint64_t> kMerCodes_1_forward; std::vector<uint64_t> kMerCodes_1_reverse;
+		std::vector<uint64_t> kMerCodes_2_forward; std::vector<uint64_t> kMerCodes_2_reverse;
+		positive_kMers.kMerCodes(read.a1.sequence, kMerCodes_1_forward, kMerCodes_1_reverse);
+		positive_kMers.kMerCodes(read.a2.sequence, kMerCodes_2_forward, kMerCodes_2_reverse);
 
-		std::vector<std::string> kMers_1_rev = partitionStringIntokMers(seq_reverse_complement(read.a1.sequence), k);
-		std::vector<std::string> kMers_2_rev = partitionStringIntokMers(read.a2.sequence, k);
+		// fwd: k-mers of read 1 and of the reverse complement of read 2; rev: the other strand
+		const std::vector<uint64_t>& kMers_1_fwd = kMerCodes_1_forward;
+		const std::vector<uint64_t>& kMers_2_fwd = kMerCodes_2_reverse;
+
+		const std::vector<uint64_t>& kMers_1_rev = kMerCodes_1_reverse;
+		const std::vector<uint64_t>& kMers_2_rev = kMerCodes_2_forward;
 
 		// std::string shortReadID = "@" + std::string(read.a1.readID.begin(), read.a1.readID.end() - 2);
 		
@@ -243,33 +303,11 @@ void readFilter::doFilter()
 			kMers_1_forward_TOTAL += kMers_1_fwd.size();
 			kMers_2_forward_TOTAL += kMers_2_fwd.size();
 
-			for(unsigned int kI = 0; kI < kMers_1_fwd.size(); kI++)
-			{
-				std::string kMer = kMers_1_fwd.at(kI);
-				if(positive_kMers.count(kMer))
-				{
-					kMers_1_forward_OK++;
-				}
-
-				if(unique_kMers.count(kMer))
-				{
-					kMers_1_forward_unique++;
-				}
-			}
-
-			for(unsigned int kI = 0; kI < kMers_2_fwd.size(); kI++)
-			{
-				std::string kMer = kMers_2_fwd.at(kI);
-				if(positive_kMers.count(kMer))
-				{
-					kMers_2_forward_OK++;
-				}
+			kMers_1_forward_OK = positive_kMers.countContained(kMers_1_fwd);
+			kMers_1_forward_unique = unique_kMers.countContained(kMers_1_fwd);
 
-				if(unique_kMers.count(kMer))
-				{
-					kMers_2_forward_unique++;
-				}
-			}
+			kMers_2_forward_OK = positive_kMers.countContained(kMers_2_fwd);
+			kMers_2_forward_unique = unique_kMers.countContained(kMers_2_fwd);
 
 			double forward_1_optim = (kMers_1_forward_TOTAL == 0) ? 0 : (kMers_1_forward_OK / kMers_1_forward_TOTAL);
 			double forward_2_optim = (kMers_2_forward_TOTAL == 0) ? 0 : (kMers_2_forward_OK / kMers_2_forward_TOTAL);
@@ -289,31 +327,11 @@ void readFilter::doFilter()
 			kMers_2_reverse_TOTAL += kMers_2_rev.size();
 
 
-			for(unsigned int kI = 0; kI < kMers_1_rev.size(); kI++)
-			{
-				std::string kMer = kMers_1_rev.at(kI);
-				if(positive_kMers.count(kMer))
-				{
-					kMers_1_reverse_OK++;
-				}
-				if(unique_kMers.count(kMer))
-				{
-					kMers_1_reverse_unique++;
-				}
-			}
+			kMers_1_reverse_OK = positive_kMers.countContained(kMers_1_rev);
+			kMers_1_reverse_unique = unique_kMers.countContained(kMers_1_rev);
 
-			for(unsigned int kI = 0; kI < kMers_2_rev.size(); kI++)
-			{
-				std::string kMer = kMers_2_rev.at(kI);
-				if(positive_kMers.count(kMer))
-				{
-					kMers_2_reverse_OK++;
-				}
-				if(unique_kMers.count(kMer))
-				{
-					kMers_2_reverse_unique++;
-				}
-			}
+			kMers_2_reverse_OK = positive_kMers.countContained(kMers_2_rev);
+			kMers_2_reverse_unique = unique_kMers.countContained(kMers_2_rev);
 
 			double reverse_1_optim = (kMers_1_reverse_TOTAL == 0) ? 0 : (kMers_1_reverse_OK / kMers_1_reverse_TOTAL);
 			double reverse_2_optim = (kMers_2_reverse_TOTAL == 0) ? 0 : (kMers_2_reverse_OK / kMers_2_reverse_TOTAL);
@@ -414,22 +432,16 @@ void readFilter::doFilter()
 			kMers_1_TOTAL += kMers_1_fwd.size();
 			kMers_2_TOTAL += kMers_2_fwd.size();
 
-			for(unsigned int kI = 0; kI < kMers_1_fwd.size(); kI++)
+			if(negative_kMers)
 			{
-				std::string kMer = kMers_1_fwd.at(kI);
-				if(negative_kMers->kMerinGraph(kMer))
-				{
-					kMers_1_notOK++;
-				}
+				kMers_1_notOK = negative_kMers->sequenceCountkMersinGraph(read.a1.sequence);
+				kMers_2_notOK = negative_kMers->sequenceCountkMersinGraph(seq_reverse_complement(read.a2.sequence));
 			}
-
-			for(unsigned int kI = 0; kI < kMers_2_fwd.size(); kI++)
+			else
 			{
-				std::string kMer = kMers_2_fwd.at(kI);
-				if(negative_kMers->kMerinGraph(kMer))
-				{
-					kMers_2_notOK++;
-				}
+				// canonical k-mers - read 2 and its reverse complement have the same ones
+				kMers_1_notOK = negative_kMers_compact.countContained_canonical(kMerCodes_1_forward, kMerCodes_1_reverse);
+				kMers_2_notOK = negative_kMers_compact.countContained_canonical(kMerCodes_2_forward, kMerCodes_2_reverse);
 			}
 
 			int kMers_1_forward_unique = 0;
@@ -439,44 +451,10 @@ void readFilter::doFilter()
 			
 			if(negativePreserveUnique)
 			{
-				for(unsigned int kI = 0; kI < kMers_1_fwd.size(); kI++)
-				{
-					std::string kMer = kMers_1_fwd.at(kI);
-					if(unique_kMers.count(kMer))
-					{
-						kMers_1_forward_unique++;
-						// seen_unique_kMers.insert(kMer);
-					}
-				}
-				for(unsigned int kI = 0; kI < kMers_2_fwd.size(); kI++)
-				{
-					std::string kMer = kMers_2_fwd.at(kI);
-					if(unique_kMers.count(kMer))
-					{
-						kMers_2_forward_unique++;
-						// seen_unique_kMers.insert(kMer);
-					}
-				}
-
-				for(unsigned int kI = 0; kI < kMers_1_rev.size(); kI++)
-				{
-					std::string kMer = kMers_1_rev.at(kI);
-					if(unique_kMers.count(kMer))
-					{
-						kMers_1_reverse_unique++;
-						// seen_unique_kMers.insert(kMer);
-					}
-				}
-
-				for(unsigned int kI = 0; kI < kMers_2_rev.size(); kI++)
-				{
-					std::string kMer = kMers_2_rev.at(kI);
-					if(unique_kMers.count(kMer))
-					{
-						kMers_2_reverse_unique++;
-						// seen_unique_kMers.insert(kMer);
-					}
-				}
+				kMers_1_forward_unique = unique_kMers.countContained(kMers_1_fwd);
+				kMers_2_forward_unique = unique_kMers.countContained(kMers_2_fwd);
+				kMers_1_reverse_unique = unique_kMers.countContained(kMers_1_rev);
+				kMers_2_reverse_unique = unique_kMers.countContained(kMers_2_rev);
 			}
 			
 			int forward_combined_unique = kMers_1_forward_unique + kMers_2_forward_unique;
@@ -653,10 +631,7 @@ void readFilter::doFilter()
 	std::cout << "Positive passed (cumulative): " << positive_OK << "\n" << std::flush;
 	// std::cout << "Saw " << saw_good_read_IDs << " / " << good_read_IDs.size() << " good read IDs\n" << std::flush;
 	
-	if(apply_filter_negative)
-	{
-		delete(negative_kMers);
-	}
+	delete(negative_kMers);
 }
 
 void filterFastQPairs(int threads, std::string fastq_basePath, std::string outputFile, std::function<bool(const fastq_readPair&, bool)>* decide, std::function<void(const fastq_readPair&)>* print)
@@ -705,9 +680,7 @@ void filterFastQPairs(int threads, std::string fastq_1_path, std::string fastq_2
 		return forReturn;
 	};
 
-	auto getReadFromFastQ = [&](std::ifstream& inputStream, std::string& ret_readID, std::string& ret_sequence, std::string& ret_qualities) -> void {
-		assert(inputStream.good());
-		std::vector<std::string> lines = getLinesFromFastQ(inputStream, 4);
+	auto getReadFromFastQ = [](const std::vector<std::string>& lines, std::string& ret_readID, std::string& ret_sequence, std::string& ret_qualities) -> void {
 		if(lines.size() == 4)
 		{
 			assert(lines.at(2) == "+");
@@ -734,67 +707,136 @@ void filterFastQPairs(int threads, std::string fastq_1_path, std::string fastq_2
 		}
 	};
 
-	while(fastQ_1_stream.good())
-	{
-		assert(fastQ_2_stream.good());
-
-		std::string read1_ID; std::string read1_sequence; std::string read1_qualities;
-		getReadFromFastQ(fastQ_1_stream, read1_ID, read1_sequence, read1_qualities);
+	omp_set_num_threads(threads);
 
-		std::string read2_ID; std::string read2_sequence; std::string read2_qualities;
-		getReadFromFastQ(fastQ_2_stream, read2_ID, read2_sequence, read2_qualities);
+	// Pairs are processed in batches. While all threads check and filter the pairs of one batch,
+	// one of them reads the raw records of the next batch; passing pairs are printed in input order.
+	size_t pairs_per_batch = 20000 * ((threads > 0) ? threads : 1);
 
-		if(!(((read1_ID.length() && read2_ID.length()) || ((!read1_ID.length()) && (!read2_ID.length())))))
+	auto readBatch = [&](std::vector<std::vector<std::string> >& batch_read1, std::vector<std::vector<std::string> >& batch_read2) -> void {
+		batch_read1.clear();
+		batch_read2.clear();
+		while(batch_read1.size() < pairs_per_batch)
 		{
-			std::cerr << "Assertion fail!\n";
-			std::cerr << "read1_ID.length(): " << read1_ID.length() << "\n";
-			std::cerr << "read2_ID.length(): " << read2_ID.length() << "\n";
-			std::cerr << "read1_ID: " << read1_ID << "\n";
-			std::cerr << "read2_ID: " << read2_ID << "\n" << std::flush;
-		}
-		assert((read1_ID.length() && read2_ID.length()) || ((!read1_ID.length()) && (!read2_ID.length())));
-		if((!read1_ID.length()) && (!read2_ID.length()))
-		{
-			break;
+			if(! fastQ_1_stream.good())
+			{
+				break;
+			}
+			assert(fastQ_2_stream.good());
+
+			std::vector<std::string> read1_lines = getLinesFromFastQ(fastQ_1_stream, 4);
+			std::vector<std::string> read2_lines = getLinesFromFastQ(fastQ_2_stream, 4);
+
+			bool have1 = ((read1_lines.size() == 4) && read1_lines.at(0).length());
+			bool have2 = ((read2_lines.size() == 4) && read2_lines.at(0).length());
+			if(have1 != have2)
+			{
+				std::cerr << "Assertion fail!\n";
+				std::cerr << "read1_ID.length(): " << (have1 ? read1_lines.at(0).length() : 0) << "\n";
+				std::cerr << "read2_ID.length(): " << (have2 ? read2_lines.at(0).length() : 0) << "\n";
+				std::cerr << "read1_ID: " << (have1 ? read1_lines.at(0) : "") << "\n";
+				std::cerr << "read2_ID: " << (have2 ? read2_lines.at(0) : "") << "\n" << std::flush;
+			}
+			assert(have1 == have2);
+			if(! have1)
+			{
+				break;
+			}
+
+			batch_read1.push_back(read1_lines);
+			batch_read2.push_back(read2_lines);
 		}
-		
-		BAMalignment simpleAlignment_1;
-		simpleAlignment_1.readID = read1_ID;
-		simpleAlignment_1.qualities = read1_qualities;
-		simpleAlignment_1.sequence = read1_sequence;
-
-		// todo check - reverse complement
-		// read2_sequence = seq_reverse_complement(read2_sequence);
-		// std::reverse(read2_qualities.begin(), read2_qualities.end());
-
-		BAMalignment simpleAlignment_2;
-		simpleAlignment_2.readID = read2_ID;
-		simpleAlignment_2.qualities = read2_qualities;
-		simpleAlignment_2.sequence = read2_sequence;
-
-		fastq_readPair thisPair;
-		bool success_1 = thisPair.takeAlignment(simpleAlignment_1, 1);
-		assert(success_1);
-		bool success_2 = thisPair.takeAlignment(simpleAlignment_2, 2);
-		assert(success_2);
-		assert(thisPair.isComplete());
-
-		std::string read1_ID_noFrom = Utilities::removeFROM(read1_ID);
-		std::string read2_ID_noFrom = Utilities::removeFROM(read2_ID);
-		
-		assert((read1_ID_noFrom.substr(read1_ID_noFrom.length() - 2, 2) == "/1") || (read1_ID_noFrom.substr(read1_ID_noFrom.length() - 2, 2) == "/2"));
-		assert((read2_ID_noFrom.substr(read2_ID_noFrom.length() - 2, 2) == "/1") || (read2_ID_noFrom.substr(read2_ID_noFrom.length() - 2, 2) == "/2"));
-		
-		if(!(read1_ID_noFrom.substr(0, read1_ID_noFrom.length() - 2) == read2_ID_noFrom.substr(0, read2_ID_noFrom.length() - 2)))
+	};
+
+	std::vector<std::vector<std::string> > batch_read1;
+	std::vector<std::vector<std::string> > batch_read2;
+	std::vector<std::vector<std::string> > nextBatch_read1;
+	std::vector<std::vector<std::string> > nextBatch_read2;
+	std::vector<fastq_readPair> batch_pairs;
+	std::vector<unsigned char> batch_pass;
+
+	size_t processed_pairs = 0;
+	size_t passed_pairs = 0;
+
+	readBatch(batch_read1, batch_read2);
+	while(batch_read1.size())
+	{
+		size_t batch_size = batch_read1.size();
+		batch_pairs.clear();
+		batch_pairs.resize(batch_size);
+		batch_pass.assign(batch_size, 0);
+
+		long long batch_size_signed = batch_size;
+		#pragma omp parallel
 		{
-			std::cerr << "Warning: read IDs don't match! " << read1_ID_noFrom << " vs " << read2_ID_noFrom << "\n";
+			#pragma omp single nowait
+			{
+				readBatch(nextBatch_read1, nextBatch_read2);
+			}
+
+			#pragma omp for schedule(dynamic, 256)
+			for(long long pairI = 0; pairI < batch_size_signed; pairI++)
+			{
+				std::string read1_ID; std::string read1_sequence; std::string read1_qualities;
+				getReadFromFastQ(batch_read1.at(pairI), read1_ID, read1_sequence, read1_qualities);
+
+				std::string read2_ID; std::string read2_sequence; std::string read2_qualities;
+				getReadFromFastQ(batch_read2.at(pairI), read2_ID, read2_sequence, read2_qualities);
+
+				BAMalignment simpleAlignment_1;
+				simpleAlignment_1.readID = read1_ID;
+				simpleAlignment_1.qualities = read1_qualities;
+				simpleAlignment_1.sequence = read1_sequence;
+
+				// todo check - reverse complement
+				// read2_sequence = seq_reverse_complement(read2_sequence);
+				// std::reverse(read2_qualities.begin(), read2_qualities.end());
+
+				BAMalignment simpleAlignment_2;
+				simpleAlignment_2.readID = read2_ID;
+				simpleAlignment_2.qualities = read2_qualities;
+				simpleAlignment_2.sequence = read2_sequence;
+
+				fastq_readPair& thisPair = batch_pairs.at(pairI);
+				bool success_1 = thisPair.takeAlignment(simpleAlignment_1, 1);
+				assert(success_1);
+				bool success_2 = thisPair.takeAlignment(simpleAlignment_2, 2);
+				assert(success_2);
+				assert(thisPair.isComplete());
+
+				std::string read1_ID_noFrom = Utilities::removeFROM(read1_ID);
+				std::string read2_ID_noFrom = Utilities::removeFROM(read2_ID);
+
+				assert((read1_ID_noFrom.substr(read1_ID_noFrom.length() - 2, 2) == "/1") || (read1_ID_noFrom.substr(read1_ID_noFrom.length() - 2, 2) == "/2"));
+				assert((read2_ID_noFrom.substr(read2_ID_noFrom.length() - 2, 2) == "/1") || (read2_ID_noFrom.substr(read2_ID_noFrom.length() - 2, 2) == "/2"));
+
+				if(!(read1_ID_noFrom.substr(0, read1_ID_noFrom.length() - 2) == read2_ID_noFrom.substr(0, read2_ID_noFrom.length() - 2)))
+				{
+					#pragma omp critical
+					{
+						std::cerr << "Warning: read IDs don't match! " << read1_ID_noFrom << " vs " << read2_ID_noFrom << "\n";
+					}
+				}
+				assert(read1_ID_noFrom.substr(0, read1_ID_noFrom.length() - 2) == read2_ID_noFrom.substr(0, read2_ID_noFrom.length() - 2));
+
+				batch_pass.at(pairI) = (*decide)(thisPair, false);
+			}
 		}
-		assert(read1_ID_noFrom.substr(0, read1_ID_noFrom.length() - 2) == read2_ID_noFrom.substr(0, read2_ID_noFrom.length() - 2));		
-		
-		if((*decide)(thisPair, false))
+
+		for(size_t pairI = 0; pairI < batch_size; pairI++)
 		{
-			(*print)(thisPair);
+			if(batch_pass.at(pairI))
+			{
+				(*print)(batch_pairs.at(pairI));
+				passed_pairs++;
+			}
 		}
+		processed_pairs += batch_size;
+
+		std::cout << "\t" << Utilities::timestamp() << " filterFastQPairs(..): " << processed_pairs << " read pairs processed, " << passed_pairs << " passed.\n" << std::flush;
+
+		batch_read1.swap(nextBatch_read1);
+		batch_read2.swap(nextBatch_read2);
 	}
 }
 